@@ -10,23 +10,53 @@
 #include <limits>
 #include <string>
 #include <sstream>
+#include <utility>
 
 #include "Vector3f.h"
 #include "BoundingBox3f.h"
 #include "BoundingBox3fOperations.h"
-#include "AabbTreeNode.h"
+#include "AabbTreeStatistics.h"
+#include "ParallelAlgorithms.h"
+#include "RaySegment.h"
 
 namespace cgmath {
 
+template<typename OBJECT> class WideAabbTree;
+template<typename OBJECT> class QuantizedAabbTree;
+
 // AabbTree
 //
 // An axis-aligned bounding box tree.
 //
+// The nodes of the tree are stored contiguously in a single array,
+// and the objects are copied into a second array, in the order
+// of the leaf nodes that contain them. Both children of a node
+// are adjacent in the node array, so each node only needs to record
+// the index of its first child, or the range of its objects.
+//
 // The template parameter class OBJECT should have the following
 // member function defined:
 //
 // cgmath::BoundingBox3f boundingBox() const;
 //     Returns the 3D bounding box of the object.
+//
+// The tree is built by several threads at once when there are enough objects
+// to make it worthwhile. The two subtrees of a node are built by separate
+// threads, and near the root, where there are only a few subtrees, the work
+// of splitting each node is itself divided among the threads.
+// The tree that's built doesn't depend on the number of threads.
+//
+// The ray segment queries evaluate the nearer child of each node first,
+// using the slab tests provided by RaySegment. For trees that aren't
+// modified after they're built, WideAabbTree answers the same queries
+// with four children per node, and QuantizedAabbTree answers them
+// in much less memory.
+//
+// The queries don't modify the tree, so a tree may be queried from several
+// threads at once, provided that the listeners allow it. Each query
+// optionally accepts an AabbTreeStatistics object that the number of tests
+// it performs is added to. When no statistics object is passed, the tests
+// are not counted at all.
 
 template<typename OBJECT>
 class AabbTree
@@ -35,6 +65,26 @@ public:
     AabbTree();
     ~AabbTree();
 
+    // The strategy used by initialize to divide the objects among the nodes
+    // of the tree.
+    enum SplitStrategy {
+        // Split each node at the median object along its longest axis,
+        // keeping objects as large as the node in the node itself.
+        MEDIAN_SPLIT,
+        // Split each node where the binned surface area heuristic estimates
+        // the lowest traversal cost, and stop splitting when a leaf node
+        // would be cheaper. This is slower to build for uniformly distributed
+        // objects, but yields better trees for irregular scenes.
+        SURFACE_AREA_HEURISTIC
+    };
+    void setSplitStrategy(SplitStrategy splitStrategy);
+    SplitStrategy splitStrategy() const;
+
+    // The largest number of threads that initialize may use to build the tree.
+    // By default, this is the number of processors.
+    void setMaximumBuildThreads(unsigned maximumBuildThreads);
+    unsigned maximumBuildThreads() const;
+
     // Initialize the AABB tree.
     typedef std::vector<OBJECT> ObjectVector;
     typedef typename ObjectVector::const_iterator ObjectVectorConstIterator;
@@ -43,12 +93,24 @@ public:
     // A string describing the AABB tree size at each level.
     std::string sizeStatistics() const;
 
-    // A string describing AABB tree statistics after it has been used.
-    std::string queryStatistics() const;
-    
-    // Clear out all the nodes from the tree.
+    // Clear out all the nodes from the tree, releasing the memory they occupied.
     void clear();
 
+    // Insert an object into the tree without rebuilding it. The object is placed
+    // in a new leaf node next to the existing node whose bounding box
+    // grows the least to accommodate it.
+    void insertObject(const OBJECT &object);
+
+    // Remove an object from the tree, shrinking the bounding boxes of the nodes
+    // that contained it. The template parameter class OBJECT must define
+    // operator==, and the object's bounding box must not have changed since it
+    // was added to the tree. Returns false if the object was not found.
+    bool removeObject(const OBJECT &object);
+
+    // Recompute the bounding boxes of all the nodes in the tree,
+    // after the bounding boxes of the objects in it have changed.
+    void refit();
+
     class BoundingBoxListener {
     public:
         virtual ~BoundingBoxListener() {}
@@ -61,7 +123,24 @@ public:
     // boxes intersect the specified bounding box.
     // Returns true if a listener function call returned true.
     bool applyToBoundingBoxIntersection(const BoundingBox3f &boundingBox,
-        BoundingBoxListener *boundingBoxListener) const;
+        BoundingBoxListener *boundingBoxListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef std::vector<BoundingBox3f> BoundingBox3fVector;
+
+    // Find the objects whose bounding boxes intersect each of a vector of
+    // bounding boxes. When there are many small boxes near each other, this is
+    // faster than calling applyToBoundingBoxIntersection for each one,
+    // because the boxes are sorted along a Morton curve and searched in groups
+    // that share the traversal of the upper levels of the tree.
+    // The results are returned in compressed sparse row form: the indices
+    // in objectVector of the objects that intersect box i are
+    // objectIndexVector[offsetVector[i]] up to objectIndexVector[offsetVector[i + 1]],
+    // in the order applyToBoundingBoxIntersection would find them.
+    // The entire search is recorded as a single query in aabbTreeStatistics.
+    void findBoundingBoxIntersections(const BoundingBox3fVector &boundingBoxVector,
+        std::vector<unsigned> *offsetVector, std::vector<unsigned> *objectIndexVector,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     class Triangle {
     public:
@@ -81,7 +160,8 @@ public:
     // array of triangles.
     // Returns true if a listener function call returned true.
     bool applyToTriangleVectorIntersection(const TriangleVector &triangleVector,
-        TriangleListener *triangleListener) const;
+        TriangleListener *triangleListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     class TetrahedronListener {
     public:
@@ -97,7 +177,8 @@ public:
     // Returns true if a listener function call returned true.
     bool applyToTetrahedronIntersection(const Vector3f &v0, const Vector3f &v1, 
         const Vector3f &v2, const Vector3f &v3,
-        TetrahedronListener *tetrahedronListener) const;
+        TetrahedronListener *tetrahedronListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     class RaySegmentOcclusionListener {
     public:
@@ -114,7 +195,8 @@ public:
     // objects in the AABB tree. The callback function should return
     // true if the ray segment intersects the object.
     bool occludesRaySegment(const Vector3f &origin, const Vector3f &endpoint, 
-        const RaySegmentOcclusionListener *raySegmentOcclusionListener) const;
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     class RaySegmentIntersectionListener {
     public:
@@ -139,36 +221,137 @@ public:
     // the object at a point with a closer value of 't'.
     bool intersectsRaySegment(const Vector3f &origin, const Vector3f &endpoint, 
         const RaySegmentIntersectionListener *raySegmentIntersectionListener,
-        cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject) const;
+        cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    class SphereListener {
+    public:
+        virtual ~SphereListener() {}
+        // If this function returns true, traversal of the AABB tree halts.
+        virtual bool applyObjectToSphere(OBJECT &object, 
+            const Vector3f &center, float radius) = 0;
+    };
+
+    // Apply a listener to all objects in the AABB tree whose bounding
+    // boxes intersect the specified sphere.
+    // Returns true if a listener function call returned true.
+    bool applyToSphereIntersection(const Vector3f &center, float radius,
+        SphereListener *sphereListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // An object returned by findNearestObjects.
+    struct NearestObject {
+        // The squared distance from the query point to the object's bounding box.
+        float mDistanceSquared;
+        OBJECT *mObject;
+        // Used to maintain the bounded priority queue of nearest objects.
+        bool operator<(const NearestObject &rhs) const {
+            return mDistanceSquared < rhs.mDistanceSquared;
+        }
+    };
+    typedef std::vector<NearestObject> NearestObjectVector;
+
+    // Find up to maximumObjects objects whose bounding boxes are closest
+    // to a point, and no farther away than maximumDistance.
+    // The objects are returned in order of increasing distance.
+    void findNearestObjects(const Vector3f &point, unsigned maximumObjects,
+        float maximumDistance, NearestObjectVector *nearestObjectVector,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // The indices of two objects whose bounding boxes overlap, in the vectors
+    // returned by objectVector.
+    typedef std::pair<unsigned, unsigned> ObjectIndexPair;
+    typedef std::vector<ObjectIndexPair> ObjectIndexPairVector;
+
+    // Find all pairs of objects, the first from this tree and the second from
+    // another tree, whose bounding boxes overlap, or are no more than tolerance
+    // apart along each axis. The two trees are traversed together, so pairs of
+    // subtrees that are far apart are skipped at once. The traversal is divided
+    // among up to threadCount threads, but the pairs are returned in the same
+    // order however many threads there are. The entire traversal is recorded
+    // as a single query in aabbTreeStatistics.
+    template<typename OTHER_OBJECT>
+    void findOverlappingPairs(const AabbTree<OTHER_OBJECT> &otherAabbTree,
+        float tolerance, unsigned threadCount,
+        ObjectIndexPairVector *objectIndexPairVector,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // Like findOverlappingPairs, but finds the pairs of distinct objects
+    // within this tree. Each pair is reported once, with the smaller index first.
+    void findSelfOverlappingPairs(float tolerance, unsigned threadCount,
+        ObjectIndexPairVector *objectIndexPairVector,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // Number of bytes occupied by the tree.
+    size_t bytesUsed() const;
+
+    // A string describing the number of bytes occupied by the nodes,
+    // objects, and free lists of the tree.
+    std::string memoryStatistics() const;
+
+    // A node of the tree. Each node is 32 bytes, so that two of them
+    // share a typical cache line.
+    struct Node {
+        BoundingBox3f mBoundingBox;
+        // For a leaf node, the index of its first object in mObjectVector.
+        // For an internal node, the index of its left child node in mNodeVector.
+        // The right child node immediately follows the left child node.
+        unsigned mIndex;
+        // The number of objects in a leaf node, or zero for an internal node.
+        unsigned mObjectCount;
+        bool isLeaf() const {
+            return mObjectCount != 0;
+        }
+    };
+    typedef std::vector<Node> NodeVector;
 
-    // The number of intersection tests performed.
-    unsigned queries() const;
+    // The nodes and objects of the tree, so that it can be saved to a file
+    // and restored later without being rebuilt. The root node is the first node.
+    // Entries freed by removeObject are included, but no node refers to them.
+    const NodeVector &nodeVector() const;
+    const ObjectVector &objectVector() const;
 
-    // The number of bounding box tests performed.
-    unsigned averageBoundingBoxTestsPerQuery() const;
-    unsigned minBoundingBoxTestsPerQuery() const;
-    unsigned maxBoundingBoxTestsPerQuery() const;
+    // Restore a tree from the nodes and objects returned by nodeVector and
+    // objectVector. Returns false, leaving the tree empty, if they don't
+    // describe a valid tree.
+    bool restore(const NodeVector &nodeVector, const ObjectVector &objectVector);
 
-    // The number of object intersection tests (via listener) performed.
-    unsigned averageObjectTestsPerQuery() const;
-    unsigned minObjectTestsPerQuery() const;
-    unsigned maxObjectTestsPerQuery() const;
-    
 private:
+    // WideAabbTree is built by collapsing the nodes of an AabbTree,
+    // and QuantizedAabbTree by compressing them.
+    template<typename> friend class WideAabbTree;
+    template<typename> friend class QuantizedAabbTree;
+
     // These unimplemented declarations prevent objects of this class
-    // from being copied. That would be dangerous, since this
-    // class contains a pointer.
+    // from being copied. This isn't necessary, but copying a tree
+    // is expensive enough that it's probably unintentional.
     AabbTree(const AabbTree &);
     void operator=(const AabbTree &);
 
-    // Delete an AabbTreeNode and its descendents.
-    void deleteAabbTreeNodeAndDescendants(AabbTreeNode<OBJECT> *aabbTreeNode);
+    // Allocate two adjacent nodes, returning the index of the first.
+    unsigned allocateNodePair();
+
+    // Copy an object into mObjectVector, returning its index.
+    unsigned allocateObject(const OBJECT &object);
+
+    // Remove an object from an AABB subtree. Returns true if the object was found.
+    // If the root node of the subtree is a leaf node, it may be left empty,
+    // in which case the caller must remove it.
+    bool removeObjectFromSubtree(unsigned nodeIndex, const OBJECT &object,
+        const BoundingBox3f &objectBoundingBox);
+
+    // Recompute the bounding boxes of an AABB subtree.
+    void refitSubtree(unsigned nodeIndex);
+
+    // Recompute the bounding box of a node from its objects or the
+    // bounding boxes of its children.
+    void refitNode(unsigned nodeIndex);
 
     // This is used by initialize and createAabbSubtree to manage a
     // temporary array for sorting the objects as they're being
     // placed in the tree. The midpoint and size are precomputed,
     // rather than being computed on the fly by the functors below,
-    // because that would potentially cause floating point roundoff 
+    // because that would potentially cause floating point roundoff
     // errors that would throw off STL's sort algorithm.
     typedef struct {
         Vector3f mMidpoint;
@@ -177,9 +360,49 @@ private:
     } ObjectPtr;
     typedef std::vector<ObjectPtr> ObjectPtrVector;
     typedef typename ObjectPtrVector::iterator ObjectPtrVectorIterator;
-    
+
+    // Fills in a range of the temporary vector of ObjectPtr's
+    // from the corresponding objects.
+    class ObjectPtrInitializationFunctor {
+    public:
+        ObjectPtrInitializationFunctor(ObjectPtrVectorIterator objectPtrBegin,
+            ObjectVectorConstIterator objectBegin);
+        void operator()(ObjectPtrVectorIterator first, ObjectPtrVectorIterator last);
+    private:
+        ObjectPtrVectorIterator mObjectPtrBegin;
+        ObjectVectorConstIterator mObjectBegin;
+    };
+
+    // Computes the bounding box of a range of objects,
+    // and the bounding box of their midpoints.
+    class BoundsFunctor {
+    public:
+        BoundsFunctor();
+        void operator()(ObjectPtrVectorIterator first, ObjectPtrVectorIterator last);
+        void merge(const BoundsFunctor &boundsFunctor);
+        const BoundingBox3f &boundingBox() const;
+        const BoundingBox3f &midpointBoundingBox() const;
+    private:
+        BoundingBox3f mBoundingBox;
+        BoundingBox3f mMidpointBoundingBox;
+    };
+
+    // This predicate is true for objects that are as large as
+    // the bounding box of a node along a particular axis.
+    class LargeObjectPredicate {
+    public:
+        LargeObjectPredicate(unsigned axis, const BoundingBox3f &boundingBox);
+        bool operator()(const ObjectPtr &objectPtr) const;
+    private:
+        unsigned mAxis;
+        float mMinimum;
+        float mMaximum;
+    };
+
     // This functor is used to sort objects by their size
     // on a particular axis. Largest objects are positioned first.
+    // Ties are broken by the objects' original order, so that
+    // the tree doesn't depend on the sorting algorithm.
     class SortBySizeFunctor {
     public:
         void setAxis(unsigned axis);
@@ -189,7 +412,7 @@ private:
     };
 
     // This functor is used to sort objects by their position
-    // on a particular axis.
+    // on a particular axis. Ties are broken by the objects' original order.
     class SortByMidpointFunctor {
     public:
         void setAxis(unsigned axis);
@@ -198,104 +421,384 @@ private:
         unsigned mAxis;
     };
 
-    // Create a subtree of the AABB tree, given a subrange
-    // of a vector of objects to place in the tree.
-    AabbTreeNode<OBJECT> *createAabbSubtree(ObjectPtrVectorIterator first,
-        ObjectPtrVectorIterator last, unsigned level);
+    // Ranges of fewer objects than this are split by a single thread.
+    enum {
+        PARALLEL_BUILD_MINIMUM_OBJECTS = 4096
+    };
+
+    // The nodes and per-level size statistics of a subtree under construction.
+    // When the two subtrees of a node are built by separate threads, each is
+    // built into its own SubtreeBuild, and they are then spliced into the
+    // parent's SubtreeBuild, so that the nodes end up in the same order that
+    // a single thread would have created them in.
+    struct SubtreeBuild {
+        SubtreeBuild(ObjectPtrVectorIterator objectPtrBegin, size_t objectCount);
+        // Allocate two adjacent nodes, returning the index of the first.
+        unsigned allocateNodePair();
+        // Make sure there are statistics for at least the specified number of levels.
+        void extendToDepth(unsigned depth);
+        // Record the size of a node at a level of the subtree.
+        void addNodeSize(unsigned level, float size);
+        // The start of the vector of all the objects in the tree.
+        // Leaf nodes refer to objects by their position in it.
+        ObjectPtrVectorIterator mObjectPtrBegin;
+        // The root node of the subtree is the first node.
+        NodeVector mNodeVector;
+        std::vector<unsigned> mNodesAtLevel;
+        std::vector<float> mMinSizeAtLevel;
+        std::vector<float> mMaxSizeAtLevel;
+        std::vector<float> mAverageSizeAtLevel;
+    };
+
+    // The thread function that builds a subtree into a SubtreeBuild.
+    class CreateAabbSubtreeTask {
+    public:
+        CreateAabbSubtreeTask(const AabbTree *aabbTree, SubtreeBuild *subtreeBuild,
+            ObjectPtrVectorIterator first, ObjectPtrVectorIterator last,
+            unsigned threadCount);
+        void operator()();
+    private:
+        const AabbTree *mAabbTree;
+        SubtreeBuild *mSubtreeBuild;
+        ObjectPtrVectorIterator mFirst;
+        ObjectPtrVectorIterator mLast;
+        unsigned mThreadCount;
+    };
+
+    // Create a subtree of the AABB tree at the specified node, given a subrange
+    // of a vector of objects to place in the tree, using up to threadCount threads.
+    void createAabbSubtree(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+        ObjectPtrVectorIterator first, ObjectPtrVectorIterator last, unsigned level,
+        unsigned threadCount) const;
+
+    // Create the subtrees at two adjacent child nodes, given the ranges of objects
+    // on either side of split. If more than one thread is available, the
+    // left subtree is built by a new thread.
+    void createAabbSubtreePair(SubtreeBuild *subtreeBuild, unsigned childIndex,
+        ObjectPtrVectorIterator first, ObjectPtrVectorIterator split,
+        ObjectPtrVectorIterator last, unsigned level, unsigned threadCount) const;
+
+    // Copy the nodes and statistics of a separately built subtree into a
+    // SubtreeBuild, with the root of the subtree at the specified node.
+    void spliceSubtree(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+        const SubtreeBuild &childSubtreeBuild, unsigned level) const;
+
+    // Make the specified node a leaf node containing a range of objects.
+    void createLeafNode(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+        ObjectPtrVectorIterator first, ObjectPtrVectorIterator last) const;
+
+    // Partition a range of objects with a predicate. Large ranges are
+    // partitioned stably by several threads, so that the result doesn't depend
+    // on the number of threads.
+    template<typename PREDICATE>
+    ObjectPtrVectorIterator partitionObjectPtrs(ObjectPtrVectorIterator first,
+        ObjectPtrVectorIterator last, PREDICATE predicate, unsigned threadCount) const;
+
+    // The number of bins along each axis that the surface area heuristic
+    // evaluates candidate splits between, and the largest number of objects
+    // that it will leave together in a leaf node.
+    enum {
+        SURFACE_AREA_HEURISTIC_BINS = 8,
+        SURFACE_AREA_HEURISTIC_MAXIMUM_LEAF_OBJECTS = 4
+    };
+
+    // This functor is used to partition objects into those whose midpoints
+    // fall into the surface area heuristic bins up to and including
+    // a particular bin, and the rest. It also determines which bin an
+    // object's midpoint falls into.
+    class BinPartitionFunctor {
+    public:
+        BinPartitionFunctor(unsigned axis, float minimum, float scale, unsigned lastBin);
+        unsigned bin(const ObjectPtr &objectPtr) const;
+        bool operator()(const ObjectPtr &objectPtr) const;
+    private:
+        unsigned mAxis;
+        float mMinimum;
+        float mScale;
+        unsigned mLastBin;
+    };
+
+    // Accumulates the bounding boxes and numbers of the objects whose midpoints
+    // fall into each surface area heuristic bin, along each axis on which
+    // the midpoints are not all the same.
+    class BinningFunctor {
+    public:
+        BinningFunctor(const BoundingBox3f &midpointBoundingBox);
+        void operator()(ObjectPtrVectorIterator first, ObjectPtrVectorIterator last);
+        void merge(const BinningFunctor &binningFunctor);
+        bool axisIsBinned(unsigned axis) const;
+        const BoundingBox3f &binBoundingBox(unsigned axis, unsigned bin) const;
+        unsigned binCount(unsigned axis, unsigned bin) const;
+    private:
+        bool mAxisIsBinned[3];
+        float mMinimum[3];
+        float mScale[3];
+        BoundingBox3f mBinBoundingBox[3][SURFACE_AREA_HEURISTIC_BINS];
+        unsigned mBinCount[3][SURFACE_AREA_HEURISTIC_BINS];
+    };
+
+    // Divide a range of objects into two subranges with the binned
+    // surface area heuristic, returning the start of the second subrange
+    // via split. Returns false if the objects should instead be kept together
+    // in a leaf node.
+    bool partitionBySurfaceAreaHeuristic(ObjectPtrVectorIterator first,
+        ObjectPtrVectorIterator last, const BoundingBox3f &boundingBox,
+        const BoundingBox3f &midpointBoundingBox, unsigned threadCount,
+        ObjectPtrVectorIterator *split) const;
+
+    // Counts the tests performed by a single query, when the caller
+    // has asked for statistics.
+    class QueryCounter {
+    public:
+        QueryCounter() : mBoundingBoxTests(0), mObjectTests(0) {}
+        void countBoundingBoxTest() {
+            ++mBoundingBoxTests;
+        }
+        void countObjectTest() {
+            ++mObjectTests;
+        }
+        void addQueryToStatistics(AabbTreeStatistics *aabbTreeStatistics) const {
+            aabbTreeStatistics->addQuery(mBoundingBoxTests, mObjectTests);
+        }
+    private:
+        unsigned mBoundingBoxTests;
+        unsigned mObjectTests;
+    };
+
+    // Takes the place of QueryCounter when the caller hasn't asked for statistics.
+    // The traversal functions are instantiated for both, so that the counting
+    // compiles away entirely when it isn't needed.
+    class NullQueryCounter {
+    public:
+        void countBoundingBoxTest() {}
+        void countObjectTest() {}
+    };
 
     // Apply a listener to all objects in an AABB subtree whose
     // bounding boxes intersect the specified bounding box. If the
     // callback returns false, the evaluation of the AABB tree halts.
-    void applyToBoundingBoxIntersectionForSubtree(
-        AabbTreeNode<OBJECT> *aabbTreeNode,
+    template<typename QUERY_COUNTER>
+    void applyToBoundingBoxIntersectionForSubtree(unsigned nodeIndex,
         bool *halted, const BoundingBox3f &boundingBox,
-        BoundingBoxListener *boundingBoxListener) const;
+        BoundingBoxListener *boundingBoxListener,
+        QUERY_COUNTER *queryCounter) const;
 
     // Apply the triangle intersection test to an AABB subtree.
-    void applyToTriangleVectorIntersectionForSubtree(
-        AabbTreeNode<OBJECT> *aabbTreeNode, 
+    template<typename QUERY_COUNTER>
+    void applyToTriangleVectorIntersectionForSubtree(unsigned nodeIndex,
         bool *halted, const TriangleVector &triangleVector,
-        TriangleListener *triangleListener) const;
+        TriangleListener *triangleListener,
+        QUERY_COUNTER *queryCounter) const;
 
     // Apply the tetrahedron intersection test to an AABB subtree.
-    void applyToTetrahedronIntersectionForSubtree(
-        AabbTreeNode<OBJECT> *aabbTreeNode, bool *halted, 
+    template<typename QUERY_COUNTER>
+    void applyToTetrahedronIntersectionForSubtree(unsigned nodeIndex, bool *halted,
         const Vector3f &v0, const Vector3f &v1, const Vector3f &v2, const Vector3f &v3,
-        TetrahedronListener *tetrahedronListener) const;
-
-    // Apply the ray segment occlusion test to an AABB subtree.
-    bool occludesRaySegmentForSubtree(
-        AabbTreeNode<OBJECT> *aabbTreeNode, bool *halted, 
-        const Vector3f &origin, const Vector3f &endpoint,
-        const RaySegmentOcclusionListener *raySegmentOcclusionListener) const;
-
-    // Apply the ray segment intersection test to an AABB subtree.
-    bool intersectsRaySegmentForSubtree(
-        AabbTreeNode<OBJECT> *aabbTreeNode,
-        const Vector3f &origin, const Vector3f &endpoint, 
+        TetrahedronListener *tetrahedronListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment occlusion test to an AABB subtree whose
+    // bounding box is known to intersect the ray segment.
+    template<typename QUERY_COUNTER>
+    bool occludesRaySegmentForSubtree(unsigned nodeIndex, bool *halted,
+        const RaySegment &raySegment,
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment intersection test to an AABB subtree whose
+    // bounding box is known to intersect the ray segment closer than 't'.
+    template<typename QUERY_COUNTER>
+    bool intersectsRaySegmentForSubtree(unsigned nodeIndex,
+        const RaySegment &raySegment,
         const RaySegmentIntersectionListener *raySegmentIntersectionListener,
-        float *t, OBJECT **intersectedObject) const;
+        float *t, OBJECT **intersectedObject,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the sphere intersection test to an AABB subtree.
+    template<typename QUERY_COUNTER>
+    void applyToSphereIntersectionForSubtree(unsigned nodeIndex, bool *halted,
+        const Vector3f &center, float radius,
+        SphereListener *sphereListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Search an AABB subtree for the objects nearest to a point.
+    // The search radius shrinks once maximumObjects objects have been found.
+    template<typename QUERY_COUNTER>
+    void findNearestObjectsForSubtree(unsigned nodeIndex,
+        const Vector3f &point, unsigned maximumObjects, float *maximumDistanceSquared,
+        NearestObjectVector *nearestObjectVector,
+        QUERY_COUNTER *queryCounter) const;
+
+    // The state of findBoundingBoxIntersections while it searches
+    // the tree for a group of boxes.
+    struct BoundingBoxGroupSearch {
+        BoundingBoxGroupSearch(const BoundingBox3fVector &boundingBoxVector)
+            : mBoundingBoxVector(boundingBoxVector),
+              mBoxIndexVectorAtLevel(),
+              mBoxObjectIndexPairVector(),
+              mBoundingBoxTests(0),
+              mObjectTests(0) {
+        }
+        const BoundingBox3fVector &mBoundingBoxVector;
+        // The indices of the boxes that intersect the node being searched
+        // at each level of the tree.
+        std::vector<std::vector<unsigned> > mBoxIndexVectorAtLevel;
+        // The index of each box and of an object it intersects.
+        std::vector<std::pair<unsigned, unsigned> > mBoxObjectIndexPairVector;
+        unsigned mBoundingBoxTests;
+        unsigned mObjectTests;
+    };
+
+    // The number of boxes that findBoundingBoxIntersections searches for together.
+    enum {
+        BOUNDING_BOX_GROUP_SIZE = 32
+    };
+
+    // Search a subtree for the objects that intersect the boxes listed
+    // for its level in boundingBoxGroupSearch, which intersect its root node.
+    void findBoundingBoxIntersectionsForSubtree(unsigned nodeIndex, unsigned level,
+        BoundingBoxGroupSearch *boundingBoxGroupSearch) const;
+
+    // A unit of the work done by findOverlappingPairs and findSelfOverlappingPairs.
+    // Either the subtrees of a node of this tree and a node of the other tree
+    // are searched for overlapping pairs, or, if mWithinSubtree is true,
+    // the subtree of a node of this tree is searched for pairs within itself.
+    struct OverlapTask {
+        unsigned mNodeIndex;
+        unsigned mOtherNodeIndex;
+        bool mWithinSubtree;
+    };
+    typedef std::vector<OverlapTask> OverlapTaskVector;
+    typedef typename OverlapTaskVector::const_iterator OverlapTaskVectorConstIterator;
+
+    // When the search for overlapping pairs is divided among several threads,
+    // the tasks are first split into subtasks until there are at least this many,
+    // so that each thread is given a similar amount of work.
+    enum {
+        PARALLEL_OVERLAP_MINIMUM_TASKS = 256
+    };
+
+    // Searches the tasks in a range for overlapping pairs, appending the pairs
+    // it finds to its own vector. When searching for pairs within a single tree,
+    // the other tree is the same tree.
+    template<typename OTHER_OBJECT>
+    class OverlapFunctor {
+    public:
+        OverlapFunctor(const AabbTree *aabbTree,
+            const AabbTree<OTHER_OBJECT> *otherAabbTree, float tolerance);
+        void operator()(OverlapTaskVectorConstIterator first,
+            OverlapTaskVectorConstIterator last);
+        // Append the subtasks that a task is made of to a vector, in the order
+        // they'd be searched in. Returns false, appending nothing, if the task
+        // can't be split because its nodes are leaf nodes.
+        bool splitTask(const OverlapTask &overlapTask, OverlapTaskVector *overlapTaskVector);
+        const ObjectIndexPairVector &objectIndexPairVector() const;
+        unsigned boundingBoxTests() const;
+        unsigned objectTests() const;
+    private:
+        typedef typename AabbTree<OTHER_OBJECT>::Node OtherNode;
+        void searchTask(const OverlapTask &overlapTask);
+        void searchSubtreePair(unsigned nodeIndex, unsigned otherNodeIndex);
+        void searchWithinSubtree(unsigned nodeIndex);
+        // Returns true if the first node, rather than the other node,
+        // should be split when the two are searched against each other.
+        bool shouldSplitFirstNode(const Node &node, const OtherNode &otherNode) const;
+        bool boundingBoxesOverlap(const BoundingBox3f &boundingBox,
+            const BoundingBox3f &otherBoundingBox) const;
+        const AabbTree *mAabbTree;
+        const AabbTree<OTHER_OBJECT> *mOtherAabbTree;
+        float mTolerance;
+        ObjectIndexPairVector mObjectIndexPairVector;
+        unsigned mBoundingBoxTests;
+        unsigned mObjectTests;
+    };
+
+    // Search for overlapping pairs starting from a single task, which is
+    // divided among up to threadCount threads.
+    template<typename OTHER_OBJECT>
+    void findOverlappingPairsForTask(const AabbTree<OTHER_OBJECT> &otherAabbTree,
+        const OverlapTask &rootOverlapTask, float tolerance, unsigned threadCount,
+        ObjectIndexPairVector *objectIndexPairVector,
+        AabbTreeStatistics *aabbTreeStatistics) const;
+
+    // The nodes of the tree. The root node is the first node.
+    NodeVector mNodeVector;
+
+    // The objects in the tree, in the order of the leaf nodes that contain them.
+    // This is mutable because the listeners are passed non-const references
+    // to the objects by the const query functions.
+    mutable ObjectVector mObjectVector;
 
-    // Update the overall usage data based on the current query.
-    void updateUsageDataFromCurrentQuery() const;
+    // The indices of node pairs and objects that were freed by removeObject,
+    // which are reused by insertObject.
+    std::vector<unsigned> mFreeNodePairVector;
+    std::vector<unsigned> mFreeObjectVector;
 
-    AabbTreeNode<OBJECT> *mRootNode;
+    SplitStrategy mSplitStrategy;
+    unsigned mMaximumBuildThreads;
 
     unsigned mDepth;
     std::vector<unsigned> mNodesAtLevel;
     std::vector<float> mMinSizeAtLevel;
     std::vector<float> mMaxSizeAtLevel;
     std::vector<float> mAverageSizeAtLevel;
-
-    mutable unsigned mQueries;
-    mutable unsigned mBoundingBoxTests;
-    mutable unsigned mCurrentQueryBoundingBoxTests;
-    mutable unsigned mMinBoundingBoxTestsPerQuery;
-    mutable unsigned mMaxBoundingBoxTestsPerQuery;
-    mutable unsigned mObjectTests;
-    mutable unsigned mCurrentQueryObjectTests;
-    mutable unsigned mMinObjectTestsPerQuery;
-    mutable unsigned mMaxObjectTestsPerQuery;
 };
 
 template<typename OBJECT>
 AabbTree<OBJECT>::AabbTree()
-    : mRootNode(NULL),
+    : mNodeVector(),
+      mObjectVector(),
+      mFreeNodePairVector(),
+      mFreeObjectVector(),
+      mSplitStrategy(MEDIAN_SPLIT),
+      mMaximumBuildThreads(GetDefaultThreadCount()),
       mDepth(0),
       mNodesAtLevel(),
       mMinSizeAtLevel(),
       mMaxSizeAtLevel(),
-      mAverageSizeAtLevel(),
-      mQueries(0),
-      mBoundingBoxTests(0),
-      mCurrentQueryBoundingBoxTests(0),
-      mMinBoundingBoxTestsPerQuery(0),
-      mMaxBoundingBoxTestsPerQuery(0),
-      mObjectTests(0),
-      mCurrentQueryObjectTests(0),
-      mMinObjectTestsPerQuery(0),
-      mMaxObjectTestsPerQuery(0)
+      mAverageSizeAtLevel()
 {
 }
 
 template<typename OBJECT>
 AabbTree<OBJECT>::~AabbTree()
 {
-    if (mRootNode != NULL) {
-        deleteAabbTreeNodeAndDescendants(mRootNode);
-        mRootNode = NULL;
-    }
 }
 
 template<typename OBJECT>
-void 
+void
+AabbTree<OBJECT>::setSplitStrategy(SplitStrategy splitStrategy)
+{
+    mSplitStrategy = splitStrategy;
+}
+
+template<typename OBJECT>
+typename AabbTree<OBJECT>::SplitStrategy
+AabbTree<OBJECT>::splitStrategy() const
+{
+    return mSplitStrategy;
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::setMaximumBuildThreads(unsigned maximumBuildThreads)
+{
+    mMaximumBuildThreads = std::max(maximumBuildThreads, 1U);
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::maximumBuildThreads() const
+{
+    return mMaximumBuildThreads;
+}
+
+template<typename OBJECT>
+void
 AabbTree<OBJECT>::initialize(const ObjectVector &objectVector)
 {
     // If there are already nodes in the tree, destroy them.
-    if (mRootNode != NULL) {
-        deleteAabbTreeNodeAndDescendants(mRootNode);
-        mRootNode = NULL;
-    }
+    clear();
 
     mDepth = 0;
     mNodesAtLevel.clear();
@@ -303,35 +806,43 @@ AabbTree<OBJECT>::initialize(const ObjectVector &objectVector)
     mMaxSizeAtLevel.clear();
     mAverageSizeAtLevel.clear();
 
-    // Create a temporary vector of pointers and midpoints 
+    if (objectVector.empty()) {
+        return;
+    }
+
+    unsigned threadCount = objectVector.size() >= PARALLEL_BUILD_MINIMUM_OBJECTS
+        ? mMaximumBuildThreads : 1;
+
+    // Create a temporary vector of pointers and midpoints
     // that's used in the creation of the AABB tree.
-    ObjectPtrVector objectPtrVector;
-    objectPtrVector.reserve(objectVector.size());
-    for (ObjectVectorConstIterator iterator = objectVector.begin();
-         iterator != objectVector.end(); ++iterator) {
-        const OBJECT &object = *iterator;
-        ObjectPtr objectPtr;
-        const BoundingBox3f &boundingBox = object.boundingBox();
-        objectPtr.mMidpoint = (boundingBox.min() + boundingBox.max())/2.0;
-        objectPtr.mSize = boundingBox.max() - boundingBox.min();
-        objectPtr.mObject = &object;
-        objectPtrVector.push_back(objectPtr);
+    ObjectPtrVector objectPtrVector(objectVector.size());
+    std::vector<ObjectPtrInitializationFunctor> objectPtrInitializationFunctorVector;
+    ApplyToChunksInParallel(objectPtrVector.begin(), objectPtrVector.end(),
+        ObjectPtrInitializationFunctor(objectPtrVector.begin(), objectVector.begin()),
+        threadCount, &objectPtrInitializationFunctorVector);
+
+    SubtreeBuild subtreeBuild(objectPtrVector.begin(), objectPtrVector.size());
+    createAabbSubtree(&subtreeBuild, 0, objectPtrVector.begin(), objectPtrVector.end(), 0,
+        threadCount);
+
+    mNodeVector.swap(subtreeBuild.mNodeVector);
+    mNodesAtLevel.swap(subtreeBuild.mNodesAtLevel);
+    mMinSizeAtLevel.swap(subtreeBuild.mMinSizeAtLevel);
+    mMaxSizeAtLevel.swap(subtreeBuild.mMaxSizeAtLevel);
+    mAverageSizeAtLevel.swap(subtreeBuild.mAverageSizeAtLevel);
+    mDepth = mNodesAtLevel.size();
+
+    // The leaf nodes refer to the objects by their final positions
+    // in objectPtrVector, which are in the order of the leaf nodes.
+    mObjectVector.reserve(objectPtrVector.size());
+    for (ObjectPtrVectorIterator iterator = objectPtrVector.begin();
+         iterator != objectPtrVector.end(); ++iterator) {
+        mObjectVector.push_back(*(*iterator).mObject);
     }
-    
-    mRootNode = createAabbSubtree(objectPtrVector.begin(),
-        objectPtrVector.end(), 0);
 
     for (unsigned level = 0; level < mDepth; ++level) {
         mAverageSizeAtLevel[level] /= mNodesAtLevel[level];
     }
-
-    mQueries = 0;
-    mBoundingBoxTests = 0;
-    mMinBoundingBoxTestsPerQuery = std::numeric_limits<unsigned>::max();
-    mMaxBoundingBoxTestsPerQuery = 0;
-    mObjectTests = 0;
-    mMinObjectTestsPerQuery = std::numeric_limits<unsigned>::max();
-    mMaxObjectTestsPerQuery = 0;
 }
 
 template<typename OBJECT>
@@ -355,84 +866,232 @@ AabbTree<OBJECT>::sizeStatistics() const
 }
 
 template<typename OBJECT>
-std::string 
-AabbTree<OBJECT>::queryStatistics() const
+void
+AabbTree<OBJECT>::clear()
 {
-    std::ostringstream ostr;
+    // Swapping with empty vectors frees their storage, which clear would keep.
+    NodeVector().swap(mNodeVector);
+    ObjectVector().swap(mObjectVector);
+    std::vector<unsigned>().swap(mFreeNodePairVector);
+    std::vector<unsigned>().swap(mFreeObjectVector);
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::insertObject(const OBJECT &object)
+{
+    const BoundingBox3f &objectBoundingBox = object.boundingBox();
+    unsigned objectIndex = allocateObject(object);
+
+    if (mNodeVector.empty()) {
+        Node leafNode;
+        leafNode.mBoundingBox = objectBoundingBox;
+        leafNode.mIndex = objectIndex;
+        leafNode.mObjectCount = 1;
+        mNodeVector.push_back(leafNode);
+        return;
+    }
+
+    // Descend into the child whose surface area would grow the least,
+    // which keeps the cost of traversing the tree low.
+    unsigned nodeIndex = 0;
+    while (!mNodeVector[nodeIndex].isLeaf()) {
+        Node &node = mNodeVector[nodeIndex];
+        node.mBoundingBox.extendByBoundingBox3f(objectBoundingBox);
+
+        unsigned leftIndex = node.mIndex;
+        unsigned rightIndex = node.mIndex + 1;
+
+        BoundingBox3f leftBoundingBox = mNodeVector[leftIndex].mBoundingBox;
+        float leftArea = GetBoundingBox3fSurfaceArea(leftBoundingBox);
+        leftBoundingBox.extendByBoundingBox3f(objectBoundingBox);
+        float leftGrowth = GetBoundingBox3fSurfaceArea(leftBoundingBox) - leftArea;
+
+        BoundingBox3f rightBoundingBox = mNodeVector[rightIndex].mBoundingBox;
+        float rightArea = GetBoundingBox3fSurfaceArea(rightBoundingBox);
+        rightBoundingBox.extendByBoundingBox3f(objectBoundingBox);
+        float rightGrowth = GetBoundingBox3fSurfaceArea(rightBoundingBox) - rightArea;
+
+        if (leftGrowth < rightGrowth
+            || (leftGrowth == rightGrowth && leftArea <= rightArea)) {
+            nodeIndex = leftIndex;
+        } else {
+            nodeIndex = rightIndex;
+        }
+    }
 
-    ostr << "Queries: " << queries() << "\n";
-    ostr << "Average bounding box tests per query: " << averageBoundingBoxTestsPerQuery() << "\n";
-    ostr << "Min bounding box tests per query: " << minBoundingBoxTestsPerQuery() << "\n";
-    ostr << "Max bounding box tests per query: " << maxBoundingBoxTestsPerQuery() << "\n";
-    ostr << "Average object tests per query: " << averageObjectTestsPerQuery() << "\n";
-    ostr << "Min object tests per query: " << minObjectTestsPerQuery() << "\n";
-    ostr << "Max object tests per query: " << maxObjectTestsPerQuery();
+    // The leaf node is replaced by a new node whose children are
+    // the old leaf node and a new leaf node containing the object.
+    unsigned childIndex = allocateNodePair();
 
-    return ostr.str();
+    mNodeVector[childIndex] = mNodeVector[nodeIndex];
+
+    Node &leafNode = mNodeVector[childIndex + 1];
+    leafNode.mBoundingBox = objectBoundingBox;
+    leafNode.mIndex = objectIndex;
+    leafNode.mObjectCount = 1;
+
+    Node &parentNode = mNodeVector[nodeIndex];
+    parentNode.mBoundingBox.extendByBoundingBox3f(objectBoundingBox);
+    parentNode.mIndex = childIndex;
+    parentNode.mObjectCount = 0;
 }
 
 template<typename OBJECT>
-void 
-AabbTree<OBJECT>::clear()
+bool
+AabbTree<OBJECT>::removeObject(const OBJECT &object)
+{
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    if (!removeObjectFromSubtree(0, object, object.boundingBox())) {
+        return false;
+    }
+
+    // If the last object was removed from the tree, the root node
+    // is an empty leaf node.
+    if (mObjectVector.size() == mFreeObjectVector.size()) {
+        clear();
+    }
+
+    return true;
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::refit()
 {
-    if (mRootNode != NULL) {
-        deleteAabbTreeNodeAndDescendants(mRootNode);
-        mRootNode = NULL;
+    if (!mNodeVector.empty()) {
+        refitSubtree(0);
     }
 }
 
 template<typename OBJECT>
 bool
 AabbTree<OBJECT>::applyToBoundingBoxIntersection(const BoundingBox3f &boundingBox,
-    BoundingBoxListener *boundingBoxListener) const
+    BoundingBoxListener *boundingBoxListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
     assert(boundingBoxListener != NULL);
 
-    if (mRootNode == NULL) {
+    if (mNodeVector.empty()) {
         return false;
     }
 
     bool halted = false;
 
-    ++mQueries;
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToBoundingBoxIntersectionForSubtree(0, &halted, boundingBox,
+            boundingBoxListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToBoundingBoxIntersectionForSubtree(0, &halted, boundingBox,
+            boundingBoxListener, &nullQueryCounter);
+    }
+
+    return halted;
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::findBoundingBoxIntersections(const BoundingBox3fVector &boundingBoxVector,
+    std::vector<unsigned> *offsetVector, std::vector<unsigned> *objectIndexVector,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(offsetVector != NULL);
+    assert(objectIndexVector != NULL);
+
+    offsetVector->assign(boundingBoxVector.size() + 1, 0);
+    objectIndexVector->clear();
 
-    mCurrentQueryBoundingBoxTests = 0;
-    mCurrentQueryObjectTests = 0;
-    if (mRootNode != NULL) {
-        applyToBoundingBoxIntersectionForSubtree(mRootNode,
-            &halted, boundingBox, boundingBoxListener);
+    if (mNodeVector.empty() || boundingBoxVector.empty()) {
+        return;
     }
 
-    updateUsageDataFromCurrentQuery();
+    // Sort the boxes by the Morton codes of their centers, so that
+    // each group contains boxes that are near each other.
+    const BoundingBox3f &rootBoundingBox = mNodeVector[0].mBoundingBox;
+    std::vector<std::pair<unsigned, unsigned> > mortonCodeVector;
+    mortonCodeVector.reserve(boundingBoxVector.size());
+    for (unsigned index = 0; index < boundingBoxVector.size(); ++index) {
+        mortonCodeVector.push_back(std::make_pair(
+                GetMortonCode(boundingBoxVector[index].center(), rootBoundingBox), index));
+    }
+    std::sort(mortonCodeVector.begin(), mortonCodeVector.end());
+
+    BoundingBoxGroupSearch boundingBoxGroupSearch(boundingBoxVector);
+    boundingBoxGroupSearch.mBoxIndexVectorAtLevel.resize(1);
+    for (size_t first = 0; first < mortonCodeVector.size();
+         first += BOUNDING_BOX_GROUP_SIZE) {
+        size_t last = std::min(first + BOUNDING_BOX_GROUP_SIZE, mortonCodeVector.size());
+
+        std::vector<unsigned> &boxIndexVector
+            = boundingBoxGroupSearch.mBoxIndexVectorAtLevel[0];
+        boxIndexVector.clear();
+        for (size_t index = first; index < last; ++index) {
+            unsigned boxIndex = mortonCodeVector[index].second;
+            ++boundingBoxGroupSearch.mBoundingBoxTests;
+            if (BoundingBox3fIntersectsBoundingBox3f(boundingBoxVector[boxIndex],
+                    rootBoundingBox)) {
+                boxIndexVector.push_back(boxIndex);
+            }
+        }
 
-    return halted;
+        if (!boxIndexVector.empty()) {
+            findBoundingBoxIntersectionsForSubtree(0, 0, &boundingBoxGroupSearch);
+        }
+    }
+
+    // Each box's objects were found in the order of a depth first traversal,
+    // which a stable counting sort by box preserves.
+    const std::vector<std::pair<unsigned, unsigned> > &boxObjectIndexPairVector
+        = boundingBoxGroupSearch.mBoxObjectIndexPairVector;
+    for (size_t index = 0; index < boxObjectIndexPairVector.size(); ++index) {
+        ++(*offsetVector)[boxObjectIndexPairVector[index].first + 1];
+    }
+    for (size_t index = 1; index < offsetVector->size(); ++index) {
+        (*offsetVector)[index] += (*offsetVector)[index - 1];
+    }
+    objectIndexVector->resize(boxObjectIndexPairVector.size());
+    std::vector<unsigned> nextVector(offsetVector->begin(), offsetVector->end() - 1);
+    for (size_t index = 0; index < boxObjectIndexPairVector.size(); ++index) {
+        (*objectIndexVector)[nextVector[boxObjectIndexPairVector[index].first]++]
+            = boxObjectIndexPairVector[index].second;
+    }
+
+    if (aabbTreeStatistics != NULL) {
+        aabbTreeStatistics->addQuery(boundingBoxGroupSearch.mBoundingBoxTests,
+            boundingBoxGroupSearch.mObjectTests);
+    }
 }
 
 template<typename OBJECT>
 bool
 AabbTree<OBJECT>::applyToTriangleVectorIntersection(const TriangleVector &triangleVector,
-    TriangleListener *triangleListener) const
+    TriangleListener *triangleListener, AabbTreeStatistics *aabbTreeStatistics) const
 {
     assert(triangleListener != NULL);
 
-    if (mRootNode == NULL) {
+    if (mNodeVector.empty()) {
         return false;
     }
 
     bool halted = false;
 
-    ++mQueries;
-
-    mCurrentQueryBoundingBoxTests = 0;
-    mCurrentQueryObjectTests = 0;
-    
-    if (mRootNode != NULL) {
-        applyToTriangleVectorIntersectionForSubtree(mRootNode, 
-            &halted, triangleVector, triangleListener);
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToTriangleVectorIntersectionForSubtree(0, &halted, triangleVector,
+            triangleListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToTriangleVectorIntersectionForSubtree(0, &halted, triangleVector,
+            triangleListener, &nullQueryCounter);
     }
 
-    updateUsageDataFromCurrentQuery();
-
     return halted;
 }
 
@@ -440,53 +1099,64 @@ template<typename OBJECT>
 bool 
 AabbTree<OBJECT>::applyToTetrahedronIntersection(const Vector3f &v0, const Vector3f &v1, 
     const Vector3f &v2, const Vector3f &v3,
-    TetrahedronListener *tetrahedronListener) const
+    TetrahedronListener *tetrahedronListener, AabbTreeStatistics *aabbTreeStatistics) const
 {
     assert(tetrahedronListener != NULL);
 
-    if (mRootNode == NULL) {
+    if (mNodeVector.empty()) {
         return false;
     }
 
     bool halted = false;
 
-    ++mQueries;
-
-    mCurrentQueryBoundingBoxTests = 0;
-    mCurrentQueryObjectTests = 0;
-    
-    if (mRootNode != NULL) {
-        applyToTetrahedronIntersectionForSubtree(mRootNode, &halted, v0, v1, v2, v3,
-            tetrahedronListener);
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToTetrahedronIntersectionForSubtree(0, &halted, v0, v1, v2, v3,
+            tetrahedronListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToTetrahedronIntersectionForSubtree(0, &halted, v0, v1, v2, v3,
+            tetrahedronListener, &nullQueryCounter);
     }
 
-    updateUsageDataFromCurrentQuery();
-
     return halted;
 }
 
 template<typename OBJECT>
 bool 
 AabbTree<OBJECT>::occludesRaySegment(const Vector3f &origin, const Vector3f &endpoint, 
-    const RaySegmentOcclusionListener *raySegmentOcclusionListener) const
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
     assert(raySegmentOcclusionListener != NULL);
 
-    if (mRootNode == NULL) {
+    if (mNodeVector.empty()) {
         return false;
     }
 
-    ++mQueries;
-
-    mCurrentQueryBoundingBoxTests = 0;
-    mCurrentQueryObjectTests = 0;
-    
+    RaySegment raySegment(origin, endpoint);
     bool halted = false;
-    bool result = occludesRaySegmentForSubtree(mRootNode, &halted,
-        origin, endpoint, raySegmentOcclusionListener);
+    bool result = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        queryCounter.countBoundingBoxTest();
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(mNodeVector[0].mBoundingBox, 1.0, &rootT)) {
+            result = occludesRaySegmentForSubtree(0, &halted, raySegment,
+                raySegmentOcclusionListener, &queryCounter);
+        }
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(mNodeVector[0].mBoundingBox, 1.0, &rootT)) {
+            result = occludesRaySegmentForSubtree(0, &halted, raySegment,
+                raySegmentOcclusionListener, &nullQueryCounter);
+        }
+    }
 
-    updateUsageDataFromCurrentQuery();
-    
     return result;
 }
 
@@ -494,141 +1164,402 @@ template<typename OBJECT>
 bool 
 AabbTree<OBJECT>::intersectsRaySegment(const Vector3f &origin, const Vector3f &endpoint, 
     const RaySegmentIntersectionListener *raySegmentIntersectionListener,
-    cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject) const
+    cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
     assert(raySegmentIntersectionListener != NULL);
     assert(intersectionPoint != NULL);
     assert(intersectedObject != NULL);
 
-    if (mRootNode == NULL) {
+    if (mNodeVector.empty()) {
         return false;
     }
 
-    ++mQueries;
-
-    mCurrentQueryBoundingBoxTests = 0;
-    mCurrentQueryObjectTests = 0;
-
+    RaySegment raySegment(origin, endpoint);
     float t = 1.0;
     *intersectedObject = NULL;
-    bool result = intersectsRaySegmentForSubtree(mRootNode,
-        origin, endpoint, raySegmentIntersectionListener, &t, intersectedObject);
+    bool result = false;
+
+    // As with the subtrees below it, the root node is skipped if
+    // the ray segment enters it at t=1.
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        queryCounter.countBoundingBoxTest();
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(mNodeVector[0].mBoundingBox, t, &rootT)
+            && rootT < t) {
+            result = intersectsRaySegmentForSubtree(0, raySegment,
+                raySegmentIntersectionListener, &t, intersectedObject, &queryCounter);
+        }
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(mNodeVector[0].mBoundingBox, t, &rootT)
+            && rootT < t) {
+            result = intersectsRaySegmentForSubtree(0, raySegment,
+                raySegmentIntersectionListener, &t, intersectedObject, &nullQueryCounter);
+        }
+    }
+
     *intersectionPoint = origin*(1.0 - t) + endpoint*t;
 
-    updateUsageDataFromCurrentQuery();
-    
     return result;
 }
 
 template<typename OBJECT>
-unsigned
-AabbTree<OBJECT>::queries() const
+bool
+AabbTree<OBJECT>::applyToSphereIntersection(const Vector3f &center, float radius,
+    SphereListener *sphereListener, AabbTreeStatistics *aabbTreeStatistics) const
 {
-    return mQueries;
-}
+    assert(sphereListener != NULL);
 
-template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::averageBoundingBoxTestsPerQuery() const
-{
-    if (mQueries == 0) {
-        return 0;
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    bool halted = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToSphereIntersectionForSubtree(0, &halted, center, radius,
+            sphereListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToSphereIntersectionForSubtree(0, &halted, center, radius,
+            sphereListener, &nullQueryCounter);
     }
 
-    return mBoundingBoxTests/mQueries;
+    return halted;
 }
 
 template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::minBoundingBoxTestsPerQuery() const
+void
+AabbTree<OBJECT>::findNearestObjects(const Vector3f &point, unsigned maximumObjects,
+    float maximumDistance, NearestObjectVector *nearestObjectVector,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
-    return mMinBoundingBoxTestsPerQuery;
+    assert(nearestObjectVector != NULL);
+    assert(maximumObjects > 0);
+
+    nearestObjectVector->clear();
+
+    if (mNodeVector.empty()) {
+        return;
+    }
+
+    float maximumDistanceSquared = maximumDistance*maximumDistance;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        findNearestObjectsForSubtree(0, point, maximumObjects,
+            &maximumDistanceSquared, nearestObjectVector, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        findNearestObjectsForSubtree(0, point, maximumObjects,
+            &maximumDistanceSquared, nearestObjectVector, &nullQueryCounter);
+    }
+
+    // The vector is a max-heap, so this leaves the nearest object first.
+    std::sort_heap(nearestObjectVector->begin(), nearestObjectVector->end());
 }
 
 template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::maxBoundingBoxTestsPerQuery() const
+template<typename OTHER_OBJECT>
+void
+AabbTree<OBJECT>::findOverlappingPairs(const AabbTree<OTHER_OBJECT> &otherAabbTree,
+    float tolerance, unsigned threadCount, ObjectIndexPairVector *objectIndexPairVector,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
-    return mMaxBoundingBoxTestsPerQuery;
+    assert(objectIndexPairVector != NULL);
+
+    objectIndexPairVector->clear();
+
+    if (mNodeVector.empty() || otherAabbTree.nodeVector().empty()) {
+        return;
+    }
+
+    OverlapTask overlapTask;
+    overlapTask.mNodeIndex = 0;
+    overlapTask.mOtherNodeIndex = 0;
+    overlapTask.mWithinSubtree = false;
+    findOverlappingPairsForTask(otherAabbTree, overlapTask, tolerance, threadCount,
+        objectIndexPairVector, aabbTreeStatistics);
 }
 
 template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::averageObjectTestsPerQuery() const
+void
+AabbTree<OBJECT>::findSelfOverlappingPairs(float tolerance, unsigned threadCount,
+    ObjectIndexPairVector *objectIndexPairVector,
+    AabbTreeStatistics *aabbTreeStatistics) const
 {
-    if (mQueries == 0) {
-        return 0;
+    assert(objectIndexPairVector != NULL);
+
+    objectIndexPairVector->clear();
+
+    if (mNodeVector.empty()) {
+        return;
     }
 
-    return mObjectTests/mQueries;
+    OverlapTask overlapTask;
+    overlapTask.mNodeIndex = 0;
+    overlapTask.mOtherNodeIndex = 0;
+    overlapTask.mWithinSubtree = true;
+    findOverlappingPairsForTask(*this, overlapTask, tolerance, threadCount,
+        objectIndexPairVector, aabbTreeStatistics);
 }
 
 template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::minObjectTestsPerQuery() const
+size_t
+AabbTree<OBJECT>::bytesUsed() const
 {
-    return mMinObjectTestsPerQuery;
+    return mNodeVector.capacity()*sizeof(Node)
+        + mObjectVector.capacity()*sizeof(OBJECT)
+        + (mFreeNodePairVector.capacity() + mFreeObjectVector.capacity())*sizeof(unsigned);
 }
 
 template<typename OBJECT>
-unsigned 
-AabbTree<OBJECT>::maxObjectTestsPerQuery() const
+std::string
+AabbTree<OBJECT>::memoryStatistics() const
 {
-    return mMaxObjectTestsPerQuery;
+    std::ostringstream ostr;
+
+    ostr << "Nodes: " << mNodeVector.size() << " ("
+        << mNodeVector.capacity()*sizeof(Node) << " bytes)" << std::endl;
+    ostr << "Objects: " << mObjectVector.size() << " ("
+        << mObjectVector.capacity()*sizeof(OBJECT) << " bytes)" << std::endl;
+    ostr << "Free lists: "
+        << (mFreeNodePairVector.capacity() + mFreeObjectVector.capacity())*sizeof(unsigned)
+        << " bytes" << std::endl;
+    ostr << "Total: " << bytesUsed() << " bytes";
+
+    return ostr.str();
 }
 
 template<typename OBJECT>
-void
-AabbTree<OBJECT>::deleteAabbTreeNodeAndDescendants(
-    AabbTreeNode<OBJECT> *aabbTreeNode)
+const typename AabbTree<OBJECT>::NodeVector &
+AabbTree<OBJECT>::nodeVector() const
 {
-    if (aabbTreeNode->leftNode() != NULL) {
-        deleteAabbTreeNodeAndDescendants(aabbTreeNode->leftNode());
-    }
-
-    if (aabbTreeNode->rightNode() != NULL) {
-        deleteAabbTreeNodeAndDescendants(aabbTreeNode->rightNode());
-    }
-
-    delete aabbTreeNode;
+    return mNodeVector;
 }
 
 template<typename OBJECT>
-AabbTreeNode<OBJECT> *
-AabbTree<OBJECT>::createAabbSubtree(ObjectPtrVectorIterator first,
-    ObjectPtrVectorIterator last, unsigned level)
+const typename AabbTree<OBJECT>::ObjectVector &
+AabbTree<OBJECT>::objectVector() const
 {
-    // Create the new node at the top of the subtree.
-    AabbTreeNode<OBJECT> *aabbTreeNode = new AabbTreeNode<OBJECT>;
+    return mObjectVector;
+}
 
-    if (level + 1 > mDepth) {
-        mDepth = level + 1;
-        mNodesAtLevel.resize(mDepth, 0);
-        mMinSizeAtLevel.resize(mDepth, std::numeric_limits<float>::max());
-        mMaxSizeAtLevel.resize(mDepth, 0.0);
-        mAverageSizeAtLevel.resize(mDepth, 0.0);
-    }
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::restore(const NodeVector &nodeVector, const ObjectVector &objectVector)
+{
+    clear();
 
-    assert(level < mNodesAtLevel.size());
+    // The statistics gathered by initialize aren't saved.
+    mDepth = 0;
+    mNodesAtLevel.clear();
+    mMinSizeAtLevel.clear();
+    mMaxSizeAtLevel.clear();
+    mAverageSizeAtLevel.clear();
 
-    ++mNodesAtLevel[level];
-    
-    // Compute the bounding box of all of the objects in the range.
-    BoundingBox3f boundingBox;
-    boundingBox.reset();
-    for (ObjectPtrVectorIterator iterator = first; iterator != last; ++iterator) {
-        const ObjectPtr &objectPtr = *iterator;
-        const OBJECT &object = *objectPtr.mObject;
-        const BoundingBox3f &objectBoundingBox = object.boundingBox();
-        boundingBox.extendByVector3f(objectBoundingBox.min());
-        boundingBox.extendByVector3f(objectBoundingBox.max());
+    if (nodeVector.empty()) {
+        return objectVector.empty();
     }
 
-    assert(!boundingBox.empty());
-
-    aabbTreeNode->setBoundingBox(boundingBox);
-
-    // Determine the longest axis of the objects in the range.
+    // Verify that every node refers to nodes and objects that exist,
+    // so that a corrupt file can't cause queries to crash. A tree with
+    // more nodes than the node vector must contain a cycle.
+    // The nodes and objects that the tree refers to are recorded,
+    // so that the rest can be returned to the free lists.
+    std::vector<bool> nodeIsUsedVector(nodeVector.size(), false);
+    std::vector<bool> objectIsUsedVector(objectVector.size(), false);
+    std::vector<unsigned> stack;
+    stack.push_back(0);
+    size_t visitedNodeCount = 0;
+    while (!stack.empty()) {
+        unsigned nodeIndex = stack.back();
+        const Node &node = nodeVector[nodeIndex];
+        stack.pop_back();
+        if (++visitedNodeCount > nodeVector.size()) {
+            return false;
+        }
+        nodeIsUsedVector[nodeIndex] = true;
+        if (node.isLeaf()) {
+            if (node.mIndex > objectVector.size()
+                || node.mObjectCount > objectVector.size() - node.mIndex) {
+                return false;
+            }
+            std::fill(objectIsUsedVector.begin() + node.mIndex,
+                objectIsUsedVector.begin() + node.mIndex + node.mObjectCount, true);
+        } else {
+            if (node.mIndex >= nodeVector.size() - 1) {
+                return false;
+            }
+            stack.push_back(node.mIndex);
+            stack.push_back(node.mIndex + 1);
+        }
+    }
+
+    mNodeVector = nodeVector;
+    mObjectVector = objectVector;
+
+    // The root node is followed by pairs of sibling nodes, so the
+    // node pairs that removeObject freed are those at odd indices
+    // that no node refers to.
+    for (unsigned nodeIndex = 1; nodeIndex + 1 < nodeVector.size(); nodeIndex += 2) {
+        if (!nodeIsUsedVector[nodeIndex] && !nodeIsUsedVector[nodeIndex + 1]) {
+            mFreeNodePairVector.push_back(nodeIndex);
+        }
+    }
+    for (unsigned objectIndex = 0; objectIndex < objectVector.size(); ++objectIndex) {
+        if (!objectIsUsedVector[objectIndex]) {
+            mFreeObjectVector.push_back(objectIndex);
+        }
+    }
+
+    return true;
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::allocateNodePair()
+{
+    if (!mFreeNodePairVector.empty()) {
+        unsigned nodeIndex = mFreeNodePairVector.back();
+        mFreeNodePairVector.pop_back();
+        return nodeIndex;
+    }
+
+    unsigned nodeIndex = mNodeVector.size();
+    mNodeVector.resize(nodeIndex + 2);
+
+    return nodeIndex;
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::allocateObject(const OBJECT &object)
+{
+    if (!mFreeObjectVector.empty()) {
+        unsigned objectIndex = mFreeObjectVector.back();
+        mFreeObjectVector.pop_back();
+        mObjectVector[objectIndex] = object;
+        return objectIndex;
+    }
+
+    mObjectVector.push_back(object);
+
+    return mObjectVector.size() - 1;
+}
+
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::removeObjectFromSubtree(unsigned nodeIndex, const OBJECT &object,
+    const BoundingBox3f &objectBoundingBox)
+{
+    // The object can only be in this subtree if the node's bounding box contains it.
+    if (!BoundingBox3fContainsBoundingBox3f(mNodeVector[nodeIndex].mBoundingBox,
+            objectBoundingBox)) {
+        return false;
+    }
+
+    if (mNodeVector[nodeIndex].isLeaf()) {
+        Node &node = mNodeVector[nodeIndex];
+        unsigned lastIndex = node.mIndex + node.mObjectCount - 1;
+        for (unsigned index = node.mIndex; index <= lastIndex; ++index) {
+            if (mObjectVector[index] == object) {
+                // Fill the gap with the last object in the leaf node,
+                // so that the node's objects remain contiguous.
+                mObjectVector[index] = mObjectVector[lastIndex];
+                mFreeObjectVector.push_back(lastIndex);
+                --node.mObjectCount;
+                if (node.mObjectCount > 0) {
+                    refitNode(nodeIndex);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned childIndex = mNodeVector[nodeIndex].mIndex;
+    for (unsigned index = childIndex; index < childIndex + 2; ++index) {
+        bool wasLeaf = mNodeVector[index].isLeaf();
+        if (!removeObjectFromSubtree(index, object, objectBoundingBox)) {
+            continue;
+        }
+
+        // A leaf node that no longer contains any objects is removed
+        // from the tree, and its sibling takes the place of their parent.
+        if (wasLeaf && mNodeVector[index].mObjectCount == 0) {
+            unsigned siblingIndex = index == childIndex ? childIndex + 1 : childIndex;
+            mNodeVector[nodeIndex] = mNodeVector[siblingIndex];
+            mFreeNodePairVector.push_back(childIndex);
+        } else {
+            refitNode(nodeIndex);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::refitSubtree(unsigned nodeIndex)
+{
+    if (!mNodeVector[nodeIndex].isLeaf()) {
+        refitSubtree(mNodeVector[nodeIndex].mIndex);
+        refitSubtree(mNodeVector[nodeIndex].mIndex + 1);
+    }
+
+    refitNode(nodeIndex);
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::refitNode(unsigned nodeIndex)
+{
+    Node &node = mNodeVector[nodeIndex];
+
+    if (!node.isLeaf()) {
+        node.mBoundingBox = mNodeVector[node.mIndex].mBoundingBox;
+        node.mBoundingBox.extendByBoundingBox3f(mNodeVector[node.mIndex + 1].mBoundingBox);
+        return;
+    }
+
+    node.mBoundingBox.reset();
+    for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount; ++index) {
+        node.mBoundingBox.extendByBoundingBox3f(mObjectVector[index].boundingBox());
+    }
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::createAabbSubtree(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+    ObjectPtrVectorIterator first, ObjectPtrVectorIterator last, unsigned level,
+    unsigned threadCount) const
+{
+    // The work of splitting a node is only divided among threads
+    // if the node contains enough objects.
+    unsigned rangeThreadCount = last - first >= PARALLEL_BUILD_MINIMUM_OBJECTS
+        ? threadCount : 1;
+
+    // Compute the bounding box of all of the objects in the range,
+    // and of their midpoints.
+    BoundsFunctor boundsFunctor;
+    ReduceInParallel(first, last, &boundsFunctor, rangeThreadCount);
+    const BoundingBox3f &boundingBox = boundsFunctor.boundingBox();
+
+    assert(!boundingBox.empty());
+
+    subtreeBuild->mNodeVector[nodeIndex].mBoundingBox = boundingBox;
+
+    // Determine the longest axis of the objects in the range.
     unsigned longestAxis = 0;
     const Vector3f &size = boundingBox.max() - boundingBox.min();
     if (size[0] >= size[1] && size[0] >= size[2]) {
@@ -639,72 +1570,527 @@ AabbTree<OBJECT>::createAabbSubtree(ObjectPtrVectorIterator first,
         longestAxis = 2;
     }
 
-    assert(level < mMinSizeAtLevel.size());
-    assert(level < mMaxSizeAtLevel.size());
-    assert(level < mAverageSizeAtLevel.size());
+    subtreeBuild->addNodeSize(level, size[longestAxis]);
 
-    if (size[longestAxis] < mMinSizeAtLevel[level]) {
-        mMinSizeAtLevel[level] = size[longestAxis];
-    }
-    if (size[longestAxis] > mMaxSizeAtLevel[level]) {
-        mMaxSizeAtLevel[level] = size[longestAxis];
+    // Note that allocateNodePair may reallocate the node vector, so references
+    // to its elements must not be held across calls to it.
+    if (mSplitStrategy == SURFACE_AREA_HEURISTIC) {
+        ObjectPtrVectorIterator split;
+        if (!partitionBySurfaceAreaHeuristic(first, last, boundingBox,
+                boundsFunctor.midpointBoundingBox(), rangeThreadCount, &split)) {
+            createLeafNode(subtreeBuild, nodeIndex, first, last);
+            return;
+        }
+
+        unsigned childIndex = subtreeBuild->allocateNodePair();
+        subtreeBuild->mNodeVector[nodeIndex].mIndex = childIndex;
+        subtreeBuild->mNodeVector[nodeIndex].mObjectCount = 0;
+        createAabbSubtreePair(subtreeBuild, childIndex, first, split, last, level + 1,
+            threadCount);
+
+        return;
     }
-    mAverageSizeAtLevel[level] += size[longestAxis];
 
-    // Sort the objects by size (largest objects first).
+    // Find all the objects that are as large as the
+    // bounding box along the chosen axis, and move them
+    // to the start of the range, largest first. These are placed
+    // in a leaf node that is the left child of this node,
+    // which places large objects higher up in the tree,
+    // so that they're encountered first during traversal.
+    ObjectPtrVectorIterator large = partitionObjectPtrs(first, last,
+        LargeObjectPredicate(longestAxis, boundingBox), rangeThreadCount);
     SortBySizeFunctor sortBySizeFunctor;
     sortBySizeFunctor.setAxis(longestAxis);
-    std::sort(first, last, sortBySizeFunctor);
+    std::sort(first, large, sortBySizeFunctor);
 
-    // Find all the objects that are as large as the
-    // bounding box along the chosen axis and add them
-    // to the node. This places large objects higher up
-    // in the tree, so that they're encountered first
-    // during traversal.
-    while (first != last
-        && ((*first).mObject->boundingBox().maxAxis(longestAxis)
-            - (*first).mObject->boundingBox().minAxis(longestAxis))
-        /(boundingBox.maxAxis(longestAxis) 
-            - boundingBox.minAxis(longestAxis))
-        > 0.9999) {
-        aabbTreeNode->addObject(*(first->mObject));
-        ++first;
-    }
-
-    // If all the objects have been placed in the node,
-    // return it.
-    if (first == last) {
-        return aabbTreeNode;
-    }
-
-    // If there's only a small number of objects left in the range, add them to the
-    // node and return.
+    // If there's only a small number of objects left in the range,
+    // place them all in a leaf node.
     // Experimentally, this seems to work best with one object per leaf node.
-    if (last - first <= 1) {
+    if (last - large <= 1) {
+        createLeafNode(subtreeBuild, nodeIndex, first, last);
+        return;
+    }
+
+    unsigned childIndex = subtreeBuild->allocateNodePair();
+    subtreeBuild->mNodeVector[nodeIndex].mIndex = childIndex;
+    subtreeBuild->mNodeVector[nodeIndex].mObjectCount = 0;
+
+    if (large != first) {
+        createLeafNode(subtreeBuild, childIndex, first, large);
+        createAabbSubtree(subtreeBuild, childIndex + 1, large, last, level + 1, threadCount);
+        return;
+    }
+
+    // Find the median object in the range along the longest axis
+    // by the objects' midpoints, and create two subtrees, using that
+    // object as the partition. Only the partition matters, so the
+    // objects on either side of it aren't sorted.
+    ObjectPtrVectorIterator median = first + (last - first)/2;
+    SortByMidpointFunctor sortByMidpointFunctor;
+    sortByMidpointFunctor.setAxis(longestAxis);
+    NthElementInParallel(first, median, last, sortByMidpointFunctor, rangeThreadCount);
+
+    // We must have broken up the range into two non-empty ranges.
+    assert(median != first);
+    assert(median != last);
+
+    // Create the two subtrees hanging off this node.
+    createAabbSubtreePair(subtreeBuild, childIndex, first, median, last, level + 1,
+        threadCount);
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::createAabbSubtreePair(SubtreeBuild *subtreeBuild, unsigned childIndex,
+    ObjectPtrVectorIterator first, ObjectPtrVectorIterator split,
+    ObjectPtrVectorIterator last, unsigned level, unsigned threadCount) const
+{
+    if (threadCount <= 1 || last - first < PARALLEL_BUILD_MINIMUM_OBJECTS) {
+        createAabbSubtree(subtreeBuild, childIndex, first, split, level, threadCount);
+        createAabbSubtree(subtreeBuild, childIndex + 1, split, last, level, threadCount);
+        return;
+    }
+
+    // The threads are divided between the two subtrees. The left subtree
+    // is built by a new thread, and the right subtree by this one.
+    unsigned leftThreadCount = threadCount/2;
+    SubtreeBuild leftSubtreeBuild(subtreeBuild->mObjectPtrBegin, split - first);
+    SubtreeBuild rightSubtreeBuild(subtreeBuild->mObjectPtrBegin, last - split);
+    boost::thread thread(CreateAabbSubtreeTask(this, &leftSubtreeBuild, first, split,
+            leftThreadCount));
+    createAabbSubtree(&rightSubtreeBuild, 0, split, last, 0, threadCount - leftThreadCount);
+    thread.join();
+
+    // A single thread would have created all of the left subtree's
+    // nodes before those of the right subtree.
+    spliceSubtree(subtreeBuild, childIndex, leftSubtreeBuild, level);
+    spliceSubtree(subtreeBuild, childIndex + 1, rightSubtreeBuild, level);
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::spliceSubtree(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+    const SubtreeBuild &childSubtreeBuild, unsigned level) const
+{
+    const NodeVector &childNodeVector = childSubtreeBuild.mNodeVector;
+
+    // The nodes below the root of the subtree are appended to the node vector,
+    // so the child indices of the internal nodes are offset by the difference
+    // between the old and new positions of those nodes.
+    unsigned offset = subtreeBuild->mNodeVector.size() - 1;
+
+    Node node = childNodeVector[0];
+    if (!node.isLeaf()) {
+        node.mIndex += offset;
+    }
+    subtreeBuild->mNodeVector[nodeIndex] = node;
+
+    for (unsigned index = 1; index < childNodeVector.size(); ++index) {
+        node = childNodeVector[index];
+        if (!node.isLeaf()) {
+            node.mIndex += offset;
+        }
+        subtreeBuild->mNodeVector.push_back(node);
+    }
+
+    unsigned childDepth = childSubtreeBuild.mNodesAtLevel.size();
+    subtreeBuild->extendToDepth(level + childDepth);
+    for (unsigned childLevel = 0; childLevel < childDepth; ++childLevel) {
+        unsigned parentLevel = level + childLevel;
+        subtreeBuild->mNodesAtLevel[parentLevel]
+            += childSubtreeBuild.mNodesAtLevel[childLevel];
+        subtreeBuild->mMinSizeAtLevel[parentLevel] = std::min(
+            subtreeBuild->mMinSizeAtLevel[parentLevel],
+            childSubtreeBuild.mMinSizeAtLevel[childLevel]);
+        subtreeBuild->mMaxSizeAtLevel[parentLevel] = std::max(
+            subtreeBuild->mMaxSizeAtLevel[parentLevel],
+            childSubtreeBuild.mMaxSizeAtLevel[childLevel]);
+        subtreeBuild->mAverageSizeAtLevel[parentLevel]
+            += childSubtreeBuild.mAverageSizeAtLevel[childLevel];
+    }
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::createLeafNode(SubtreeBuild *subtreeBuild, unsigned nodeIndex,
+    ObjectPtrVectorIterator first, ObjectPtrVectorIterator last) const
+{
+    Node &node = subtreeBuild->mNodeVector[nodeIndex];
+    node.mBoundingBox.reset();
+    node.mIndex = first - subtreeBuild->mObjectPtrBegin;
+    node.mObjectCount = last - first;
+
+    for (ObjectPtrVectorIterator iterator = first; iterator != last; ++iterator) {
+        node.mBoundingBox.extendByBoundingBox3f((*iterator).mObject->boundingBox());
+    }
+}
+
+template<typename OBJECT>
+template<typename PREDICATE>
+typename AabbTree<OBJECT>::ObjectPtrVectorIterator
+AabbTree<OBJECT>::partitionObjectPtrs(ObjectPtrVectorIterator first,
+    ObjectPtrVectorIterator last, PREDICATE predicate, unsigned threadCount) const
+{
+    // Whether the stable algorithm is used depends only on the number
+    // of objects, so that the order of the objects is the same no matter
+    // how many threads there are.
+    if (last - first < PARALLEL_BUILD_MINIMUM_OBJECTS) {
+        return std::partition(first, last, predicate);
+    }
+
+    return StablePartitionInParallel(first, last, predicate, threadCount);
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::SubtreeBuild::SubtreeBuild(ObjectPtrVectorIterator objectPtrBegin,
+    size_t objectCount)
+    : mObjectPtrBegin(objectPtrBegin),
+      mNodeVector(),
+      mNodesAtLevel(),
+      mMinSizeAtLevel(),
+      mMaxSizeAtLevel(),
+      mAverageSizeAtLevel()
+{
+    // A binary tree with one object per leaf node has fewer than
+    // twice as many nodes as objects.
+    mNodeVector.reserve(2*objectCount);
+    mNodeVector.resize(1);
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::SubtreeBuild::allocateNodePair()
+{
+    unsigned nodeIndex = mNodeVector.size();
+    mNodeVector.resize(nodeIndex + 2);
+
+    return nodeIndex;
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::SubtreeBuild::extendToDepth(unsigned depth)
+{
+    if (depth > mNodesAtLevel.size()) {
+        mNodesAtLevel.resize(depth, 0);
+        mMinSizeAtLevel.resize(depth, std::numeric_limits<float>::max());
+        mMaxSizeAtLevel.resize(depth, 0.0);
+        mAverageSizeAtLevel.resize(depth, 0.0);
+    }
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::SubtreeBuild::addNodeSize(unsigned level, float size)
+{
+    extendToDepth(level + 1);
+
+    ++mNodesAtLevel[level];
+    if (size < mMinSizeAtLevel[level]) {
+        mMinSizeAtLevel[level] = size;
+    }
+    if (size > mMaxSizeAtLevel[level]) {
+        mMaxSizeAtLevel[level] = size;
+    }
+    mAverageSizeAtLevel[level] += size;
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::CreateAabbSubtreeTask::CreateAabbSubtreeTask(const AabbTree *aabbTree,
+    SubtreeBuild *subtreeBuild, ObjectPtrVectorIterator first,
+    ObjectPtrVectorIterator last, unsigned threadCount)
+    : mAabbTree(aabbTree),
+      mSubtreeBuild(subtreeBuild),
+      mFirst(first),
+      mLast(last),
+      mThreadCount(threadCount)
+{
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::CreateAabbSubtreeTask::operator()()
+{
+    mAabbTree->createAabbSubtree(mSubtreeBuild, 0, mFirst, mLast, 0, mThreadCount);
+}
+
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::partitionBySurfaceAreaHeuristic(ObjectPtrVectorIterator first,
+    ObjectPtrVectorIterator last, const BoundingBox3f &boundingBox,
+    const BoundingBox3f &midpointBoundingBox, unsigned threadCount,
+    ObjectPtrVectorIterator *split) const
+{
+    unsigned objectCount = last - first;
+    bool mayBeLeaf = objectCount <= SURFACE_AREA_HEURISTIC_MAXIMUM_LEAF_OBJECTS;
+
+    if (objectCount <= 1) {
+        return false;
+    }
+
+    // The objects are binned by their midpoints.
+    BinningFunctor binningFunctor(midpointBoundingBox);
+    ReduceInParallel(first, last, &binningFunctor, threadCount);
+
+    // The cost of testing every object in a leaf node. The costs of a bounding
+    // box test and an object test are both taken to be one.
+    float bestCost = objectCount;
+    unsigned bestAxis = 0;
+    unsigned bestBin = 0;
+    bool foundSplit = false;
+
+    float parentArea = GetBoundingBox3fSurfaceArea(boundingBox);
+
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        if (!binningFunctor.axisIsBinned(axis) || parentArea <= 0.0) {
+            continue;
+        }
+
+        // Sweep from the right to find the area and object count
+        // to the right of each candidate split.
+        float rightArea[SURFACE_AREA_HEURISTIC_BINS];
+        unsigned rightCount[SURFACE_AREA_HEURISTIC_BINS];
+        BoundingBox3f accumulatedBoundingBox;
+        accumulatedBoundingBox.reset();
+        unsigned accumulatedCount = 0;
+        for (unsigned bin = SURFACE_AREA_HEURISTIC_BINS - 1; bin > 0; --bin) {
+            accumulatedBoundingBox.extendByBoundingBox3f(
+                binningFunctor.binBoundingBox(axis, bin));
+            accumulatedCount += binningFunctor.binCount(axis, bin);
+            rightArea[bin] = GetBoundingBox3fSurfaceArea(accumulatedBoundingBox);
+            rightCount[bin] = accumulatedCount;
+        }
+
+        // Sweep from the left, evaluating the split after each bin.
+        accumulatedBoundingBox.reset();
+        accumulatedCount = 0;
+        for (unsigned bin = 0; bin < SURFACE_AREA_HEURISTIC_BINS - 1; ++bin) {
+            accumulatedBoundingBox.extendByBoundingBox3f(
+                binningFunctor.binBoundingBox(axis, bin));
+            accumulatedCount += binningFunctor.binCount(axis, bin);
+            if (accumulatedCount == 0 || rightCount[bin + 1] == 0) {
+                continue;
+            }
+            float cost = 1.0 + (GetBoundingBox3fSurfaceArea(accumulatedBoundingBox)
+                *accumulatedCount + rightArea[bin + 1]*rightCount[bin + 1])/parentArea;
+            if (cost < bestCost || !foundSplit) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+                foundSplit = true;
+            }
+        }
+    }
+
+    if (!foundSplit) {
+        // All the midpoints coincide, so the objects can't be told apart.
+        // Keep them in a leaf node if there aren't too many, and otherwise
+        // split them arbitrarily.
+        if (mayBeLeaf) {
+            return false;
+        }
+        *split = first + objectCount/2;
+        return true;
+    }
+
+    if (mayBeLeaf && bestCost >= objectCount) {
+        return false;
+    }
+
+    float minimum = midpointBoundingBox.minAxis(bestAxis);
+    float scale = SURFACE_AREA_HEURISTIC_BINS
+        /(midpointBoundingBox.maxAxis(bestAxis) - minimum);
+    *split = partitionObjectPtrs(first, last,
+        BinPartitionFunctor(bestAxis, minimum, scale, bestBin), threadCount);
+
+    // The split was only chosen if both sides of it were occupied.
+    assert(*split != first);
+    assert(*split != last);
+
+    return true;
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::BinPartitionFunctor::BinPartitionFunctor(unsigned axis, float minimum,
+    float scale, unsigned lastBin)
+    : mAxis(axis),
+      mMinimum(minimum),
+      mScale(scale),
+      mLastBin(lastBin)
+{
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::BinPartitionFunctor::bin(const ObjectPtr &objectPtr) const
+{
+    int bin = int((objectPtr.mMidpoint[mAxis] - mMinimum)*mScale);
+    return std::min(std::max(bin, 0), int(SURFACE_AREA_HEURISTIC_BINS) - 1);
+}
+
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::BinPartitionFunctor::operator()(const ObjectPtr &objectPtr) const
+{
+    return bin(objectPtr) <= mLastBin;
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::BinningFunctor::BinningFunctor(const BoundingBox3f &midpointBoundingBox)
+{
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        mMinimum[axis] = midpointBoundingBox.minAxis(axis);
+        float extent = midpointBoundingBox.maxAxis(axis) - mMinimum[axis];
+        mAxisIsBinned[axis] = extent > 0.0;
+        mScale[axis] = mAxisIsBinned[axis] ? SURFACE_AREA_HEURISTIC_BINS/extent : 0.0;
+        for (unsigned bin = 0; bin < SURFACE_AREA_HEURISTIC_BINS; ++bin) {
+            mBinBoundingBox[axis][bin].reset();
+            mBinCount[axis][bin] = 0;
+        }
+    }
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::BinningFunctor::operator()(ObjectPtrVectorIterator first,
+    ObjectPtrVectorIterator last)
+{
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        if (!mAxisIsBinned[axis]) {
+            continue;
+        }
+        BinPartitionFunctor binPartitionFunctor(axis, mMinimum[axis], mScale[axis], 0);
         for (ObjectPtrVectorIterator iterator = first; iterator != last; ++iterator) {
-            aabbTreeNode->addObject(*((*iterator).mObject));
+            const ObjectPtr &objectPtr = *iterator;
+            unsigned bin = binPartitionFunctor.bin(objectPtr);
+            mBinBoundingBox[axis][bin].extendByVector3f(
+                objectPtr.mMidpoint - objectPtr.mSize/2.0);
+            mBinBoundingBox[axis][bin].extendByVector3f(
+                objectPtr.mMidpoint + objectPtr.mSize/2.0);
+            ++mBinCount[axis][bin];
         }
-        return aabbTreeNode;
     }
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::BinningFunctor::merge(const BinningFunctor &binningFunctor)
+{
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        for (unsigned bin = 0; bin < SURFACE_AREA_HEURISTIC_BINS; ++bin) {
+            mBinBoundingBox[axis][bin].extendByBoundingBox3f(
+                binningFunctor.mBinBoundingBox[axis][bin]);
+            mBinCount[axis][bin] += binningFunctor.mBinCount[axis][bin];
+        }
+    }
+}
+
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::BinningFunctor::axisIsBinned(unsigned axis) const
+{
+    return mAxisIsBinned[axis];
+}
+
+template<typename OBJECT>
+const BoundingBox3f &
+AabbTree<OBJECT>::BinningFunctor::binBoundingBox(unsigned axis, unsigned bin) const
+{
+    return mBinBoundingBox[axis][bin];
+}
+
+template<typename OBJECT>
+unsigned
+AabbTree<OBJECT>::BinningFunctor::binCount(unsigned axis, unsigned bin) const
+{
+    return mBinCount[axis][bin];
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::ObjectPtrInitializationFunctor::ObjectPtrInitializationFunctor(
+    ObjectPtrVectorIterator objectPtrBegin, ObjectVectorConstIterator objectBegin)
+    : mObjectPtrBegin(objectPtrBegin),
+      mObjectBegin(objectBegin)
+{
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::ObjectPtrInitializationFunctor::operator()(
+    ObjectPtrVectorIterator first, ObjectPtrVectorIterator last)
+{
+    ObjectVectorConstIterator objectIterator = mObjectBegin + (first - mObjectPtrBegin);
+    for (ObjectPtrVectorIterator iterator = first; iterator != last; ++iterator) {
+        const OBJECT &object = *objectIterator++;
+        ObjectPtr &objectPtr = *iterator;
+        const BoundingBox3f &boundingBox = object.boundingBox();
+        objectPtr.mMidpoint = (boundingBox.min() + boundingBox.max())/2.0;
+        objectPtr.mSize = boundingBox.max() - boundingBox.min();
+        objectPtr.mObject = &object;
+    }
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::BoundsFunctor::BoundsFunctor()
+    : mBoundingBox(),
+      mMidpointBoundingBox()
+{
+    mBoundingBox.reset();
+    mMidpointBoundingBox.reset();
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::BoundsFunctor::operator()(ObjectPtrVectorIterator first,
+    ObjectPtrVectorIterator last)
+{
+    for (ObjectPtrVectorIterator iterator = first; iterator != last; ++iterator) {
+        const ObjectPtr &objectPtr = *iterator;
+        const BoundingBox3f &objectBoundingBox = objectPtr.mObject->boundingBox();
+        mBoundingBox.extendByVector3f(objectBoundingBox.min());
+        mBoundingBox.extendByVector3f(objectBoundingBox.max());
+        mMidpointBoundingBox.extendByVector3f(objectPtr.mMidpoint);
+    }
+}
 
-    // Sort the objects along the longest axis by their midpoint.
-    SortByMidpointFunctor sortByMidpointFunctor;
-    sortByMidpointFunctor.setAxis(longestAxis);
-    std::sort(first, last, sortByMidpointFunctor);
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::BoundsFunctor::merge(const BoundsFunctor &boundsFunctor)
+{
+    mBoundingBox.extendByBoundingBox3f(boundsFunctor.mBoundingBox);
+    mMidpointBoundingBox.extendByBoundingBox3f(boundsFunctor.mMidpointBoundingBox);
+}
 
-    // Find the median object in the range, and create two
-    // subtrees, using that object as the partition.
-    ObjectPtrVectorIterator median = first + (last - first)/2;
+template<typename OBJECT>
+const BoundingBox3f &
+AabbTree<OBJECT>::BoundsFunctor::boundingBox() const
+{
+    return mBoundingBox;
+}
 
-    // We must have broken up the range into two non-empty ranges.
-    assert(median != first);
-    assert(median != last);
-    
-    // Create the two subtrees hanging off this node.
-    aabbTreeNode->setLeftNode(createAabbSubtree(first, median, level + 1));
-    aabbTreeNode->setRightNode(createAabbSubtree(median, last, level + 1));
-    
-    return aabbTreeNode;
+template<typename OBJECT>
+const BoundingBox3f &
+AabbTree<OBJECT>::BoundsFunctor::midpointBoundingBox() const
+{
+    return mMidpointBoundingBox;
+}
+
+template<typename OBJECT>
+AabbTree<OBJECT>::LargeObjectPredicate::LargeObjectPredicate(unsigned axis,
+    const BoundingBox3f &boundingBox)
+    : mAxis(axis),
+      mMinimum(boundingBox.minAxis(axis)),
+      mMaximum(boundingBox.maxAxis(axis))
+{
+}
+
+template<typename OBJECT>
+bool
+AabbTree<OBJECT>::LargeObjectPredicate::operator()(const ObjectPtr &objectPtr) const
+{
+    const BoundingBox3f &objectBoundingBox = objectPtr.mObject->boundingBox();
+    return (objectBoundingBox.maxAxis(mAxis) - objectBoundingBox.minAxis(mAxis))
+        /(mMaximum - mMinimum) > 0.9999;
 }
 
 template<typename OBJECT>
@@ -719,7 +2105,11 @@ bool
 AabbTree<OBJECT>::SortBySizeFunctor::operator()(const ObjectPtr &lhs, 
     const ObjectPtr &rhs) const
 {
-    return lhs.mSize[mAxis] > rhs.mSize[mAxis];
+    if (lhs.mSize[mAxis] != rhs.mSize[mAxis]) {
+        return lhs.mSize[mAxis] > rhs.mSize[mAxis];
+    }
+
+    return lhs.mObject < rhs.mObject;
 }
 
 template<typename OBJECT>
@@ -734,85 +2124,88 @@ bool
 AabbTree<OBJECT>::SortByMidpointFunctor::operator()(const ObjectPtr &lhs, 
     const ObjectPtr &rhs) const
 {
-    return lhs.mMidpoint[mAxis] < rhs.mMidpoint[mAxis];
+    if (lhs.mMidpoint[mAxis] != rhs.mMidpoint[mAxis]) {
+        return lhs.mMidpoint[mAxis] < rhs.mMidpoint[mAxis];
+    }
+
+    return lhs.mObject < rhs.mObject;
 }
 
-template<typename OBJECT> 
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
 void
-AabbTree<OBJECT>::applyToBoundingBoxIntersectionForSubtree(
-    AabbTreeNode<OBJECT> *aabbTreeNode,
+AabbTree<OBJECT>::applyToBoundingBoxIntersectionForSubtree(unsigned nodeIndex,
     bool *halted, const BoundingBox3f &boundingBox,
-    BoundingBoxListener *boundingBoxListener) const
+    BoundingBoxListener *boundingBoxListener,
+    QUERY_COUNTER *queryCounter) const
 {
     if (*halted) {
         return;
     }
 
     while (true) {
-        ++mBoundingBoxTests;
-        ++mCurrentQueryBoundingBoxTests;
+        const Node &node = mNodeVector[nodeIndex];
+
+        queryCounter->countBoundingBoxTest();
 
         // If the specified bounding box doesn't intersect
         // the node's bounding box, skip this subtree.
-        if (!BoundingBox3fIntersectsBoundingBox3f(boundingBox, aabbTreeNode->boundingBox())) {
+        if (!BoundingBox3fIntersectsBoundingBox3f(boundingBox, node.mBoundingBox)) {
             return;
         }
 
-        // Evaluate the callback on all of the objects in this node.
-        for (typename AabbTreeNode<OBJECT>::ObjectVectorIterator iterator
-                 = aabbTreeNode->objectBegin();
-             iterator != aabbTreeNode->objectEnd(); ++iterator) {
-            OBJECT &object = *iterator;
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
 
-            ++mObjectTests;
-            ++mCurrentQueryObjectTests;
+                queryCounter->countObjectTest();
 
-            // If the callback returns true, skip all further processing.
-            if (boundingBoxListener->applyObjectToBoundingBox(object, boundingBox)) {
-                *halted = true;
-                return;
+                // If the callback returns true, skip all further processing.
+                if (boundingBoxListener->applyObjectToBoundingBox(object, boundingBox)) {
+                    *halted = true;
+                    return;
+                }
             }
+            return;
         }
 
         // Evaluate the left subtree.
-        if (aabbTreeNode->leftNode() != NULL) {
-            applyToBoundingBoxIntersectionForSubtree(aabbTreeNode->leftNode(),
-                halted, boundingBox, boundingBoxListener);
-            if (*halted) {
-                return;
-            }
+        applyToBoundingBoxIntersectionForSubtree(node.mIndex,
+            halted, boundingBox, boundingBoxListener, queryCounter);
+        if (*halted) {
+            return;
         }
 
-        // To avoid function call overhead, loop on the right subtree.
+        // To avoid function call overhead, loop on the right subtree
         // rather than using recursion.
-        if (aabbTreeNode->rightNode() != NULL) {
-            aabbTreeNode = aabbTreeNode->rightNode();
-        } else {
-            break;
-        }
+        nodeIndex = node.mIndex + 1;
     }
 }
 
 template<typename OBJECT>
+template<typename QUERY_COUNTER>
 void
-AabbTree<OBJECT>::applyToTriangleVectorIntersectionForSubtree(
-    AabbTreeNode<OBJECT> *aabbTreeNode, 
+AabbTree<OBJECT>::applyToTriangleVectorIntersectionForSubtree(unsigned nodeIndex,
     bool *halted, const TriangleVector &triangleVector,
-    TriangleListener *triangleListener) const
+    TriangleListener *triangleListener,
+    QUERY_COUNTER *queryCounter) const
 {
     if (*halted) {
         return;
     }
 
     while (true) {
-        ++mBoundingBoxTests;
-        ++mCurrentQueryBoundingBoxTests;
+        const Node &node = mNodeVector[nodeIndex];
+
+        queryCounter->countBoundingBoxTest();
 
         // If none of the specified triangles intersect
         // the node's bounding box, skip this subtree.
         bool foundIntersection = false;
         for (unsigned index = 0; index < triangleVector.size(); ++index) {
-            if (BoundingBox3fIntersectsTriangle(aabbTreeNode->boundingBox(), 
+            if (BoundingBox3fIntersectsTriangle(node.mBoundingBox,
                     triangleVector[index].mPointArray[0],
                     triangleVector[index].mPointArray[1],
                     triangleVector[index].mPointArray[2])) {
@@ -824,251 +2217,718 @@ AabbTree<OBJECT>::applyToTriangleVectorIntersectionForSubtree(
             return;
         }
 
-        // Evaluate the callback on all of the objects in this node.
-        for (typename AabbTreeNode<OBJECT>::ObjectVectorIterator iterator
-                 = aabbTreeNode->objectBegin();
-             iterator != aabbTreeNode->objectEnd(); ++iterator) {
-            OBJECT &object = *iterator;
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
 
-            ++mObjectTests;
-            ++mCurrentQueryObjectTests;
+                queryCounter->countObjectTest();
 
-            // If the callback returns true, skip all further processing.
-            if (triangleListener->applyObjectToTriangleVector(object, triangleVector)) {
-                *halted = true;
-                return;
+                // If the callback returns true, skip all further processing.
+                if (triangleListener->applyObjectToTriangleVector(object, triangleVector)) {
+                    *halted = true;
+                    return;
+                }
             }
+            return;
         }
 
         // Evaluate the left subtree.
-        if (aabbTreeNode->leftNode() != NULL) {
-            applyToTriangleVectorIntersectionForSubtree(aabbTreeNode->leftNode(),
-                halted, triangleVector, triangleListener);
-            if (*halted) {
-                return;
-            }
+        applyToTriangleVectorIntersectionForSubtree(node.mIndex,
+            halted, triangleVector, triangleListener, queryCounter);
+        if (*halted) {
+            return;
         }
 
-        // To avoid function call overhead, loop on the right subtree.
+        // To avoid function call overhead, loop on the right subtree
         // rather than using recursion.
-        if (aabbTreeNode->rightNode() != NULL) {
-            aabbTreeNode = aabbTreeNode->rightNode();
-        } else {
-            break;
-        }
+        nodeIndex = node.mIndex + 1;
     }
 }
 
 template<typename OBJECT>
+template<typename QUERY_COUNTER>
 void
-AabbTree<OBJECT>::applyToTetrahedronIntersectionForSubtree(
-    AabbTreeNode<OBJECT> *aabbTreeNode, bool *halted, 
+AabbTree<OBJECT>::applyToTetrahedronIntersectionForSubtree(unsigned nodeIndex,
+    bool *halted,
     const Vector3f &v0, const Vector3f &v1, const Vector3f &v2, const Vector3f &v3,
-    TetrahedronListener *tetrahedronListener) const
+    TetrahedronListener *tetrahedronListener,
+    QUERY_COUNTER *queryCounter) const
 {
     if (*halted) {
         return;
     }
 
     while (true) {
-        ++mBoundingBoxTests;
-        ++mCurrentQueryBoundingBoxTests;
+        const Node &node = mNodeVector[nodeIndex];
+
+        queryCounter->countBoundingBoxTest();
 
         // If the tetrahedron doesn't intersect
         // the node's bounding box, skip this subtree.
-        if (!BoundingBox3fIntersectsTetrahedron(aabbTreeNode->boundingBox(), 
-                v0, v1, v2, v2)) {
+        if (!BoundingBox3fIntersectsTetrahedron(node.mBoundingBox,
+                v0, v1, v2, v3)) {
             return;
         }
 
-        // Evaluate the callback on all of the objects in this node.
-        for (typename AabbTreeNode<OBJECT>::ObjectVectorIterator iterator
-                 = aabbTreeNode->objectBegin();
-             iterator != aabbTreeNode->objectEnd(); ++iterator) {
-            OBJECT &object = *iterator;
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
 
-            ++mObjectTests;
-            ++mCurrentQueryObjectTests;
+                queryCounter->countObjectTest();
 
-            // If the callback returns true, skip all further processing.
-            if (tetrahedronListener->applyObjectToTetrahedron(object, v0, v1, v2, v3)) {
-                *halted = true;
-                return;
+                // If the callback returns true, skip all further processing.
+                if (tetrahedronListener->applyObjectToTetrahedron(object, v0, v1, v2, v3)) {
+                    *halted = true;
+                    return;
+                }
             }
+            return;
         }
 
         // Evaluate the left subtree.
-        if (aabbTreeNode->leftNode() != NULL) {
-            applyToTetrahedronIntersectionForSubtree(aabbTreeNode->leftNode(),
-                halted, v0, v1, v2, v3, tetrahedronListener);
-            if (*halted) {
-                return;
-            }
+        applyToTetrahedronIntersectionForSubtree(node.mIndex,
+            halted, v0, v1, v2, v3, tetrahedronListener, queryCounter);
+        if (*halted) {
+            return;
         }
 
-        // To avoid function call overhead, loop on the right subtree.
+        // To avoid function call overhead, loop on the right subtree
         // rather than using recursion.
-        if (aabbTreeNode->rightNode() != NULL) {
-            aabbTreeNode = aabbTreeNode->rightNode();
-        } else {
-            break;
-        }
+        nodeIndex = node.mIndex + 1;
     }
 }
 
 template<typename OBJECT>
-bool 
-AabbTree<OBJECT>::occludesRaySegmentForSubtree(
-    AabbTreeNode<OBJECT> *aabbTreeNode, bool *halted, 
-    const Vector3f &origin, const Vector3f &endpoint,
-    const RaySegmentOcclusionListener *raySegmentOcclusionListener) const
+template<typename QUERY_COUNTER>
+bool
+AabbTree<OBJECT>::occludesRaySegmentForSubtree(unsigned nodeIndex, bool *halted,
+    const RaySegment &raySegment,
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    QUERY_COUNTER *queryCounter) const
 {
     if (*halted) {
         return true;
     }
 
     while (true) {
-        ++mBoundingBoxTests;
-        ++mCurrentQueryBoundingBoxTests;
-
-        // If the ray segment does not intersect the bounding
-        // box of this node, don't bother testing the subtree
-        // any further.
-        if (!BoundingBox3fIntersectsRaySegment(aabbTreeNode->boundingBox(),
-                origin, endpoint)) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                const OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                // If the callback returns true, we've hit something,
+                // and there's no need to perform further tests.
+                if (raySegmentOcclusionListener->objectOccludesRaySegment(object,
+                        raySegment.origin(), raySegment.endpoint())) {
+                    *halted = true;
+                    return true;
+                }
+            }
             return false;
         }
 
-        // Evaluate the callback on all of the objects in this node.
-        for (typename AabbTreeNode<OBJECT>::ObjectVectorIterator iterator
-                 = aabbTreeNode->objectBegin();
-             iterator != aabbTreeNode->objectEnd(); ++iterator) {
-            OBJECT &object = *iterator;
-
-            ++mObjectTests;
-            ++mCurrentQueryObjectTests;
-            
-            // If the callback returns true, we've hit something,
-            // and there's no need to perform further tests.
-            if (raySegmentOcclusionListener->objectOccludesRaySegment(object, 
-                    origin, endpoint)) {
-                *halted = true;
-                return true;
-            }
-        }
-        
-        // Evaluate the left subtree.
-        if (aabbTreeNode->leftNode() != NULL) {
-            if (occludesRaySegmentForSubtree(
-                    aabbTreeNode->leftNode(), halted, origin, endpoint, 
-                    raySegmentOcclusionListener)) {
-                return true;
+        // Test the bounding boxes of both children here, rather than
+        // in the children themselves, so that the nearer child can be
+        // evaluated first. Occluders near the ray origin are found sooner.
+        unsigned nearIndex = node.mIndex;
+        unsigned farIndex = node.mIndex + 1;
+        float nearT = 0.0;
+        float farT = 0.0;
+        queryCounter->countBoundingBoxTest();
+        queryCounter->countBoundingBoxTest();
+        bool nearHit = raySegment.intersectsBoundingBox3f(
+            mNodeVector[nearIndex].mBoundingBox, 1.0, &nearT);
+        bool farHit = raySegment.intersectsBoundingBox3f(
+            mNodeVector[farIndex].mBoundingBox, 1.0, &farT);
+
+        if (nearHit && farHit) {
+            if (farT < nearT) {
+                std::swap(nearIndex, farIndex);
             }
-            if (*halted) {
+
+            // Evaluate the nearer subtree.
+            if (occludesRaySegmentForSubtree(nearIndex, halted, raySegment,
+                    raySegmentOcclusionListener, queryCounter)) {
                 return true;
             }
-        }
 
-        // To avoid function call overhead, loop on the right subtree.
-        // rather than using recursion.
-        if (aabbTreeNode->rightNode() != NULL) {
-            aabbTreeNode = aabbTreeNode->rightNode();
+            // To avoid function call overhead, loop on the farther subtree
+            // rather than using recursion.
+            nodeIndex = farIndex;
+        } else if (nearHit) {
+            nodeIndex = nearIndex;
+        } else if (farHit) {
+            nodeIndex = farIndex;
         } else {
-            break;
+            return false;
         }
     }
-    
-    return false;
 }
 
 template<typename OBJECT>
-bool 
-AabbTree<OBJECT>::intersectsRaySegmentForSubtree(
-    AabbTreeNode<OBJECT> *aabbTreeNode,
-    const Vector3f &origin, const Vector3f &endpoint, 
+template<typename QUERY_COUNTER>
+bool
+AabbTree<OBJECT>::intersectsRaySegmentForSubtree(unsigned nodeIndex,
+    const RaySegment &raySegment,
     const RaySegmentIntersectionListener *raySegmentIntersectionListener,
-    float *t, OBJECT **intersectedObject) const
+    float *t, OBJECT **intersectedObject,
+    QUERY_COUNTER *queryCounter) const
 {
     bool result = false;
 
     while (true) {
-        ++mBoundingBoxTests;
-        ++mCurrentQueryBoundingBoxTests;
-
-        // If the ray segment does not intersect the bounding
-        // box of this node, don't bother testing the subtree
-        // any further.
-        float bboxT = 0.0;
-        if (!BoundingBox3fIntersectsRaySegment(aabbTreeNode->boundingBox(),
-                origin, endpoint, &bboxT)) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                if (raySegmentIntersectionListener->objectIntersectsRaySegment(object,
+                        raySegment.origin(), raySegment.endpoint(), t)) {
+                    result = true;
+                    *intersectedObject = &object;
+                }
+            }
             return result;
         }
 
-        // If the value of 't' where the ray intersects the bounding box
-        // is farther away than smallest value of 't' we've encountered
-        // so far, so it's not possible that any of the objects
-        // within it are closer. Consequently, there's no reason to test
-        // against the objects within the bounding box.
-        if (bboxT >= *t) {
+        // Test the bounding boxes of both children here, so that the
+        // nearer child can be evaluated first. Any intersection found there
+        // reduces 't', which often lets the farther child be skipped.
+        // If the value of 't' where the ray enters a child's bounding box
+        // is not closer than the smallest value of 't' we've encountered
+        // so far, none of the objects within it can be closer either.
+        unsigned nearIndex = node.mIndex;
+        unsigned farIndex = node.mIndex + 1;
+        float nearT = 0.0;
+        float farT = 0.0;
+        queryCounter->countBoundingBoxTest();
+        queryCounter->countBoundingBoxTest();
+        bool nearHit = raySegment.intersectsBoundingBox3f(
+            mNodeVector[nearIndex].mBoundingBox, *t, &nearT) && nearT < *t;
+        bool farHit = raySegment.intersectsBoundingBox3f(
+            mNodeVector[farIndex].mBoundingBox, *t, &farT) && farT < *t;
+
+        if (nearHit && farHit) {
+            if (farT < nearT) {
+                std::swap(nearIndex, farIndex);
+                std::swap(nearT, farT);
+            }
+
+            // Evaluate the nearer subtree.
+            if (intersectsRaySegmentForSubtree(nearIndex, raySegment,
+                    raySegmentIntersectionListener, t, intersectedObject, queryCounter)) {
+                result = true;
+            }
+
+            // The nearer subtree may have found an intersection
+            // in front of the farther subtree.
+            if (farT >= *t) {
+                return result;
+            }
+
+            // To avoid function call overhead, loop on the farther subtree
+            // rather than using recursion.
+            nodeIndex = farIndex;
+        } else if (nearHit) {
+            nodeIndex = nearIndex;
+        } else if (farHit) {
+            nodeIndex = farIndex;
+        } else {
             return result;
         }
+    }
+}
 
-        // Evaluate the callback on all of the objects in this node.
-        for (typename AabbTreeNode<OBJECT>::ObjectVectorIterator iterator
-                 = aabbTreeNode->objectBegin();
-             iterator != aabbTreeNode->objectEnd(); ++iterator) {
-            OBJECT &object = *iterator;
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+void
+AabbTree<OBJECT>::applyToSphereIntersectionForSubtree(unsigned nodeIndex, bool *halted,
+    const Vector3f &center, float radius,
+    SphereListener *sphereListener,
+    QUERY_COUNTER *queryCounter) const
+{
+    if (*halted) {
+        return;
+    }
 
-            ++mObjectTests;
-            ++mCurrentQueryObjectTests;
+    while (true) {
+        const Node &node = mNodeVector[nodeIndex];
 
-            if (raySegmentIntersectionListener->objectIntersectsRaySegment(object, 
-                    origin, endpoint, t)) {
-                result = true;
-                *intersectedObject = &object;
+        queryCounter->countBoundingBoxTest();
+
+        // If the sphere doesn't intersect
+        // the node's bounding box, skip this subtree.
+        if (!BoundingBox3fIntersectsSphere(node.mBoundingBox, center, radius)) {
+            return;
+        }
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node
+            // whose bounding boxes intersect the sphere.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                if (!BoundingBox3fIntersectsSphere(object.boundingBox(), center, radius)) {
+                    continue;
+                }
+
+                // If the callback returns true, skip all further processing.
+                if (sphereListener->applyObjectToSphere(object, center, radius)) {
+                    *halted = true;
+                    return;
+                }
             }
+            return;
         }
-        
+
         // Evaluate the left subtree.
-        if (aabbTreeNode->leftNode() != NULL) {
-            if (intersectsRaySegmentForSubtree(
-                    aabbTreeNode->leftNode(), origin, endpoint, 
-                    raySegmentIntersectionListener, t, intersectedObject)) {
-                result = true;
-            }
+        applyToSphereIntersectionForSubtree(node.mIndex,
+            halted, center, radius, sphereListener, queryCounter);
+        if (*halted) {
+            return;
         }
 
-        // To avoid function call overhead, loop on the right subtree.
+        // To avoid function call overhead, loop on the right subtree
         // rather than using recursion.
-        if (aabbTreeNode->rightNode() != NULL) {
-            aabbTreeNode = aabbTreeNode->rightNode();
-        } else {
+        nodeIndex = node.mIndex + 1;
+    }
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+void
+AabbTree<OBJECT>::findNearestObjectsForSubtree(unsigned nodeIndex,
+    const Vector3f &point, unsigned maximumObjects, float *maximumDistanceSquared,
+    NearestObjectVector *nearestObjectVector,
+    QUERY_COUNTER *queryCounter) const
+{
+    const Node &node = mNodeVector[nodeIndex];
+
+    queryCounter->countBoundingBoxTest();
+
+    if (GetSquaredDistanceFromBoundingBox3fToPoint(node.mBoundingBox, point)
+        > *maximumDistanceSquared) {
+        return;
+    }
+
+    if (node.isLeaf()) {
+        for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+             ++index) {
+            OBJECT &object = mObjectVector[index];
+
+            queryCounter->countObjectTest();
+
+            float distanceSquared = GetSquaredDistanceFromBoundingBox3fToPoint(
+                object.boundingBox(), point);
+            if (distanceSquared > *maximumDistanceSquared) {
+                continue;
+            }
+
+            // Once the queue is full, an object must be closer than the
+            // farthest object in the queue to displace it.
+            if (nearestObjectVector->size() == maximumObjects) {
+                if (distanceSquared >= nearestObjectVector->front().mDistanceSquared) {
+                    continue;
+                }
+                std::pop_heap(nearestObjectVector->begin(), nearestObjectVector->end());
+                nearestObjectVector->pop_back();
+            }
+
+            NearestObject nearestObject;
+            nearestObject.mDistanceSquared = distanceSquared;
+            nearestObject.mObject = &object;
+            nearestObjectVector->push_back(nearestObject);
+            std::push_heap(nearestObjectVector->begin(), nearestObjectVector->end());
+
+            if (nearestObjectVector->size() == maximumObjects) {
+                *maximumDistanceSquared = nearestObjectVector->front().mDistanceSquared;
+            }
+        }
+        return;
+    }
+
+    unsigned nearIndex = node.mIndex;
+    unsigned farIndex = node.mIndex + 1;
+
+    // Visit the nearer child first, so that the search radius
+    // shrinks as quickly as possible.
+    if (GetSquaredDistanceFromBoundingBox3fToPoint(mNodeVector[farIndex].mBoundingBox, point)
+        < GetSquaredDistanceFromBoundingBox3fToPoint(mNodeVector[nearIndex].mBoundingBox,
+            point)) {
+        std::swap(nearIndex, farIndex);
+    }
+
+    findNearestObjectsForSubtree(nearIndex, point, maximumObjects,
+        maximumDistanceSquared, nearestObjectVector, queryCounter);
+    findNearestObjectsForSubtree(farIndex, point, maximumObjects,
+        maximumDistanceSquared, nearestObjectVector, queryCounter);
+}
+
+template<typename OBJECT>
+void
+AabbTree<OBJECT>::findBoundingBoxIntersectionsForSubtree(unsigned nodeIndex, unsigned level,
+    BoundingBoxGroupSearch *boundingBoxGroupSearch) const
+{
+    const Node &node = mNodeVector[nodeIndex];
+    const BoundingBox3fVector &boundingBoxVector = boundingBoxGroupSearch->mBoundingBoxVector;
+
+    if (node.isLeaf()) {
+        const std::vector<unsigned> &boxIndexVector
+            = boundingBoxGroupSearch->mBoxIndexVectorAtLevel[level];
+        for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount; ++index) {
+            const BoundingBox3f objectBoundingBox = mObjectVector[index].boundingBox();
+            for (size_t boxIndex = 0; boxIndex < boxIndexVector.size(); ++boxIndex) {
+                ++boundingBoxGroupSearch->mObjectTests;
+                if (BoundingBox3fIntersectsBoundingBox3f(
+                        boundingBoxVector[boxIndexVector[boxIndex]], objectBoundingBox)) {
+                    boundingBoxGroupSearch->mBoxObjectIndexPairVector.push_back(
+                        std::make_pair(boxIndexVector[boxIndex], index));
+                }
+            }
+        }
+        return;
+    }
+
+    if (boundingBoxGroupSearch->mBoxIndexVectorAtLevel.size() <= level + 1) {
+        boundingBoxGroupSearch->mBoxIndexVectorAtLevel.resize(level + 2);
+    }
+
+    for (unsigned childIndex = node.mIndex; childIndex <= node.mIndex + 1; ++childIndex) {
+        // The vectors are moved when deeper levels are added,
+        // so references to them don't outlast the search of a child.
+        const std::vector<unsigned> &boxIndexVector
+            = boundingBoxGroupSearch->mBoxIndexVectorAtLevel[level];
+        std::vector<unsigned> &childBoxIndexVector
+            = boundingBoxGroupSearch->mBoxIndexVectorAtLevel[level + 1];
+        const BoundingBox3f &childBoundingBox = mNodeVector[childIndex].mBoundingBox;
+        childBoxIndexVector.clear();
+        for (size_t index = 0; index < boxIndexVector.size(); ++index) {
+            ++boundingBoxGroupSearch->mBoundingBoxTests;
+            if (BoundingBox3fIntersectsBoundingBox3f(boundingBoxVector[boxIndexVector[index]],
+                    childBoundingBox)) {
+                childBoxIndexVector.push_back(boxIndexVector[index]);
+            }
+        }
+        if (!childBoxIndexVector.empty()) {
+            findBoundingBoxIntersectionsForSubtree(childIndex, level + 1,
+                boundingBoxGroupSearch);
+        }
+    }
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+void
+AabbTree<OBJECT>::findOverlappingPairsForTask(const AabbTree<OTHER_OBJECT> &otherAabbTree,
+    const OverlapTask &rootOverlapTask, float tolerance, unsigned threadCount,
+    ObjectIndexPairVector *objectIndexPairVector,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    OverlapFunctor<OTHER_OBJECT> overlapFunctor(this, &otherAabbTree, tolerance);
+
+    if (mObjectVector.size() + otherAabbTree.objectVector().size()
+        < PARALLEL_BUILD_MINIMUM_OBJECTS) {
+        threadCount = 1;
+    }
+
+    // Split the tasks into subtasks until there are enough of them
+    // to divide among the threads. The subtasks are listed in the order
+    // that a single thread would search them in, so the pairs that are found
+    // are in the same order either way.
+    OverlapTaskVector overlapTaskVector(1, rootOverlapTask);
+    while (threadCount > 1 && overlapTaskVector.size() < PARALLEL_OVERLAP_MINIMUM_TASKS) {
+        OverlapTaskVector splitOverlapTaskVector;
+        bool wasSplit = false;
+        for (OverlapTaskVectorConstIterator iterator = overlapTaskVector.begin();
+             iterator != overlapTaskVector.end(); ++iterator) {
+            if (overlapFunctor.splitTask(*iterator, &splitOverlapTaskVector)) {
+                wasSplit = true;
+            } else {
+                splitOverlapTaskVector.push_back(*iterator);
+            }
+        }
+        overlapTaskVector.swap(splitOverlapTaskVector);
+        if (!wasSplit) {
             break;
         }
     }
-    
-    return result;
+
+    std::vector<OverlapFunctor<OTHER_OBJECT> > overlapFunctorVector;
+    ApplyToChunksInParallel(OverlapTaskVectorConstIterator(overlapTaskVector.begin()),
+        OverlapTaskVectorConstIterator(overlapTaskVector.end()), overlapFunctor,
+        std::min<size_t>(threadCount, std::max<size_t>(overlapTaskVector.size(), 1)),
+        &overlapFunctorVector);
+
+    size_t pairCount = 0;
+    for (size_t index = 0; index < overlapFunctorVector.size(); ++index) {
+        pairCount += overlapFunctorVector[index].objectIndexPairVector().size();
+    }
+    objectIndexPairVector->reserve(pairCount);
+
+    unsigned boundingBoxTests = overlapFunctor.boundingBoxTests();
+    unsigned objectTests = 0;
+    for (size_t index = 0; index < overlapFunctorVector.size(); ++index) {
+        const OverlapFunctor<OTHER_OBJECT> &chunkOverlapFunctor
+            = overlapFunctorVector[index];
+        objectIndexPairVector->insert(objectIndexPairVector->end(),
+            chunkOverlapFunctor.objectIndexPairVector().begin(),
+            chunkOverlapFunctor.objectIndexPairVector().end());
+        boundingBoxTests += chunkOverlapFunctor.boundingBoxTests();
+        objectTests += chunkOverlapFunctor.objectTests();
+    }
+
+    if (aabbTreeStatistics != NULL) {
+        aabbTreeStatistics->addQuery(boundingBoxTests, objectTests);
+    }
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::OverlapFunctor(const AabbTree *aabbTree,
+    const AabbTree<OTHER_OBJECT> *otherAabbTree, float tolerance)
+    : mAabbTree(aabbTree),
+      mOtherAabbTree(otherAabbTree),
+      mTolerance(tolerance),
+      mObjectIndexPairVector(),
+      mBoundingBoxTests(0),
+      mObjectTests(0)
+{
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+void
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::operator()(
+    OverlapTaskVectorConstIterator first, OverlapTaskVectorConstIterator last)
+{
+    // The functor was copied after it was used to split the tasks,
+    // so don't count those tests twice.
+    mBoundingBoxTests = 0;
+
+    for (OverlapTaskVectorConstIterator iterator = first; iterator != last; ++iterator) {
+        searchTask(*iterator);
+    }
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+bool
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::splitTask(const OverlapTask &overlapTask,
+    OverlapTaskVector *overlapTaskVector)
+{
+    const Node &node = mAabbTree->mNodeVector[overlapTask.mNodeIndex];
+
+    if (overlapTask.mWithinSubtree) {
+        if (node.isLeaf()) {
+            return false;
+        }
+        OverlapTask subtask;
+        subtask.mWithinSubtree = true;
+        subtask.mNodeIndex = node.mIndex;
+        overlapTaskVector->push_back(subtask);
+        subtask.mNodeIndex = node.mIndex + 1;
+        overlapTaskVector->push_back(subtask);
+        subtask.mWithinSubtree = false;
+        subtask.mNodeIndex = node.mIndex;
+        subtask.mOtherNodeIndex = node.mIndex + 1;
+        overlapTaskVector->push_back(subtask);
+        return true;
+    }
+
+    const OtherNode &otherNode = mOtherAabbTree->nodeVector()[overlapTask.mOtherNodeIndex];
+    if (node.isLeaf() && otherNode.isLeaf()) {
+        return false;
+    }
+
+    // Subtrees that are too far apart to contain any pairs
+    // don't need to be searched at all.
+    ++mBoundingBoxTests;
+    if (!boundingBoxesOverlap(node.mBoundingBox, otherNode.mBoundingBox)) {
+        return true;
+    }
+
+    OverlapTask subtask = overlapTask;
+    if (shouldSplitFirstNode(node, otherNode)) {
+        subtask.mNodeIndex = node.mIndex;
+        overlapTaskVector->push_back(subtask);
+        subtask.mNodeIndex = node.mIndex + 1;
+        overlapTaskVector->push_back(subtask);
+    } else {
+        subtask.mOtherNodeIndex = otherNode.mIndex;
+        overlapTaskVector->push_back(subtask);
+        subtask.mOtherNodeIndex = otherNode.mIndex + 1;
+        overlapTaskVector->push_back(subtask);
+    }
+    return true;
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+const typename AabbTree<OBJECT>::ObjectIndexPairVector &
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::objectIndexPairVector() const
+{
+    return mObjectIndexPairVector;
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+unsigned
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::boundingBoxTests() const
+{
+    return mBoundingBoxTests;
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+unsigned
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::objectTests() const
+{
+    return mObjectTests;
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+void
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::searchTask(const OverlapTask &overlapTask)
+{
+    if (overlapTask.mWithinSubtree) {
+        searchWithinSubtree(overlapTask.mNodeIndex);
+    } else {
+        searchSubtreePair(overlapTask.mNodeIndex, overlapTask.mOtherNodeIndex);
+    }
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+void
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::searchSubtreePair(unsigned nodeIndex,
+    unsigned otherNodeIndex)
+{
+    const Node &node = mAabbTree->mNodeVector[nodeIndex];
+    const OtherNode &otherNode = mOtherAabbTree->nodeVector()[otherNodeIndex];
+
+    ++mBoundingBoxTests;
+    if (!boundingBoxesOverlap(node.mBoundingBox, otherNode.mBoundingBox)) {
+        return;
+    }
+
+    if (node.isLeaf() && otherNode.isLeaf()) {
+        const ObjectVector &objectVector = mAabbTree->mObjectVector;
+        const typename AabbTree<OTHER_OBJECT>::ObjectVector &otherObjectVector
+            = mOtherAabbTree->objectVector();
+        // When searching within a single tree, the two nodes are distinct,
+        // so each pair is only found once, but the indices may be in either order.
+        bool withinTree = static_cast<const void *>(mAabbTree)
+            == static_cast<const void *>(mOtherAabbTree);
+        for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+             ++index) {
+            BoundingBox3f boundingBox = objectVector[index].boundingBox();
+            for (unsigned otherIndex = otherNode.mIndex;
+                 otherIndex < otherNode.mIndex + otherNode.mObjectCount; ++otherIndex) {
+                ++mObjectTests;
+                if (boundingBoxesOverlap(boundingBox,
+                        otherObjectVector[otherIndex].boundingBox())) {
+                    if (withinTree && otherIndex < index) {
+                        mObjectIndexPairVector.push_back(
+                            ObjectIndexPair(otherIndex, index));
+                    } else {
+                        mObjectIndexPairVector.push_back(
+                            ObjectIndexPair(index, otherIndex));
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    if (shouldSplitFirstNode(node, otherNode)) {
+        searchSubtreePair(node.mIndex, otherNodeIndex);
+        searchSubtreePair(node.mIndex + 1, otherNodeIndex);
+    } else {
+        searchSubtreePair(nodeIndex, otherNode.mIndex);
+        searchSubtreePair(nodeIndex, otherNode.mIndex + 1);
+    }
 }
 
 template<typename OBJECT>
+template<typename OTHER_OBJECT>
 void
-AabbTree<OBJECT>::updateUsageDataFromCurrentQuery() const
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::searchWithinSubtree(unsigned nodeIndex)
 {
-    if (mCurrentQueryBoundingBoxTests < mMinBoundingBoxTestsPerQuery) {
-        mMinBoundingBoxTestsPerQuery = mCurrentQueryBoundingBoxTests;
+    const Node &node = mAabbTree->mNodeVector[nodeIndex];
+
+    if (node.isLeaf()) {
+        const ObjectVector &objectVector = mAabbTree->mObjectVector;
+        unsigned lastIndex = node.mIndex + node.mObjectCount;
+        for (unsigned index = node.mIndex; index < lastIndex; ++index) {
+            BoundingBox3f boundingBox = objectVector[index].boundingBox();
+            for (unsigned otherIndex = index + 1; otherIndex < lastIndex; ++otherIndex) {
+                ++mObjectTests;
+                if (boundingBoxesOverlap(boundingBox,
+                        objectVector[otherIndex].boundingBox())) {
+                    mObjectIndexPairVector.push_back(ObjectIndexPair(index, otherIndex));
+                }
+            }
+        }
+        return;
     }
 
-    if (mCurrentQueryBoundingBoxTests > mMaxBoundingBoxTestsPerQuery) {
-        mMaxBoundingBoxTestsPerQuery = mCurrentQueryBoundingBoxTests;
+    // Every pair is either within one of the two subtrees, or between them.
+    searchWithinSubtree(node.mIndex);
+    searchWithinSubtree(node.mIndex + 1);
+    searchSubtreePair(node.mIndex, node.mIndex + 1);
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+bool
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::shouldSplitFirstNode(const Node &node,
+    const OtherNode &otherNode) const
+{
+    if (node.isLeaf()) {
+        return false;
     }
-    
-    if (mCurrentQueryObjectTests < mMinObjectTestsPerQuery) {
-        mMinObjectTestsPerQuery = mCurrentQueryObjectTests;
+    if (otherNode.isLeaf()) {
+        return true;
     }
 
-    if (mCurrentQueryObjectTests > mMaxObjectTestsPerQuery) {
-        mMaxObjectTestsPerQuery = mCurrentQueryObjectTests;
+    // Split the larger node, so that the two nodes being compared
+    // stay roughly the same size.
+    return GetBoundingBox3fSurfaceArea(node.mBoundingBox)
+        >= GetBoundingBox3fSurfaceArea(otherNode.mBoundingBox);
+}
+
+template<typename OBJECT>
+template<typename OTHER_OBJECT>
+bool
+AabbTree<OBJECT>::OverlapFunctor<OTHER_OBJECT>::boundingBoxesOverlap(
+    const BoundingBox3f &boundingBox, const BoundingBox3f &otherBoundingBox) const
+{
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        if (boundingBox(0, axis) > otherBoundingBox(1, axis) + mTolerance
+            || otherBoundingBox(0, axis) > boundingBox(1, axis) + mTolerance) {
+            return false;
+        }
     }
+
+    return true;
 }
 
 } // namespace cgmath
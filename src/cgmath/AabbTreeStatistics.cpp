@@ -0,0 +1,145 @@
+// Copyright 2010 Drew Olbrich
+
+#include "AabbTreeStatistics.h"
+
+#include <limits>
+#include <sstream>
+#include <algorithm>
+
+namespace cgmath {
+
+AabbTreeStatistics::AabbTreeStatistics()
+    : mQueries(0),
+      mBoundingBoxTests(0),
+      mMinBoundingBoxTestsPerQuery(0),
+      mMaxBoundingBoxTestsPerQuery(0),
+      mObjectTests(0),
+      mMinObjectTestsPerQuery(0),
+      mMaxObjectTestsPerQuery(0)
+{
+    reset();
+}
+
+AabbTreeStatistics::~AabbTreeStatistics()
+{
+}
+
+void
+AabbTreeStatistics::reset()
+{
+    mQueries = 0;
+    mBoundingBoxTests = 0;
+    mMinBoundingBoxTestsPerQuery = std::numeric_limits<unsigned>::max();
+    mMaxBoundingBoxTestsPerQuery = 0;
+    mObjectTests = 0;
+    mMinObjectTestsPerQuery = std::numeric_limits<unsigned>::max();
+    mMaxObjectTestsPerQuery = 0;
+}
+
+void
+AabbTreeStatistics::addQuery(unsigned boundingBoxTests, unsigned objectTests)
+{
+    ++mQueries;
+
+    mBoundingBoxTests += boundingBoxTests;
+    mMinBoundingBoxTestsPerQuery = std::min(mMinBoundingBoxTestsPerQuery, boundingBoxTests);
+    mMaxBoundingBoxTestsPerQuery = std::max(mMaxBoundingBoxTestsPerQuery, boundingBoxTests);
+
+    mObjectTests += objectTests;
+    mMinObjectTestsPerQuery = std::min(mMinObjectTestsPerQuery, objectTests);
+    mMaxObjectTestsPerQuery = std::max(mMaxObjectTestsPerQuery, objectTests);
+}
+
+void
+AabbTreeStatistics::merge(const AabbTreeStatistics &aabbTreeStatistics)
+{
+    mQueries += aabbTreeStatistics.mQueries;
+
+    mBoundingBoxTests += aabbTreeStatistics.mBoundingBoxTests;
+    mMinBoundingBoxTestsPerQuery = std::min(mMinBoundingBoxTestsPerQuery,
+        aabbTreeStatistics.mMinBoundingBoxTestsPerQuery);
+    mMaxBoundingBoxTestsPerQuery = std::max(mMaxBoundingBoxTestsPerQuery,
+        aabbTreeStatistics.mMaxBoundingBoxTestsPerQuery);
+
+    mObjectTests += aabbTreeStatistics.mObjectTests;
+    mMinObjectTestsPerQuery = std::min(mMinObjectTestsPerQuery,
+        aabbTreeStatistics.mMinObjectTestsPerQuery);
+    mMaxObjectTestsPerQuery = std::max(mMaxObjectTestsPerQuery,
+        aabbTreeStatistics.mMaxObjectTestsPerQuery);
+}
+
+unsigned
+AabbTreeStatistics::queries() const
+{
+    return mQueries;
+}
+
+unsigned
+AabbTreeStatistics::averageBoundingBoxTestsPerQuery() const
+{
+    if (mQueries == 0) {
+        return 0;
+    }
+
+    return mBoundingBoxTests/mQueries;
+}
+
+unsigned
+AabbTreeStatistics::minBoundingBoxTestsPerQuery() const
+{
+    if (mQueries == 0) {
+        return 0;
+    }
+
+    return mMinBoundingBoxTestsPerQuery;
+}
+
+unsigned
+AabbTreeStatistics::maxBoundingBoxTestsPerQuery() const
+{
+    return mMaxBoundingBoxTestsPerQuery;
+}
+
+unsigned
+AabbTreeStatistics::averageObjectTestsPerQuery() const
+{
+    if (mQueries == 0) {
+        return 0;
+    }
+
+    return mObjectTests/mQueries;
+}
+
+unsigned
+AabbTreeStatistics::minObjectTestsPerQuery() const
+{
+    if (mQueries == 0) {
+        return 0;
+    }
+
+    return mMinObjectTestsPerQuery;
+}
+
+unsigned
+AabbTreeStatistics::maxObjectTestsPerQuery() const
+{
+    return mMaxObjectTestsPerQuery;
+}
+
+std::string
+AabbTreeStatistics::asString() const
+{
+    std::ostringstream ostr;
+
+    ostr << "Queries: " << queries() << "\n";
+    ostr << "Average bounding box tests per query: " << averageBoundingBoxTestsPerQuery() << "\n";
+    ostr << "Min bounding box tests per query: " << minBoundingBoxTestsPerQuery() << "\n";
+    ostr << "Max bounding box tests per query: " << maxBoundingBoxTestsPerQuery() << "\n";
+    ostr << "Average object tests per query: " << averageObjectTestsPerQuery() << "\n";
+    ostr << "Min object tests per query: " << minObjectTestsPerQuery() << "\n";
+    ostr << "Max object tests per query: " << maxObjectTestsPerQuery();
+
+    return ostr.str();
+}
+
+} // namespace cgmath
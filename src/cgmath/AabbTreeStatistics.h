@@ -0,0 +1,62 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__AABB_TREE_STATISTICS__INCLUDED
+#define CGMATH__AABB_TREE_STATISTICS__INCLUDED
+
+#include <string>
+
+namespace cgmath {
+
+// AabbTreeStatistics
+//
+// Accumulates the number of tests performed by AabbTree queries.
+//
+// AabbTree does not keep statistics itself, so that a tree may be queried
+// from several threads at once. Instead, a statistics object may optionally
+// be passed to each query. The object is not synchronized, so each thread
+// should pass its own, and the objects may be merged afterward.
+
+class AabbTreeStatistics
+{
+public:
+    AabbTreeStatistics();
+    ~AabbTreeStatistics();
+
+    // Discard the statistics accumulated so far.
+    void reset();
+
+    // Record a query that performed the specified numbers of tests.
+    void addQuery(unsigned boundingBoxTests, unsigned objectTests);
+
+    // Add the statistics accumulated by another object to this one.
+    void merge(const AabbTreeStatistics &aabbTreeStatistics);
+
+    // The number of queries performed.
+    unsigned queries() const;
+
+    // The number of bounding box tests performed.
+    unsigned averageBoundingBoxTestsPerQuery() const;
+    unsigned minBoundingBoxTestsPerQuery() const;
+    unsigned maxBoundingBoxTestsPerQuery() const;
+
+    // The number of object intersection tests (via listener) performed.
+    unsigned averageObjectTestsPerQuery() const;
+    unsigned minObjectTestsPerQuery() const;
+    unsigned maxObjectTestsPerQuery() const;
+
+    // A string describing the statistics.
+    std::string asString() const;
+
+private:
+    unsigned mQueries;
+    unsigned mBoundingBoxTests;
+    unsigned mMinBoundingBoxTestsPerQuery;
+    unsigned mMaxBoundingBoxTestsPerQuery;
+    unsigned mObjectTests;
+    unsigned mMinObjectTestsPerQuery;
+    unsigned mMaxObjectTestsPerQuery;
+};
+
+} // namespace cgmath
+
+#endif // CGMATH__AABB_TREE_STATISTICS__INCLUDED
@@ -390,6 +390,56 @@ BoundingBox3fIntersectsTetrahedron(const BoundingBox3f &bbox,
     return true;
 }
 
+float
+GetSquaredDistanceFromBoundingBox3fToPoint(const BoundingBox3f &bbox,
+    const Vector3f &point)
+{
+    float distanceSquared = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        float delta = 0.0;
+        if (point[axis] < bbox.min()[axis]) {
+            delta = bbox.min()[axis] - point[axis];
+        } else if (point[axis] > bbox.max()[axis]) {
+            delta = point[axis] - bbox.max()[axis];
+        }
+        distanceSquared += delta*delta;
+    }
+
+    return distanceSquared;
+}
+
+bool
+BoundingBox3fIntersectsSphere(const BoundingBox3f &bbox,
+    const Vector3f &center, float radius)
+{
+    return GetSquaredDistanceFromBoundingBox3fToPoint(bbox, center) <= radius*radius;
+}
+
+bool
+BoundingBox3fContainsBoundingBox3f(const BoundingBox3f &lhs, const BoundingBox3f &rhs)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        if (rhs.min()[axis] < lhs.min()[axis]
+            || rhs.max()[axis] > lhs.max()[axis]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+float
+GetBoundingBox3fSurfaceArea(const BoundingBox3f &bbox)
+{
+    if (bbox.empty()) {
+        return 0.0;
+    }
+
+    Vector3f size = bbox.max() - bbox.min();
+
+    return 2.0*(size[0]*size[1] + size[1]*size[2] + size[2]*size[0]);
+}
+
 BoundingBox3f
 GrowBoundingBox3fByAbsoluteAndRelativeTolerance(const BoundingBox3f &bbox,
     float absoluteTolerance, float relativeTolerance)
@@ -404,4 +454,39 @@ GrowBoundingBox3fByAbsoluteAndRelativeTolerance(const BoundingBox3f &bbox,
     return BoundingBox3f(min, max);
 }
 
+// Spread the lower ten bits of a value out so that there are
+// two zero bits between each of them.
+static unsigned
+SpreadMortonCodeBits(unsigned value)
+{
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value << 8)) & 0x0300f00f;
+    value = (value | (value << 4)) & 0x030c30c3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+unsigned
+GetMortonCode(const Vector3f &point, const BoundingBox3f &bbox)
+{
+    const unsigned MAX_COORDINATE = (1 << 10) - 1;
+
+    unsigned code = 0;
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        float size = bbox.max()[axis] - bbox.min()[axis];
+        unsigned coordinate = 0;
+        if (size > 0.0) {
+            float t = (point[axis] - bbox.min()[axis])/size;
+            if (t >= 1.0) {
+                coordinate = MAX_COORDINATE;
+            } else if (t > 0.0) {
+                coordinate = std::min(unsigned(t*(MAX_COORDINATE + 1)), MAX_COORDINATE);
+            }
+        }
+        code |= SpreadMortonCodeBits(coordinate) << (2 - axis);
+    }
+
+    return code;
+}
+
 } // namespace cgmath
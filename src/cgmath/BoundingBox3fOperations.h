@@ -37,10 +37,32 @@ bool BoundingBox3fIntersectsTriangle(const BoundingBox3f &bbox,
 bool BoundingBox3fIntersectsTetrahedron(const BoundingBox3f &bbox,
     const Vector3f &v0, const Vector3f &v1, const Vector3f &v2, const Vector3f &v3);
 
+// Returns the squared distance from a point to the nearest point
+// of a bounding box, which is zero if the point lies inside the bounding box.
+float GetSquaredDistanceFromBoundingBox3fToPoint(const BoundingBox3f &bbox,
+    const Vector3f &point);
+
+// Returns true if a bounding box intersects a sphere.
+bool BoundingBox3fIntersectsSphere(const BoundingBox3f &bbox,
+    const Vector3f &center, float radius);
+
+// Returns true if the first bounding box entirely contains the second.
+bool BoundingBox3fContainsBoundingBox3f(const BoundingBox3f &lhs, const BoundingBox3f &rhs);
+
+// Returns the surface area of a bounding box.
+float GetBoundingBox3fSurfaceArea(const BoundingBox3f &bbox);
+
 // Grow a bounding box by the specified absolute and relative tolerance.
 BoundingBox3f GrowBoundingBox3fByAbsoluteAndRelativeTolerance(const BoundingBox3f &bbox,
     float absoluteTolerance, float relativeTolerance);
 
+// Returns the Morton code of a point, which interleaves the bits of its
+// coordinates, quantized to ten bits each within a bounding box.
+// Points that are near each other tend to have nearby codes, so sorting
+// points by their codes orders them along a space-filling curve.
+// Points outside the bounding box are clamped to it.
+unsigned GetMortonCode(const Vector3f &point, const BoundingBox3f &bbox);
+
 } // namespace cgmath
 
 #endif // CGMATH__BOUNDING_BOX3F_OPERATIONS__INCLUDED
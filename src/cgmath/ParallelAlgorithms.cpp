@@ -0,0 +1,14 @@
+// Copyright 2010 Drew Olbrich
+
+#include "ParallelAlgorithms.h"
+
+namespace cgmath {
+
+unsigned
+GetDefaultThreadCount()
+{
+    // hardware_concurrency returns zero if the number of processors is unknown.
+    return std::max(boost::thread::hardware_concurrency(), 1U);
+}
+
+} // namespace cgmath
@@ -0,0 +1,340 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__PARALLEL_ALGORITHMS__INCLUDED
+#define CGMATH__PARALLEL_ALGORITHMS__INCLUDED
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include <boost/thread.hpp>
+
+namespace cgmath {
+
+// These functions divide a range into consecutive chunks that are
+// processed by separate threads. The calling thread processes the last chunk
+// itself, and the functions return once all of the chunks are done.
+// The results never depend on the number of threads, so that the data
+// structures built with them are the same however many processors there are.
+
+// Returns the number of threads that should be used by default,
+// which is the number of processors.
+unsigned GetDefaultThreadCount();
+
+// Apply each functor in functorVector to its own chunk of the range
+// [first, last), as functor(chunkFirst, chunkLast). There is one chunk
+// per functor, and the chunks are in the order of the functors.
+template<typename ITERATOR, typename FUNCTOR>
+void ApplyToChunksInParallel(ITERATOR first, ITERATOR last,
+    std::vector<FUNCTOR> *functorVector);
+
+// Apply copies of a functor to up to threadCount chunks of the range [first, last),
+// as in ApplyToChunksInParallel. The copies are returned via functorVector.
+template<typename ITERATOR, typename FUNCTOR>
+void ApplyToChunksInParallel(ITERATOR first, ITERATOR last, const FUNCTOR &functor,
+    unsigned threadCount, std::vector<FUNCTOR> *functorVector);
+
+// Apply copies of a functor to up to threadCount chunks of the range [first, last),
+// and then replace the functor with the first copy, merging the other copies
+// into it in order by calling functor->merge(copy). If threadCount is one,
+// the functor is just applied to the entire range.
+template<typename ITERATOR, typename FUNCTOR>
+void ReduceInParallel(ITERATOR first, ITERATOR last, FUNCTOR *functor,
+    unsigned threadCount);
+
+// Equivalent to std::stable_partition, using up to threadCount threads.
+template<typename ITERATOR, typename PREDICATE>
+ITERATOR StablePartitionInParallel(ITERATOR first, ITERATOR last,
+    PREDICATE predicate, unsigned threadCount);
+
+// Equivalent to std::nth_element, using up to threadCount threads. The range
+// is repeatedly partitioned in parallel around a pivot, until the part of it
+// that contains nth is small enough that std::nth_element is faster.
+// Note that unless compare is a strict total order, the arrangement of the
+// elements that compare equal to nth may depend on the number of threads.
+template<typename ITERATOR, typename COMPARE>
+void NthElementInParallel(ITERATOR first, ITERATOR nth, ITERATOR last,
+    COMPARE compare, unsigned threadCount);
+
+// Returns the start of a chunk of a range divided into chunkCount chunks.
+// Used by the functions above.
+template<typename ITERATOR>
+ITERATOR GetChunkStart(ITERATOR first, ITERATOR last, unsigned chunk, unsigned chunkCount);
+
+// The thread function that applies a functor to a chunk.
+// Used by ApplyToChunksInParallel.
+template<typename ITERATOR, typename FUNCTOR>
+class ParallelChunkTask
+{
+public:
+    ParallelChunkTask(FUNCTOR *functor, ITERATOR first, ITERATOR last)
+        : mFunctor(functor),
+          mFirst(first),
+          mLast(last) {
+    }
+    void operator()() {
+        (*mFunctor)(mFirst, mLast);
+    }
+private:
+    FUNCTOR *mFunctor;
+    ITERATOR mFirst;
+    ITERATOR mLast;
+};
+
+// Counts the elements of a chunk that satisfy a predicate.
+// Used by StablePartitionInParallel.
+template<typename ITERATOR, typename PREDICATE>
+class PartitionCountFunctor
+{
+public:
+    PartitionCountFunctor(PREDICATE predicate)
+        : mPredicate(predicate),
+          mCount(0) {
+    }
+    void operator()(ITERATOR first, ITERATOR last) {
+        mCount = std::count_if(first, last, mPredicate);
+    }
+    size_t count() const {
+        return mCount;
+    }
+private:
+    PREDICATE mPredicate;
+    size_t mCount;
+};
+
+// Copies the elements of a chunk that satisfy a predicate to one
+// destination, and the rest to another.
+// Used by StablePartitionInParallel.
+template<typename ITERATOR, typename OUTPUT_ITERATOR, typename PREDICATE>
+class PartitionCopyFunctor
+{
+public:
+    PartitionCopyFunctor(PREDICATE predicate, OUTPUT_ITERATOR trueOutput,
+        OUTPUT_ITERATOR falseOutput)
+        : mPredicate(predicate),
+          mTrueOutput(trueOutput),
+          mFalseOutput(falseOutput) {
+    }
+    void operator()(ITERATOR first, ITERATOR last) {
+        for (ITERATOR iterator = first; iterator != last; ++iterator) {
+            if (mPredicate(*iterator)) {
+                *mTrueOutput++ = *iterator;
+            } else {
+                *mFalseOutput++ = *iterator;
+            }
+        }
+    }
+private:
+    PREDICATE mPredicate;
+    OUTPUT_ITERATOR mTrueOutput;
+    OUTPUT_ITERATOR mFalseOutput;
+};
+
+// Copies a chunk of one range to the same position in another range.
+// Used by StablePartitionInParallel.
+template<typename ITERATOR, typename OUTPUT_ITERATOR>
+class ChunkCopyFunctor
+{
+public:
+    ChunkCopyFunctor(ITERATOR sourceBegin, OUTPUT_ITERATOR destinationBegin)
+        : mSourceBegin(sourceBegin),
+          mDestinationBegin(destinationBegin) {
+    }
+    void operator()(ITERATOR first, ITERATOR last) {
+        std::copy(first, last, mDestinationBegin + (first - mSourceBegin));
+    }
+private:
+    ITERATOR mSourceBegin;
+    OUTPUT_ITERATOR mDestinationBegin;
+};
+
+// Compares elements to a pivot element.
+// Used by NthElementInParallel.
+template<typename VALUE, typename COMPARE>
+class PivotPredicate
+{
+public:
+    // If orEqual is false, the predicate is true for elements less than the pivot.
+    // Otherwise, it's true for elements not greater than the pivot.
+    PivotPredicate(COMPARE compare, const VALUE &pivot, bool orEqual)
+        : mCompare(compare),
+          mPivot(pivot),
+          mOrEqual(orEqual) {
+    }
+    bool operator()(const VALUE &value) const {
+        if (mOrEqual) {
+            return !mCompare(mPivot, value);
+        }
+        return mCompare(value, mPivot);
+    }
+private:
+    COMPARE mCompare;
+    VALUE mPivot;
+    bool mOrEqual;
+};
+
+template<typename ITERATOR>
+ITERATOR
+GetChunkStart(ITERATOR first, ITERATOR last, unsigned chunk, unsigned chunkCount)
+{
+    return first + (last - first)*chunk/chunkCount;
+}
+
+template<typename ITERATOR, typename FUNCTOR>
+void
+ApplyToChunksInParallel(ITERATOR first, ITERATOR last,
+    std::vector<FUNCTOR> *functorVector)
+{
+    assert(functorVector != NULL);
+    assert(!functorVector->empty());
+
+    unsigned chunkCount = functorVector->size();
+
+    boost::thread_group threadGroup;
+    for (unsigned chunk = 0; chunk < chunkCount - 1; ++chunk) {
+        threadGroup.create_thread(ParallelChunkTask<ITERATOR, FUNCTOR>(
+                &(*functorVector)[chunk],
+                GetChunkStart(first, last, chunk, chunkCount),
+                GetChunkStart(first, last, chunk + 1, chunkCount)));
+    }
+
+    // The calling thread processes the last chunk.
+    (*functorVector)[chunkCount - 1](
+        GetChunkStart(first, last, chunkCount - 1, chunkCount), last);
+
+    threadGroup.join_all();
+}
+
+template<typename ITERATOR, typename FUNCTOR>
+void
+ApplyToChunksInParallel(ITERATOR first, ITERATOR last, const FUNCTOR &functor,
+    unsigned threadCount, std::vector<FUNCTOR> *functorVector)
+{
+    assert(functorVector != NULL);
+
+    functorVector->assign(std::max(threadCount, 1U), functor);
+    ApplyToChunksInParallel(first, last, functorVector);
+}
+
+template<typename ITERATOR, typename FUNCTOR>
+void
+ReduceInParallel(ITERATOR first, ITERATOR last, FUNCTOR *functor,
+    unsigned threadCount)
+{
+    assert(functor != NULL);
+
+    if (threadCount <= 1) {
+        (*functor)(first, last);
+        return;
+    }
+
+    std::vector<FUNCTOR> functorVector;
+    ApplyToChunksInParallel(first, last, *functor, threadCount, &functorVector);
+
+    *functor = functorVector[0];
+    for (size_t index = 1; index < functorVector.size(); ++index) {
+        functor->merge(functorVector[index]);
+    }
+}
+
+template<typename ITERATOR, typename PREDICATE>
+ITERATOR
+StablePartitionInParallel(ITERATOR first, ITERATOR last,
+    PREDICATE predicate, unsigned threadCount)
+{
+    if (threadCount <= 1) {
+        return std::stable_partition(first, last, predicate);
+    }
+
+    // Count the elements of each chunk that satisfy the predicate.
+    std::vector<PartitionCountFunctor<ITERATOR, PREDICATE> > countFunctorVector;
+    ApplyToChunksInParallel(first, last,
+        PartitionCountFunctor<ITERATOR, PREDICATE>(predicate),
+        threadCount, &countFunctorVector);
+
+    size_t trueCount = 0;
+    for (size_t index = 0; index < countFunctorVector.size(); ++index) {
+        trueCount += countFunctorVector[index].count();
+    }
+
+    // Copy the elements to a temporary vector, and then copy each chunk's
+    // elements back into place.
+    typedef typename std::iterator_traits<ITERATOR>::value_type Value;
+    typedef std::vector<Value> ValueVector;
+    typedef typename ValueVector::iterator ValueVectorIterator;
+    ValueVector valueVector(last - first);
+    std::vector<ChunkCopyFunctor<ITERATOR, ValueVectorIterator> > chunkCopyFunctorVector;
+    ApplyToChunksInParallel(first, last,
+        ChunkCopyFunctor<ITERATOR, ValueVectorIterator>(first, valueVector.begin()),
+        threadCount, &chunkCopyFunctorVector);
+
+    typedef PartitionCopyFunctor<ValueVectorIterator, ITERATOR,
+        PREDICATE> CopyFunctor;
+    std::vector<CopyFunctor> copyFunctorVector;
+    copyFunctorVector.reserve(countFunctorVector.size());
+    ITERATOR trueOutput = first;
+    ITERATOR falseOutput = first + trueCount;
+    unsigned chunkCount = countFunctorVector.size();
+    for (unsigned chunk = 0; chunk < chunkCount; ++chunk) {
+        copyFunctorVector.push_back(CopyFunctor(predicate, trueOutput, falseOutput));
+        size_t chunkSize = GetChunkStart(first, last, chunk + 1, chunkCount)
+            - GetChunkStart(first, last, chunk, chunkCount);
+        trueOutput += countFunctorVector[chunk].count();
+        falseOutput += chunkSize - countFunctorVector[chunk].count();
+    }
+    ApplyToChunksInParallel(valueVector.begin(), valueVector.end(), &copyFunctorVector);
+
+    return first + trueCount;
+}
+
+template<typename ITERATOR, typename COMPARE>
+void
+NthElementInParallel(ITERATOR first, ITERATOR nth, ITERATOR last,
+    COMPARE compare, unsigned threadCount)
+{
+    // Below this size, std::nth_element is faster than partitioning in parallel.
+    static const size_t MINIMUM_PARALLEL_ELEMENTS = 16384;
+
+    typedef typename std::iterator_traits<ITERATOR>::value_type Value;
+
+    while (threadCount > 1 && size_t(last - first) >= MINIMUM_PARALLEL_ELEMENTS) {
+        // Use the median of three elements as the pivot.
+        Value pivot = *first;
+        Value middle = *(first + (last - first)/2);
+        Value back = *(last - 1);
+        if (compare(middle, pivot)) {
+            std::swap(middle, pivot);
+        }
+        if (compare(back, middle)) {
+            middle = compare(back, pivot) ? pivot : back;
+        }
+        pivot = middle;
+
+        ITERATOR split = StablePartitionInParallel(first, last,
+            PivotPredicate<Value, COMPARE>(compare, pivot, false), threadCount);
+
+        // If the pivot is the smallest element, separate the elements
+        // that are equal to it instead. The pivot is one of them,
+        // so this always makes progress.
+        if (split == first) {
+            split = StablePartitionInParallel(first, last,
+                PivotPredicate<Value, COMPARE>(compare, pivot, true), threadCount);
+            if (nth < split) {
+                return;
+            }
+        }
+
+        if (nth < split) {
+            last = split;
+        } else {
+            first = split;
+        }
+    }
+
+    std::nth_element(first, nth, last, compare);
+}
+
+} // namespace cgmath
+
+#endif // CGMATH__PARALLEL_ALGORITHMS__INCLUDED
@@ -0,0 +1,488 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__POINT_TREE__INCLUDED
+#define CGMATH__POINT_TREE__INCLUDED
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "Vector3f.h"
+#include "BoundingBox3f.h"
+#include "ParallelAlgorithms.h"
+
+namespace cgmath {
+
+// PointTree
+//
+// A compact balanced kd-tree, specialized for objects that are points,
+// such as mesh vertices or illumination samples. This serves the same
+// purpose as AabbTree for point objects, but since points need no bounding
+// boxes, it supports nearest neighbor and radius queries with far less memory.
+//
+// There are no nodes and no child pointers. Each range of the object array is
+// a subtree whose root is the object in the middle of the range, and
+// whose children are the two halves on either side of it.
+// The positions are stored in a separate array from the objects,
+// so that traversal touches as little memory as possible.
+//
+// The two halves of large ranges are built by separate threads.
+//
+// The template parameter class OBJECT should have the following
+// member function defined:
+//
+// cgmath::Vector3f position() const;
+//     Returns the position of the object.
+
+template<typename OBJECT>
+class PointTree
+{
+public:
+    PointTree();
+    ~PointTree();
+
+    // The largest number of threads that initialize may use to build the tree.
+    // By default, this is the number of processors.
+    void setMaximumBuildThreads(unsigned maximumBuildThreads);
+    unsigned maximumBuildThreads() const;
+
+    // Initialize the tree. The objects are copied.
+    typedef std::vector<OBJECT> ObjectVector;
+    void initialize(const ObjectVector &objectVector);
+
+    // Clear out all the objects from the tree.
+    void clear();
+
+    // The number of objects in the tree.
+    size_t size() const;
+
+    class SphereListener {
+    public:
+        virtual ~SphereListener() {}
+        // Called with each object within the sphere, along with its squared
+        // distance from the center of the sphere.
+        // If this function returns true, traversal of the tree halts.
+        virtual bool applyObjectToSphere(OBJECT &object, const Vector3f &center,
+            float radius, float distanceSquared) = 0;
+    };
+
+    // Apply a listener to all objects in the tree that lie within the specified sphere.
+    // Returns true if a listener function call returned true.
+    bool applyToSphereIntersection(const Vector3f &center, float radius,
+        SphereListener *sphereListener);
+
+    class NearestObjectFilter {
+    public:
+        virtual ~NearestObjectFilter() {}
+        // Returns true if the object should be considered by findNearestObjects.
+        virtual bool acceptNearestObject(const OBJECT &object) const = 0;
+    };
+
+    // An object returned by findNearestObjects.
+    struct NearestObject {
+        // The squared distance from the query point to the object.
+        float mDistanceSquared;
+        OBJECT *mObject;
+        // Used to maintain the bounded priority queue of nearest objects.
+        bool operator<(const NearestObject &rhs) const {
+            return mDistanceSquared < rhs.mDistanceSquared;
+        }
+    };
+    typedef std::vector<NearestObject> NearestObjectVector;
+
+    // Find up to maximumObjects objects closest to a point, no farther away
+    // than maximumDistance. If nearestObjectFilter is not NULL, only
+    // the objects it accepts are considered.
+    // The objects are returned in order of increasing distance.
+    void findNearestObjects(const Vector3f &point, unsigned maximumObjects,
+        float maximumDistance, NearestObjectVector *nearestObjectVector,
+        const NearestObjectFilter *nearestObjectFilter = NULL);
+
+    // The number of queries performed.
+    unsigned queries() const;
+
+    // The average number of objects visited per query.
+    unsigned averageObjectTestsPerQuery() const;
+
+    // Number of bytes occupied by the tree.
+    size_t bytesUsed() const;
+
+private:
+    // Ranges of fewer objects than this are built by a single thread.
+    enum {
+        PARALLEL_BUILD_MINIMUM_OBJECTS = 4096
+    };
+
+    // Recursively build the tree over a range of the index vector,
+    // using up to threadCount threads.
+    void createSubtree(std::vector<size_t> &indexVector, size_t begin, size_t end,
+        unsigned threadCount);
+
+    // The thread function that builds a subtree.
+    class CreateSubtreeTask {
+    public:
+        CreateSubtreeTask(PointTree *pointTree, std::vector<size_t> *indexVector,
+            size_t begin, size_t end, unsigned threadCount)
+            : mPointTree(pointTree), mIndexVector(indexVector), mBegin(begin), mEnd(end),
+              mThreadCount(threadCount) {}
+        void operator()() {
+            mPointTree->createSubtree(*mIndexVector, mBegin, mEnd, mThreadCount);
+        }
+    private:
+        PointTree *mPointTree;
+        std::vector<size_t> *mIndexVector;
+        size_t mBegin;
+        size_t mEnd;
+        unsigned mThreadCount;
+    };
+
+    // Recursively apply the sphere intersection test to a subtree.
+    void applyToSphereIntersectionForSubtree(size_t begin, size_t end, bool *halted,
+        const Vector3f &center, float radius, float radiusSquared,
+        SphereListener *sphereListener);
+
+    // Recursively search a subtree for the objects nearest to a point.
+    void findNearestObjectsForSubtree(size_t begin, size_t end,
+        const Vector3f &point, unsigned maximumObjects, float *maximumDistanceSquared,
+        NearestObjectVector *nearestObjectVector,
+        const NearestObjectFilter *nearestObjectFilter);
+
+    // This functor is used to partition objects by their position
+    // on a particular axis.
+    class CompareIndexByAxisFunctor {
+    public:
+        CompareIndexByAxisFunctor(const std::vector<Vector3f> &positionVector,
+            unsigned axis)
+            : mPositionVector(positionVector), mAxis(axis) {}
+        bool operator()(size_t lhs, size_t rhs) const {
+            return mPositionVector[lhs][mAxis] < mPositionVector[rhs][mAxis];
+        }
+    private:
+        const std::vector<Vector3f> &mPositionVector;
+        unsigned mAxis;
+    };
+
+    // The positions and objects, in tree order.
+    std::vector<Vector3f> mPositionVector;
+    ObjectVector mObjectVector;
+
+    // The splitting axis of the subtree rooted at each object.
+    std::vector<unsigned char> mAxisVector;
+
+    unsigned mMaximumBuildThreads;
+
+    unsigned mQueries;
+    unsigned mObjectTests;
+};
+
+template<typename OBJECT>
+PointTree<OBJECT>::PointTree()
+    : mPositionVector(),
+      mObjectVector(),
+      mAxisVector(),
+      mMaximumBuildThreads(GetDefaultThreadCount()),
+      mQueries(0),
+      mObjectTests(0)
+{
+}
+
+template<typename OBJECT>
+PointTree<OBJECT>::~PointTree()
+{
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::setMaximumBuildThreads(unsigned maximumBuildThreads)
+{
+    mMaximumBuildThreads = std::max(maximumBuildThreads, 1U);
+}
+
+template<typename OBJECT>
+unsigned
+PointTree<OBJECT>::maximumBuildThreads() const
+{
+    return mMaximumBuildThreads;
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::initialize(const ObjectVector &objectVector)
+{
+    // The tree is built by partitioning a vector of indices,
+    // so the objects themselves are only copied once.
+    std::vector<Vector3f> positionVector;
+    positionVector.reserve(objectVector.size());
+    std::vector<size_t> indexVector;
+    indexVector.reserve(objectVector.size());
+    for (size_t index = 0; index < objectVector.size(); ++index) {
+        positionVector.push_back(objectVector[index].position());
+        indexVector.push_back(index);
+    }
+
+    mPositionVector.swap(positionVector);
+    mAxisVector.assign(objectVector.size(), 0);
+
+    createSubtree(indexVector, 0, indexVector.size(), mMaximumBuildThreads);
+
+    // Arrange the positions and objects in tree order.
+    positionVector.clear();
+    positionVector.reserve(indexVector.size());
+    ObjectVector sortedObjectVector;
+    sortedObjectVector.reserve(indexVector.size());
+    std::vector<unsigned char> axisVector;
+    axisVector.reserve(indexVector.size());
+    for (size_t index = 0; index < indexVector.size(); ++index) {
+        positionVector.push_back(mPositionVector[indexVector[index]]);
+        sortedObjectVector.push_back(objectVector[indexVector[index]]);
+        axisVector.push_back(mAxisVector[index]);
+    }
+    mPositionVector.swap(positionVector);
+    mObjectVector.swap(sortedObjectVector);
+    mAxisVector.swap(axisVector);
+
+    mQueries = 0;
+    mObjectTests = 0;
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::clear()
+{
+    std::vector<Vector3f>().swap(mPositionVector);
+    ObjectVector().swap(mObjectVector);
+    std::vector<unsigned char>().swap(mAxisVector);
+}
+
+template<typename OBJECT>
+size_t
+PointTree<OBJECT>::size() const
+{
+    return mObjectVector.size();
+}
+
+template<typename OBJECT>
+bool
+PointTree<OBJECT>::applyToSphereIntersection(const Vector3f &center, float radius,
+    SphereListener *sphereListener)
+{
+    assert(sphereListener != NULL);
+
+    ++mQueries;
+
+    bool halted = false;
+    applyToSphereIntersectionForSubtree(0, mObjectVector.size(), &halted,
+        center, radius, radius*radius, sphereListener);
+
+    return halted;
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::findNearestObjects(const Vector3f &point, unsigned maximumObjects,
+    float maximumDistance, NearestObjectVector *nearestObjectVector,
+    const NearestObjectFilter *nearestObjectFilter)
+{
+    assert(nearestObjectVector != NULL);
+    assert(maximumObjects > 0);
+
+    ++mQueries;
+
+    nearestObjectVector->clear();
+
+    float maximumDistanceSquared = maximumDistance*maximumDistance;
+    findNearestObjectsForSubtree(0, mObjectVector.size(), point, maximumObjects,
+        &maximumDistanceSquared, nearestObjectVector, nearestObjectFilter);
+
+    // The vector is a max-heap, so this leaves the nearest object first.
+    std::sort_heap(nearestObjectVector->begin(), nearestObjectVector->end());
+}
+
+template<typename OBJECT>
+unsigned
+PointTree<OBJECT>::queries() const
+{
+    return mQueries;
+}
+
+template<typename OBJECT>
+unsigned
+PointTree<OBJECT>::averageObjectTestsPerQuery() const
+{
+    if (mQueries == 0) {
+        return 0;
+    }
+
+    return mObjectTests/mQueries;
+}
+
+template<typename OBJECT>
+size_t
+PointTree<OBJECT>::bytesUsed() const
+{
+    return mPositionVector.capacity()*sizeof(Vector3f)
+        + mObjectVector.capacity()*sizeof(OBJECT)
+        + mAxisVector.capacity()*sizeof(unsigned char);
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::createSubtree(std::vector<size_t> &indexVector,
+    size_t begin, size_t end, unsigned threadCount)
+{
+    if (end - begin < 2) {
+        return;
+    }
+
+    // Split along the longest axis of the points in the range.
+    BoundingBox3f boundingBox = BoundingBox3f::EMPTY_SET;
+    for (size_t index = begin; index < end; ++index) {
+        boundingBox.extendByVector3f(mPositionVector[indexVector[index]]);
+    }
+    const Vector3f size = boundingBox.max() - boundingBox.min();
+    unsigned axis = 0;
+    if (size[1] > size[axis]) {
+        axis = 1;
+    }
+    if (size[2] > size[axis]) {
+        axis = 2;
+    }
+
+    size_t middle = begin + (end - begin)/2;
+    std::nth_element(indexVector.begin() + begin, indexVector.begin() + middle,
+        indexVector.begin() + end, CompareIndexByAxisFunctor(mPositionVector, axis));
+
+    // mAxisVector is indexed by tree position.
+    mAxisVector[middle] = axis;
+
+    if (threadCount <= 1 || end - begin < PARALLEL_BUILD_MINIMUM_OBJECTS) {
+        createSubtree(indexVector, begin, middle, threadCount);
+        createSubtree(indexVector, middle + 1, end, threadCount);
+        return;
+    }
+
+    // The two halves are disjoint, so they may be built at the same time.
+    unsigned leftThreadCount = threadCount/2;
+    boost::thread thread(CreateSubtreeTask(this, &indexVector, begin, middle,
+            leftThreadCount));
+    createSubtree(indexVector, middle + 1, end, threadCount - leftThreadCount);
+    thread.join();
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::applyToSphereIntersectionForSubtree(size_t begin, size_t end,
+    bool *halted, const Vector3f &center, float radius, float radiusSquared,
+    SphereListener *sphereListener)
+{
+    while (begin < end && !*halted) {
+        size_t middle = begin + (end - begin)/2;
+        const Vector3f &position = mPositionVector[middle];
+
+        ++mObjectTests;
+
+        float distanceSquared = (position - center).lengthSquared();
+        if (distanceSquared <= radiusSquared) {
+            if (sphereListener->applyObjectToSphere(mObjectVector[middle], center,
+                    radius, distanceSquared)) {
+                *halted = true;
+                return;
+            }
+        }
+
+        if (end - begin == 1) {
+            return;
+        }
+
+        unsigned axis = mAxisVector[middle];
+        float delta = center[axis] - position[axis];
+
+        // Evaluate the left subtree if the sphere reaches into it.
+        if (delta <= radius) {
+            applyToSphereIntersectionForSubtree(begin, middle, halted,
+                center, radius, radiusSquared, sphereListener);
+        }
+
+        // To avoid function call overhead, loop on the right subtree
+        // rather than using recursion.
+        if (delta < -radius) {
+            return;
+        }
+        begin = middle + 1;
+    }
+}
+
+template<typename OBJECT>
+void
+PointTree<OBJECT>::findNearestObjectsForSubtree(size_t begin, size_t end,
+    const Vector3f &point, unsigned maximumObjects, float *maximumDistanceSquared,
+    NearestObjectVector *nearestObjectVector,
+    const NearestObjectFilter *nearestObjectFilter)
+{
+    if (begin >= end) {
+        return;
+    }
+
+    size_t middle = begin + (end - begin)/2;
+    const Vector3f &position = mPositionVector[middle];
+
+    if (end - begin > 1) {
+        // Visit the half of the tree containing the query point first,
+        // so that the search radius shrinks as quickly as possible.
+        unsigned axis = mAxisVector[middle];
+        float delta = point[axis] - position[axis];
+        if (delta < 0.0) {
+            findNearestObjectsForSubtree(begin, middle, point, maximumObjects,
+                maximumDistanceSquared, nearestObjectVector, nearestObjectFilter);
+            if (delta*delta < *maximumDistanceSquared) {
+                findNearestObjectsForSubtree(middle + 1, end, point, maximumObjects,
+                    maximumDistanceSquared, nearestObjectVector, nearestObjectFilter);
+            }
+        } else {
+            findNearestObjectsForSubtree(middle + 1, end, point, maximumObjects,
+                maximumDistanceSquared, nearestObjectVector, nearestObjectFilter);
+            if (delta*delta < *maximumDistanceSquared) {
+                findNearestObjectsForSubtree(begin, middle, point, maximumObjects,
+                    maximumDistanceSquared, nearestObjectVector, nearestObjectFilter);
+            }
+        }
+    }
+
+    ++mObjectTests;
+
+    float distanceSquared = (position - point).lengthSquared();
+    if (distanceSquared > *maximumDistanceSquared) {
+        return;
+    }
+
+    OBJECT &object = mObjectVector[middle];
+    if (nearestObjectFilter != NULL
+        && !nearestObjectFilter->acceptNearestObject(object)) {
+        return;
+    }
+
+    // Once the queue is full, an object must be closer than the
+    // farthest object in the queue to displace it.
+    if (nearestObjectVector->size() == maximumObjects) {
+        if (distanceSquared >= nearestObjectVector->front().mDistanceSquared) {
+            return;
+        }
+        std::pop_heap(nearestObjectVector->begin(), nearestObjectVector->end());
+        nearestObjectVector->pop_back();
+    }
+
+    NearestObject nearestObject;
+    nearestObject.mDistanceSquared = distanceSquared;
+    nearestObject.mObject = &object;
+    nearestObjectVector->push_back(nearestObject);
+    std::push_heap(nearestObjectVector->begin(), nearestObjectVector->end());
+
+    if (nearestObjectVector->size() == maximumObjects) {
+        *maximumDistanceSquared = nearestObjectVector->front().mDistanceSquared;
+    }
+}
+
+} // namespace cgmath
+
+#endif // CGMATH__POINT_TREE__INCLUDED
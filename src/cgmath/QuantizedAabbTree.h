@@ -0,0 +1,908 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__QUANTIZED_AABB_TREE__INCLUDED
+#define CGMATH__QUANTIZED_AABB_TREE__INCLUDED
+
+#include <cassert>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+#include "Vector3f.h"
+#include "BoundingBox3f.h"
+#include "BoundingBox3fOperations.h"
+#include "AabbTree.h"
+#include "AabbTreeStatistics.h"
+#include "RaySegment.h"
+
+namespace cgmath {
+
+// QuantizedAabbTree
+//
+// A compressed copy of an AabbTree, for large scenes where the memory
+// occupied by the tree matters more than the speed of its queries.
+//
+// Only the bounding box of the root node is stored in full. The bounding box
+// of every other node is quantized to 8 bits per coordinate, relative to the
+// bounding box of its parent, so each node occupies 12 bytes rather than 32.
+// The quantized boxes are rounded outward, so they always contain the
+// objects beneath them, and no query misses an object that the AabbTree
+// would have found. The boxes are decoded as the tree is traversed,
+// and since they're slightly larger, a few more objects are tested.
+//
+// Only the objects that the AabbTree's leaf nodes refer to are copied,
+// so that none of the space freed by AabbTree::removeObject is kept.
+//
+// The bounding box, triangle and ray segment queries of AabbTree are
+// supported, with the same listener classes, but objects may not be
+// inserted or removed. To modify the tree, build an AabbTree from
+// objectVector, and modify that instead.
+//
+// As with AabbTree, the queries don't modify the tree, so a tree may be
+// queried from several threads at once.
+
+template<typename OBJECT>
+class QuantizedAabbTree
+{
+public:
+    QuantizedAabbTree();
+    ~QuantizedAabbTree();
+
+    // Initialize the tree from an AabbTree. The objects are copied.
+    void initialize(const AabbTree<OBJECT> &aabbTree);
+
+    // Remove all of the objects from the tree, releasing the memory
+    // they occupied.
+    void clear();
+
+    // Returns true if the tree contains no objects.
+    bool empty() const;
+
+    // The objects in the tree, in the order of the leaf nodes that contain them.
+    const typename AabbTree<OBJECT>::ObjectVector &objectVector() const;
+
+    typedef typename AabbTree<OBJECT>::BoundingBoxListener BoundingBoxListener;
+
+    // Calls a BoundingBoxListener on all objects whose bounding boxes
+    // might intersect the specified bounding box,
+    // as with AabbTree::applyToBoundingBoxIntersection.
+    // Returns true if a listener function call returned true.
+    bool applyToBoundingBoxIntersection(const BoundingBox3f &boundingBox,
+        BoundingBoxListener *boundingBoxListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef typename AabbTree<OBJECT>::TriangleVector TriangleVector;
+    typedef typename AabbTree<OBJECT>::TriangleListener TriangleListener;
+
+    // Calls a TriangleListener on all objects whose bounding boxes
+    // might intersect the specified array of triangles,
+    // as with AabbTree::applyToTriangleVectorIntersection.
+    // Returns true if a listener function call returned true.
+    bool applyToTriangleVectorIntersection(const TriangleVector &triangleVector,
+        TriangleListener *triangleListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef typename AabbTree<OBJECT>::RaySegmentOcclusionListener
+    RaySegmentOcclusionListener;
+
+    // Returns true if the specified ray intersects one or more
+    // objects in the tree, as with AabbTree::occludesRaySegment.
+    bool occludesRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef typename AabbTree<OBJECT>::RaySegmentIntersectionListener
+    RaySegmentIntersectionListener;
+
+    // Returns true if the specified ray segment intersects one or more
+    // objects in the tree, returning the closest point of intersection
+    // and the intersected object, as with AabbTree::intersectsRaySegment.
+    bool intersectsRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+        const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+        cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // Number of bytes occupied by the tree.
+    size_t bytesUsed() const;
+
+private:
+    // These unimplemented declarations prevent objects of this class
+    // from being copied.
+    QuantizedAabbTree(const QuantizedAabbTree &);
+    void operator=(const QuantizedAabbTree &);
+
+    typedef AabbTree<OBJECT> SourceAabbTree;
+    typedef typename SourceAabbTree::QueryCounter QueryCounter;
+    typedef typename SourceAabbTree::NullQueryCounter NullQueryCounter;
+
+    // The largest quantized coordinate. A quantized minimum of zero decodes
+    // to the minimum of the parent's bounding box, and a quantized maximum
+    // of MAXIMUM_QUANTIZED_COORDINATE decodes to its maximum.
+    enum { MAXIMUM_QUANTIZED_COORDINATE = UCHAR_MAX };
+
+    // A decoded bounding box. This is stored as plain floats rather than
+    // as a BoundingBox3f, since two of them are decoded at every internal
+    // node that a query visits.
+    struct DecodedBoundingBox {
+        // Indexed like BoundingBox3f::operator().
+        float mBounds[2][3];
+    };
+
+    // As in AabbTree, both children of an internal node are adjacent.
+    struct Node {
+        // For a leaf node, the index of its first object in mObjectVector.
+        // For an internal node, the index of its left child node in mNodeVector.
+        unsigned mIndex;
+        // The number of objects in a leaf node, or zero for an internal node.
+        unsigned short mObjectCount;
+        // The node's bounding box, relative to its parent's bounding box,
+        // indexed like BoundingBox3f::operator(). These are unused
+        // for the root node.
+        unsigned char mQuantizedBounds[2][3];
+        bool isLeaf() const {
+            return mObjectCount != 0;
+        }
+    };
+    typedef std::vector<Node> NodeVector;
+
+    // Copy a subtree of the AabbTree, given the index of a node that's
+    // already been added to mNodeVector and the decoded bounding box
+    // it was assigned.
+    void quantizeSubtree(const SourceAabbTree &aabbTree, unsigned sourceNodeIndex,
+        unsigned nodeIndex, const DecodedBoundingBox &nodeBoundingBox);
+
+    // Set the quantized bounds of a node to the smallest box
+    // that decodes to a box containing the specified bounding box.
+    static void quantizeBoundingBox(const DecodedBoundingBox &parentBoundingBox,
+        const BoundingBox3f &boundingBox, Node *node);
+
+    // Decode the bounding boxes of the two children of an internal node.
+    void decodeChildBoundingBoxes(const DecodedBoundingBox &nodeBoundingBox,
+        const Node &node, DecodedBoundingBox *childBoundingBoxes) const;
+
+    // Decode one quantized coordinate of a minimum or maximum. The same
+    // computations are used both when a box is quantized and when it's
+    // decoded, so the outward rounding can't be undone by roundoff error.
+    static float decodeMinimum(float min, float step, unsigned quantizedMinimum);
+    static float decodeMaximum(float max, float step, unsigned quantizedMaximum);
+
+    // Convert between decoded bounding boxes and BoundingBox3f.
+    static DecodedBoundingBox toDecodedBoundingBox(const BoundingBox3f &boundingBox);
+    static BoundingBox3f toBoundingBox3f(const DecodedBoundingBox &decodedBoundingBox);
+
+    // Copy the decoded bounding boxes of the two children of a node into
+    // the first two entries of a BoundingBox3fQuad, so that a ray segment
+    // can be tested against both at once.
+    static void setBoundingBox3fQuad(const DecodedBoundingBox *childBoundingBoxes,
+        BoundingBox3fQuad *quad);
+
+    // Apply the bounding box intersection test to a subtree.
+    template<typename QUERY_COUNTER>
+    void applyToBoundingBoxIntersectionForSubtree(unsigned nodeIndex,
+        const DecodedBoundingBox &nodeBoundingBox, bool *halted,
+        const BoundingBox3f &boundingBox, BoundingBoxListener *boundingBoxListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the triangle intersection test to a subtree.
+    template<typename QUERY_COUNTER>
+    void applyToTriangleVectorIntersectionForSubtree(unsigned nodeIndex,
+        const DecodedBoundingBox &nodeBoundingBox, bool *halted,
+        const TriangleVector &triangleVector, TriangleListener *triangleListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment occlusion test to a subtree whose bounding box
+    // the ray segment is known to intersect.
+    template<typename QUERY_COUNTER>
+    bool occludesRaySegmentForSubtree(unsigned nodeIndex,
+        const DecodedBoundingBox &nodeBoundingBox, const RaySegment &raySegment,
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment intersection test to a subtree whose bounding box
+    // the ray segment is known to enter closer than 't'.
+    template<typename QUERY_COUNTER>
+    bool intersectsRaySegmentForSubtree(unsigned nodeIndex,
+        const DecodedBoundingBox &nodeBoundingBox, const RaySegment &raySegment,
+        const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+        float *t, OBJECT **intersectedObject,
+        QUERY_COUNTER *queryCounter) const;
+
+    // The bounding box of the root node.
+    DecodedBoundingBox mRootBoundingBox;
+
+    // The nodes of the tree. The root node is the first node.
+    NodeVector mNodeVector;
+
+    // The objects in the tree, in the order of the leaf nodes that contain them.
+    // This is mutable because the listeners are passed non-const references
+    // to the objects.
+    mutable typename SourceAabbTree::ObjectVector mObjectVector;
+};
+
+template<typename OBJECT>
+QuantizedAabbTree<OBJECT>::QuantizedAabbTree()
+    : mRootBoundingBox(toDecodedBoundingBox(BoundingBox3f())),
+      mNodeVector(),
+      mObjectVector()
+{
+}
+
+template<typename OBJECT>
+QuantizedAabbTree<OBJECT>::~QuantizedAabbTree()
+{
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::initialize(const AabbTree<OBJECT> &aabbTree)
+{
+    clear();
+
+    if (aabbTree.mNodeVector.empty()) {
+        return;
+    }
+
+    // Nodes and objects freed by removeObject aren't copied.
+    mNodeVector.reserve(aabbTree.mNodeVector.size()
+        - 2*aabbTree.mFreeNodePairVector.size());
+    mObjectVector.reserve(aabbTree.mObjectVector.size()
+        - aabbTree.mFreeObjectVector.size());
+
+    mRootBoundingBox = toDecodedBoundingBox(aabbTree.mNodeVector[0].mBoundingBox);
+
+    Node root;
+    root.mIndex = 0;
+    root.mObjectCount = 0;
+    quantizeBoundingBox(mRootBoundingBox, aabbTree.mNodeVector[0].mBoundingBox, &root);
+    mNodeVector.push_back(root);
+
+    quantizeSubtree(aabbTree, 0, 0, mRootBoundingBox);
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::clear()
+{
+    mRootBoundingBox = toDecodedBoundingBox(BoundingBox3f());
+    NodeVector().swap(mNodeVector);
+    typename SourceAabbTree::ObjectVector().swap(mObjectVector);
+}
+
+template<typename OBJECT>
+bool
+QuantizedAabbTree<OBJECT>::empty() const
+{
+    return mNodeVector.empty();
+}
+
+template<typename OBJECT>
+const typename AabbTree<OBJECT>::ObjectVector &
+QuantizedAabbTree<OBJECT>::objectVector() const
+{
+    return mObjectVector;
+}
+
+template<typename OBJECT>
+bool
+QuantizedAabbTree<OBJECT>::applyToBoundingBoxIntersection(const BoundingBox3f &boundingBox,
+    BoundingBoxListener *boundingBoxListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(boundingBoxListener != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    bool halted = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToBoundingBoxIntersectionForSubtree(0, mRootBoundingBox, &halted,
+            boundingBox, boundingBoxListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToBoundingBoxIntersectionForSubtree(0, mRootBoundingBox, &halted,
+            boundingBox, boundingBoxListener, &nullQueryCounter);
+    }
+
+    return halted;
+}
+
+template<typename OBJECT>
+bool
+QuantizedAabbTree<OBJECT>::applyToTriangleVectorIntersection(
+    const TriangleVector &triangleVector, TriangleListener *triangleListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(triangleListener != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    bool halted = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        applyToTriangleVectorIntersectionForSubtree(0, mRootBoundingBox, &halted,
+            triangleVector, triangleListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        applyToTriangleVectorIntersectionForSubtree(0, mRootBoundingBox, &halted,
+            triangleVector, triangleListener, &nullQueryCounter);
+    }
+
+    return halted;
+}
+
+template<typename OBJECT>
+bool
+QuantizedAabbTree<OBJECT>::occludesRaySegment(const Vector3f &origin,
+    const Vector3f &endpoint,
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(raySegmentOcclusionListener != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    RaySegment raySegment(origin, endpoint);
+    bool result = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        queryCounter.countBoundingBoxTest();
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(toBoundingBox3f(mRootBoundingBox), 1.0,
+                &rootT)) {
+            result = occludesRaySegmentForSubtree(0, mRootBoundingBox, raySegment,
+                raySegmentOcclusionListener, &queryCounter);
+        }
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(toBoundingBox3f(mRootBoundingBox), 1.0,
+                &rootT)) {
+            result = occludesRaySegmentForSubtree(0, mRootBoundingBox, raySegment,
+                raySegmentOcclusionListener, &nullQueryCounter);
+        }
+    }
+
+    return result;
+}
+
+template<typename OBJECT>
+bool
+QuantizedAabbTree<OBJECT>::intersectsRaySegment(const Vector3f &origin,
+    const Vector3f &endpoint,
+    const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+    cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(raySegmentIntersectionListener != NULL);
+    assert(intersectionPoint != NULL);
+    assert(intersectedObject != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    RaySegment raySegment(origin, endpoint);
+    float t = 1.0;
+    *intersectedObject = NULL;
+    bool result = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        queryCounter.countBoundingBoxTest();
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(toBoundingBox3f(mRootBoundingBox), t,
+                &rootT)
+            && rootT < t) {
+            result = intersectsRaySegmentForSubtree(0, mRootBoundingBox, raySegment,
+                raySegmentIntersectionListener, &t, intersectedObject, &queryCounter);
+        }
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        float rootT = 0.0;
+        if (raySegment.intersectsBoundingBox3f(toBoundingBox3f(mRootBoundingBox), t,
+                &rootT)
+            && rootT < t) {
+            result = intersectsRaySegmentForSubtree(0, mRootBoundingBox, raySegment,
+                raySegmentIntersectionListener, &t, intersectedObject, &nullQueryCounter);
+        }
+    }
+
+    *intersectionPoint = origin*(1.0 - t) + endpoint*t;
+
+    return result;
+}
+
+template<typename OBJECT>
+size_t
+QuantizedAabbTree<OBJECT>::bytesUsed() const
+{
+    return mNodeVector.capacity()*sizeof(Node)
+        + mObjectVector.capacity()*sizeof(OBJECT);
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::quantizeSubtree(const SourceAabbTree &aabbTree,
+    unsigned sourceNodeIndex, unsigned nodeIndex, const DecodedBoundingBox &nodeBoundingBox)
+{
+    const typename SourceAabbTree::Node &sourceNode = aabbTree.mNodeVector[sourceNodeIndex];
+
+    if (sourceNode.isLeaf()) {
+        assert(sourceNode.mObjectCount <= USHRT_MAX);
+        mNodeVector[nodeIndex].mIndex = mObjectVector.size();
+        mNodeVector[nodeIndex].mObjectCount = sourceNode.mObjectCount;
+        mObjectVector.insert(mObjectVector.end(),
+            aabbTree.mObjectVector.begin() + sourceNode.mIndex,
+            aabbTree.mObjectVector.begin() + sourceNode.mIndex + sourceNode.mObjectCount);
+        return;
+    }
+
+    // The recursive calls may reallocate mNodeVector,
+    // so the nodes are referred to by index.
+    unsigned childIndex = mNodeVector.size();
+    mNodeVector[nodeIndex].mIndex = childIndex;
+    mNodeVector[nodeIndex].mObjectCount = 0;
+
+    Node child;
+    child.mIndex = 0;
+    child.mObjectCount = 0;
+    for (unsigned index = 0; index < 2; ++index) {
+        quantizeBoundingBox(nodeBoundingBox,
+            aabbTree.mNodeVector[sourceNode.mIndex + index].mBoundingBox, &child);
+        mNodeVector.push_back(child);
+    }
+
+    // The children are quantized relative to their parent's decoded
+    // bounding box, not its original one, since that's all that's
+    // available when the tree is traversed.
+    DecodedBoundingBox childBoundingBoxes[2];
+    decodeChildBoundingBoxes(nodeBoundingBox, mNodeVector[nodeIndex], childBoundingBoxes);
+
+    for (unsigned index = 0; index < 2; ++index) {
+        quantizeSubtree(aabbTree, sourceNode.mIndex + index, childIndex + index,
+            childBoundingBoxes[index]);
+    }
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::quantizeBoundingBox(
+    const DecodedBoundingBox &parentBoundingBox, const BoundingBox3f &boundingBox,
+    Node *node)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        float min = parentBoundingBox.mBounds[0][axis];
+        float max = parentBoundingBox.mBounds[1][axis];
+        float step = (max - min)*(1.0f/MAXIMUM_QUANTIZED_COORDINATE);
+        float boxMin = boundingBox(0, axis);
+        float boxMax = boundingBox(1, axis);
+        assert(boxMin >= min && boxMax <= max);
+
+        // Estimate the quantized coordinates, rounding outward, and then
+        // correct the estimates for roundoff error, so that the decoded
+        // box always contains the original one. The extreme quantized
+        // coordinates decode to the parent's bounds exactly,
+        // so this always succeeds.
+        int quantizedMin = 0;
+        int quantizedMax = MAXIMUM_QUANTIZED_COORDINATE;
+        if (step > 0.0) {
+            quantizedMin = std::max(0, std::min(int(MAXIMUM_QUANTIZED_COORDINATE),
+                    int(std::floor((boxMin - min)/step))));
+            quantizedMax = std::max(0, std::min(int(MAXIMUM_QUANTIZED_COORDINATE),
+                    int(std::ceil((boxMax - min)/step))));
+            while (quantizedMin > 0
+                && decodeMinimum(min, step, quantizedMin) > boxMin) {
+                --quantizedMin;
+            }
+            while (quantizedMin < MAXIMUM_QUANTIZED_COORDINATE
+                && decodeMinimum(min, step, quantizedMin + 1) <= boxMin) {
+                ++quantizedMin;
+            }
+            while (quantizedMax < MAXIMUM_QUANTIZED_COORDINATE
+                && decodeMaximum(max, step, quantizedMax) < boxMax) {
+                ++quantizedMax;
+            }
+            while (quantizedMax > 0
+                && decodeMaximum(max, step, quantizedMax - 1) >= boxMax) {
+                --quantizedMax;
+            }
+        }
+
+        node->mQuantizedBounds[0][axis] = quantizedMin;
+        node->mQuantizedBounds[1][axis] = quantizedMax;
+    }
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::decodeChildBoundingBoxes(
+    const DecodedBoundingBox &nodeBoundingBox, const Node &node,
+    DecodedBoundingBox *childBoundingBoxes) const
+{
+    assert(!node.isLeaf());
+
+    const Node *children = &mNodeVector[node.mIndex];
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float min = nodeBoundingBox.mBounds[0][axis];
+        float max = nodeBoundingBox.mBounds[1][axis];
+        float step = (max - min)*(1.0f/MAXIMUM_QUANTIZED_COORDINATE);
+        for (unsigned index = 0; index < 2; ++index) {
+            childBoundingBoxes[index].mBounds[0][axis] = decodeMinimum(min, step,
+                children[index].mQuantizedBounds[0][axis]);
+            childBoundingBoxes[index].mBounds[1][axis] = decodeMaximum(max, step,
+                children[index].mQuantizedBounds[1][axis]);
+        }
+    }
+}
+
+template<typename OBJECT>
+float
+QuantizedAabbTree<OBJECT>::decodeMinimum(float min, float step, unsigned quantizedMinimum)
+{
+    return min + step*float(quantizedMinimum);
+}
+
+template<typename OBJECT>
+float
+QuantizedAabbTree<OBJECT>::decodeMaximum(float max, float step, unsigned quantizedMaximum)
+{
+    return max - step*float(MAXIMUM_QUANTIZED_COORDINATE - quantizedMaximum);
+}
+
+template<typename OBJECT>
+typename QuantizedAabbTree<OBJECT>::DecodedBoundingBox
+QuantizedAabbTree<OBJECT>::toDecodedBoundingBox(const BoundingBox3f &boundingBox)
+{
+    DecodedBoundingBox decodedBoundingBox;
+    for (int axis = 0; axis < 3; ++axis) {
+        decodedBoundingBox.mBounds[0][axis] = boundingBox(0, axis);
+        decodedBoundingBox.mBounds[1][axis] = boundingBox(1, axis);
+    }
+
+    return decodedBoundingBox;
+}
+
+template<typename OBJECT>
+BoundingBox3f
+QuantizedAabbTree<OBJECT>::toBoundingBox3f(const DecodedBoundingBox &decodedBoundingBox)
+{
+    return BoundingBox3f(
+        decodedBoundingBox.mBounds[0][0], decodedBoundingBox.mBounds[1][0],
+        decodedBoundingBox.mBounds[0][1], decodedBoundingBox.mBounds[1][1],
+        decodedBoundingBox.mBounds[0][2], decodedBoundingBox.mBounds[1][2]);
+}
+
+template<typename OBJECT>
+void
+QuantizedAabbTree<OBJECT>::setBoundingBox3fQuad(const DecodedBoundingBox *childBoundingBoxes,
+    BoundingBox3fQuad *quad)
+{
+    for (unsigned index = 0; index < 2; ++index) {
+        for (int axis = 0; axis < 3; ++axis) {
+            quad->mBounds[0][axis][index] = childBoundingBoxes[index].mBounds[0][axis];
+            quad->mBounds[1][axis][index] = childBoundingBoxes[index].mBounds[1][axis];
+        }
+    }
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+void
+QuantizedAabbTree<OBJECT>::applyToBoundingBoxIntersectionForSubtree(unsigned nodeIndex,
+    const DecodedBoundingBox &nodeBoundingBox, bool *halted,
+    const BoundingBox3f &boundingBox, BoundingBoxListener *boundingBoxListener,
+    QUERY_COUNTER *queryCounter) const
+{
+    if (*halted) {
+        return;
+    }
+
+    DecodedBoundingBox currentBoundingBox = nodeBoundingBox;
+
+    while (true) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        queryCounter->countBoundingBoxTest();
+
+        // If the specified bounding box doesn't intersect
+        // the node's bounding box, skip this subtree.
+        if (!BoundingBox3fIntersectsBoundingBox3f(boundingBox,
+                toBoundingBox3f(currentBoundingBox))) {
+            return;
+        }
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                // If the callback returns true, skip all further processing.
+                if (boundingBoxListener->applyObjectToBoundingBox(object, boundingBox)) {
+                    *halted = true;
+                    return;
+                }
+            }
+            return;
+        }
+
+        DecodedBoundingBox childBoundingBoxes[2];
+        decodeChildBoundingBoxes(currentBoundingBox, node, childBoundingBoxes);
+
+        // Evaluate the left subtree.
+        applyToBoundingBoxIntersectionForSubtree(node.mIndex, childBoundingBoxes[0],
+            halted, boundingBox, boundingBoxListener, queryCounter);
+        if (*halted) {
+            return;
+        }
+
+        // To avoid function call overhead, loop on the right subtree
+        // rather than using recursion.
+        nodeIndex = node.mIndex + 1;
+        currentBoundingBox = childBoundingBoxes[1];
+    }
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+void
+QuantizedAabbTree<OBJECT>::applyToTriangleVectorIntersectionForSubtree(unsigned nodeIndex,
+    const DecodedBoundingBox &nodeBoundingBox, bool *halted,
+    const TriangleVector &triangleVector, TriangleListener *triangleListener,
+    QUERY_COUNTER *queryCounter) const
+{
+    if (*halted) {
+        return;
+    }
+
+    DecodedBoundingBox currentBoundingBox = nodeBoundingBox;
+
+    while (true) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        queryCounter->countBoundingBoxTest();
+
+        // If none of the specified triangles intersect
+        // the node's bounding box, skip this subtree.
+        const BoundingBox3f boundingBox = toBoundingBox3f(currentBoundingBox);
+        bool foundIntersection = false;
+        for (unsigned index = 0; index < triangleVector.size(); ++index) {
+            if (BoundingBox3fIntersectsTriangle(boundingBox,
+                    triangleVector[index].mPointArray[0],
+                    triangleVector[index].mPointArray[1],
+                    triangleVector[index].mPointArray[2])) {
+                foundIntersection = true;
+                break;
+            }
+        }
+        if (!foundIntersection) {
+            return;
+        }
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                // If the callback returns true, skip all further processing.
+                if (triangleListener->applyObjectToTriangleVector(object, triangleVector)) {
+                    *halted = true;
+                    return;
+                }
+            }
+            return;
+        }
+
+        DecodedBoundingBox childBoundingBoxes[2];
+        decodeChildBoundingBoxes(currentBoundingBox, node, childBoundingBoxes);
+
+        // Evaluate the left subtree.
+        applyToTriangleVectorIntersectionForSubtree(node.mIndex, childBoundingBoxes[0],
+            halted, triangleVector, triangleListener, queryCounter);
+        if (*halted) {
+            return;
+        }
+
+        // To avoid function call overhead, loop on the right subtree
+        // rather than using recursion.
+        nodeIndex = node.mIndex + 1;
+        currentBoundingBox = childBoundingBoxes[1];
+    }
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+bool
+QuantizedAabbTree<OBJECT>::occludesRaySegmentForSubtree(unsigned nodeIndex,
+    const DecodedBoundingBox &nodeBoundingBox, const RaySegment &raySegment,
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    QUERY_COUNTER *queryCounter) const
+{
+    DecodedBoundingBox currentBoundingBox = nodeBoundingBox;
+
+    // Only the first two entries are used.
+    BoundingBox3fQuad quad;
+    quad.reset(2);
+    quad.reset(3);
+
+    while (true) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                queryCounter->countObjectTest();
+
+                // If the callback returns true, we've hit something,
+                // and there's no need to perform further tests.
+                if (raySegmentOcclusionListener->objectOccludesRaySegment(
+                        mObjectVector[index], raySegment.origin(), raySegment.endpoint())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // As in AabbTree, both children are tested here, so that
+        // the nearer one can be evaluated first. As in WideAabbTree,
+        // they're tested at once.
+        DecodedBoundingBox childBoundingBoxes[2];
+        decodeChildBoundingBoxes(currentBoundingBox, node, childBoundingBoxes);
+        setBoundingBox3fQuad(childBoundingBoxes, &quad);
+
+        float childT[4];
+        queryCounter->countBoundingBoxTest();
+        queryCounter->countBoundingBoxTest();
+        unsigned hitMask = raySegment.intersectsBoundingBox3fQuad(quad, 1.0, childT);
+
+        unsigned nearChild = 0;
+        unsigned farChild = 1;
+        float nearT = childT[0];
+        float farT = childT[1];
+        bool nearHit = (hitMask & 1) != 0;
+        bool farHit = (hitMask & 2) != 0;
+
+        if (nearHit && farHit) {
+            if (farT < nearT) {
+                std::swap(nearChild, farChild);
+            }
+
+            // Evaluate the nearer subtree.
+            if (occludesRaySegmentForSubtree(node.mIndex + nearChild,
+                    childBoundingBoxes[nearChild], raySegment,
+                    raySegmentOcclusionListener, queryCounter)) {
+                return true;
+            }
+
+            // To avoid function call overhead, loop on the farther subtree
+            // rather than using recursion.
+            nodeIndex = node.mIndex + farChild;
+            currentBoundingBox = childBoundingBoxes[farChild];
+        } else if (nearHit) {
+            nodeIndex = node.mIndex + nearChild;
+            currentBoundingBox = childBoundingBoxes[nearChild];
+        } else if (farHit) {
+            nodeIndex = node.mIndex + farChild;
+            currentBoundingBox = childBoundingBoxes[farChild];
+        } else {
+            return false;
+        }
+    }
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+bool
+QuantizedAabbTree<OBJECT>::intersectsRaySegmentForSubtree(unsigned nodeIndex,
+    const DecodedBoundingBox &nodeBoundingBox, const RaySegment &raySegment,
+    const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+    float *t, OBJECT **intersectedObject,
+    QUERY_COUNTER *queryCounter) const
+{
+    DecodedBoundingBox currentBoundingBox = nodeBoundingBox;
+    bool result = false;
+
+    // Only the first two entries are used.
+    BoundingBox3fQuad quad;
+    quad.reset(2);
+    quad.reset(3);
+
+    while (true) {
+        const Node &node = mNodeVector[nodeIndex];
+
+        if (node.isLeaf()) {
+            // Evaluate the callback on all of the objects in this node.
+            for (unsigned index = node.mIndex; index < node.mIndex + node.mObjectCount;
+                 ++index) {
+                OBJECT &object = mObjectVector[index];
+
+                queryCounter->countObjectTest();
+
+                if (raySegmentIntersectionListener->objectIntersectsRaySegment(object,
+                        raySegment.origin(), raySegment.endpoint(), t)) {
+                    result = true;
+                    *intersectedObject = &object;
+                }
+            }
+            return result;
+        }
+
+        // As in AabbTree, both children are tested here, so that the
+        // nearer one can be evaluated first, and children that the
+        // ray segment enters no closer than 't' are skipped.
+        DecodedBoundingBox childBoundingBoxes[2];
+        decodeChildBoundingBoxes(currentBoundingBox, node, childBoundingBoxes);
+        setBoundingBox3fQuad(childBoundingBoxes, &quad);
+
+        float childT[4];
+        queryCounter->countBoundingBoxTest();
+        queryCounter->countBoundingBoxTest();
+        unsigned hitMask = raySegment.intersectsBoundingBox3fQuad(quad, *t, childT);
+
+        unsigned nearChild = 0;
+        unsigned farChild = 1;
+        float nearT = childT[0];
+        float farT = childT[1];
+        bool nearHit = (hitMask & 1) != 0 && nearT < *t;
+        bool farHit = (hitMask & 2) != 0 && farT < *t;
+
+        if (nearHit && farHit) {
+            if (farT < nearT) {
+                std::swap(nearChild, farChild);
+                std::swap(nearT, farT);
+            }
+
+            // Evaluate the nearer subtree.
+            if (intersectsRaySegmentForSubtree(node.mIndex + nearChild,
+                    childBoundingBoxes[nearChild], raySegment,
+                    raySegmentIntersectionListener, t, intersectedObject, queryCounter)) {
+                result = true;
+            }
+
+            // The nearer subtree may have found an intersection
+            // in front of the farther subtree.
+            if (farT >= *t) {
+                return result;
+            }
+
+            // To avoid function call overhead, loop on the farther subtree
+            // rather than using recursion.
+            nodeIndex = node.mIndex + farChild;
+            currentBoundingBox = childBoundingBoxes[farChild];
+        } else if (nearHit) {
+            nodeIndex = node.mIndex + nearChild;
+            currentBoundingBox = childBoundingBoxes[nearChild];
+        } else if (farHit) {
+            nodeIndex = node.mIndex + farChild;
+            currentBoundingBox = childBoundingBoxes[farChild];
+        } else {
+            return result;
+        }
+    }
+}
+
+} // namespace cgmath
+
+#endif // CGMATH__QUANTIZED_AABB_TREE__INCLUDED
@@ -0,0 +1,207 @@
+// Copyright 2010 Drew Olbrich
+
+#include "RaySegment.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "BoundingBox3f.h"
+
+namespace cgmath {
+
+// The factor by which the far end of each slab is pushed out.
+// The three floating point operations that compute the far end
+// can each be off by half an ulp, and this bounds their combined error,
+// as described in section 3.9.2 of Physically Based Rendering,
+// second edition.
+static const float FAR_T_GROWTH = 1.0
+    + 2.0*3.0*(std::numeric_limits<float>::epsilon()*0.5)
+    /(1.0 - 3.0*(std::numeric_limits<float>::epsilon()*0.5));
+
+void
+BoundingBox3fQuad::setBoundingBox3f(unsigned index, const BoundingBox3f &bbox)
+{
+    assert(index < 4);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        mBounds[0][axis][index] = bbox.min()[axis];
+        mBounds[1][axis][index] = bbox.max()[axis];
+    }
+}
+
+void
+BoundingBox3fQuad::reset(unsigned index)
+{
+    assert(index < 4);
+
+    // The slabs of an inverted box have negative thickness,
+    // so the near end of each slab is always beyond the far end.
+    for (int axis = 0; axis < 3; ++axis) {
+        mBounds[0][axis][index] = std::numeric_limits<float>::max();
+        mBounds[1][axis][index] = -std::numeric_limits<float>::max();
+    }
+}
+
+RaySegment::RaySegment(const Vector3f &origin, const Vector3f &endpoint)
+    : mOrigin(origin),
+      mEndpoint(endpoint),
+      mInverseDirection()
+{
+    const Vector3f direction = endpoint - origin;
+    for (int axis = 0; axis < 3; ++axis) {
+        // Directions so close to zero that their reciprocal would overflow
+        // are treated as zero.
+        mParallel[axis] = std::fabs(direction[axis])
+            <= 1.0/std::numeric_limits<float>::max();
+        if (mParallel[axis]) {
+            mInverseDirection[axis] = 0.0;
+        } else {
+            mInverseDirection[axis] = 1.0/direction[axis];
+        }
+        mSign[axis] = direction[axis] < 0.0 ? 1 : 0;
+    }
+}
+
+RaySegment::~RaySegment()
+{
+}
+
+const Vector3f &
+RaySegment::origin() const
+{
+    return mOrigin;
+}
+
+const Vector3f &
+RaySegment::endpoint() const
+{
+    return mEndpoint;
+}
+
+const Vector3f &
+RaySegment::inverseDirection() const
+{
+    return mInverseDirection;
+}
+
+int
+RaySegment::sign(int axis) const
+{
+    assert(axis >= 0 && axis <= 2);
+
+    return mSign[axis];
+}
+
+bool
+RaySegment::parallel(int axis) const
+{
+    assert(axis >= 0 && axis <= 2);
+
+    return mParallel[axis];
+}
+
+bool
+RaySegment::intersectsBoundingBox3f(const BoundingBox3f &bbox, float maxT, float *t) const
+{
+    assert(t != NULL);
+
+    float nearT = 0.0;
+    float farT = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        // If the ray segment is parallel to the slab,
+        // it either lies entirely within it, or misses it.
+        if (mParallel[axis]) {
+            if (mOrigin[axis] < bbox.min()[axis] || mOrigin[axis] > bbox.max()[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float slabNearT = (bbox(mSign[axis], axis) - mOrigin[axis])
+            *mInverseDirection[axis];
+        float slabFarT = (bbox(1 - mSign[axis], axis) - mOrigin[axis])
+            *mInverseDirection[axis]*FAR_T_GROWTH;
+        nearT = std::max(nearT, slabNearT);
+        farT = std::min(farT, slabFarT);
+        if (nearT > farT) {
+            return false;
+        }
+    }
+
+    *t = nearT;
+
+    return true;
+}
+
+unsigned
+RaySegment::intersectsBoundingBox3fQuad(const BoundingBox3fQuad &quad, float maxT,
+    float *t) const
+{
+    assert(t != NULL);
+
+#ifdef __SSE__
+    __m128 nearT = _mm_setzero_ps();
+    __m128 farT = _mm_set1_ps(maxT);
+    // The boxes whose slabs a parallel ray segment lies outside of
+    // are marked by setting this to all ones.
+    __m128 missed = _mm_setzero_ps();
+    const __m128 farTGrowth = _mm_set1_ps(FAR_T_GROWTH);
+    for (int axis = 0; axis < 3; ++axis) {
+        const __m128 origin = _mm_set1_ps(mOrigin[axis]);
+        if (mParallel[axis]) {
+            missed = _mm_or_ps(missed, _mm_or_ps(
+                    _mm_cmplt_ps(origin, _mm_loadu_ps(quad.mBounds[0][axis])),
+                    _mm_cmpgt_ps(origin, _mm_loadu_ps(quad.mBounds[1][axis]))));
+            continue;
+        }
+        const __m128 inverseDirection = _mm_set1_ps(mInverseDirection[axis]);
+        __m128 slabNearT = _mm_mul_ps(
+            _mm_sub_ps(_mm_loadu_ps(quad.mBounds[mSign[axis]][axis]), origin),
+            inverseDirection);
+        __m128 slabFarT = _mm_mul_ps(_mm_mul_ps(
+                _mm_sub_ps(_mm_loadu_ps(quad.mBounds[1 - mSign[axis]][axis]), origin),
+                inverseDirection), farTGrowth);
+        nearT = _mm_max_ps(nearT, slabNearT);
+        farT = _mm_min_ps(farT, slabFarT);
+    }
+
+    _mm_storeu_ps(t, nearT);
+
+    return _mm_movemask_ps(_mm_andnot_ps(missed, _mm_cmple_ps(nearT, farT)));
+#else
+    unsigned result = 0;
+    for (unsigned index = 0; index < 4; ++index) {
+        float nearT = 0.0;
+        float farT = maxT;
+        bool missed = false;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (mParallel[axis]) {
+                if (mOrigin[axis] < quad.mBounds[0][axis][index]
+                    || mOrigin[axis] > quad.mBounds[1][axis][index]) {
+                    missed = true;
+                }
+                continue;
+            }
+            float slabNearT = (quad.mBounds[mSign[axis]][axis][index] - mOrigin[axis])
+                *mInverseDirection[axis];
+            float slabFarT = (quad.mBounds[1 - mSign[axis]][axis][index] - mOrigin[axis])
+                *mInverseDirection[axis]*FAR_T_GROWTH;
+            nearT = std::max(nearT, slabNearT);
+            farT = std::min(farT, slabFarT);
+        }
+        t[index] = nearT;
+        if (!missed && nearT <= farT) {
+            result |= 1 << index;
+        }
+    }
+
+    return result;
+#endif
+}
+
+} // namespace cgmath
@@ -0,0 +1,88 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__RAY_SEGMENT__INCLUDED
+#define CGMATH__RAY_SEGMENT__INCLUDED
+
+#include "Vector3f.h"
+
+namespace cgmath {
+
+class BoundingBox3f;
+
+// The bounding boxes of four objects, stored so that each coordinate
+// of all four boxes can be loaded into a single SSE register.
+// The first index is 0 for the minimum and 1 for the maximum,
+// as with BoundingBox3f::operator(), the second is the axis,
+// and the third selects the box.
+struct BoundingBox3fQuad {
+    float mBounds[2][3][4];
+
+    // Set one of the four boxes.
+    void setBoundingBox3f(unsigned index, const BoundingBox3f &bbox);
+
+    // Set one of the four boxes to a box that no ray segment intersects.
+    void reset(unsigned index);
+};
+
+// RaySegment
+//
+// A ray segment from an origin to an endpoint. The reciprocal of its direction,
+// and the sign of each component of its direction, are computed once,
+// so that the ray segment may be tested against many bounding boxes
+// without any divisions, as when traversing an AABB tree.
+//
+// The bounding box tests use the slab method. The far end of each slab
+// is pushed out very slightly, so that roundoff error never causes a box
+// that the ray segment grazes to be missed.
+
+class RaySegment
+{
+public:
+    RaySegment(const Vector3f &origin, const Vector3f &endpoint);
+    ~RaySegment();
+
+    const Vector3f &origin() const;
+    const Vector3f &endpoint() const;
+
+    // The reciprocal of each component of the direction (endpoint - origin).
+    // Components of the direction that are zero have a reciprocal of zero.
+    const Vector3f &inverseDirection() const;
+
+    // Returns 1 if the direction is negative along an axis, and 0 otherwise.
+    // This is the index of the near side of a bounding box along the axis,
+    // as passed to BoundingBox3f::operator().
+    int sign(int axis) const;
+
+    // Returns true if the direction is zero along an axis, so that the
+    // ray segment is parallel to the slabs of bounding boxes along that axis.
+    // These slabs are tested by comparing them with the origin directly,
+    // rather than by computing infinite values of t, which would
+    // produce NaNs when the origin lies on the side of a box.
+    bool parallel(int axis) const;
+
+    // Returns true if the ray segment intersects a bounding box
+    // between t=0 and t=maxT, where t=0 at the origin and t=1 at the endpoint.
+    // The value of t where the ray segment enters the bounding box
+    // is returned via t, which is 0 if the origin is inside the box.
+    bool intersectsBoundingBox3f(const BoundingBox3f &bbox, float maxT, float *t) const;
+
+    // Tests the ray segment against four bounding boxes at once, as with
+    // intersectsBoundingBox3f. Bit n of the result is set if the ray segment
+    // intersects box n, and the values of t where it enters each box
+    // are returned via t, which must point to an array of four floats.
+    // When compiled with SSE, each coordinate of the four boxes is tested
+    // with a single instruction.
+    unsigned intersectsBoundingBox3fQuad(const BoundingBox3fQuad &quad, float maxT,
+        float *t) const;
+
+private:
+    Vector3f mOrigin;
+    Vector3f mEndpoint;
+    Vector3f mInverseDirection;
+    int mSign[3];
+    bool mParallel[3];
+};
+
+} // namespace cgmath
+
+#endif // CGMATH__RAY_SEGMENT__INCLUDED
@@ -0,0 +1,470 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef CGMATH__WIDE_AABB_TREE__INCLUDED
+#define CGMATH__WIDE_AABB_TREE__INCLUDED
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "Vector3f.h"
+#include "BoundingBox3f.h"
+#include "BoundingBox3fOperations.h"
+#include "AabbTree.h"
+#include "AabbTreeStatistics.h"
+#include "RaySegment.h"
+
+namespace cgmath {
+
+// WideAabbTree
+//
+// An axis-aligned bounding box tree with up to four children per node,
+// built by collapsing the nodes of an AabbTree. The bounding boxes of
+// the children of each node are stored together, so that a ray segment
+// can be tested against all of them at once with SSE instructions.
+// The children that the ray segment intersects are evaluated in order
+// of increasing distance along it.
+//
+// Only the ray segment queries of AabbTree are supported, with the same
+// listener classes, and objects may not be inserted or removed.
+// If the AabbTree it was built from is modified, the WideAabbTree
+// must be initialized again.
+//
+// As with AabbTree, the queries don't modify the tree, so a tree may be
+// queried from several threads at once.
+
+template<typename OBJECT>
+class WideAabbTree
+{
+public:
+    WideAabbTree();
+    ~WideAabbTree();
+
+    // Initialize the tree from an AabbTree. The objects are copied.
+    void initialize(const AabbTree<OBJECT> &aabbTree);
+
+    // Remove all of the objects from the tree, releasing the memory
+    // they occupied.
+    void clear();
+
+    // Returns true if the tree contains no objects.
+    bool empty() const;
+
+    typedef typename AabbTree<OBJECT>::RaySegmentOcclusionListener
+    RaySegmentOcclusionListener;
+
+    // Returns true if the specified ray intersects one or more
+    // objects in the tree, as with AabbTree::occludesRaySegment.
+    bool occludesRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef typename AabbTree<OBJECT>::RaySegmentIntersectionListener
+    RaySegmentIntersectionListener;
+
+    // Returns true if the specified ray segment intersects one or more
+    // objects in the tree, returning the closest point of intersection
+    // and the intersected object, as with AabbTree::intersectsRaySegment.
+    bool intersectsRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+        const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+        cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+        AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // Number of bytes occupied by the tree.
+    size_t bytesUsed() const;
+
+private:
+    // These unimplemented declarations prevent objects of this class
+    // from being copied.
+    WideAabbTree(const WideAabbTree &);
+    void operator=(const WideAabbTree &);
+
+    typedef AabbTree<OBJECT> SourceAabbTree;
+    typedef typename SourceAabbTree::QueryCounter QueryCounter;
+    typedef typename SourceAabbTree::NullQueryCounter NullQueryCounter;
+
+    // A node of the tree, which records its children's bounding boxes.
+    // A node has between two and four children, except for the root node
+    // of a tree built from an AabbTree with a single leaf node,
+    // which has one child.
+    struct Node {
+        // The bounding boxes of the children. Unused entries are reset,
+        // so that no ray segment intersects them.
+        BoundingBox3fQuad mChildBoundingBoxes;
+        // For a leaf child, the index of its first object in mObjectVector.
+        // For an internal child, the index of its node in mNodeVector.
+        unsigned mChildIndex[4];
+        // The number of objects in each leaf child.
+        unsigned mChildObjectCount[4];
+        // Bit n is set if child n exists.
+        unsigned mChildMask;
+        // Bit n is set if child n is a leaf.
+        unsigned mLeafMask;
+    };
+    typedef std::vector<Node> NodeVector;
+
+    // Create a node whose children are the nearest descendants of a node
+    // of the AabbTree, opening the internal descendant with the largest
+    // surface area until there are four. Returns the index of the new node.
+    unsigned collapseSubtree(const SourceAabbTree &aabbTree, unsigned sourceNodeIndex);
+
+    // Find the children of a node that a ray segment intersects closer
+    // than maxT, returning their indices sorted by increasing values of 't'
+    // via childOrder, and the values of 't' via childT.
+    // Returns the number of children found.
+    template<typename QUERY_COUNTER>
+    unsigned findIntersectedChildren(const Node &node, const RaySegment &raySegment,
+        float maxT, unsigned *childOrder, float *childT,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment occlusion test to a subtree.
+    template<typename QUERY_COUNTER>
+    bool occludesRaySegmentForSubtree(unsigned nodeIndex,
+        const RaySegment &raySegment,
+        const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+        QUERY_COUNTER *queryCounter) const;
+
+    // Apply the ray segment intersection test to a subtree.
+    template<typename QUERY_COUNTER>
+    bool intersectsRaySegmentForSubtree(unsigned nodeIndex,
+        const RaySegment &raySegment,
+        const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+        float *t, OBJECT **intersectedObject,
+        QUERY_COUNTER *queryCounter) const;
+
+    // The nodes of the tree. The root node is the first node.
+    NodeVector mNodeVector;
+
+    // The objects in the tree, in the same order as in the AabbTree.
+    // This is mutable because intersectsRaySegment returns a non-const
+    // pointer to the intersected object.
+    mutable typename SourceAabbTree::ObjectVector mObjectVector;
+};
+
+template<typename OBJECT>
+WideAabbTree<OBJECT>::WideAabbTree()
+    : mNodeVector(),
+      mObjectVector()
+{
+}
+
+template<typename OBJECT>
+WideAabbTree<OBJECT>::~WideAabbTree()
+{
+}
+
+template<typename OBJECT>
+void
+WideAabbTree<OBJECT>::initialize(const AabbTree<OBJECT> &aabbTree)
+{
+    clear();
+
+    if (aabbTree.mNodeVector.empty()) {
+        return;
+    }
+
+    // The leaf nodes of the AabbTree refer to ranges of its object vector,
+    // so it's copied as is, including any entries freed by removeObject,
+    // which no node refers to.
+    mObjectVector = aabbTree.mObjectVector;
+
+    // A collapsed tree has a little under a third as many nodes.
+    mNodeVector.reserve(aabbTree.mNodeVector.size()/3 + 1);
+
+    collapseSubtree(aabbTree, 0);
+}
+
+template<typename OBJECT>
+void
+WideAabbTree<OBJECT>::clear()
+{
+    NodeVector().swap(mNodeVector);
+    typename SourceAabbTree::ObjectVector().swap(mObjectVector);
+}
+
+template<typename OBJECT>
+bool
+WideAabbTree<OBJECT>::empty() const
+{
+    return mNodeVector.empty();
+}
+
+template<typename OBJECT>
+bool
+WideAabbTree<OBJECT>::occludesRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(raySegmentOcclusionListener != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    RaySegment raySegment(origin, endpoint);
+    bool result = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        result = occludesRaySegmentForSubtree(0, raySegment,
+            raySegmentOcclusionListener, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        result = occludesRaySegmentForSubtree(0, raySegment,
+            raySegmentOcclusionListener, &nullQueryCounter);
+    }
+
+    return result;
+}
+
+template<typename OBJECT>
+bool
+WideAabbTree<OBJECT>::intersectsRaySegment(const Vector3f &origin, const Vector3f &endpoint,
+    const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+    cgmath::Vector3f *intersectionPoint, OBJECT **intersectedObject,
+    AabbTreeStatistics *aabbTreeStatistics) const
+{
+    assert(raySegmentIntersectionListener != NULL);
+    assert(intersectionPoint != NULL);
+    assert(intersectedObject != NULL);
+
+    if (mNodeVector.empty()) {
+        return false;
+    }
+
+    RaySegment raySegment(origin, endpoint);
+    float t = 1.0;
+    *intersectedObject = NULL;
+    bool result = false;
+
+    if (aabbTreeStatistics != NULL) {
+        QueryCounter queryCounter;
+        result = intersectsRaySegmentForSubtree(0, raySegment,
+            raySegmentIntersectionListener, &t, intersectedObject, &queryCounter);
+        queryCounter.addQueryToStatistics(aabbTreeStatistics);
+    } else {
+        NullQueryCounter nullQueryCounter;
+        result = intersectsRaySegmentForSubtree(0, raySegment,
+            raySegmentIntersectionListener, &t, intersectedObject, &nullQueryCounter);
+    }
+
+    *intersectionPoint = origin*(1.0 - t) + endpoint*t;
+
+    return result;
+}
+
+template<typename OBJECT>
+size_t
+WideAabbTree<OBJECT>::bytesUsed() const
+{
+    return mNodeVector.capacity()*sizeof(Node)
+        + mObjectVector.capacity()*sizeof(OBJECT);
+}
+
+template<typename OBJECT>
+unsigned
+WideAabbTree<OBJECT>::collapseSubtree(const SourceAabbTree &aabbTree,
+    unsigned sourceNodeIndex)
+{
+    typedef typename SourceAabbTree::Node SourceNode;
+    const typename SourceAabbTree::NodeVector &sourceNodeVector = aabbTree.mNodeVector;
+
+    // Starting with the source node itself, repeatedly replace the internal
+    // node with the largest surface area by its two children. Opening the
+    // largest nodes first keeps the bounding boxes of the children small.
+    unsigned sourceChildIndex[4];
+    sourceChildIndex[0] = sourceNodeIndex;
+    unsigned childCount = 1;
+    while (childCount < 4) {
+        int largestChild = -1;
+        float largestArea = 0.0;
+        for (unsigned child = 0; child < childCount; ++child) {
+            const SourceNode &sourceNode = sourceNodeVector[sourceChildIndex[child]];
+            if (sourceNode.isLeaf()) {
+                continue;
+            }
+            float area = GetBoundingBox3fSurfaceArea(sourceNode.mBoundingBox);
+            if (largestChild == -1 || area > largestArea) {
+                largestChild = child;
+                largestArea = area;
+            }
+        }
+        if (largestChild == -1) {
+            break;
+        }
+        unsigned firstGrandchildIndex = sourceNodeVector[sourceChildIndex[largestChild]].mIndex;
+        sourceChildIndex[largestChild] = firstGrandchildIndex;
+        sourceChildIndex[childCount] = firstGrandchildIndex + 1;
+        ++childCount;
+    }
+
+    unsigned nodeIndex = mNodeVector.size();
+    mNodeVector.push_back(Node());
+
+    Node node;
+    node.mChildMask = 0;
+    node.mLeafMask = 0;
+    for (unsigned child = 0; child < 4; ++child) {
+        node.mChildIndex[child] = 0;
+        node.mChildObjectCount[child] = 0;
+        if (child >= childCount) {
+            node.mChildBoundingBoxes.reset(child);
+            continue;
+        }
+        const SourceNode &sourceNode = sourceNodeVector[sourceChildIndex[child]];
+        node.mChildBoundingBoxes.setBoundingBox3f(child, sourceNode.mBoundingBox);
+        node.mChildMask |= 1 << child;
+        if (sourceNode.isLeaf()) {
+            node.mLeafMask |= 1 << child;
+            node.mChildIndex[child] = sourceNode.mIndex;
+            node.mChildObjectCount[child] = sourceNode.mObjectCount;
+        } else {
+            // The recursive call may reallocate mNodeVector, so the node
+            // is filled in locally, and copied into place afterward.
+            node.mChildIndex[child] = collapseSubtree(aabbTree, sourceChildIndex[child]);
+        }
+    }
+
+    mNodeVector[nodeIndex] = node;
+
+    return nodeIndex;
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+unsigned
+WideAabbTree<OBJECT>::findIntersectedChildren(const Node &node,
+    const RaySegment &raySegment, float maxT, unsigned *childOrder, float *childT,
+    QUERY_COUNTER *queryCounter) const
+{
+    unsigned hitMask = raySegment.intersectsBoundingBox3fQuad(
+        node.mChildBoundingBoxes, maxT, childT) & node.mChildMask;
+
+    // Sort the intersected children by insertion sort. Children that
+    // are entered at the same value of 't' keep their original order.
+    unsigned hitCount = 0;
+    for (unsigned child = 0; child < 4; ++child) {
+        if ((node.mChildMask & (1 << child)) == 0) {
+            continue;
+        }
+        queryCounter->countBoundingBoxTest();
+        if ((hitMask & (1 << child)) == 0) {
+            continue;
+        }
+        unsigned position = hitCount;
+        while (position > 0 && childT[childOrder[position - 1]] > childT[child]) {
+            childOrder[position] = childOrder[position - 1];
+            --position;
+        }
+        childOrder[position] = child;
+        ++hitCount;
+    }
+
+    return hitCount;
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+bool
+WideAabbTree<OBJECT>::occludesRaySegmentForSubtree(unsigned nodeIndex,
+    const RaySegment &raySegment,
+    const RaySegmentOcclusionListener *raySegmentOcclusionListener,
+    QUERY_COUNTER *queryCounter) const
+{
+    const Node &node = mNodeVector[nodeIndex];
+
+    unsigned childOrder[4];
+    float childT[4];
+    unsigned hitCount = findIntersectedChildren(node, raySegment, 1.0,
+        childOrder, childT, queryCounter);
+
+    for (unsigned order = 0; order < hitCount; ++order) {
+        unsigned child = childOrder[order];
+
+        if ((node.mLeafMask & (1 << child)) == 0) {
+            if (occludesRaySegmentForSubtree(node.mChildIndex[child], raySegment,
+                    raySegmentOcclusionListener, queryCounter)) {
+                return true;
+            }
+            continue;
+        }
+
+        // Evaluate the callback on all of the objects in the leaf child.
+        unsigned first = node.mChildIndex[child];
+        unsigned last = first + node.mChildObjectCount[child];
+        for (unsigned index = first; index < last; ++index) {
+            queryCounter->countObjectTest();
+
+            // If the callback returns true, we've hit something,
+            // and there's no need to perform further tests.
+            if (raySegmentOcclusionListener->objectOccludesRaySegment(
+                    mObjectVector[index], raySegment.origin(), raySegment.endpoint())) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template<typename OBJECT>
+template<typename QUERY_COUNTER>
+bool
+WideAabbTree<OBJECT>::intersectsRaySegmentForSubtree(unsigned nodeIndex,
+    const RaySegment &raySegment,
+    const RaySegmentIntersectionListener *raySegmentIntersectionListener,
+    float *t, OBJECT **intersectedObject,
+    QUERY_COUNTER *queryCounter) const
+{
+    const Node &node = mNodeVector[nodeIndex];
+
+    unsigned childOrder[4];
+    float childT[4];
+    unsigned hitCount = findIntersectedChildren(node, raySegment, *t,
+        childOrder, childT, queryCounter);
+
+    bool result = false;
+
+    for (unsigned order = 0; order < hitCount; ++order) {
+        unsigned child = childOrder[order];
+
+        // If the ray segment enters the child's bounding box no closer
+        // than the closest intersection found so far, none of the objects
+        // within it can be closer, and since the children are sorted,
+        // neither can any of the remaining children.
+        if (childT[child] >= *t) {
+            break;
+        }
+
+        if ((node.mLeafMask & (1 << child)) == 0) {
+            if (intersectsRaySegmentForSubtree(node.mChildIndex[child], raySegment,
+                    raySegmentIntersectionListener, t, intersectedObject, queryCounter)) {
+                result = true;
+            }
+            continue;
+        }
+
+        // Evaluate the callback on all of the objects in the leaf child.
+        unsigned first = node.mChildIndex[child];
+        unsigned last = first + node.mChildObjectCount[child];
+        for (unsigned index = first; index < last; ++index) {
+            OBJECT &object = mObjectVector[index];
+
+            queryCounter->countObjectTest();
+
+            if (raySegmentIntersectionListener->objectIntersectsRaySegment(object,
+                    raySegment.origin(), raySegment.endpoint(), t)) {
+                result = true;
+                *intersectedObject = &object;
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace cgmath
+
+#endif // CGMATH__WIDE_AABB_TREE__INCLUDED
@@ -2,7 +2,14 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/thread.hpp>
+
 #include <cgmath/AabbTree.h>
+#include <cgmath/AabbTreeStatistics.h>
 #include <cgmath/Vector3f.h>
 
 using cgmath::AabbTree;
@@ -18,6 +25,86 @@ public:
     }
 };
 
+// A unit cube offset along the x axis.
+class OffsetObject
+{
+public:
+    OffsetObject(float offset) : mOffset(offset) {}
+    cgmath::BoundingBox3f boundingBox() const {
+        return cgmath::BoundingBox3f(mOffset, mOffset + 1, 0, 1, 0, 1);
+    }
+    float offset() const {
+        return mOffset;
+    }
+    bool operator==(const OffsetObject &rhs) const {
+        return mOffset == rhs.mOffset;
+    }
+private:
+    float mOffset;
+};
+
+// An object with an arbitrary bounding box.
+class BoxObject
+{
+public:
+    BoxObject(const cgmath::BoundingBox3f &boundingBox) : mBoundingBox(boundingBox) {}
+    cgmath::BoundingBox3f boundingBox() const {
+        return mBoundingBox;
+    }
+private:
+    cgmath::BoundingBox3f mBoundingBox;
+};
+
+// Counts the objects found by a bounding box query.
+class CountingBoundingBoxListener : public AabbTree<BoxObject>::BoundingBoxListener
+{
+public:
+    CountingBoundingBoxListener() : mCount(0) {}
+    virtual bool applyObjectToBoundingBox(BoxObject &boxObject,
+        const cgmath::BoundingBox3f &boundingBox) {
+        if (cgmath::BoundingBox3fIntersectsBoundingBox3f(boxObject.boundingBox(),
+                boundingBox)) {
+            ++mCount;
+        }
+        return false;
+    }
+    int mCount;
+};
+
+// Records the indices of the objects whose bounding boxes
+// intersect a bounding box query.
+class IndexRecordingBoundingBoxListener : public AabbTree<BoxObject>::BoundingBoxListener
+{
+public:
+    IndexRecordingBoundingBoxListener(const AabbTree<BoxObject> &aabbTree)
+        : mAabbTree(aabbTree), mIndexVector() {}
+    virtual bool applyObjectToBoundingBox(BoxObject &boxObject,
+        const cgmath::BoundingBox3f &boundingBox) {
+        if (cgmath::BoundingBox3fIntersectsBoundingBox3f(boxObject.boundingBox(),
+                boundingBox)) {
+            mIndexVector.push_back(&boxObject - &mAabbTree.objectVector()[0]);
+        }
+        return false;
+    }
+    const AabbTree<BoxObject> &mAabbTree;
+    std::vector<unsigned> mIndexVector;
+};
+
+// Returns true if two bounding boxes are no more than tolerance apart
+// along each axis.
+static bool
+BoundingBoxesAreWithinTolerance(const cgmath::BoundingBox3f &lhs,
+    const cgmath::BoundingBox3f &rhs, float tolerance)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        if (lhs.min()[axis] > rhs.max()[axis] + tolerance
+            || rhs.min()[axis] > lhs.max()[axis] + tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
 class BoundingBoxListener : public AabbTree<Object>::BoundingBoxListener 
 {
 public:
@@ -48,6 +135,86 @@ public:
     }
 };
 
+class SphereListener : public AabbTree<Object>::SphereListener
+{
+public:
+    virtual bool applyObjectToSphere(Object &, const Vector3f &, float) {
+        gCalled = true;
+        return true;
+    }
+};
+
+// Treats each offset object as a solid box for ray segment queries.
+class OffsetObjectOcclusionListener
+    : public AabbTree<OffsetObject>::RaySegmentOcclusionListener
+{
+public:
+    virtual bool objectOccludesRaySegment(const OffsetObject &offsetObject,
+        const Vector3f &origin, const Vector3f &endpoint) const {
+        return cgmath::BoundingBox3fIntersectsRaySegment(offsetObject.boundingBox(),
+            origin, endpoint);
+    }
+};
+
+class OffsetObjectIntersectionListener
+    : public AabbTree<OffsetObject>::RaySegmentIntersectionListener
+{
+public:
+    virtual bool objectIntersectsRaySegment(const OffsetObject &offsetObject,
+        const Vector3f &origin, const Vector3f &endpoint, float *t) const {
+        float objectT = 0.0;
+        if (!cgmath::BoundingBox3fIntersectsRaySegment(offsetObject.boundingBox(),
+                origin, endpoint, &objectT)
+            || objectT >= *t) {
+            return false;
+        }
+        *t = objectT;
+        return true;
+    }
+};
+
+// Queries a shared tree with boxes centered on each of a set of points,
+// counting the objects found, and the objects hit by rays between the points.
+class AabbTreeQueryThread
+{
+public:
+    AabbTreeQueryThread(const AabbTree<BoxObject> *aabbTree,
+        const std::vector<Vector3f> *pointVector, std::vector<int> *countVector,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics)
+        : mAabbTree(aabbTree), mPointVector(pointVector), mCountVector(countVector),
+          mAabbTreeStatistics(aabbTreeStatistics) {}
+    void operator()() {
+        mCountVector->clear();
+        for (size_t index = 0; index < mPointVector->size(); ++index) {
+            const Vector3f &point = (*mPointVector)[index];
+            CountingBoundingBoxListener countingBoundingBoxListener;
+            mAabbTree->applyToBoundingBoxIntersection(
+                cgmath::BoundingBox3f(point, point + Vector3f(1, 1, 1)),
+                &countingBoundingBoxListener, mAabbTreeStatistics);
+            mCountVector->push_back(countingBoundingBoxListener.mCount);
+        }
+    }
+private:
+    const AabbTree<BoxObject> *mAabbTree;
+    const std::vector<Vector3f> *mPointVector;
+    std::vector<int> *mCountVector;
+    cgmath::AabbTreeStatistics *mAabbTreeStatistics;
+};
+
+// Records the corners of the objects found by a bounding box query,
+// in the order they're found.
+class RecordingBoundingBoxListener : public AabbTree<BoxObject>::BoundingBoxListener
+{
+public:
+    virtual bool applyObjectToBoundingBox(BoxObject &boxObject,
+        const cgmath::BoundingBox3f &) {
+        mCornerVector.push_back(boxObject.boundingBox().min());
+        mCornerVector.push_back(boxObject.boundingBox().max());
+        return false;
+    }
+    std::vector<Vector3f> mCornerVector;
+};
+
 class AabbTreeTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE(AabbTreeTest);
@@ -55,6 +222,20 @@ class AabbTreeTest : public CppUnit::TestFixture
     CPPUNIT_TEST(testBoundingBoxListener);
     CPPUNIT_TEST(testTriangleListener);
     CPPUNIT_TEST(testTetrahedronListener);
+    CPPUNIT_TEST(testSphereListener);
+    CPPUNIT_TEST(testFindNearestObjects);
+    CPPUNIT_TEST(testRaySegment);
+    CPPUNIT_TEST(testInsertObject);
+    CPPUNIT_TEST(testRemoveObject);
+    CPPUNIT_TEST(testReuseRemovedStorage);
+    CPPUNIT_TEST(testSurfaceAreaHeuristic);
+    CPPUNIT_TEST(testStatistics);
+    CPPUNIT_TEST(testConcurrentQueries);
+    CPPUNIT_TEST(testParallelBuild);
+    CPPUNIT_TEST(testRestore);
+    CPPUNIT_TEST(testRestoreAfterRemoveObject);
+    CPPUNIT_TEST(testFindOverlappingPairs);
+    CPPUNIT_TEST(testFindBoundingBoxIntersections);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -159,6 +340,680 @@ public:
             &tetrahedronListener);
         CPPUNIT_ASSERT(!gCalled);
     }
+
+    void testSphereListener() {
+        typedef AabbTree<Object> ObjectAabbTree;
+        ObjectAabbTree mObjectAabbTree;
+
+        ObjectAabbTree::ObjectVector objectVector;
+        objectVector.push_back(Object());
+
+        mObjectAabbTree.initialize(objectVector);
+
+        SphereListener sphereListener;
+
+        gCalled = false;
+        mObjectAabbTree.applyToSphereIntersection(Vector3f(2.0, 0.5, 0.5), 1.5,
+            &sphereListener);
+        CPPUNIT_ASSERT(gCalled);
+
+        // The bounding box of the sphere overlaps the object,
+        // but the sphere itself does not.
+        gCalled = false;
+        mObjectAabbTree.applyToSphereIntersection(Vector3f(1.9, 1.9, 1.9), 1.5,
+            &sphereListener);
+        CPPUNIT_ASSERT(!gCalled);
+    }
+
+    void testFindNearestObjects() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        OffsetObjectAabbTree::NearestObjectVector nearestObjectVector;
+
+        mOffsetObjectAabbTree.findNearestObjects(Vector3f(51.4, 0.5, 0.5), 3, 100.0,
+            &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.size() == 3);
+        CPPUNIT_ASSERT(nearestObjectVector[0].mObject->offset() == 50.0);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(nearestObjectVector[0].mDistanceSquared, 0.16, 0.0001);
+        CPPUNIT_ASSERT(nearestObjectVector[1].mObject->offset() == 52.0);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(nearestObjectVector[1].mDistanceSquared, 0.36, 0.0001);
+        CPPUNIT_ASSERT(nearestObjectVector[2].mObject->offset() == 48.0);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(nearestObjectVector[2].mDistanceSquared, 5.76, 0.0001);
+
+        // Only one object lies within the maximum distance.
+        mOffsetObjectAabbTree.findNearestObjects(Vector3f(-1.0, 0.5, 0.5), 3, 2.0,
+            &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.size() == 1);
+        CPPUNIT_ASSERT(nearestObjectVector[0].mObject->offset() == 0.0);
+
+        mOffsetObjectAabbTree.findNearestObjects(Vector3f(-10.0, 0.5, 0.5), 3, 2.0,
+            &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.empty());
+    }
+
+    void testRaySegment() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        OffsetObjectOcclusionListener occlusionListener;
+        CPPUNIT_ASSERT(mOffsetObjectAabbTree.occludesRaySegment(Vector3f(-1, 0.5, 0.5),
+                Vector3f(0.5, 0.5, 0.5), &occlusionListener));
+        CPPUNIT_ASSERT(!mOffsetObjectAabbTree.occludesRaySegment(Vector3f(1.25, 0.5, 0.5),
+                Vector3f(1.75, 0.5, 0.5), &occlusionListener));
+        CPPUNIT_ASSERT(!mOffsetObjectAabbTree.occludesRaySegment(Vector3f(0, 2, 0.5),
+                Vector3f(200, 2, 0.5), &occlusionListener));
+
+        // The closest object along the ray must be found, in either direction.
+        OffsetObjectIntersectionListener intersectionListener;
+        Vector3f intersectionPoint;
+        OffsetObject *intersectedObject = NULL;
+        CPPUNIT_ASSERT(mOffsetObjectAabbTree.intersectsRaySegment(Vector3f(101.5, 0.5, 0.5),
+                Vector3f(300, 0.5, 0.5), &intersectionListener,
+                &intersectionPoint, &intersectedObject));
+        CPPUNIT_ASSERT(intersectedObject != NULL);
+        CPPUNIT_ASSERT(intersectedObject->offset() == 102);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(intersectionPoint[0], 102.0, 0.0001);
+
+        CPPUNIT_ASSERT(mOffsetObjectAabbTree.intersectsRaySegment(Vector3f(101.5, 0.5, 0.5),
+                Vector3f(-100, 0.5, 0.5), &intersectionListener,
+                &intersectionPoint, &intersectedObject));
+        CPPUNIT_ASSERT(intersectedObject->offset() == 100);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(intersectionPoint[0], 101.0, 0.0001);
+
+        CPPUNIT_ASSERT(!mOffsetObjectAabbTree.intersectsRaySegment(Vector3f(101.25, 0.5, 0.5),
+                Vector3f(101.75, 0.5, 0.5), &intersectionListener,
+                &intersectionPoint, &intersectedObject));
+        CPPUNIT_ASSERT(intersectedObject == NULL);
+    }
+
+    void testInsertObject() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        // Objects may be inserted into an empty tree.
+        for (int index = 0; index < 50; ++index) {
+            mOffsetObjectAabbTree.insertObject(OffsetObject(index*2));
+        }
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 50; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        for (int index = 0; index < 50; ++index) {
+            mOffsetObjectAabbTree.insertObject(OffsetObject(index*2));
+        }
+
+        OffsetObjectAabbTree::NearestObjectVector nearestObjectVector;
+        for (int index = 0; index < 100; ++index) {
+            mOffsetObjectAabbTree.findNearestObjects(Vector3f(index*2 + 0.5, 0.5, 0.5), 
+                1, 0.1, &nearestObjectVector);
+            CPPUNIT_ASSERT(nearestObjectVector.size() == 1);
+            CPPUNIT_ASSERT(nearestObjectVector[0].mObject->offset() == index*2);
+        }
+    }
+
+    void testRemoveObject() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        // Remove the objects with odd indices.
+        for (int index = 1; index < 100; index += 2) {
+            CPPUNIT_ASSERT(mOffsetObjectAabbTree.removeObject(OffsetObject(index*2)));
+        }
+        CPPUNIT_ASSERT(!mOffsetObjectAabbTree.removeObject(OffsetObject(2)));
+        CPPUNIT_ASSERT(!mOffsetObjectAabbTree.removeObject(OffsetObject(1)));
+
+        mOffsetObjectAabbTree.refit();
+
+        OffsetObjectAabbTree::NearestObjectVector nearestObjectVector;
+        for (int index = 0; index < 100; ++index) {
+            mOffsetObjectAabbTree.findNearestObjects(Vector3f(index*2 + 0.5, 0.5, 0.5), 
+                1, 0.1, &nearestObjectVector);
+            CPPUNIT_ASSERT(nearestObjectVector.size() == (index % 2 == 0 ? 1 : 0));
+        }
+
+        // The tree is empty once all the objects are removed.
+        for (int index = 0; index < 100; index += 2) {
+            CPPUNIT_ASSERT(mOffsetObjectAabbTree.removeObject(OffsetObject(index*2)));
+        }
+        mOffsetObjectAabbTree.findNearestObjects(Vector3f(0, 0, 0), 1, 1000.0, 
+            &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.empty());
+    }
+
+    void testReuseRemovedStorage() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        // Replacing objects one at a time reuses the storage
+        // freed by the objects that were removed.
+        size_t bytesUsed = 0;
+        for (int pass = 0; pass < 4; ++pass) {
+            for (int index = 0; index < 100; ++index) {
+                CPPUNIT_ASSERT(mOffsetObjectAabbTree.removeObject(
+                        OffsetObject(index*2 + (pass % 2))));
+                mOffsetObjectAabbTree.insertObject(OffsetObject(index*2 + 1 - (pass % 2)));
+            }
+            if (pass == 0) {
+                bytesUsed = mOffsetObjectAabbTree.bytesUsed();
+            }
+        }
+        CPPUNIT_ASSERT(mOffsetObjectAabbTree.bytesUsed() == bytesUsed);
+
+        OffsetObjectAabbTree::NearestObjectVector nearestObjectVector;
+        for (int index = 0; index < 100; ++index) {
+            mOffsetObjectAabbTree.findNearestObjects(Vector3f(index*2 + 0.5, 0.5, 0.5),
+                1, 0.1, &nearestObjectVector);
+            CPPUNIT_ASSERT(nearestObjectVector.size() == 1);
+            CPPUNIT_ASSERT(nearestObjectVector[0].mObject->offset() == index*2);
+        }
+    }
+
+    void testSurfaceAreaHeuristic() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+
+        // Small boxes clustered near the origin, plus a few large ones,
+        // which the median split handles poorly.
+        srand48(1);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 1000; ++index) {
+            float scale = index % 100 == 0 ? 10.0 : 0.1;
+            Vector3f min(drand48()*drand48(), drand48()*drand48(), drand48()*drand48());
+            min *= 100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*scale;
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+        }
+
+        BoxObjectAabbTree medianSplitAabbTree;
+        medianSplitAabbTree.initialize(objectVector);
+
+        BoxObjectAabbTree surfaceAreaHeuristicAabbTree;
+        surfaceAreaHeuristicAabbTree.setSplitStrategy(
+            BoxObjectAabbTree::SURFACE_AREA_HEURISTIC);
+        CPPUNIT_ASSERT(surfaceAreaHeuristicAabbTree.splitStrategy()
+            == BoxObjectAabbTree::SURFACE_AREA_HEURISTIC);
+        surfaceAreaHeuristicAabbTree.initialize(objectVector);
+
+        // Both trees must find the same objects as a brute force search.
+        for (int query = 0; query < 100; ++query) {
+            Vector3f min(drand48()*drand48(), drand48()*drand48(), drand48()*drand48());
+            min *= 100.0;
+            cgmath::BoundingBox3f boundingBox(min, min + Vector3f(1, 1, 1));
+
+            int count = 0;
+            for (size_t index = 0; index < objectVector.size(); ++index) {
+                if (cgmath::BoundingBox3fIntersectsBoundingBox3f(
+                        objectVector[index].boundingBox(), boundingBox)) {
+                    ++count;
+                }
+            }
+
+            CountingBoundingBoxListener medianSplitListener;
+            medianSplitAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                &medianSplitListener);
+            CPPUNIT_ASSERT(medianSplitListener.mCount == count);
+
+            CountingBoundingBoxListener surfaceAreaHeuristicListener;
+            surfaceAreaHeuristicAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                &surfaceAreaHeuristicListener);
+            CPPUNIT_ASSERT(surfaceAreaHeuristicListener.mCount == count);
+        }
+
+        // Objects whose midpoints coincide must still be placed in the tree.
+        BoxObjectAabbTree::ObjectVector coincidentObjectVector;
+        for (int index = 0; index < 100; ++index) {
+            coincidentObjectVector.push_back(BoxObject(cgmath::BoundingBox3f(
+                        -index, index, -index, index, -index, index)));
+        }
+        surfaceAreaHeuristicAabbTree.initialize(coincidentObjectVector);
+        CountingBoundingBoxListener coincidentListener;
+        surfaceAreaHeuristicAabbTree.applyToBoundingBoxIntersection(
+            cgmath::BoundingBox3f(-0.5, 0.5, -0.5, 0.5, -0.5, 0.5), &coincidentListener);
+        CPPUNIT_ASSERT(coincidentListener.mCount == 100);
+    }
+
+    void testStatistics() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree mOffsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        mOffsetObjectAabbTree.initialize(objectVector);
+
+        // Queries are only counted when a statistics object is passed.
+        cgmath::AabbTreeStatistics aabbTreeStatistics;
+        OffsetObjectAabbTree::NearestObjectVector nearestObjectVector;
+        for (int index = 0; index < 10; ++index) {
+            mOffsetObjectAabbTree.findNearestObjects(Vector3f(index*2 + 0.5, 0.5, 0.5),
+                1, 0.1, &nearestObjectVector, &aabbTreeStatistics);
+            mOffsetObjectAabbTree.findNearestObjects(Vector3f(index*2 + 0.5, 0.5, 0.5),
+                1, 0.1, &nearestObjectVector);
+        }
+        CPPUNIT_ASSERT(aabbTreeStatistics.queries() == 10);
+        CPPUNIT_ASSERT(aabbTreeStatistics.minObjectTestsPerQuery() >= 1);
+        CPPUNIT_ASSERT(aabbTreeStatistics.minBoundingBoxTestsPerQuery()
+            <= aabbTreeStatistics.averageBoundingBoxTestsPerQuery());
+        CPPUNIT_ASSERT(aabbTreeStatistics.averageBoundingBoxTestsPerQuery()
+            <= aabbTreeStatistics.maxBoundingBoxTestsPerQuery());
+        CPPUNIT_ASSERT(aabbTreeStatistics.maxBoundingBoxTestsPerQuery() < 100);
+
+        cgmath::AabbTreeStatistics mergedAabbTreeStatistics;
+        mergedAabbTreeStatistics.merge(aabbTreeStatistics);
+        mergedAabbTreeStatistics.merge(aabbTreeStatistics);
+        CPPUNIT_ASSERT(mergedAabbTreeStatistics.queries() == 20);
+        CPPUNIT_ASSERT(mergedAabbTreeStatistics.maxObjectTestsPerQuery()
+            == aabbTreeStatistics.maxObjectTestsPerQuery());
+
+        aabbTreeStatistics.reset();
+        CPPUNIT_ASSERT(aabbTreeStatistics.queries() == 0);
+        CPPUNIT_ASSERT(aabbTreeStatistics.minObjectTestsPerQuery() == 0);
+    }
+
+    void testConcurrentQueries() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+
+        srand48(1);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 2000; ++index) {
+            Vector3f min(drand48(), drand48(), drand48());
+            min *= 20.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48());
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+        }
+        BoxObjectAabbTree aabbTree;
+        aabbTree.initialize(objectVector);
+
+        std::vector<Vector3f> pointVector;
+        for (int index = 0; index < 2000; ++index) {
+            pointVector.push_back(Vector3f(drand48(), drand48(), drand48())*20.0);
+        }
+
+        // The results of a single thread are the reference.
+        std::vector<int> expectedCountVector;
+        cgmath::AabbTreeStatistics expectedAabbTreeStatistics;
+        AabbTreeQueryThread(&aabbTree, &pointVector, &expectedCountVector,
+            &expectedAabbTreeStatistics)();
+
+        // Several threads query the same tree at once, each with its own
+        // statistics object.
+        static const int THREAD_COUNT = 4;
+        std::vector<std::vector<int> > countVectorVector(THREAD_COUNT);
+        std::vector<cgmath::AabbTreeStatistics> aabbTreeStatisticsVector(THREAD_COUNT);
+        boost::thread_group threadGroup;
+        for (int thread = 0; thread < THREAD_COUNT; ++thread) {
+            // Half of the threads don't gather statistics.
+            threadGroup.create_thread(AabbTreeQueryThread(&aabbTree, &pointVector,
+                    &countVectorVector[thread],
+                    thread % 2 == 0 ? &aabbTreeStatisticsVector[thread] : NULL));
+        }
+        threadGroup.join_all();
+
+        cgmath::AabbTreeStatistics mergedAabbTreeStatistics;
+        for (int thread = 0; thread < THREAD_COUNT; ++thread) {
+            CPPUNIT_ASSERT(countVectorVector[thread] == expectedCountVector);
+            mergedAabbTreeStatistics.merge(aabbTreeStatisticsVector[thread]);
+        }
+
+        CPPUNIT_ASSERT(mergedAabbTreeStatistics.queries()
+            == expectedAabbTreeStatistics.queries()*THREAD_COUNT/2);
+        CPPUNIT_ASSERT(mergedAabbTreeStatistics.averageObjectTestsPerQuery()
+            == expectedAabbTreeStatistics.averageObjectTestsPerQuery());
+        CPPUNIT_ASSERT(mergedAabbTreeStatistics.maxBoundingBoxTestsPerQuery()
+            == expectedAabbTreeStatistics.maxBoundingBoxTestsPerQuery());
+    }
+
+    void testParallelBuild() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+
+        // Enough objects that the tree is built by several threads,
+        // including some that span the whole tree, and some with
+        // coincident midpoints.
+        srand48(2);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 20000; ++index) {
+            Vector3f min(drand48(), drand48(), drand48());
+            min *= 100.0;
+            if (index % 100 == 0) {
+                min[index/100 % 3] = 0.0;
+            }
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48());
+            if (index % 100 == 0) {
+                max[index/100 % 3] = 101.0;
+            }
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+            if (index % 10 == 0) {
+                objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+            }
+        }
+
+        for (int strategy = 0; strategy < 2; ++strategy) {
+            BoxObjectAabbTree::SplitStrategy splitStrategy = strategy == 0
+                ? BoxObjectAabbTree::MEDIAN_SPLIT : BoxObjectAabbTree::SURFACE_AREA_HEURISTIC;
+
+            BoxObjectAabbTree serialAabbTree;
+            serialAabbTree.setSplitStrategy(splitStrategy);
+            serialAabbTree.setMaximumBuildThreads(1);
+            serialAabbTree.initialize(objectVector);
+
+            RecordingBoundingBoxListener serialListener;
+            serialAabbTree.applyToBoundingBoxIntersection(
+                cgmath::BoundingBox3f(Vector3f(-1, -1, -1), Vector3f(102, 102, 102)),
+                &serialListener);
+            CPPUNIT_ASSERT(serialListener.mCornerVector.size() == 2*objectVector.size());
+
+            // The tree must be identical no matter how many threads built it,
+            // so the objects are found in the same order.
+            for (unsigned threads = 2; threads <= 5; ++threads) {
+                BoxObjectAabbTree parallelAabbTree;
+                parallelAabbTree.setSplitStrategy(splitStrategy);
+                parallelAabbTree.setMaximumBuildThreads(threads);
+                CPPUNIT_ASSERT(parallelAabbTree.maximumBuildThreads() == threads);
+                parallelAabbTree.initialize(objectVector);
+
+                RecordingBoundingBoxListener parallelListener;
+                parallelAabbTree.applyToBoundingBoxIntersection(
+                    cgmath::BoundingBox3f(Vector3f(-1, -1, -1), Vector3f(102, 102, 102)),
+                    &parallelListener);
+                CPPUNIT_ASSERT(parallelListener.mCornerVector
+                    == serialListener.mCornerVector);
+                CPPUNIT_ASSERT(parallelAabbTree.bytesUsed() == serialAabbTree.bytesUsed());
+
+                cgmath::AabbTreeStatistics serialStatistics;
+                cgmath::AabbTreeStatistics parallelStatistics;
+                for (int query = 0; query < 100; ++query) {
+                    Vector3f point = Vector3f(drand48(), drand48(), drand48())*100.0;
+                    cgmath::BoundingBox3f boundingBox(point, point + Vector3f(2, 2, 2));
+                    CountingBoundingBoxListener serialCountingListener;
+                    serialAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                        &serialCountingListener, &serialStatistics);
+                    CountingBoundingBoxListener parallelCountingListener;
+                    parallelAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                        &parallelCountingListener, &parallelStatistics);
+                    CPPUNIT_ASSERT(parallelCountingListener.mCount
+                        == serialCountingListener.mCount);
+                }
+                CPPUNIT_ASSERT(parallelStatistics.maxBoundingBoxTestsPerQuery()
+                    == serialStatistics.maxBoundingBoxTestsPerQuery());
+            }
+        }
+    }
+
+    void testRestore() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+
+        srand48(3);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 1000; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*4.0;
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+        }
+
+        BoxObjectAabbTree aabbTree;
+        aabbTree.initialize(objectVector);
+
+        // A restored tree finds the same objects in the same order.
+        BoxObjectAabbTree restoredAabbTree;
+        CPPUNIT_ASSERT(restoredAabbTree.restore(aabbTree.nodeVector(),
+                aabbTree.objectVector()));
+        for (int query = 0; query < 100; ++query) {
+            Vector3f point = Vector3f(drand48(), drand48(), drand48())*100.0;
+            cgmath::BoundingBox3f boundingBox(point, point + Vector3f(8, 8, 8));
+            RecordingBoundingBoxListener listener;
+            aabbTree.applyToBoundingBoxIntersection(boundingBox, &listener);
+            RecordingBoundingBoxListener restoredListener;
+            restoredAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                &restoredListener);
+            CPPUNIT_ASSERT(restoredListener.mCornerVector == listener.mCornerVector);
+        }
+
+        // An empty tree may be restored.
+        CPPUNIT_ASSERT(restoredAabbTree.restore(BoxObjectAabbTree::NodeVector(),
+                BoxObjectAabbTree::ObjectVector()));
+        CPPUNIT_ASSERT(restoredAabbTree.nodeVector().empty());
+
+        // Nodes that refer to objects that don't exist are rejected.
+        BoxObjectAabbTree::NodeVector nodeVector = aabbTree.nodeVector();
+        BoxObjectAabbTree::ObjectVector truncatedObjectVector(objectVector.begin(),
+            objectVector.begin() + objectVector.size()/2);
+        CPPUNIT_ASSERT(!restoredAabbTree.restore(nodeVector, truncatedObjectVector));
+        CPPUNIT_ASSERT(restoredAabbTree.nodeVector().empty());
+
+        // So are nodes that don't exist, and cycles.
+        nodeVector.resize(nodeVector.size()/2);
+        CPPUNIT_ASSERT(!restoredAabbTree.restore(nodeVector, objectVector));
+        nodeVector = aabbTree.nodeVector();
+        CPPUNIT_ASSERT(!nodeVector[1].isLeaf());
+        nodeVector[1].mIndex = 0;
+        CPPUNIT_ASSERT(!restoredAabbTree.restore(nodeVector, objectVector));
+    }
+
+    void testRestoreAfterRemoveObject() {
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+        OffsetObjectAabbTree offsetObjectAabbTree;
+
+        OffsetObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 100; ++index) {
+            objectVector.push_back(OffsetObject(index*2));
+        }
+        offsetObjectAabbTree.initialize(objectVector);
+        for (int index = 1; index < 100; index += 2) {
+            CPPUNIT_ASSERT(offsetObjectAabbTree.removeObject(OffsetObject(index*2)));
+        }
+
+        // The entries freed by removeObject are freed in the restored tree too,
+        // so inserting objects reuses them rather than growing the tree.
+        OffsetObjectAabbTree restoredAabbTree;
+        CPPUNIT_ASSERT(restoredAabbTree.restore(offsetObjectAabbTree.nodeVector(),
+                offsetObjectAabbTree.objectVector()));
+        size_t nodeCount = restoredAabbTree.nodeVector().size();
+        size_t objectCount = restoredAabbTree.objectVector().size();
+        for (int index = 1; index < 100; index += 2) {
+            restoredAabbTree.insertObject(OffsetObject(index*2));
+        }
+        CPPUNIT_ASSERT(restoredAabbTree.nodeVector().size() == nodeCount);
+        CPPUNIT_ASSERT(restoredAabbTree.objectVector().size() == objectCount);
+
+        // The restored tree is empty once all the objects are removed.
+        CPPUNIT_ASSERT(restoredAabbTree.restore(offsetObjectAabbTree.nodeVector(),
+                offsetObjectAabbTree.objectVector()));
+        for (int index = 0; index < 100; index += 2) {
+            CPPUNIT_ASSERT(restoredAabbTree.removeObject(OffsetObject(index*2)));
+        }
+        CPPUNIT_ASSERT(restoredAabbTree.nodeVector().empty());
+        CPPUNIT_ASSERT(restoredAabbTree.objectVector().empty());
+    }
+
+    void testFindOverlappingPairs() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+        typedef AabbTree<OffsetObject> OffsetObjectAabbTree;
+
+        // Enough boxes that the search is divided among threads.
+        srand48(4);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 5000; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*2.0;
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+        }
+        BoxObjectAabbTree aabbTree;
+        aabbTree.initialize(objectVector);
+        const BoxObjectAabbTree::ObjectVector &treeObjectVector = aabbTree.objectVector();
+
+        OffsetObjectAabbTree::ObjectVector offsetObjectVector;
+        for (int index = 0; index < 100; ++index) {
+            offsetObjectVector.push_back(OffsetObject(index*1.5));
+        }
+        OffsetObjectAabbTree offsetAabbTree;
+        offsetAabbTree.initialize(offsetObjectVector);
+        const OffsetObjectAabbTree::ObjectVector &treeOffsetObjectVector
+            = offsetAabbTree.objectVector();
+
+        for (int toleranceIndex = 0; toleranceIndex < 2; ++toleranceIndex) {
+            float tolerance = toleranceIndex*0.5;
+
+            // Find the pairs by brute force.
+            BoxObjectAabbTree::ObjectIndexPairVector expectedSelfPairVector;
+            for (unsigned first = 0; first < treeObjectVector.size(); ++first) {
+                cgmath::BoundingBox3f boundingBox = treeObjectVector[first].boundingBox();
+                for (unsigned second = first + 1; second < treeObjectVector.size();
+                     ++second) {
+                    if (BoundingBoxesAreWithinTolerance(boundingBox,
+                            treeObjectVector[second].boundingBox(), tolerance)) {
+                        expectedSelfPairVector.push_back(
+                            BoxObjectAabbTree::ObjectIndexPair(first, second));
+                    }
+                }
+            }
+            CPPUNIT_ASSERT(!expectedSelfPairVector.empty());
+
+            BoxObjectAabbTree::ObjectIndexPairVector expectedPairVector;
+            for (unsigned first = 0; first < treeObjectVector.size(); ++first) {
+                cgmath::BoundingBox3f boundingBox = treeObjectVector[first].boundingBox();
+                for (unsigned second = 0; second < treeOffsetObjectVector.size();
+                     ++second) {
+                    if (BoundingBoxesAreWithinTolerance(boundingBox,
+                            treeOffsetObjectVector[second].boundingBox(), tolerance)) {
+                        expectedPairVector.push_back(
+                            BoxObjectAabbTree::ObjectIndexPair(first, second));
+                    }
+                }
+            }
+            CPPUNIT_ASSERT(!expectedPairVector.empty());
+
+            BoxObjectAabbTree::ObjectIndexPairVector serialSelfPairVector;
+            BoxObjectAabbTree::ObjectIndexPairVector serialPairVector;
+            for (unsigned threads = 1; threads <= 4; ++threads) {
+                cgmath::AabbTreeStatistics aabbTreeStatistics;
+                BoxObjectAabbTree::ObjectIndexPairVector selfPairVector;
+                aabbTree.findSelfOverlappingPairs(tolerance, threads, &selfPairVector,
+                    &aabbTreeStatistics);
+                CPPUNIT_ASSERT(aabbTreeStatistics.queries() == 1);
+
+                // The pairs are found in the same order by any number of threads.
+                if (threads == 1) {
+                    serialSelfPairVector = selfPairVector;
+                } else {
+                    CPPUNIT_ASSERT(selfPairVector == serialSelfPairVector);
+                }
+
+                for (size_t index = 0; index < selfPairVector.size(); ++index) {
+                    CPPUNIT_ASSERT(selfPairVector[index].first
+                        < selfPairVector[index].second);
+                }
+                std::sort(selfPairVector.begin(), selfPairVector.end());
+                CPPUNIT_ASSERT(selfPairVector == expectedSelfPairVector);
+
+                BoxObjectAabbTree::ObjectIndexPairVector pairVector;
+                aabbTree.findOverlappingPairs(offsetAabbTree, tolerance, threads,
+                    &pairVector);
+                if (threads == 1) {
+                    serialPairVector = pairVector;
+                } else {
+                    CPPUNIT_ASSERT(pairVector == serialPairVector);
+                }
+                std::sort(pairVector.begin(), pairVector.end());
+                CPPUNIT_ASSERT(pairVector == expectedPairVector);
+            }
+        }
+
+        // Nothing overlaps an empty tree.
+        BoxObjectAabbTree::ObjectIndexPairVector pairVector;
+        aabbTree.findOverlappingPairs(OffsetObjectAabbTree(), 0.0, 1, &pairVector);
+        CPPUNIT_ASSERT(pairVector.empty());
+        BoxObjectAabbTree().findSelfOverlappingPairs(0.0, 1, &pairVector);
+        CPPUNIT_ASSERT(pairVector.empty());
+    }
+
+    void testFindBoundingBoxIntersections() {
+        typedef AabbTree<BoxObject> BoxObjectAabbTree;
+
+        srand48(5);
+        BoxObjectAabbTree::ObjectVector objectVector;
+        for (int index = 0; index < 2000; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*4.0;
+            objectVector.push_back(BoxObject(cgmath::BoundingBox3f(min, max)));
+        }
+
+        // Inserting objects puts some of them out of order in the tree.
+        BoxObjectAabbTree aabbTree;
+        aabbTree.initialize(BoxObjectAabbTree::ObjectVector(objectVector.begin(),
+                objectVector.begin() + 1500));
+        for (size_t index = 1500; index < objectVector.size(); ++index) {
+            aabbTree.insertObject(objectVector[index]);
+        }
+
+        BoxObjectAabbTree::BoundingBox3fVector boundingBoxVector;
+        for (int query = 0; query < 1000; ++query) {
+            Vector3f point = Vector3f(drand48(), drand48(), drand48())*110.0
+                - Vector3f(5, 5, 5);
+            boundingBoxVector.push_back(cgmath::BoundingBox3f(point,
+                    point + Vector3f(drand48(), drand48(), drand48())*6.0));
+        }
+
+        std::vector<unsigned> offsetVector;
+        std::vector<unsigned> objectIndexVector;
+        cgmath::AabbTreeStatistics aabbTreeStatistics;
+        aabbTree.findBoundingBoxIntersections(boundingBoxVector, &offsetVector,
+            &objectIndexVector, &aabbTreeStatistics);
+        CPPUNIT_ASSERT(aabbTreeStatistics.queries() == 1);
+        CPPUNIT_ASSERT(offsetVector.size() == boundingBoxVector.size() + 1);
+        CPPUNIT_ASSERT(offsetVector.front() == 0);
+        CPPUNIT_ASSERT(offsetVector.back() == objectIndexVector.size());
+
+        // The objects are the same, and in the same order, as those
+        // found by separate queries.
+        size_t nonemptyCount = 0;
+        for (size_t index = 0; index < boundingBoxVector.size(); ++index) {
+            IndexRecordingBoundingBoxListener listener(aabbTree);
+            aabbTree.applyToBoundingBoxIntersection(boundingBoxVector[index], &listener);
+            CPPUNIT_ASSERT(std::vector<unsigned>(
+                    objectIndexVector.begin() + offsetVector[index],
+                    objectIndexVector.begin() + offsetVector[index + 1])
+                == listener.mIndexVector);
+            if (!listener.mIndexVector.empty()) {
+                ++nonemptyCount;
+            }
+        }
+        CPPUNIT_ASSERT(nonemptyCount > 0 && nonemptyCount < boundingBoxVector.size());
+
+        // An empty tree intersects nothing.
+        BoxObjectAabbTree().findBoundingBoxIntersections(boundingBoxVector, &offsetVector,
+            &objectIndexVector);
+        CPPUNIT_ASSERT(offsetVector == std::vector<unsigned>(boundingBoxVector.size() + 1, 0));
+        CPPUNIT_ASSERT(objectIndexVector.empty());
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(AabbTreeTest);
@@ -22,6 +22,11 @@ class BoundingBox3fOperationsTest : public CppUnit::TestFixture
     CPPUNIT_TEST(testBoundingBox3fIntersectsTriangleSuccess);
     CPPUNIT_TEST(testBoundingBox3fIntersectsTriangleFailure);
     CPPUNIT_TEST(testBoundingBox3fIntersectsTetrahedron);
+    CPPUNIT_TEST(testGetSquaredDistanceFromBoundingBox3fToPoint);
+    CPPUNIT_TEST(testBoundingBox3fIntersectsSphere);
+    CPPUNIT_TEST(testBoundingBox3fContainsBoundingBox3f);
+    CPPUNIT_TEST(testGetBoundingBox3fSurfaceArea);
+    CPPUNIT_TEST(testGetMortonCode);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -334,6 +339,62 @@ public:
                            Vector3f(6.0, 6.0, 0.0),
                            Vector3f(6.0, 0.0, 6.0)));
     }
+
+    void testGetSquaredDistanceFromBoundingBox3fToPoint() {
+        mBBox1 = BoundingBox3f(-1, 1, -1, 1, -1, 1);
+        CPPUNIT_ASSERT(GetSquaredDistanceFromBoundingBox3fToPoint(mBBox1,
+                Vector3f(0.5, 0.5, 0.5)) == 0.0);
+        CPPUNIT_ASSERT(GetSquaredDistanceFromBoundingBox3fToPoint(mBBox1,
+                Vector3f(3, 0, 0)) == 4.0);
+        CPPUNIT_ASSERT(GetSquaredDistanceFromBoundingBox3fToPoint(mBBox1,
+                Vector3f(-2, 3, 1)) == 5.0);
+    }
+
+    void testBoundingBox3fIntersectsSphere() {
+        mBBox1 = BoundingBox3f(-1, 1, -1, 1, -1, 1);
+        CPPUNIT_ASSERT(BoundingBox3fIntersectsSphere(mBBox1, Vector3f(0, 0, 0), 0.1));
+        CPPUNIT_ASSERT(BoundingBox3fIntersectsSphere(mBBox1, Vector3f(3, 0, 0), 2.5));
+        CPPUNIT_ASSERT(!BoundingBox3fIntersectsSphere(mBBox1, Vector3f(3, 0, 0), 1.5));
+        CPPUNIT_ASSERT(!BoundingBox3fIntersectsSphere(mBBox1, Vector3f(2, 2, 2), 1.5));
+    }
+
+    void testBoundingBox3fContainsBoundingBox3f() {
+        mBBox1 = BoundingBox3f(-1, 1, -1, 1, -1, 1);
+        CPPUNIT_ASSERT(BoundingBox3fContainsBoundingBox3f(mBBox1, mBBox1));
+        mBBox2 = BoundingBox3f(-0.5, 0.5, -1, 0, 0, 1);
+        CPPUNIT_ASSERT(BoundingBox3fContainsBoundingBox3f(mBBox1, mBBox2));
+        CPPUNIT_ASSERT(!BoundingBox3fContainsBoundingBox3f(mBBox2, mBBox1));
+        mBBox2 = BoundingBox3f(0, 2, 0, 1, 0, 1);
+        CPPUNIT_ASSERT(!BoundingBox3fContainsBoundingBox3f(mBBox1, mBBox2));
+    }
+
+    void testGetBoundingBox3fSurfaceArea() {
+        mBBox1 = BoundingBox3f(0, 1, 0, 2, 0, 3);
+        CPPUNIT_ASSERT(GetBoundingBox3fSurfaceArea(mBBox1) == 22.0);
+        mBBox1.reset();
+        CPPUNIT_ASSERT(GetBoundingBox3fSurfaceArea(mBBox1) == 0.0);
+    }
+
+    void testGetMortonCode() {
+        mBBox1 = BoundingBox3f(0, 1, 0, 1, 0, 1);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0, 0, 0), mBBox1) == 0);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(1, 1, 1), mBBox1) == (1U << 30) - 1);
+
+        // The highest bit of each coordinate is the highest bit of the code,
+        // with x first.
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0.5, 0, 0), mBBox1) == 1U << 29);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0, 0.5, 0), mBBox1) == 1U << 28);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0, 0, 0.5), mBBox1) == 1U << 27);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0, 0, 1.0/1024.0), mBBox1) == 1);
+
+        // Points outside the box are clamped to it.
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(-1, 2, -1), mBBox1)
+            == GetMortonCode(Vector3f(0, 1, 0), mBBox1));
+
+        // A box that's flat along an axis ignores that axis.
+        mBBox2 = BoundingBox3f(0, 1, 0, 1, 2, 2);
+        CPPUNIT_ASSERT(GetMortonCode(Vector3f(0.5, 0.5, 2), mBBox2) == 3U << 28);
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(BoundingBox3fOperationsTest);
@@ -0,0 +1,130 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include <cgmath/ParallelAlgorithms.h>
+
+// Sums a range of integers.
+class SumFunctor
+{
+public:
+    SumFunctor() : mSum(0), mChunks(1) {}
+    void operator()(std::vector<int>::iterator first, std::vector<int>::iterator last) {
+        for (std::vector<int>::iterator iterator = first; iterator != last; ++iterator) {
+            mSum += *iterator;
+        }
+    }
+    void merge(const SumFunctor &sumFunctor) {
+        mSum += sumFunctor.mSum;
+        mChunks += sumFunctor.mChunks;
+    }
+    long mSum;
+    int mChunks;
+};
+
+// True for even integers.
+class IsEvenPredicate
+{
+public:
+    bool operator()(int value) const {
+        return value % 2 == 0;
+    }
+};
+
+class ParallelAlgorithmsTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ParallelAlgorithmsTest);
+    CPPUNIT_TEST(testReduceInParallel);
+    CPPUNIT_TEST(testStablePartitionInParallel);
+    CPPUNIT_TEST(testNthElementInParallel);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testReduceInParallel() {
+        std::vector<int> valueVector;
+        for (int value = 1; value <= 1000; ++value) {
+            valueVector.push_back(value);
+        }
+
+        for (unsigned threads = 1; threads <= 8; ++threads) {
+            SumFunctor sumFunctor;
+            cgmath::ReduceInParallel(valueVector.begin(), valueVector.end(),
+                &sumFunctor, threads);
+            CPPUNIT_ASSERT(sumFunctor.mSum == 500500);
+            CPPUNIT_ASSERT(sumFunctor.mChunks == int(threads));
+        }
+
+        // More threads than elements.
+        std::vector<int> shortValueVector(3, 1);
+        SumFunctor sumFunctor;
+        cgmath::ReduceInParallel(shortValueVector.begin(), shortValueVector.end(),
+            &sumFunctor, 5);
+        CPPUNIT_ASSERT(sumFunctor.mSum == 3);
+    }
+
+    void testStablePartitionInParallel() {
+        srand48(1);
+        std::vector<int> valueVector;
+        for (int index = 0; index < 10000; ++index) {
+            valueVector.push_back(lrand48() % 1000);
+        }
+
+        std::vector<int> expectedValueVector = valueVector;
+        std::vector<int>::iterator expectedSplit = std::stable_partition(
+            expectedValueVector.begin(), expectedValueVector.end(), IsEvenPredicate());
+
+        for (unsigned threads = 1; threads <= 7; ++threads) {
+            std::vector<int> partitionedValueVector = valueVector;
+            std::vector<int>::iterator split = cgmath::StablePartitionInParallel(
+                partitionedValueVector.begin(), partitionedValueVector.end(),
+                IsEvenPredicate(), threads);
+            CPPUNIT_ASSERT(split - partitionedValueVector.begin()
+                == expectedSplit - expectedValueVector.begin());
+            CPPUNIT_ASSERT(partitionedValueVector == expectedValueVector);
+        }
+    }
+
+    void testNthElementInParallel() {
+        srand48(2);
+        std::vector<int> valueVector;
+        for (int index = 0; index < 100000; ++index) {
+            // Many duplicates, including many copies of the smallest value.
+            valueVector.push_back(index % 7 == 0 ? 0 : lrand48() % 5000);
+        }
+
+        std::vector<int> sortedValueVector = valueVector;
+        std::sort(sortedValueVector.begin(), sortedValueVector.end());
+
+        size_t positions[] = { 0, 1, 10000, 14285, 14286, 50000, 99999 };
+        for (unsigned threads = 1; threads <= 4; ++threads) {
+            for (size_t index = 0; index < sizeof(positions)/sizeof(positions[0]); ++index) {
+                std::vector<int> selectedValueVector = valueVector;
+                std::vector<int>::iterator nth = selectedValueVector.begin() + positions[index];
+                cgmath::NthElementInParallel(selectedValueVector.begin(), nth,
+                    selectedValueVector.end(), std::less<int>(), threads);
+                CPPUNIT_ASSERT(*nth == sortedValueVector[positions[index]]);
+                for (std::vector<int>::iterator iterator = selectedValueVector.begin();
+                     iterator != nth; ++iterator) {
+                    CPPUNIT_ASSERT(*iterator <= *nth);
+                }
+                for (std::vector<int>::iterator iterator = nth;
+                     iterator != selectedValueVector.end(); ++iterator) {
+                    CPPUNIT_ASSERT(*iterator >= *nth);
+                }
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelAlgorithmsTest);
@@ -0,0 +1,250 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include <cgmath/PointTree.h>
+#include <cgmath/Vector3f.h>
+
+using cgmath::PointTree;
+using cgmath::Vector3f;
+
+class Point
+{
+public:
+    Point(const Vector3f &position) : mPosition(position) {}
+    const Vector3f &position() const {
+        return mPosition;
+    }
+private:
+    Vector3f mPosition;
+};
+
+typedef PointTree<Point> PointPointTree;
+
+// Counts the points found within the sphere.
+class PointSphereListener : public PointPointTree::SphereListener
+{
+public:
+    PointSphereListener() : mCount(0) {}
+    virtual bool applyObjectToSphere(Point &point, const Vector3f &center, float radius,
+        float distanceSquared) {
+        CPPUNIT_ASSERT((point.position() - center).lengthSquared() == distanceSquared);
+        CPPUNIT_ASSERT(distanceSquared <= radius*radius);
+        ++mCount;
+        return false;
+    }
+    int mCount;
+};
+
+// Halts traversal of the tree at the first point found.
+class HaltingPointSphereListener : public PointPointTree::SphereListener
+{
+public:
+    virtual bool applyObjectToSphere(Point &, const Vector3f &, float, float) {
+        return true;
+    }
+};
+
+// Only accepts points with positive x coordinates.
+class PositiveXFilter : public PointPointTree::NearestObjectFilter
+{
+public:
+    virtual bool acceptNearestObject(const Point &point) const {
+        return point.position()[0] > 0.0;
+    }
+};
+
+class PointTreeTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(PointTreeTest);
+    CPPUNIT_TEST(testCreation);
+    CPPUNIT_TEST(testSphereListener);
+    CPPUNIT_TEST(testFindNearestObjects);
+    CPPUNIT_TEST(testFindNearestObjectsWithFilter);
+    CPPUNIT_TEST(testRandomPoints);
+    CPPUNIT_TEST(testParallelBuild);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testCreation() {
+        PointPointTree pointTree;
+
+        PointPointTree::ObjectVector objectVector;
+        pointTree.initialize(objectVector);
+        CPPUNIT_ASSERT(pointTree.size() == 0);
+
+        objectVector.push_back(Point(Vector3f(0, 0, 0)));
+        pointTree.initialize(objectVector);
+        CPPUNIT_ASSERT(pointTree.size() == 1);
+
+        pointTree.clear();
+        CPPUNIT_ASSERT(pointTree.size() == 0);
+    }
+
+    void testSphereListener() {
+        PointPointTree pointTree;
+
+        PointPointTree::ObjectVector objectVector;
+        for (int index = 0; index < 10; ++index) {
+            objectVector.push_back(Point(Vector3f(index, 0, 0)));
+        }
+        pointTree.initialize(objectVector);
+
+        PointSphereListener pointSphereListener;
+        CPPUNIT_ASSERT(!pointTree.applyToSphereIntersection(Vector3f(4.5, 0, 0), 2.0,
+                &pointSphereListener));
+        CPPUNIT_ASSERT(pointSphereListener.mCount == 4);
+
+        // Points on the surface of the sphere are included.
+        pointSphereListener.mCount = 0;
+        pointTree.applyToSphereIntersection(Vector3f(4, 1, 0), 1.0, &pointSphereListener);
+        CPPUNIT_ASSERT(pointSphereListener.mCount == 1);
+
+        pointSphereListener.mCount = 0;
+        pointTree.applyToSphereIntersection(Vector3f(4, 2, 0), 1.0, &pointSphereListener);
+        CPPUNIT_ASSERT(pointSphereListener.mCount == 0);
+
+        HaltingPointSphereListener haltingPointSphereListener;
+        CPPUNIT_ASSERT(pointTree.applyToSphereIntersection(Vector3f(4.5, 0, 0), 2.0,
+                &haltingPointSphereListener));
+    }
+
+    void testFindNearestObjects() {
+        PointPointTree pointTree;
+
+        PointPointTree::ObjectVector objectVector;
+        for (int index = 0; index < 10; ++index) {
+            objectVector.push_back(Point(Vector3f(index, 0, 0)));
+        }
+        pointTree.initialize(objectVector);
+
+        PointPointTree::NearestObjectVector nearestObjectVector;
+        pointTree.findNearestObjects(Vector3f(4.4, 0, 0), 3, 100.0, &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.size() == 3);
+        CPPUNIT_ASSERT(nearestObjectVector[0].mObject->position() == Vector3f(4, 0, 0));
+        CPPUNIT_ASSERT(nearestObjectVector[1].mObject->position() == Vector3f(5, 0, 0));
+        CPPUNIT_ASSERT(nearestObjectVector[2].mObject->position() == Vector3f(3, 0, 0));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(nearestObjectVector[0].mDistanceSquared, 0.16, 0.0001);
+
+        // Only two points lie within the maximum distance.
+        pointTree.findNearestObjects(Vector3f(-1, 0, 0), 3, 2.0, &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.size() == 2);
+        CPPUNIT_ASSERT(nearestObjectVector[0].mObject->position() == Vector3f(0, 0, 0));
+        CPPUNIT_ASSERT(nearestObjectVector[1].mObject->position() == Vector3f(1, 0, 0));
+
+        pointTree.findNearestObjects(Vector3f(-10, 0, 0), 3, 2.0, &nearestObjectVector);
+        CPPUNIT_ASSERT(nearestObjectVector.empty());
+    }
+
+    void testFindNearestObjectsWithFilter() {
+        PointPointTree pointTree;
+
+        PointPointTree::ObjectVector objectVector;
+        for (int index = -5; index <= 5; ++index) {
+            objectVector.push_back(Point(Vector3f(index, 0, 0)));
+        }
+        pointTree.initialize(objectVector);
+
+        PositiveXFilter positiveXFilter;
+        PointPointTree::NearestObjectVector nearestObjectVector;
+        pointTree.findNearestObjects(Vector3f(-0.1, 0, 0), 2, 100.0, &nearestObjectVector,
+            &positiveXFilter);
+        CPPUNIT_ASSERT(nearestObjectVector.size() == 2);
+        CPPUNIT_ASSERT(nearestObjectVector[0].mObject->position() == Vector3f(1, 0, 0));
+        CPPUNIT_ASSERT(nearestObjectVector[1].mObject->position() == Vector3f(2, 0, 0));
+    }
+
+    void testRandomPoints() {
+        // Compare the results of the queries against a brute force search.
+        srand48(1);
+
+        PointPointTree::ObjectVector objectVector;
+        for (int index = 0; index < 1000; ++index) {
+            objectVector.push_back(Point(Vector3f(drand48(), drand48(), drand48())));
+        }
+
+        PointPointTree pointTree;
+        pointTree.initialize(objectVector);
+
+        static const unsigned MAXIMUM_OBJECTS = 10;
+        static const float RADIUS = 0.1;
+
+        for (int query = 0; query < 100; ++query) {
+            Vector3f point(drand48(), drand48(), drand48());
+
+            std::vector<float> distanceSquaredVector;
+            int pointsInSphere = 0;
+            for (size_t index = 0; index < objectVector.size(); ++index) {
+                float distanceSquared
+                    = (objectVector[index].position() - point).lengthSquared();
+                distanceSquaredVector.push_back(distanceSquared);
+                if (distanceSquared <= RADIUS*RADIUS) {
+                    ++pointsInSphere;
+                }
+            }
+            std::sort(distanceSquaredVector.begin(), distanceSquaredVector.end());
+
+            PointSphereListener pointSphereListener;
+            pointTree.applyToSphereIntersection(point, RADIUS, &pointSphereListener);
+            CPPUNIT_ASSERT(pointSphereListener.mCount == pointsInSphere);
+
+            PointPointTree::NearestObjectVector nearestObjectVector;
+            pointTree.findNearestObjects(point, MAXIMUM_OBJECTS, 10.0,
+                &nearestObjectVector);
+            CPPUNIT_ASSERT(nearestObjectVector.size() == MAXIMUM_OBJECTS);
+            for (size_t index = 0; index < MAXIMUM_OBJECTS; ++index) {
+                CPPUNIT_ASSERT(nearestObjectVector[index].mDistanceSquared
+                    == distanceSquaredVector[index]);
+            }
+        }
+
+        CPPUNIT_ASSERT(pointTree.queries() == 200);
+
+        // The queries should not visit every point in the tree.
+        CPPUNIT_ASSERT(pointTree.averageObjectTestsPerQuery() < objectVector.size()/4);
+    }
+
+    void testParallelBuild() {
+        srand48(3);
+        PointPointTree::ObjectVector objectVector;
+        for (int index = 0; index < 20000; ++index) {
+            objectVector.push_back(Point(Vector3f(drand48(), drand48(), drand48())));
+        }
+
+        PointPointTree serialPointTree;
+        serialPointTree.setMaximumBuildThreads(1);
+        serialPointTree.initialize(objectVector);
+
+        PointPointTree parallelPointTree;
+        parallelPointTree.setMaximumBuildThreads(4);
+        parallelPointTree.initialize(objectVector);
+
+        // Both trees must find the same nearest points.
+        PointPointTree::NearestObjectVector serialNearestObjectVector;
+        PointPointTree::NearestObjectVector parallelNearestObjectVector;
+        for (int query = 0; query < 100; ++query) {
+            Vector3f point(drand48(), drand48(), drand48());
+            serialPointTree.findNearestObjects(point, 8, 1.0, &serialNearestObjectVector);
+            parallelPointTree.findNearestObjects(point, 8, 1.0,
+                &parallelNearestObjectVector);
+            CPPUNIT_ASSERT(parallelNearestObjectVector.size()
+                == serialNearestObjectVector.size());
+            for (size_t index = 0; index < serialNearestObjectVector.size(); ++index) {
+                CPPUNIT_ASSERT(parallelNearestObjectVector[index].mObject->position()
+                    == serialNearestObjectVector[index].mObject->position());
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PointTreeTest);
@@ -0,0 +1,333 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+#include <vector>
+#include <set>
+
+#include <cgmath/QuantizedAabbTree.h>
+#include <cgmath/AabbTree.h>
+#include <cgmath/AabbTreeStatistics.h>
+#include <cgmath/BoundingBox3fOperations.h>
+#include <cgmath/Vector3f.h>
+
+using cgmath::AabbTree;
+using cgmath::QuantizedAabbTree;
+using cgmath::BoundingBox3f;
+using cgmath::Vector3f;
+
+// An object with an arbitrary bounding box, and an identifier
+// to tell objects apart once they've been copied into a tree.
+class BoxShape
+{
+public:
+    BoxShape(const BoundingBox3f &boundingBox, int id)
+        : mBoundingBox(boundingBox), mId(id) {}
+    BoundingBox3f boundingBox() const {
+        return mBoundingBox;
+    }
+    int id() const {
+        return mId;
+    }
+    bool operator==(const BoxShape &rhs) const {
+        return mId == rhs.mId;
+    }
+private:
+    BoundingBox3f mBoundingBox;
+    int mId;
+};
+
+// Treats each object as a solid box for ray segment queries.
+class BoxShapeRaySegmentListener
+    : public AabbTree<BoxShape>::RaySegmentOcclusionListener,
+      public AabbTree<BoxShape>::RaySegmentIntersectionListener
+{
+public:
+    virtual bool objectOccludesRaySegment(const BoxShape &boxShape,
+        const Vector3f &origin, const Vector3f &endpoint) const {
+        return cgmath::BoundingBox3fIntersectsRaySegment(boxShape.boundingBox(),
+            origin, endpoint);
+    }
+    virtual bool objectIntersectsRaySegment(const BoxShape &boxShape,
+        const Vector3f &origin, const Vector3f &endpoint, float *t) const {
+        float objectT = 0.0;
+        if (!cgmath::BoundingBox3fIntersectsRaySegment(boxShape.boundingBox(),
+                origin, endpoint, &objectT)
+            || objectT >= *t) {
+            return false;
+        }
+        *t = objectT;
+        return true;
+    }
+};
+
+// Records the objects whose bounding boxes intersect the query's bounding box.
+class BoxShapeBoundingBoxListener : public AabbTree<BoxShape>::BoundingBoxListener
+{
+public:
+    virtual bool applyObjectToBoundingBox(BoxShape &boxShape,
+        const BoundingBox3f &boundingBox) {
+        if (cgmath::BoundingBox3fIntersectsBoundingBox3f(boxShape.boundingBox(),
+                boundingBox)) {
+            mIdSet.insert(boxShape.id());
+        }
+        return false;
+    }
+    std::set<int> mIdSet;
+};
+
+class QuantizedAabbTreeTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(QuantizedAabbTreeTest);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testSingleObject);
+    CPPUNIT_TEST(testBoundingBoxQueries);
+    CPPUNIT_TEST(testRandomRaySegments);
+    CPPUNIT_TEST(testModifiedAabbTree);
+    CPPUNIT_TEST(testBytesUsed);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testEmpty() {
+        AabbTree<BoxShape> aabbTree;
+        QuantizedAabbTree<BoxShape> quantizedAabbTree;
+        quantizedAabbTree.initialize(aabbTree);
+        CPPUNIT_ASSERT(quantizedAabbTree.empty());
+        CPPUNIT_ASSERT(quantizedAabbTree.objectVector().empty());
+
+        BoxShapeRaySegmentListener raySegmentListener;
+        CPPUNIT_ASSERT(!quantizedAabbTree.occludesRaySegment(Vector3f(0, 0, 0),
+                Vector3f(1, 1, 1), &raySegmentListener));
+        BoxShapeBoundingBoxListener boundingBoxListener;
+        CPPUNIT_ASSERT(!quantizedAabbTree.applyToBoundingBoxIntersection(
+                BoundingBox3f(0, 1, 0, 1, 0, 1), &boundingBoxListener));
+    }
+
+    void testSingleObject() {
+        AabbTree<BoxShape>::ObjectVector objectVector;
+        objectVector.push_back(BoxShape(BoundingBox3f(0, 1, 0, 1, 0, 1), 0));
+        AabbTree<BoxShape> aabbTree;
+        aabbTree.initialize(objectVector);
+
+        QuantizedAabbTree<BoxShape> quantizedAabbTree;
+        quantizedAabbTree.initialize(aabbTree);
+        CPPUNIT_ASSERT(!quantizedAabbTree.empty());
+        CPPUNIT_ASSERT(quantizedAabbTree.objectVector().size() == 1);
+
+        BoxShapeRaySegmentListener raySegmentListener;
+        CPPUNIT_ASSERT(quantizedAabbTree.occludesRaySegment(Vector3f(-1, 0.5, 0.5),
+                Vector3f(0.5, 0.5, 0.5), &raySegmentListener));
+        CPPUNIT_ASSERT(!quantizedAabbTree.occludesRaySegment(Vector3f(-1, 1.5, 0.5),
+                Vector3f(0.5, 1.5, 0.5), &raySegmentListener));
+
+        Vector3f intersectionPoint;
+        BoxShape *intersectedObject = NULL;
+        CPPUNIT_ASSERT(quantizedAabbTree.intersectsRaySegment(Vector3f(3, 0.5, 0.5),
+                Vector3f(-1, 0.5, 0.5), &raySegmentListener,
+                &intersectionPoint, &intersectedObject));
+        CPPUNIT_ASSERT(intersectedObject != NULL);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(intersectionPoint[0], 1.0, 0.0001);
+
+        quantizedAabbTree.clear();
+        CPPUNIT_ASSERT(quantizedAabbTree.empty());
+    }
+
+    void testBoundingBoxQueries() {
+        srand48(1);
+        AabbTree<BoxShape>::ObjectVector objectVector;
+        createRandomObjects(5000, 4.0, &objectVector);
+
+        for (int strategy = 0; strategy < 2; ++strategy) {
+            AabbTree<BoxShape> aabbTree;
+            aabbTree.setSplitStrategy(strategy == 0
+                ? AabbTree<BoxShape>::MEDIAN_SPLIT
+                : AabbTree<BoxShape>::SURFACE_AREA_HEURISTIC);
+            aabbTree.initialize(objectVector);
+
+            QuantizedAabbTree<BoxShape> quantizedAabbTree;
+            quantizedAabbTree.initialize(aabbTree);
+            CPPUNIT_ASSERT(quantizedAabbTree.objectVector().size() == objectVector.size());
+
+            cgmath::AabbTreeStatistics aabbTreeStatistics;
+            cgmath::AabbTreeStatistics quantizedAabbTreeStatistics;
+            for (int query = 0; query < 200; ++query) {
+                Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+                Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*10.0;
+                BoundingBox3f boundingBox(min, max);
+
+                // The listener filters out the objects whose bounding boxes
+                // don't intersect, so both trees must report the same objects,
+                // even though the quantized tree may test more of them.
+                BoxShapeBoundingBoxListener listener;
+                aabbTree.applyToBoundingBoxIntersection(boundingBox, &listener,
+                    &aabbTreeStatistics);
+                BoxShapeBoundingBoxListener quantizedListener;
+                quantizedAabbTree.applyToBoundingBoxIntersection(boundingBox,
+                    &quantizedListener, &quantizedAabbTreeStatistics);
+                CPPUNIT_ASSERT(quantizedListener.mIdSet == listener.mIdSet);
+            }
+
+            // The decoded bounding boxes are only a little larger.
+            CPPUNIT_ASSERT(quantizedAabbTreeStatistics.averageObjectTestsPerQuery()
+                < aabbTreeStatistics.averageObjectTestsPerQuery()*2.0 + 1.0);
+        }
+    }
+
+    void testRandomRaySegments() {
+        srand48(2);
+        AabbTree<BoxShape>::ObjectVector objectVector;
+        createRandomObjects(5000, 4.0, &objectVector);
+
+        for (int strategy = 0; strategy < 2; ++strategy) {
+            AabbTree<BoxShape> aabbTree;
+            aabbTree.setSplitStrategy(strategy == 0
+                ? AabbTree<BoxShape>::MEDIAN_SPLIT
+                : AabbTree<BoxShape>::SURFACE_AREA_HEURISTIC);
+            aabbTree.initialize(objectVector);
+
+            QuantizedAabbTree<BoxShape> quantizedAabbTree;
+            quantizedAabbTree.initialize(aabbTree);
+
+            compareRaySegmentQueries(objectVector, aabbTree, quantizedAabbTree);
+        }
+    }
+
+    void testModifiedAabbTree() {
+        srand48(3);
+        AabbTree<BoxShape>::ObjectVector objectVector;
+        createRandomObjects(1000, 8.0, &objectVector);
+
+        AabbTree<BoxShape> aabbTree;
+        aabbTree.initialize(objectVector);
+
+        // Remove some objects and insert others, so that the AabbTree
+        // has freed objects and nodes that aren't copied.
+        AabbTree<BoxShape>::ObjectVector remainingObjectVector;
+        for (size_t index = 0; index < objectVector.size(); ++index) {
+            if (index % 3 == 0) {
+                CPPUNIT_ASSERT(aabbTree.removeObject(objectVector[index]));
+            } else {
+                remainingObjectVector.push_back(objectVector[index]);
+            }
+        }
+        AabbTree<BoxShape>::ObjectVector insertedObjectVector;
+        createRandomObjects(200, 8.0, &insertedObjectVector);
+        for (size_t index = 0; index < insertedObjectVector.size(); ++index) {
+            BoxShape boxShape(insertedObjectVector[index].boundingBox(),
+                objectVector.size() + index);
+            aabbTree.insertObject(boxShape);
+            remainingObjectVector.push_back(boxShape);
+        }
+
+        QuantizedAabbTree<BoxShape> quantizedAabbTree;
+        quantizedAabbTree.initialize(aabbTree);
+        CPPUNIT_ASSERT(quantizedAabbTree.objectVector().size()
+            == remainingObjectVector.size());
+
+        compareRaySegmentQueries(remainingObjectVector, aabbTree, quantizedAabbTree);
+
+        // An AabbTree rebuilt from the quantized tree's objects
+        // contains the same objects.
+        AabbTree<BoxShape> rebuiltAabbTree;
+        rebuiltAabbTree.initialize(quantizedAabbTree.objectVector());
+        compareRaySegmentQueries(remainingObjectVector, rebuiltAabbTree,
+            quantizedAabbTree);
+    }
+
+    void testBytesUsed() {
+        srand48(4);
+        AabbTree<BoxShape>::ObjectVector objectVector;
+        createRandomObjects(10000, 4.0, &objectVector);
+
+        AabbTree<BoxShape> aabbTree;
+        aabbTree.initialize(objectVector);
+
+        QuantizedAabbTree<BoxShape> quantizedAabbTree;
+        quantizedAabbTree.initialize(aabbTree);
+
+        // Each node occupies 12 bytes rather than 32.
+        size_t objectBytes = objectVector.size()*sizeof(BoxShape);
+        CPPUNIT_ASSERT((quantizedAabbTree.bytesUsed() - objectBytes)*2
+            < aabbTree.bytesUsed() - objectBytes);
+    }
+
+private:
+    void createRandomObjects(unsigned count, float size,
+        AabbTree<BoxShape>::ObjectVector *objectVector) {
+        for (unsigned index = 0; index < count; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*size;
+            objectVector->push_back(BoxShape(BoundingBox3f(min, max),
+                    objectVector->size()));
+        }
+    }
+
+    // The AabbTree, the QuantizedAabbTree and a brute force search of the
+    // objects must all find the same closest intersections and occlusions.
+    void compareRaySegmentQueries(const AabbTree<BoxShape>::ObjectVector &objectVector,
+        const AabbTree<BoxShape> &aabbTree,
+        const QuantizedAabbTree<BoxShape> &quantizedAabbTree) {
+        BoxShapeRaySegmentListener raySegmentListener;
+        cgmath::AabbTreeStatistics quantizedAabbTreeStatistics;
+
+        int hits = 0;
+        for (int query = 0; query < 500; ++query) {
+            Vector3f origin = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f endpoint = origin
+                + (Vector3f(drand48(), drand48(), drand48()) - Vector3f(0.5, 0.5, 0.5))
+                *(query % 2 == 0 ? 20.0 : 200.0);
+            if (query % 7 == 0) {
+                endpoint[query % 3] = origin[query % 3];
+            }
+
+            // Find the closest object by brute force.
+            float expectedT = 1.0;
+            const BoxShape *expectedObject = NULL;
+            for (size_t index = 0; index < objectVector.size(); ++index) {
+                if (raySegmentListener.objectIntersectsRaySegment(objectVector[index],
+                        origin, endpoint, &expectedT)) {
+                    expectedObject = &objectVector[index];
+                }
+            }
+
+            Vector3f intersectionPoint;
+            BoxShape *intersectedObject = NULL;
+            bool result = aabbTree.intersectsRaySegment(origin, endpoint,
+                &raySegmentListener, &intersectionPoint, &intersectedObject);
+            Vector3f quantizedIntersectionPoint;
+            BoxShape *quantizedIntersectedObject = NULL;
+            bool quantizedResult = quantizedAabbTree.intersectsRaySegment(origin, endpoint,
+                &raySegmentListener, &quantizedIntersectionPoint,
+                &quantizedIntersectedObject, &quantizedAabbTreeStatistics);
+
+            CPPUNIT_ASSERT(result == (expectedObject != NULL));
+            CPPUNIT_ASSERT(quantizedResult == result);
+            if (result) {
+                ++hits;
+                // When the origin is inside several objects, they're all
+                // intersected at t=0, and any of them may be returned.
+                if (expectedT > 0.0) {
+                    CPPUNIT_ASSERT(*quantizedIntersectedObject == *expectedObject);
+                }
+                CPPUNIT_ASSERT(quantizedIntersectionPoint == intersectionPoint);
+            }
+
+            CPPUNIT_ASSERT(quantizedAabbTree.occludesRaySegment(origin, endpoint,
+                    &raySegmentListener) == result);
+        }
+        CPPUNIT_ASSERT(hits > 50);
+        CPPUNIT_ASSERT(hits < 500);
+
+        CPPUNIT_ASSERT(quantizedAabbTreeStatistics.averageObjectTestsPerQuery()
+            < objectVector.size()/10);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(QuantizedAabbTreeTest);
@@ -0,0 +1,202 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+
+#include <cgmath/RaySegment.h>
+#include <cgmath/BoundingBox3f.h>
+#include <cgmath/BoundingBox3fOperations.h>
+#include <cgmath/Vector3f.h>
+
+using cgmath::RaySegment;
+using cgmath::BoundingBox3f;
+using cgmath::BoundingBox3fQuad;
+using cgmath::Vector3f;
+
+class RaySegmentTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(RaySegmentTest);
+    CPPUNIT_TEST(testConstructor);
+    CPPUNIT_TEST(testIntersectsBoundingBox3f);
+    CPPUNIT_TEST(testAxisAligned);
+    CPPUNIT_TEST(testMaxT);
+    CPPUNIT_TEST(testRandomBoundingBoxes);
+    CPPUNIT_TEST(testIntersectsBoundingBox3fQuad);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testConstructor() {
+        RaySegment raySegment(Vector3f(1, 2, 3), Vector3f(3, 2, -1));
+        CPPUNIT_ASSERT(raySegment.origin() == Vector3f(1, 2, 3));
+        CPPUNIT_ASSERT(raySegment.endpoint() == Vector3f(3, 2, -1));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(raySegment.inverseDirection()[0], 0.5, 0.0001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(raySegment.inverseDirection()[2], -0.25, 0.0001);
+        CPPUNIT_ASSERT(raySegment.sign(0) == 0);
+        CPPUNIT_ASSERT(raySegment.sign(1) == 0);
+        CPPUNIT_ASSERT(raySegment.sign(2) == 1);
+
+        // Zero components of the direction are flagged.
+        CPPUNIT_ASSERT(!raySegment.parallel(0));
+        CPPUNIT_ASSERT(raySegment.parallel(1));
+        CPPUNIT_ASSERT(!raySegment.parallel(2));
+    }
+
+    void testIntersectsBoundingBox3f() {
+        BoundingBox3f bbox(0, 1, 0, 1, 0, 1);
+        float t = -1.0;
+
+        CPPUNIT_ASSERT(RaySegment(Vector3f(-1, 0.5, 0.5), Vector3f(3, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(t, 0.25, 0.0001);
+
+        // In the opposite direction.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(3, 0.5, 0.5), Vector3f(-1, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(t, 0.5, 0.0001);
+
+        // The origin is inside the box.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(0.5, 0.5, 0.5), Vector3f(3, 2, 1))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT(t == 0.0);
+
+        // The segment ends before the box.
+        CPPUNIT_ASSERT(!RaySegment(Vector3f(-2, 0.5, 0.5), Vector3f(-0.5, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+
+        // The segment points away from the box.
+        CPPUNIT_ASSERT(!RaySegment(Vector3f(-1, 0.5, 0.5), Vector3f(-3, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+
+        // The segment passes beside the box.
+        CPPUNIT_ASSERT(!RaySegment(Vector3f(-1, 1.5, 0.5), Vector3f(3, 0.5, 2.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+    }
+
+    void testAxisAligned() {
+        BoundingBox3f bbox(0, 1, 0, 1, 0, 1);
+        float t = -1.0;
+
+        // A segment lying in the plane of a face of the box
+        // is not missed.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(-1, 0, 0.5), Vector3f(2, 0, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(t, 1.0/3.0, 0.0001);
+        CPPUNIT_ASSERT(RaySegment(Vector3f(0.5, 1, 2), Vector3f(0.5, 1, -2))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(t, 0.25, 0.0001);
+
+        // Nor is one along an edge of the box.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(1, 1, -1), Vector3f(1, 1, 3))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+
+        // A segment parallel to a face, but outside the box, is missed.
+        CPPUNIT_ASSERT(!RaySegment(Vector3f(-1, 1.01, 0.5), Vector3f(2, 1.01, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+
+        // A segment that ends exactly on the box hits it.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(-1, 0.5, 0.5), Vector3f(0, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(t, 1.0, 0.0001);
+
+        // A degenerate segment hits a box only if it's inside it.
+        CPPUNIT_ASSERT(RaySegment(Vector3f(0.5, 0.5, 0.5), Vector3f(0.5, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+        CPPUNIT_ASSERT(!RaySegment(Vector3f(1.5, 0.5, 0.5), Vector3f(1.5, 0.5, 0.5))
+            .intersectsBoundingBox3f(bbox, 1.0, &t));
+    }
+
+    void testMaxT() {
+        BoundingBox3f bbox(0, 1, 0, 1, 0, 1);
+        float t = -1.0;
+
+        RaySegment raySegment(Vector3f(-1, 0.5, 0.5), Vector3f(3, 0.5, 0.5));
+        CPPUNIT_ASSERT(raySegment.intersectsBoundingBox3f(bbox, 0.3, &t));
+        CPPUNIT_ASSERT(!raySegment.intersectsBoundingBox3f(bbox, 0.2, &t));
+    }
+
+    void testRandomBoundingBoxes() {
+        srand48(1);
+
+        // Whenever BoundingBox3fIntersectsRaySegment finds an intersection,
+        // the slab test must find it too, at the same value of t.
+        int hits = 0;
+        for (int index = 0; index < 10000; ++index) {
+            Vector3f min(drand48(), drand48(), drand48());
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48());
+            BoundingBox3f bbox(min, max);
+            // Aim most of the segments near the box.
+            Vector3f origin = Vector3f(drand48(), drand48(), drand48())*4.0
+                - Vector3f(1.5, 1.5, 1.5);
+            Vector3f endpoint = origin
+                + (Vector3f(drand48(), drand48(), drand48())*2.0 - origin)*2.0;
+
+            float expectedT = 0.0;
+            float t = 0.0;
+            bool expectedResult = cgmath::BoundingBox3fIntersectsRaySegment(bbox,
+                origin, endpoint, &expectedT);
+            bool result = RaySegment(origin, endpoint).intersectsBoundingBox3f(bbox,
+                1.0, &t);
+            if (expectedResult) {
+                ++hits;
+                CPPUNIT_ASSERT(result);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(t, expectedT, 0.0001);
+            }
+        }
+        CPPUNIT_ASSERT(hits > 1000);
+    }
+
+    void testIntersectsBoundingBox3fQuad() {
+        srand48(2);
+
+        // The four-way test must agree exactly with the single box test.
+        for (int index = 0; index < 1000; ++index) {
+            BoundingBox3f bboxes[4];
+            BoundingBox3fQuad quad;
+            for (unsigned box = 0; box < 4; ++box) {
+                Vector3f min(drand48(), drand48(), drand48());
+                Vector3f max = min + Vector3f(drand48(), drand48(), drand48());
+                bboxes[box] = BoundingBox3f(min, max);
+                quad.setBoundingBox3f(box, bboxes[box]);
+            }
+            // Sometimes leave the last entry unused.
+            bool reset = index % 4 == 0;
+            if (reset) {
+                quad.reset(3);
+            }
+
+            Vector3f origin = Vector3f(drand48(), drand48(), drand48())*4.0
+                - Vector3f(1.5, 1.5, 1.5);
+            Vector3f endpoint = Vector3f(drand48(), drand48(), drand48())*4.0
+                - Vector3f(1.5, 1.5, 1.5);
+            if (index % 3 == 0) {
+                endpoint[index % 2] = origin[index % 2];
+            }
+            RaySegment raySegment(origin, endpoint);
+            float maxT = index % 5 == 0 ? 0.5 : 1.0;
+
+            float quadT[4];
+            unsigned mask = raySegment.intersectsBoundingBox3fQuad(quad, maxT, quadT);
+            for (unsigned box = 0; box < 4; ++box) {
+                if (reset && box == 3) {
+                    CPPUNIT_ASSERT((mask & (1 << box)) == 0);
+                    continue;
+                }
+                float t = 0.0;
+                bool result = raySegment.intersectsBoundingBox3f(bboxes[box], maxT, &t);
+                CPPUNIT_ASSERT(result == ((mask & (1 << box)) != 0));
+                if (result) {
+                    CPPUNIT_ASSERT(t == quadT[box]);
+                }
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RaySegmentTest);
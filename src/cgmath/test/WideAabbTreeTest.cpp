@@ -0,0 +1,251 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include <cgmath/WideAabbTree.h>
+#include <cgmath/AabbTree.h>
+#include <cgmath/AabbTreeStatistics.h>
+#include <cgmath/BoundingBox3fOperations.h>
+#include <cgmath/Vector3f.h>
+
+using cgmath::AabbTree;
+using cgmath::WideAabbTree;
+using cgmath::Vector3f;
+
+// An object with an arbitrary bounding box.
+class SolidBox
+{
+public:
+    SolidBox(const cgmath::BoundingBox3f &boundingBox) : mBoundingBox(boundingBox) {}
+    cgmath::BoundingBox3f boundingBox() const {
+        return mBoundingBox;
+    }
+    bool operator==(const SolidBox &rhs) const {
+        return mBoundingBox == rhs.mBoundingBox;
+    }
+private:
+    cgmath::BoundingBox3f mBoundingBox;
+};
+
+// Treats each object as a solid box for ray segment queries.
+class SolidBoxOcclusionListener
+    : public AabbTree<SolidBox>::RaySegmentOcclusionListener
+{
+public:
+    virtual bool objectOccludesRaySegment(const SolidBox &solidBox,
+        const Vector3f &origin, const Vector3f &endpoint) const {
+        return cgmath::BoundingBox3fIntersectsRaySegment(solidBox.boundingBox(),
+            origin, endpoint);
+    }
+};
+
+class SolidBoxIntersectionListener
+    : public AabbTree<SolidBox>::RaySegmentIntersectionListener
+{
+public:
+    virtual bool objectIntersectsRaySegment(const SolidBox &solidBox,
+        const Vector3f &origin, const Vector3f &endpoint, float *t) const {
+        float objectT = 0.0;
+        if (!cgmath::BoundingBox3fIntersectsRaySegment(solidBox.boundingBox(),
+                origin, endpoint, &objectT)
+            || objectT >= *t) {
+            return false;
+        }
+        *t = objectT;
+        return true;
+    }
+};
+
+class WideAabbTreeTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(WideAabbTreeTest);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testSingleObject);
+    CPPUNIT_TEST(testRandomRaySegments);
+    CPPUNIT_TEST(testModifiedAabbTree);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testEmpty() {
+        AabbTree<SolidBox> aabbTree;
+        WideAabbTree<SolidBox> wideAabbTree;
+        wideAabbTree.initialize(aabbTree);
+        CPPUNIT_ASSERT(wideAabbTree.empty());
+
+        SolidBoxOcclusionListener occlusionListener;
+        CPPUNIT_ASSERT(!wideAabbTree.occludesRaySegment(Vector3f(0, 0, 0),
+                Vector3f(1, 1, 1), &occlusionListener));
+    }
+
+    void testSingleObject() {
+        AabbTree<SolidBox>::ObjectVector objectVector;
+        objectVector.push_back(SolidBox(cgmath::BoundingBox3f(0, 1, 0, 1, 0, 1)));
+        AabbTree<SolidBox> aabbTree;
+        aabbTree.initialize(objectVector);
+
+        WideAabbTree<SolidBox> wideAabbTree;
+        wideAabbTree.initialize(aabbTree);
+        CPPUNIT_ASSERT(!wideAabbTree.empty());
+
+        SolidBoxOcclusionListener occlusionListener;
+        CPPUNIT_ASSERT(wideAabbTree.occludesRaySegment(Vector3f(-1, 0.5, 0.5),
+                Vector3f(0.5, 0.5, 0.5), &occlusionListener));
+        CPPUNIT_ASSERT(!wideAabbTree.occludesRaySegment(Vector3f(-1, 1.5, 0.5),
+                Vector3f(0.5, 1.5, 0.5), &occlusionListener));
+
+        SolidBoxIntersectionListener intersectionListener;
+        Vector3f intersectionPoint;
+        SolidBox *intersectedObject = NULL;
+        CPPUNIT_ASSERT(wideAabbTree.intersectsRaySegment(Vector3f(3, 0.5, 0.5),
+                Vector3f(-1, 0.5, 0.5), &intersectionListener,
+                &intersectionPoint, &intersectedObject));
+        CPPUNIT_ASSERT(intersectedObject != NULL);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(intersectionPoint[0], 1.0, 0.0001);
+
+        wideAabbTree.clear();
+        CPPUNIT_ASSERT(wideAabbTree.empty());
+    }
+
+    void testRandomRaySegments() {
+        srand48(1);
+        AabbTree<SolidBox>::ObjectVector objectVector;
+        for (int index = 0; index < 5000; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*4.0;
+            objectVector.push_back(SolidBox(cgmath::BoundingBox3f(min, max)));
+        }
+
+        for (int strategy = 0; strategy < 2; ++strategy) {
+            AabbTree<SolidBox> aabbTree;
+            aabbTree.setSplitStrategy(strategy == 0
+                ? AabbTree<SolidBox>::MEDIAN_SPLIT
+                : AabbTree<SolidBox>::SURFACE_AREA_HEURISTIC);
+            aabbTree.initialize(objectVector);
+
+            WideAabbTree<SolidBox> wideAabbTree;
+            wideAabbTree.initialize(aabbTree);
+            CPPUNIT_ASSERT(wideAabbTree.bytesUsed() > 0);
+
+            compareRaySegmentQueries(objectVector, aabbTree, wideAabbTree);
+        }
+    }
+
+    void testModifiedAabbTree() {
+        srand48(2);
+        AabbTree<SolidBox>::ObjectVector objectVector;
+        for (int index = 0; index < 1000; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*8.0;
+            objectVector.push_back(SolidBox(cgmath::BoundingBox3f(min, max)));
+        }
+
+        AabbTree<SolidBox> aabbTree;
+        aabbTree.initialize(objectVector);
+
+        // Remove some objects and insert others, so that the AabbTree
+        // has freed objects and nodes that the WideAabbTree must ignore.
+        AabbTree<SolidBox>::ObjectVector remainingObjectVector;
+        for (size_t index = 0; index < objectVector.size(); ++index) {
+            if (index % 3 == 0) {
+                CPPUNIT_ASSERT(aabbTree.removeObject(objectVector[index]));
+            } else {
+                remainingObjectVector.push_back(objectVector[index]);
+            }
+        }
+        for (int index = 0; index < 200; ++index) {
+            Vector3f min = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f max = min + Vector3f(drand48(), drand48(), drand48())*8.0;
+            SolidBox solidBox(cgmath::BoundingBox3f(min, max));
+            aabbTree.insertObject(solidBox);
+            remainingObjectVector.push_back(solidBox);
+        }
+
+        WideAabbTree<SolidBox> wideAabbTree;
+        wideAabbTree.initialize(aabbTree);
+
+        compareRaySegmentQueries(remainingObjectVector, aabbTree, wideAabbTree);
+    }
+
+private:
+    // The AabbTree, the WideAabbTree and a brute force search of the
+    // objects must all find the same closest intersections and occlusions.
+    void compareRaySegmentQueries(const AabbTree<SolidBox>::ObjectVector &objectVector,
+        const AabbTree<SolidBox> &aabbTree, const WideAabbTree<SolidBox> &wideAabbTree) {
+        SolidBoxOcclusionListener occlusionListener;
+        SolidBoxIntersectionListener intersectionListener;
+        cgmath::AabbTreeStatistics aabbTreeStatistics;
+        cgmath::AabbTreeStatistics wideAabbTreeStatistics;
+
+        int hits = 0;
+        for (int query = 0; query < 500; ++query) {
+            Vector3f origin = Vector3f(drand48(), drand48(), drand48())*100.0;
+            Vector3f endpoint = origin
+                + (Vector3f(drand48(), drand48(), drand48()) - Vector3f(0.5, 0.5, 0.5))
+                *(query % 2 == 0 ? 20.0 : 200.0);
+            if (query % 7 == 0) {
+                endpoint[query % 3] = origin[query % 3];
+            }
+
+            // Find the closest object by brute force.
+            float expectedT = 1.0;
+            const SolidBox *expectedObject = NULL;
+            for (size_t index = 0; index < objectVector.size(); ++index) {
+                if (intersectionListener.objectIntersectsRaySegment(objectVector[index],
+                        origin, endpoint, &expectedT)) {
+                    expectedObject = &objectVector[index];
+                }
+            }
+
+            Vector3f intersectionPoint;
+            SolidBox *intersectedObject = NULL;
+            bool result = aabbTree.intersectsRaySegment(origin, endpoint,
+                &intersectionListener, &intersectionPoint, &intersectedObject,
+                &aabbTreeStatistics);
+            Vector3f wideIntersectionPoint;
+            SolidBox *wideIntersectedObject = NULL;
+            bool wideResult = wideAabbTree.intersectsRaySegment(origin, endpoint,
+                &intersectionListener, &wideIntersectionPoint, &wideIntersectedObject,
+                &wideAabbTreeStatistics);
+
+            CPPUNIT_ASSERT(result == (expectedObject != NULL));
+            CPPUNIT_ASSERT(wideResult == result);
+            if (result) {
+                ++hits;
+                // When the origin is inside several objects, they're all
+                // intersected at t=0, and any of them may be returned.
+                if (expectedT > 0.0) {
+                    CPPUNIT_ASSERT(*intersectedObject == *expectedObject);
+                    CPPUNIT_ASSERT(*wideIntersectedObject == *expectedObject);
+                }
+                CPPUNIT_ASSERT(intersectionPoint == origin*(1.0 - expectedT)
+                    + endpoint*expectedT);
+                CPPUNIT_ASSERT(wideIntersectionPoint == intersectionPoint);
+            }
+
+            bool occluded = aabbTree.occludesRaySegment(origin, endpoint,
+                &occlusionListener);
+            CPPUNIT_ASSERT(occluded == result);
+            CPPUNIT_ASSERT(wideAabbTree.occludesRaySegment(origin, endpoint,
+                    &occlusionListener) == occluded);
+        }
+        CPPUNIT_ASSERT(hits > 50);
+        CPPUNIT_ASSERT(hits < 500);
+
+        // Both trees should test far fewer objects than there are.
+        CPPUNIT_ASSERT(aabbTreeStatistics.averageObjectTestsPerQuery()
+            < objectVector.size()/10);
+        CPPUNIT_ASSERT(wideAabbTreeStatistics.averageObjectTestsPerQuery()
+            < objectVector.size()/10);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WideAabbTreeTest);
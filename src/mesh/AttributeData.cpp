@@ -3,6 +3,7 @@
 #include "AttributeData.h"
 
 #include <cstdlib>
+#include <new>
 #include <cassert>
 
 #include <cgmath/Vector2f.h>
@@ -26,7 +27,8 @@ namespace mesh {
 AttributeData::AttributeData(AttributeKey attributeKey)
     : mHandle(attributeKey.handle()),
       mType(attributeKey.type()),
-      mData(NULL)
+      mData(NULL),
+      mLocalData()
 {
     allocateData();
 }
@@ -44,9 +46,11 @@ AttributeData::~AttributeData()
 }
 
 AttributeData::AttributeData(const AttributeData &rhs)
+    : mHandle(rhs.mHandle),
+      mType(rhs.mType),
+      mData(NULL),
+      mLocalData()
 {
-    mData = NULL;
-    
     *this = rhs;
 }
 
@@ -84,6 +88,27 @@ AttributeData::operator=(const AttributeData &rhs)
     return *this;
 }
 
+size_t
+AttributeData::bytesAllocated() const
+{
+    if (mData == NULL) {
+        return 0;
+    }
+
+    switch (mType) {
+    case AttributeKey::MATRIX3F:
+        return sizeof(Matrix3f);
+    case AttributeKey::MATRIX4F:
+        return sizeof(Matrix4f);
+    case AttributeKey::STRING:
+        return sizeof(std::string) + static_cast<const std::string *>(mData)->capacity();
+    case AttributeKey::BOUNDINGBOX3F:
+        return sizeof(BoundingBox3f);
+    default:
+        return 0;
+    }
+}
+
 void
 AttributeData::copyData(const AttributeData &rhs)
 {
@@ -149,22 +174,22 @@ AttributeData::allocateData()
         abort();
         break;
     case AttributeKey::BOOL:
-        mData = static_cast<void *>(new bool);
+        mData = static_cast<void *>(new (&mLocalData) bool);
         break;
     case AttributeKey::INT:
-        mData = static_cast<void *>(new int32_t);
+        mData = static_cast<void *>(new (&mLocalData) int32_t);
         break;
     case AttributeKey::FLOAT:
-        mData = static_cast<void *>(new float);
+        mData = static_cast<void *>(new (&mLocalData) float);
         break;
     case AttributeKey::VECTOR2F:
-        mData = static_cast<void *>(new Vector2f);
+        mData = static_cast<void *>(new (&mLocalData) Vector2f);
         break;
     case AttributeKey::VECTOR3F:
-        mData = static_cast<void *>(new Vector3f);
+        mData = static_cast<void *>(new (&mLocalData) Vector3f);
         break;
     case AttributeKey::VECTOR4F:
-        mData = static_cast<void *>(new Vector4f);
+        mData = static_cast<void *>(new (&mLocalData) Vector4f);
         break;
     case AttributeKey::MATRIX3F:
         mData = static_cast<void *>(new Matrix3f);
@@ -176,10 +201,10 @@ AttributeData::allocateData()
         mData = static_cast<void *>(new std::string);
         break;
     case AttributeKey::UNIT_VECTOR3F:
-        mData = static_cast<void *>(new Vector3f);
+        mData = static_cast<void *>(new (&mLocalData) Vector3f);
         break;
     case AttributeKey::BOUNDINGBOX2F:
-        mData = static_cast<void *>(new BoundingBox2f);
+        mData = static_cast<void *>(new (&mLocalData) BoundingBox2f);
         break;
     case AttributeKey::BOUNDINGBOX3F:
         mData = static_cast<void *>(new BoundingBox3f);
@@ -202,22 +227,19 @@ AttributeData::deallocateData()
         abort();
         break;
     case AttributeKey::BOOL:
-        delete static_cast<bool *>(mData);
         break;
     case AttributeKey::INT:
-        delete static_cast<int32_t *>(mData);
         break;
     case AttributeKey::FLOAT:
-        delete static_cast<float *>(mData);
         break;
     case AttributeKey::VECTOR2F:
-        delete static_cast<Vector2f *>(mData);
+        static_cast<Vector2f *>(mData)->~Vector2f();
         break;
     case AttributeKey::VECTOR3F:
-        delete static_cast<Vector3f *>(mData);
+        static_cast<Vector3f *>(mData)->~Vector3f();
         break;
     case AttributeKey::VECTOR4F:
-        delete static_cast<Vector4f *>(mData);
+        static_cast<Vector4f *>(mData)->~Vector4f();
         break;
     case AttributeKey::MATRIX3F:
         delete static_cast<Matrix3f *>(mData);
@@ -229,10 +251,10 @@ AttributeData::deallocateData()
         delete static_cast<std::string *>(mData);
         break;
     case AttributeKey::UNIT_VECTOR3F:
-        delete static_cast<Vector3f *>(mData);
+        static_cast<Vector3f *>(mData)->~Vector3f();
         break;
     case AttributeKey::BOUNDINGBOX2F:
-        delete static_cast<BoundingBox2f *>(mData);
+        static_cast<BoundingBox2f *>(mData)->~BoundingBox2f();
         break;
     case AttributeKey::BOUNDINGBOX3F:
         delete static_cast<BoundingBox3f *>(mData);
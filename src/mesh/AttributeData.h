@@ -3,6 +3,11 @@
 #ifndef MESH__ATTRIBUTE_DATA__INCLUDED
 #define MESH__ATTRIBUTE_DATA__INCLUDED
 
+#include <cstddef>
+#include <string>
+
+#include <stdint.h>
+
 #include "AttributeKey.h"
 
 namespace mesh {
@@ -12,9 +17,12 @@ namespace mesh {
 // This class holds a pointer to an arbitrary data type. Even though
 // the data itself is pointed to separately, it should work properly
 // when used as a value, so you can stick them in STL containers.
-// 
-// If the extra memory usage ever becomes a problem, perhaps this
-// could be reimplemented in terms of boost::pool.
+//
+// Values of up to four floats (booleans, integers, floats, vectors,
+// and 2D bounding boxes) are stored within the AttributeData object
+// itself, and the pointer points there, so the attributes that are
+// set on nearly every element don't each cost a heap allocation.
+// Matrices, 3D bounding boxes, and strings are allocated separately.
 
 class AttributeData {
 public:
@@ -28,6 +36,10 @@ public:
     AttributeKey::Type type() const { return mType; }
     void *data() const { return mData; }
 
+    // The number of bytes allocated separately for the value,
+    // which is zero if it's stored within the object.
+    size_t bytesAllocated() const;
+
     // Copy only the data pointed to, not the handle or type.
     void copyData(const AttributeData &rhs);
 
@@ -43,6 +55,13 @@ private:
     AttributeKey::Handle mHandle;
     AttributeKey::Type mType;
     void *mData;
+
+    // Storage for the values that are kept within the object.
+    union {
+        bool mBool;
+        int32_t mInt;
+        float mFloatArray[4];
+    } mLocalData;
 };
 
 } // namespace mesh
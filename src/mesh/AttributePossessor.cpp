@@ -386,6 +386,12 @@ AttributePossessor::attributeDataCount() const
     return mAttributeDataVector.size();
 }
 
+int
+AttributePossessor::attributeDataCapacity() const
+{
+    return mAttributeDataVector.capacity();
+}
+
 AttributePossessor::AttributeDataVector::iterator 
 AttributePossessor::attributeDataBegin()
 {
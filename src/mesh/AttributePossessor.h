@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include "AttributeData.h"
+#include "TypedAttributeKey.h"
 
 namespace cgmath {
 class Vector2f;
@@ -88,12 +89,21 @@ public:
     void setBoundingBox2f(const AttributeKey &key, const cgmath::BoundingBox2f &value);
     void setBoundingBox3f(const AttributeKey &key, const cgmath::BoundingBox3f &value);
 
+    // Get and set an attribute through a TypedAttributeKey. The attribute
+    // is found by handle as with the functions above, but its value is
+    // copied without checking the key's type again.
+    template<typename VALUE>
+    VALUE getValue(const TypedAttributeKey<VALUE> &key) const;
+    template<typename VALUE>
+    void setValue(const TypedAttributeKey<VALUE> &key, const VALUE &value);
+
     // Functions for iterating directly over the attributes,
     // without a key.
     typedef std::vector<AttributeData> AttributeDataVector;
     typedef AttributeDataVector::iterator iterator;
     typedef AttributeDataVector::const_iterator const_iterator;
     int attributeDataCount() const;
+    int attributeDataCapacity() const;
     AttributeDataVector::iterator attributeDataBegin();
     AttributeDataVector::iterator attributeDataEnd();
     AttributeDataVector::const_iterator attributeDataBegin() const;
@@ -115,6 +125,27 @@ private:
     AttributeDataVector mAttributeDataVector;
 };
 
+template<typename VALUE>
+VALUE
+AttributePossessor::getValue(const TypedAttributeKey<VALUE> &key) const
+{
+    for (AttributeDataVector::const_iterator iterator = mAttributeDataVector.begin();
+         iterator != mAttributeDataVector.end(); ++iterator) {
+        if ((*iterator).handle() == key.handle()) {
+            return *static_cast<const VALUE *>((*iterator).data());
+        }
+    }
+
+    return AttributeValueTraits<VALUE>::defaultValue();
+}
+
+template<typename VALUE>
+void
+AttributePossessor::setValue(const TypedAttributeKey<VALUE> &key, const VALUE &value)
+{
+    *static_cast<VALUE *>(findOrCreateAttributeData(key.key())->data()) = value;
+}
+
 } // namespace mesh
 
 #endif // MESH__ATTRIBUTE_POSSESSSOR__INCLUDED
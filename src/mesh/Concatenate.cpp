@@ -28,6 +28,11 @@ Concatenate(Mesh *targetMesh, const Mesh &sourceMesh)
     // Copy the mesh attributes.
     CopyAttributesBetweenMeshes(targetMesh, sourceMesh, targetMesh, sourceMesh);
 
+    // Reserve room for the copied elements up front.
+    targetMesh->reserveVertices(targetMesh->vertexCount() + sourceMesh.vertexCount());
+    targetMesh->reserveEdges(targetMesh->edgeCount() + sourceMesh.edgeCount());
+    targetMesh->reserveFaces(targetMesh->faceCount() + sourceMesh.faceCount());
+
     // Copy all vertices.
     ConstVertexPtrToVertexPtrMap vertexMap;
     for (ConstVertexPtr sourceVertexPtr = sourceMesh.vertexBegin();
@@ -68,6 +73,8 @@ Concatenate(Mesh *targetMesh, const Mesh &sourceMesh)
          sourceVertexPtr != sourceMesh.vertexEnd(); ++sourceVertexPtr) {
 
         VertexPtr targetVertexPtr = vertexMap[sourceVertexPtr];
+        targetVertexPtr->reserveAdjacentEdges(sourceVertexPtr->adjacentEdgeCount());
+        targetVertexPtr->reserveAdjacentFaces(sourceVertexPtr->adjacentFaceCount());
 
         // Copy all adjacent edge pointers.
         for (AdjacentEdgeConstIterator iterator = sourceVertexPtr->adjacentEdgeBegin();
@@ -87,6 +94,7 @@ Concatenate(Mesh *targetMesh, const Mesh &sourceMesh)
          sourceEdgePtr != sourceMesh.edgeEnd(); ++sourceEdgePtr) {
 
         EdgePtr targetEdgePtr = edgeMap[sourceEdgePtr];
+        targetEdgePtr->reserveAdjacentFaces(sourceEdgePtr->adjacentFaceCount());
 
         // Copy all adjacent vertex pointers.
         for (AdjacentVertexConstIterator iterator = sourceEdgePtr->adjacentVertexBegin();
@@ -106,6 +114,8 @@ Concatenate(Mesh *targetMesh, const Mesh &sourceMesh)
          sourceFacePtr != sourceMesh.faceEnd(); ++sourceFacePtr) {
 
         FacePtr targetFacePtr = faceMap[sourceFacePtr];
+        targetFacePtr->reserveAdjacentVertices(sourceFacePtr->adjacentVertexCount());
+        targetFacePtr->reserveAdjacentEdges(sourceFacePtr->adjacentEdgeCount());
 
         // Copy all adjacent vertex pointers.
         for (AdjacentVertexConstIterator iterator = sourceFacePtr->adjacentVertexBegin();
@@ -87,6 +87,12 @@ Edge::addAdjacentFace(FacePtr face)
     mFacePtrVector.push_back(face);
 }
 
+void
+Edge::reserveAdjacentFaces(unsigned count)
+{
+    mFacePtrVector.reserve(count);
+}
+
 void 
 Edge::removeAdjacentFace(FacePtr face)
 {
@@ -94,14 +100,14 @@ Edge::removeAdjacentFace(FacePtr face)
     assert(hasAdjacentFace(face));
 
     // Remove the face from the edge's face list.
-    mFacePtrVector.erase(find(mFacePtrVector.begin(), mFacePtrVector.end(), face));
+    mFacePtrVector.erase(std::find(mFacePtrVector.begin(), mFacePtrVector.end(), face));
 }
 
 bool 
 Edge::hasAdjacentFace(ConstFacePtr face) const
 {
     // Return true if the face is in the edge's face list.
-    return find(mFacePtrVector.begin(), mFacePtrVector.end(), face) != mFacePtrVector.end();
+    return std::find(mFacePtrVector.begin(), mFacePtrVector.end(), face) != mFacePtrVector.end();
 }
 
 unsigned int
@@ -134,4 +140,10 @@ Edge::adjacentFaceEnd() const
     return mFacePtrVector.end();
 }
 
+size_t
+Edge::adjacencyBytesAllocated() const
+{
+    return mVertexPtrVector.bytesAllocated() + mFacePtrVector.bytesAllocated();
+}
+
 } // namespace mesh
@@ -32,6 +32,7 @@ public:
 
     // Adjacent faces.
     void addAdjacentFace(FacePtr facePtr);
+    void reserveAdjacentFaces(unsigned count);
     void removeAdjacentFace(FacePtr facePtr);
     bool hasAdjacentFace(ConstFacePtr facePtr) const;
     unsigned int adjacentFaceCount() const;
@@ -40,9 +41,13 @@ public:
     AdjacentFaceConstIterator adjacentFaceBegin() const;
     AdjacentFaceConstIterator adjacentFaceEnd() const;
 
+    // The number of bytes allocated separately from the edge
+    // for its adjacent vertices and faces.
+    size_t adjacencyBytesAllocated() const;
+
 private:
-    AdjacentVertexVector mVertexPtrVector;
-    AdjacentFaceVector mFacePtrVector;
+    EdgeAdjacentVertexVector mVertexPtrVector;
+    EdgeAdjacentFaceVector mFacePtrVector;
 };
 
 } // namespace mesh
@@ -0,0 +1,573 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__ELEMENT_LIST__INCLUDED
+#define MESH__ELEMENT_LIST__INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <vector>
+
+#include <boost/type_traits/has_trivial_destructor.hpp>
+
+namespace mesh {
+
+// ElementHandle
+//
+// Identifies an element of an ElementList by its index and the generation
+// of the slot it occupies. Unlike an iterator, a handle can be tested
+// to determine whether its element still exists, because the generation
+// of a slot changes whenever an element is created or destroyed in it.
+
+template<typename T>
+class ElementHandle
+{
+public:
+    ElementHandle();
+    ElementHandle(unsigned index, unsigned generation);
+
+    unsigned index() const;
+    unsigned generation() const;
+
+    bool operator==(const ElementHandle &rhs) const;
+    bool operator!=(const ElementHandle &rhs) const;
+
+private:
+    unsigned mIndex;
+    unsigned mGeneration;
+};
+
+// ElementList
+//
+// The container used by Mesh to store its vertices, edges, and faces.
+// It behaves like the subset of std::list that Mesh relies on:
+// elements are iterated over in the order they were created,
+// and iterators remain valid until their elements are destroyed.
+//
+// Unlike std::list, which allocates each node separately, the nodes
+// are stored contiguously in blocks that are never moved,
+// and the slots of destroyed elements are reused by new elements.
+// Each slot has an index, so that arrays indexed by element may be
+// kept alongside the list, and a generation counter, so that
+// ElementHandles to destroyed elements can be detected.
+//
+// The first block is small, and successive blocks double in size
+// up to a limit, so that small meshes don't waste memory.
+
+template<typename T>
+class ElementList
+{
+private:
+    // The links between nodes. The list's sentinel is a Link
+    // without an element.
+    struct Link {
+        Link *mPrev;
+        Link *mNext;
+    };
+
+    struct Node : public Link {
+        Node(unsigned index) : Link(), mIndex(index), mValue() {}
+        unsigned mIndex;
+        T mValue;
+    };
+
+public:
+    typedef size_t size_type;
+
+    class const_iterator;
+
+    class iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        iterator() : mLink(NULL) {}
+
+        T &operator*() const { return static_cast<Node *>(mLink)->mValue; }
+        T *operator->() const { return &static_cast<Node *>(mLink)->mValue; }
+
+        iterator &operator++() { mLink = mLink->mNext; return *this; }
+        iterator operator++(int) { iterator result(*this); mLink = mLink->mNext; return result; }
+        iterator &operator--() { mLink = mLink->mPrev; return *this; }
+        iterator operator--(int) { iterator result(*this); mLink = mLink->mPrev; return result; }
+
+        friend bool operator==(const iterator &lhs, const iterator &rhs) {
+            return lhs.mLink == rhs.mLink;
+        }
+        friend bool operator!=(const iterator &lhs, const iterator &rhs) {
+            return lhs.mLink != rhs.mLink;
+        }
+
+    private:
+        friend class ElementList;
+        friend class const_iterator;
+
+        explicit iterator(Link *link) : mLink(link) {}
+
+        Link *mLink;
+    };
+
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        const_iterator() : mLink(NULL) {}
+        const_iterator(const iterator &rhs) : mLink(rhs.mLink) {}
+
+        const T &operator*() const { return static_cast<const Node *>(mLink)->mValue; }
+        const T *operator->() const { return &static_cast<const Node *>(mLink)->mValue; }
+
+        const_iterator &operator++() { mLink = mLink->mNext; return *this; }
+        const_iterator operator++(int) {
+            const_iterator result(*this); mLink = mLink->mNext; return result;
+        }
+        const_iterator &operator--() { mLink = mLink->mPrev; return *this; }
+        const_iterator operator--(int) {
+            const_iterator result(*this); mLink = mLink->mPrev; return result;
+        }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) {
+            return lhs.mLink == rhs.mLink;
+        }
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) {
+            return lhs.mLink != rhs.mLink;
+        }
+
+    private:
+        friend class ElementList;
+
+        explicit const_iterator(const Link *link) : mLink(link) {}
+
+        const Link *mLink;
+    };
+
+    ElementList();
+    ~ElementList();
+
+    // Create a default-constructed element at the end of the list.
+    iterator create();
+
+    // Destroy an element. Iterators to other elements are unaffected.
+    void erase(iterator position);
+
+    // Destroy all of the elements and free the blocks.
+    void clear();
+
+    // Allocate blocks so that the specified number of elements
+    // can exist at once without allocating more blocks.
+    void reserve(size_type count);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    size_type size() const;
+    bool empty() const;
+
+    // Efficiently swap the contents of two lists.
+    void swap(ElementList &rhs);
+
+    // The index of an element's slot. The index doesn't change while
+    // the element exists, and is less than indexLimit().
+    unsigned index(const_iterator position) const;
+
+    // One more than the largest index of any slot.
+    unsigned indexLimit() const;
+
+    // A handle to an element.
+    ElementHandle<T> handle(const_iterator position) const;
+
+    // Returns the element that a handle refers to, or end()
+    // if the element has since been destroyed.
+    iterator find(const ElementHandle<T> &handle);
+    const_iterator find(const ElementHandle<T> &handle) const;
+
+    // The number of bytes occupied by the blocks and the slot bookkeeping,
+    // not counting memory that the elements allocate themselves.
+    size_t bytesUsed() const;
+
+private:
+    // Disallow copying.
+    ElementList(const ElementList &);
+    ElementList &operator=(const ElementList &);
+
+    // The first DOUBLING_BLOCK_COUNT blocks double in size starting
+    // from FIRST_BLOCK_SIZE, and hold DOUBLING_SLOT_COUNT slots in all.
+    // The remaining blocks have MAXIMUM_BLOCK_SIZE slots.
+    enum {
+        FIRST_BLOCK_SIZE = 16,
+        DOUBLING_BLOCK_COUNT = 8,
+        DOUBLING_SLOT_COUNT = FIRST_BLOCK_SIZE*((1 << DOUBLING_BLOCK_COUNT) - 1),
+        MAXIMUM_BLOCK_SIZE = FIRST_BLOCK_SIZE << DOUBLING_BLOCK_COUNT
+    };
+
+    // The size of a block.
+    static unsigned blockSize(unsigned block);
+
+    // Allocate the next block.
+    void addBlock();
+
+    // The slot with the specified index, whose element may not exist.
+    Node *slot(unsigned index) const;
+
+    // Make the neighbors of the sentinel point back to it, after the
+    // sentinel has been copied from another list.
+    void repairSentinel(const Link &otherSentinel);
+
+    Link mSentinel;
+    size_type mSize;
+
+    // Blocks of raw memory, each with blockSize(index) nodes.
+    std::vector<Node *> mBlockVector;
+
+    // The number of slots that have ever been occupied,
+    // and the number of slots in all of the blocks.
+    unsigned mSlotCount;
+    unsigned mSlotCapacity;
+
+    // The generation of each slot, which is odd if the slot holds an element.
+    std::vector<unsigned> mGenerationVector;
+
+    // Indices of slots whose elements have been destroyed.
+    std::vector<unsigned> mFreeIndexVector;
+};
+
+template<typename T>
+ElementHandle<T>::ElementHandle()
+    : mIndex(0),
+      mGeneration(0)
+{
+}
+
+template<typename T>
+ElementHandle<T>::ElementHandle(unsigned index, unsigned generation)
+    : mIndex(index),
+      mGeneration(generation)
+{
+}
+
+template<typename T>
+unsigned
+ElementHandle<T>::index() const
+{
+    return mIndex;
+}
+
+template<typename T>
+unsigned
+ElementHandle<T>::generation() const
+{
+    return mGeneration;
+}
+
+template<typename T>
+bool
+ElementHandle<T>::operator==(const ElementHandle &rhs) const
+{
+    return mIndex == rhs.mIndex && mGeneration == rhs.mGeneration;
+}
+
+template<typename T>
+bool
+ElementHandle<T>::operator!=(const ElementHandle &rhs) const
+{
+    return !(*this == rhs);
+}
+
+template<typename T>
+ElementList<T>::ElementList()
+    : mSentinel(),
+      mSize(0),
+      mBlockVector(),
+      mSlotCount(0),
+      mSlotCapacity(0),
+      mGenerationVector(),
+      mFreeIndexVector()
+{
+    mSentinel.mPrev = &mSentinel;
+    mSentinel.mNext = &mSentinel;
+}
+
+template<typename T>
+ElementList<T>::~ElementList()
+{
+    clear();
+}
+
+template<typename T>
+typename ElementList<T>::iterator
+ElementList<T>::create()
+{
+    unsigned index;
+    if (!mFreeIndexVector.empty()) {
+        index = mFreeIndexVector.back();
+        mFreeIndexVector.pop_back();
+    } else {
+        index = mSlotCount;
+        if (index == mSlotCapacity) {
+            addBlock();
+        }
+        ++mSlotCount;
+        mGenerationVector.push_back(0);
+    }
+
+    Node *node = new (slot(index)) Node(index);
+    assert(mGenerationVector[index] % 2 == 0);
+    ++mGenerationVector[index];
+
+    node->mPrev = mSentinel.mPrev;
+    node->mNext = &mSentinel;
+    mSentinel.mPrev->mNext = node;
+    mSentinel.mPrev = node;
+    ++mSize;
+
+    return iterator(node);
+}
+
+template<typename T>
+void
+ElementList<T>::erase(iterator position)
+{
+    assert(position.mLink != &mSentinel);
+    Node *node = static_cast<Node *>(position.mLink);
+
+    node->mPrev->mNext = node->mNext;
+    node->mNext->mPrev = node->mPrev;
+    --mSize;
+
+    unsigned index = node->mIndex;
+    assert(mGenerationVector[index] % 2 == 1);
+    ++mGenerationVector[index];
+    mFreeIndexVector.push_back(index);
+
+    node->~Node();
+}
+
+template<typename T>
+void
+ElementList<T>::clear()
+{
+    // Elements with trivial destructors need no teardown, so their blocks
+    // are simply freed. Otherwise, the elements are destroyed in slot order,
+    // one block at a time, rather than by following the links between nodes,
+    // which may lead anywhere in the blocks once slots have been reused.
+    if (!boost::has_trivial_destructor<T>::value) {
+        unsigned index = 0;
+        for (size_t block = 0; block < mBlockVector.size() && index < mSlotCount; ++block) {
+            Node *node = mBlockVector[block];
+            Node *nodeEnd = node + std::min(blockSize(block), mSlotCount - index);
+            for (; node != nodeEnd; ++node, ++index) {
+                if (mGenerationVector[index] % 2 == 1) {
+                    node->~Node();
+                }
+            }
+        }
+    }
+
+    for (size_t index = 0; index < mBlockVector.size(); ++index) {
+        ::operator delete(mBlockVector[index]);
+    }
+
+    mSentinel.mPrev = &mSentinel;
+    mSentinel.mNext = &mSentinel;
+    mSize = 0;
+    std::vector<Node *>().swap(mBlockVector);
+    mSlotCount = 0;
+    mSlotCapacity = 0;
+    std::vector<unsigned>().swap(mGenerationVector);
+    std::vector<unsigned>().swap(mFreeIndexVector);
+}
+
+template<typename T>
+void
+ElementList<T>::reserve(size_type count)
+{
+    while (mSlotCapacity < count) {
+        addBlock();
+    }
+    mGenerationVector.reserve(count);
+}
+
+template<typename T>
+typename ElementList<T>::iterator
+ElementList<T>::begin()
+{
+    return iterator(mSentinel.mNext);
+}
+
+template<typename T>
+typename ElementList<T>::iterator
+ElementList<T>::end()
+{
+    return iterator(&mSentinel);
+}
+
+template<typename T>
+typename ElementList<T>::const_iterator
+ElementList<T>::begin() const
+{
+    return const_iterator(mSentinel.mNext);
+}
+
+template<typename T>
+typename ElementList<T>::const_iterator
+ElementList<T>::end() const
+{
+    return const_iterator(&mSentinel);
+}
+
+template<typename T>
+typename ElementList<T>::size_type
+ElementList<T>::size() const
+{
+    return mSize;
+}
+
+template<typename T>
+bool
+ElementList<T>::empty() const
+{
+    return mSize == 0;
+}
+
+template<typename T>
+void
+ElementList<T>::swap(ElementList &rhs)
+{
+    std::swap(mSentinel, rhs.mSentinel);
+    repairSentinel(rhs.mSentinel);
+    rhs.repairSentinel(mSentinel);
+
+    std::swap(mSize, rhs.mSize);
+    mBlockVector.swap(rhs.mBlockVector);
+    std::swap(mSlotCount, rhs.mSlotCount);
+    std::swap(mSlotCapacity, rhs.mSlotCapacity);
+    mGenerationVector.swap(rhs.mGenerationVector);
+    mFreeIndexVector.swap(rhs.mFreeIndexVector);
+}
+
+template<typename T>
+unsigned
+ElementList<T>::index(const_iterator position) const
+{
+    assert(position.mLink != &mSentinel);
+
+    return static_cast<const Node *>(position.mLink)->mIndex;
+}
+
+template<typename T>
+unsigned
+ElementList<T>::indexLimit() const
+{
+    return mSlotCount;
+}
+
+template<typename T>
+ElementHandle<T>
+ElementList<T>::handle(const_iterator position) const
+{
+    unsigned slotIndex = index(position);
+
+    return ElementHandle<T>(slotIndex, mGenerationVector[slotIndex]);
+}
+
+template<typename T>
+typename ElementList<T>::iterator
+ElementList<T>::find(const ElementHandle<T> &handle)
+{
+    if (handle.index() >= mSlotCount
+        || handle.generation() % 2 == 0
+        || mGenerationVector[handle.index()] != handle.generation()) {
+        return end();
+    }
+
+    return iterator(slot(handle.index()));
+}
+
+template<typename T>
+typename ElementList<T>::const_iterator
+ElementList<T>::find(const ElementHandle<T> &handle) const
+{
+    return const_cast<ElementList *>(this)->find(handle);
+}
+
+template<typename T>
+size_t
+ElementList<T>::bytesUsed() const
+{
+    return mSlotCapacity*sizeof(Node)
+        + mBlockVector.capacity()*sizeof(Node *)
+        + mGenerationVector.capacity()*sizeof(unsigned)
+        + mFreeIndexVector.capacity()*sizeof(unsigned);
+}
+
+template<typename T>
+unsigned
+ElementList<T>::blockSize(unsigned block)
+{
+    if (block >= DOUBLING_BLOCK_COUNT) {
+        return MAXIMUM_BLOCK_SIZE;
+    }
+
+    return FIRST_BLOCK_SIZE << block;
+}
+
+template<typename T>
+void
+ElementList<T>::addBlock()
+{
+    unsigned size = blockSize(mBlockVector.size());
+    mBlockVector.push_back(static_cast<Node *>(::operator new(size*sizeof(Node))));
+    mSlotCapacity += size;
+}
+
+template<typename T>
+typename ElementList<T>::Node *
+ElementList<T>::slot(unsigned index) const
+{
+    assert(index < mSlotCount);
+
+    if (index >= DOUBLING_SLOT_COUNT) {
+        unsigned offset = index - DOUBLING_SLOT_COUNT;
+        return mBlockVector[DOUBLING_BLOCK_COUNT + offset/MAXIMUM_BLOCK_SIZE]
+            + offset % MAXIMUM_BLOCK_SIZE;
+    }
+
+    // Block n begins at index FIRST_BLOCK_SIZE*(2^n - 1).
+    unsigned block = 0;
+    while (index >= FIRST_BLOCK_SIZE*((2u << block) - 1)) {
+        ++block;
+    }
+
+    return mBlockVector[block] + (index - FIRST_BLOCK_SIZE*((1u << block) - 1));
+}
+
+template<typename T>
+void
+ElementList<T>::repairSentinel(const Link &otherSentinel)
+{
+    if (mSentinel.mNext == &otherSentinel) {
+        // The list is empty.
+        mSentinel.mPrev = &mSentinel;
+        mSentinel.mNext = &mSentinel;
+    } else {
+        mSentinel.mNext->mPrev = &mSentinel;
+        mSentinel.mPrev->mNext = &mSentinel;
+    }
+}
+
+} // namespace mesh
+
+#endif // MESH__ELEMENT_LIST__INCLUDED
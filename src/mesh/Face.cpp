@@ -7,6 +7,9 @@
 
 namespace mesh {
 
+// The attributes of corners without a FaceVertex.
+static const FaceVertex EMPTY_FACE_VERTEX;
+
 Face::Face()
     : AttributePossessor(),
       mVertexPtrVector(),
@@ -33,6 +36,7 @@ Face::addAdjacentVertex(VertexPtr vertexPtr)
 
     // Add the vertex to the face's vertex vector.
     mVertexPtrVector.push_back(vertexPtr);
+    insertCorner(mVertexPtrVector.size() - 1, vertexPtr);
 }
 
 void
@@ -43,6 +47,7 @@ Face::prependAdjacentVertex(VertexPtr vertexPtr)
 
     // Add the vertex to the face's vertex vector.
     mVertexPtrVector.insert(mVertexPtrVector.begin(), vertexPtr);
+    insertCorner(0, vertexPtr);
 }
 
 void 
@@ -51,13 +56,21 @@ Face::insertAdjacentVertex(VertexPtr vertexPtr, VertexPtr beforeVertexPtr)
     // The face must not already have this vertex.
     assert(!hasAdjacentVertex(vertexPtr));
 
-    AdjacentVertexVector::iterator iterator 
+    AdjacentVertexIterator iterator 
         = std::find(mVertexPtrVector.begin(), mVertexPtrVector.end(), beforeVertexPtr);
 
     assert(iterator != mVertexPtrVector.end());
     
     // Add the vertex to the face's vertex vector.
-    mVertexPtrVector.insert(iterator, vertexPtr);
+    iterator = mVertexPtrVector.insert(iterator, vertexPtr);
+    insertCorner(iterator - mVertexPtrVector.begin(), vertexPtr);
+}
+
+void
+Face::reserveAdjacentVertices(unsigned count)
+{
+    mVertexPtrVector.reserve(count);
+    mFaceVertexVector.reserve(count);
 }
 
 void 
@@ -66,12 +79,14 @@ Face::removeAdjacentVertex(VertexPtr vertexPtr)
     // The face must already have this vertex.
     assert(hasAdjacentVertex(vertexPtr));
 
-    // Remove the vertex from the face's vertex vector.
-    mVertexPtrVector.erase(std::find(mVertexPtrVector.begin(), 
-            mVertexPtrVector.end(), vertexPtr));
+    // Remove the FaceVertex corresponding to this VertexPtr,
+    // along with its corner.
+    unsigned corner = findCorner(vertexPtr);
+    delete mFaceVertexVector[corner];
+    mFaceVertexVector.erase(mFaceVertexVector.begin() + corner);
 
-    // Remove the FaceVertex corresponding to this VertexPtr.
-    eraseFaceVertex(vertexPtr);
+    // Remove the vertex from the face's vertex vector.
+    mVertexPtrVector.erase(mVertexPtrVector.begin() + corner);
 }
 
 bool 
@@ -152,13 +167,19 @@ Face::insertAdjacentEdge(EdgePtr edgePtr, EdgePtr beforeEdgePtr)
     // The face must not already have this edge.
     assert(!hasAdjacentEdge(edgePtr));
 
-    AdjacentEdgeVector::iterator iterator 
+    AdjacentEdgeIterator iterator 
         = std::find(mEdgePtrVector.begin(), mEdgePtrVector.end(), beforeEdgePtr);
 
     // Add the edge to the face's edge vector.
     mEdgePtrVector.insert(iterator, edgePtr);
 }
 
+void
+Face::reserveAdjacentEdges(unsigned count)
+{
+    mEdgePtrVector.reserve(count);
+}
+
 void 
 Face::removeAdjacentEdge(EdgePtr edge)
 {
@@ -166,14 +187,14 @@ Face::removeAdjacentEdge(EdgePtr edge)
     assert(hasAdjacentEdge(edge));
 
     // Remove the edge from the face's edge list.
-    mEdgePtrVector.erase(find(mEdgePtrVector.begin(), mEdgePtrVector.end(), edge));
+    mEdgePtrVector.erase(std::find(mEdgePtrVector.begin(), mEdgePtrVector.end(), edge));
 }
 
 bool 
 Face::hasAdjacentEdge(ConstEdgePtr edge) const
 {
     // Return true if the edge is in the face's edge list.
-    return find(mEdgePtrVector.begin(), mEdgePtrVector.end(), edge) != mEdgePtrVector.end();
+    return std::find(mEdgePtrVector.begin(), mEdgePtrVector.end(), edge) != mEdgePtrVector.end();
 }
 
 unsigned int
@@ -206,6 +227,12 @@ Face::adjacentEdgeEnd() const
     return mEdgePtrVector.end();
 }
 
+size_t
+Face::adjacencyBytesAllocated() const
+{
+    return mVertexPtrVector.bytesAllocated() + mEdgePtrVector.bytesAllocated();
+}
+
 bool 
 Face::hasVertexAttribute(ConstVertexPtr vertexPtr, AttributeKey key) const
 {
@@ -444,6 +471,131 @@ Face::setVertexBoundingBox3f(ConstVertexPtr vertexPtr,
     getFaceVertex(vertexPtr)->setBoundingBox3f(key, value);
 }
 
+unsigned
+Face::findCorner(ConstVertexPtr vertexPtr) const
+{
+    unsigned corner = 0;
+    while (corner < mVertexPtrVector.size() && mVertexPtrVector[corner] != vertexPtr) {
+        ++corner;
+    }
+
+    return corner;
+}
+
+VertexPtr
+Face::cornerVertexPtr(unsigned corner) const
+{
+    return mVertexPtrVector[corner];
+}
+
+const AttributePossessor &
+Face::cornerAttributes(unsigned corner) const
+{
+    const FaceVertex *faceVertex = findCornerFaceVertex(corner);
+    if (faceVertex == NULL) {
+        return EMPTY_FACE_VERTEX;
+    }
+
+    return *faceVertex;
+}
+
+FaceVertex *
+Face::findCornerFaceVertex(unsigned corner)
+{
+    assert(corner < mVertexPtrVector.size());
+
+    return mFaceVertexVector[corner];
+}
+
+const FaceVertex *
+Face::findCornerFaceVertex(unsigned corner) const
+{
+    assert(corner < mVertexPtrVector.size());
+
+    return mFaceVertexVector[corner];
+}
+
+FaceVertex *
+Face::getCornerFaceVertex(unsigned corner)
+{
+    assert(corner < mVertexPtrVector.size());
+
+    FaceVertex *&faceVertex = mFaceVertexVector[corner];
+    if (faceVertex == NULL) {
+        faceVertex = new FaceVertex(mVertexPtrVector[corner]);
+    }
+
+    return faceVertex;
+}
+
+Face::CornerConstIterator::CornerConstIterator()
+    : mFace(NULL),
+      mCorner(0)
+{
+}
+
+Face::CornerConstIterator::CornerConstIterator(const Face *face, unsigned corner)
+    : mFace(face),
+      mCorner(corner)
+{
+}
+
+unsigned
+Face::CornerConstIterator::corner() const
+{
+    return mCorner;
+}
+
+VertexPtr
+Face::CornerConstIterator::vertexPtr() const
+{
+    return mFace->cornerVertexPtr(mCorner);
+}
+
+const AttributePossessor &
+Face::CornerConstIterator::attributes() const
+{
+    return mFace->cornerAttributes(mCorner);
+}
+
+const FaceVertex *
+Face::CornerConstIterator::faceVertex() const
+{
+    return mFace->findCornerFaceVertex(mCorner);
+}
+
+Face::CornerConstIterator &
+Face::CornerConstIterator::operator++()
+{
+    ++mCorner;
+
+    return *this;
+}
+
+bool
+Face::CornerConstIterator::operator==(const CornerConstIterator &rhs) const
+{
+    return mFace == rhs.mFace && mCorner == rhs.mCorner;
+}
+
+bool
+Face::CornerConstIterator::operator!=(const CornerConstIterator &rhs) const
+{
+    return !(*this == rhs);
+}
+
+Face::CornerConstIterator
+Face::cornerBegin() const
+{
+    return CornerConstIterator(this, 0);
+}
+
+Face::CornerConstIterator
+Face::cornerEnd() const
+{
+    return CornerConstIterator(this, mVertexPtrVector.size());
+}
+
 Face::FaceVertexVector::size_type 
 Face::faceVertexVectorSize() const
 {
@@ -462,45 +614,60 @@ Face::faceVertexVectorEnd() const
     return mFaceVertexVector.end();
 }
 
-FaceVertex *
-Face::getFaceVertex(ConstVertexPtr vertexPtr)
+size_t
+Face::faceVertexBytesAllocated() const
 {
-    for (FaceVertexVector::iterator iterator = mFaceVertexVector.begin();
+    size_t bytes = mFaceVertexVector.bytesAllocated();
+    for (FaceVertexVectorConstIterator iterator = mFaceVertexVector.begin();
          iterator != mFaceVertexVector.end(); ++iterator) {
-        if ((*iterator)->vertexPtr() == vertexPtr) {
-            return *iterator;
+        if (*iterator != NULL) {
+            bytes += sizeof(FaceVertex);
         }
     }
 
+    return bytes;
+}
+
+FaceVertex *
+Face::getFaceVertex(ConstVertexPtr vertexPtr)
+{
+    unsigned corner = findCorner(vertexPtr);
+    if (corner < mVertexPtrVector.size()) {
+        return getCornerFaceVertex(corner);
+    }
+
+    unsigned index = findNonadjacentFaceVertex(vertexPtr);
+    if (index < mFaceVertexVector.size()) {
+        return mFaceVertexVector[index];
+    }
+
     // A FaceVertex corresponding to the VertexPtr could not
     // be found, so add it to the FaceVertexVector and return   
-    // a pointer to it.
+    // a pointer to it. It will be moved to the vertex's corner
+    // if the vertex is later made adjacent to the face.
     mFaceVertexVector.push_back(new FaceVertex(vertexPtr));
 
-    return mFaceVertexVector.back();
+    return mFaceVertexVector[mFaceVertexVector.size() - 1];
 }
 
 FaceVertex *
 Face::findFaceVertex(ConstVertexPtr vertexPtr)
 {
-    for (FaceVertexVector::iterator iterator = mFaceVertexVector.begin();
-         iterator != mFaceVertexVector.end(); ++iterator) {
-        if ((*iterator)->vertexPtr() == vertexPtr) {
-            return *iterator;
-        }
-    }
-
-    return NULL;
+    return const_cast<FaceVertex *>(
+        static_cast<const Face *>(this)->findFaceVertex(vertexPtr));
 }
 
 const FaceVertex *
 Face::findFaceVertex(ConstVertexPtr vertexPtr) const
 {
-    for (FaceVertexVector::const_iterator iterator = mFaceVertexVector.begin();
-         iterator != mFaceVertexVector.end(); ++iterator) {
-        if ((*iterator)->vertexPtr() == vertexPtr) {
-            return *iterator;
-        }
+    unsigned corner = findCorner(vertexPtr);
+    if (corner < mVertexPtrVector.size()) {
+        return mFaceVertexVector[corner];
+    }
+
+    unsigned index = findNonadjacentFaceVertex(vertexPtr);
+    if (index < mFaceVertexVector.size()) {
+        return mFaceVertexVector[index];
     }
 
     return NULL;
@@ -515,14 +682,50 @@ Face::hasFaceVertex(ConstVertexPtr vertexPtr) const
 void 
 Face::eraseFaceVertex(ConstVertexPtr vertexPtr)
 {
-    for (FaceVertexVector::iterator iterator = mFaceVertexVector.begin();
-         iterator != mFaceVertexVector.end(); ++iterator) {
-        if ((*iterator)->vertexPtr() == vertexPtr) {
-            delete *iterator;
-            mFaceVertexVector.erase(iterator);
-            return;
+    unsigned corner = findCorner(vertexPtr);
+    if (corner < mVertexPtrVector.size()) {
+        delete mFaceVertexVector[corner];
+        mFaceVertexVector[corner] = NULL;
+        return;
+    }
+
+    unsigned index = findNonadjacentFaceVertex(vertexPtr);
+    if (index < mFaceVertexVector.size()) {
+        delete mFaceVertexVector[index];
+        mFaceVertexVector.erase(mFaceVertexVector.begin() + index);
+    }
+}
+
+void
+Face::insertCorner(unsigned corner, ConstVertexPtr vertexPtr)
+{
+    // The vertex has already been inserted into mVertexPtrVector,
+    // so the FaceVertex objects of nonadjacent vertices start
+    // one element later than they will once the corner is inserted.
+    FaceVertex *faceVertex = NULL;
+    for (unsigned index = mVertexPtrVector.size() - 1; 
+         index < mFaceVertexVector.size(); ++index) {
+        if (mFaceVertexVector[index]->vertexPtr() == vertexPtr) {
+            faceVertex = mFaceVertexVector[index];
+            mFaceVertexVector.erase(mFaceVertexVector.begin() + index);
+            break;
         }
     }
+
+    mFaceVertexVector.insert(mFaceVertexVector.begin() + corner, faceVertex);
+}
+
+unsigned
+Face::findNonadjacentFaceVertex(ConstVertexPtr vertexPtr) const
+{
+    for (unsigned index = mVertexPtrVector.size(); 
+         index < mFaceVertexVector.size(); ++index) {
+        if (mFaceVertexVector[index]->vertexPtr() == vertexPtr) {
+            return index;
+        }
+    }
+
+    return mFaceVertexVector.size();
 }
 
 } // namespace mesh
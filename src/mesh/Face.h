@@ -25,6 +25,7 @@ public:
     void addAdjacentVertex(VertexPtr vertexPtr);
     void prependAdjacentVertex(VertexPtr vertexPtr);
     void insertAdjacentVertex(VertexPtr vertexPtr, VertexPtr beforeVertexPtr);
+    void reserveAdjacentVertices(unsigned count);
     void removeAdjacentVertex(VertexPtr vertexPtr);
     bool hasAdjacentVertex(ConstVertexPtr vertexPtr) const;
     unsigned int adjacentVertexCount() const;
@@ -40,6 +41,7 @@ public:
     // Adjacent edges.
     void addAdjacentEdge(EdgePtr edgePtr);
     void insertAdjacentEdge(EdgePtr edgePtr, EdgePtr beforeEdgePtr);
+    void reserveAdjacentEdges(unsigned count);
     void removeAdjacentEdge(EdgePtr edgePtr);
     bool hasAdjacentEdge(ConstEdgePtr edgePtr) const;
     unsigned int adjacentEdgeCount() const;
@@ -48,6 +50,10 @@ public:
     AdjacentEdgeConstIterator adjacentEdgeBegin() const;
     AdjacentEdgeConstIterator adjacentEdgeEnd() const;
 
+    // The number of bytes allocated separately from the face
+    // for its adjacent vertices and edges.
+    size_t adjacencyBytesAllocated() const;
+
     // The following functions provide for per-vertex attributes for
     // the Face, in addition to the attribute functionality inherited
     // from the AttributePossessor class, which apply to the Face
@@ -103,19 +109,85 @@ public:
     void setVertexBoundingBox3f(ConstVertexPtr vertexPtr, 
         AttributeKey key, const cgmath::BoundingBox3f &value);
 
+    // Get and set a face vertex attribute through a TypedAttributeKey.
+    template<typename VALUE>
+    VALUE getVertexValue(ConstVertexPtr vertexPtr, const TypedAttributeKey<VALUE> &key) const;
+    template<typename VALUE>
+    void setVertexValue(ConstVertexPtr vertexPtr, const TypedAttributeKey<VALUE> &key,
+        const VALUE &value);
+
+    // Corners. Each vertex adjacent to the face is a corner of the face,
+    // and the corners are numbered in the order that the vertices are
+    // adjacent to the face. The face vertex attributes of a corner are
+    // found in constant time, without searching the face vertices.
+
+    // Returns the corner of the specified vertex, or adjacentVertexCount()
+    // if the vertex isn't adjacent to the face.
+    unsigned findCorner(ConstVertexPtr vertexPtr) const;
+
+    // Returns the vertex of a corner.
+    VertexPtr cornerVertexPtr(unsigned corner) const;
+
+    // Returns the face vertex attributes of a corner. If the corner
+    // has no face vertex attributes, an AttributePossessor with no
+    // attributes is returned, so its get* functions return default values.
+    const AttributePossessor &cornerAttributes(unsigned corner) const;
+
+    // Returns the FaceVertex of a corner, or NULL if none exists.
+    FaceVertex *findCornerFaceVertex(unsigned corner);
+    const FaceVertex *findCornerFaceVertex(unsigned corner) const;
+
+    // Returns the FaceVertex of a corner, creating it if it doesn't
+    // already exist.
+    FaceVertex *getCornerFaceVertex(unsigned corner);
+
+    // Iterates over the corners of a face, yielding each adjacent
+    // vertex together with its face vertex attributes.
+    class CornerConstIterator
+    {
+    public:
+        CornerConstIterator();
+        CornerConstIterator(const Face *face, unsigned corner);
+
+        unsigned corner() const;
+        VertexPtr vertexPtr() const;
+        const AttributePossessor &attributes() const;
+
+        // Returns NULL if the corner has no face vertex attributes.
+        const FaceVertex *faceVertex() const;
+
+        CornerConstIterator &operator++();
+
+        bool operator==(const CornerConstIterator &rhs) const;
+        bool operator!=(const CornerConstIterator &rhs) const;
+
+    private:
+        const Face *mFace;
+        unsigned mCorner;
+    };
+    CornerConstIterator cornerBegin() const;
+    CornerConstIterator cornerEnd() const;
+
     // The vector of FaceVertex objects used to hold
     // vertex-specific attributes for the Face.
     // These functions should not normally be called
     // by user code. The setVertex* functions above should be
     // used instead.
-    // The FaceVertex objects traversed by these iterators do not necessarily have the same
-    // ordering as the vertices adjacent to the face.
-    typedef std::vector<FaceVertex *> FaceVertexVector;
+    // The first adjacentVertexCount() elements correspond to the
+    // corners of the face, and are NULL for corners without face vertex
+    // attributes. Any further elements are FaceVertex objects
+    // for vertices that aren't adjacent to the face.
+    typedef SmallVector<FaceVertex *, 3> FaceVertexVector;
     typedef FaceVertexVector::const_iterator FaceVertexVectorConstIterator;
     FaceVertexVector::size_type faceVertexVectorSize() const;
     FaceVertexVectorConstIterator faceVertexVectorBegin() const;
     FaceVertexVectorConstIterator faceVertexVectorEnd() const;
 
+    // The number of bytes allocated separately from the face for its
+    // FaceVertex objects and the vector that holds them, not counting
+    // the memory allocated by the FaceVertex objects for their attributes.
+    size_t faceVertexBytesAllocated() const;
+
     // Return a pointer to the FaceVertex corresponding to the
     // specified VertexPtr, or create one if it does not
     // already exist.
@@ -138,12 +210,41 @@ private:
     // specified VertexPtr.
     void eraseFaceVertex(ConstVertexPtr vertexPtr);
 
-    AdjacentVertexVector mVertexPtrVector;
-    AdjacentEdgeVector mEdgePtrVector;
+    // Inserts a corner without a FaceVertex for a newly adjacent vertex.
+    // If the vertex already has a FaceVertex, it's moved to the corner.
+    void insertCorner(unsigned corner, ConstVertexPtr vertexPtr);
+
+    // Returns the index in mFaceVertexVector of the FaceVertex
+    // of a vertex that isn't adjacent to the face, or
+    // mFaceVertexVector.size() if none exists.
+    unsigned findNonadjacentFaceVertex(ConstVertexPtr vertexPtr) const;
+
+    FaceAdjacentVertexVector mVertexPtrVector;
+    FaceAdjacentEdgeVector mEdgePtrVector;
 
     FaceVertexVector mFaceVertexVector;
 };
 
+template<typename VALUE>
+VALUE
+Face::getVertexValue(ConstVertexPtr vertexPtr, const TypedAttributeKey<VALUE> &key) const
+{
+    const FaceVertex *faceVertex = findFaceVertex(vertexPtr);
+    if (faceVertex == NULL) {
+        return AttributeValueTraits<VALUE>::defaultValue();
+    }
+
+    return faceVertex->getValue(key);
+}
+
+template<typename VALUE>
+void
+Face::setVertexValue(ConstVertexPtr vertexPtr, const TypedAttributeKey<VALUE> &key,
+    const VALUE &value)
+{
+    getFaceVertex(vertexPtr)->setValue(key, value);
+}
+
 } // namespace mesh
 
 #endif // MESH__FACE__INCLUDED
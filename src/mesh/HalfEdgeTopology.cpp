@@ -0,0 +1,443 @@
+// Copyright 2010 Drew Olbrich
+
+#include "HalfEdgeTopology.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "Mesh.h"
+#include "Vertex.h"
+#include "Edge.h"
+#include "Face.h"
+
+namespace mesh {
+
+HalfEdgeTopology::HalfEdgeTopology()
+    : mMesh(NULL),
+      mFaceBeginVector(),
+      mFaceEndVector(),
+      mFacePtrVector(),
+      mOriginVertexPtrVector(),
+      mEdgePtrVector(),
+      mNextVector(),
+      mPreviousVector(),
+      mTwinVector(),
+      mNonmanifoldVector(),
+      mEdgeOffsetVector(),
+      mEdgeHalfEdgeVector(),
+      mVertexOffsetVector(),
+      mOutgoingHalfEdgeVector(),
+      mManifoldVertexVector()
+{
+}
+
+HalfEdgeTopology::~HalfEdgeTopology()
+{
+}
+
+void
+HalfEdgeTopology::build(Mesh *mesh)
+{
+    assert(mesh != NULL);
+
+    clear();
+    mMesh = mesh;
+
+    buildHalfEdges();
+    buildTwins();
+    buildOutgoingHalfEdges();
+}
+
+void
+HalfEdgeTopology::clear()
+{
+    // Swap with empty vectors, so the memory is released.
+    mMesh = NULL;
+    std::vector<unsigned>().swap(mFaceBeginVector);
+    std::vector<unsigned>().swap(mFaceEndVector);
+    std::vector<FacePtr>().swap(mFacePtrVector);
+    std::vector<VertexPtr>().swap(mOriginVertexPtrVector);
+    std::vector<EdgePtr>().swap(mEdgePtrVector);
+    std::vector<unsigned>().swap(mNextVector);
+    std::vector<unsigned>().swap(mPreviousVector);
+    std::vector<unsigned>().swap(mTwinVector);
+    std::vector<bool>().swap(mNonmanifoldVector);
+    std::vector<unsigned>().swap(mEdgeOffsetVector);
+    std::vector<unsigned>().swap(mEdgeHalfEdgeVector);
+    std::vector<unsigned>().swap(mVertexOffsetVector);
+    std::vector<unsigned>().swap(mOutgoingHalfEdgeVector);
+    std::vector<bool>().swap(mManifoldVertexVector);
+}
+
+Mesh *
+HalfEdgeTopology::mesh() const
+{
+    return mMesh;
+}
+
+unsigned
+HalfEdgeTopology::halfEdgeCount() const
+{
+    return mFacePtrVector.size();
+}
+
+unsigned
+HalfEdgeTopology::faceHalfEdgeBegin(ConstFacePtr facePtr) const
+{
+    return mFaceBeginVector[mMesh->faceIndex(facePtr)];
+}
+
+unsigned
+HalfEdgeTopology::faceHalfEdgeEnd(ConstFacePtr facePtr) const
+{
+    return mFaceEndVector[mMesh->faceIndex(facePtr)];
+}
+
+unsigned
+HalfEdgeTopology::next(unsigned halfEdge) const
+{
+    assert(halfEdge < mNextVector.size());
+
+    return mNextVector[halfEdge];
+}
+
+unsigned
+HalfEdgeTopology::previous(unsigned halfEdge) const
+{
+    assert(halfEdge < mPreviousVector.size());
+
+    return mPreviousVector[halfEdge];
+}
+
+bool
+HalfEdgeTopology::hasTwin(unsigned halfEdge) const
+{
+    assert(halfEdge < mTwinVector.size());
+
+    // Half-edges without twins are their own twin.
+    return mTwinVector[halfEdge] != halfEdge;
+}
+
+unsigned
+HalfEdgeTopology::twin(unsigned halfEdge) const
+{
+    assert(hasTwin(halfEdge));
+
+    return mTwinVector[halfEdge];
+}
+
+bool
+HalfEdgeTopology::isBoundary(unsigned halfEdge) const
+{
+    return !hasTwin(halfEdge) && !mNonmanifoldVector[halfEdge];
+}
+
+bool
+HalfEdgeTopology::isNonmanifold(unsigned halfEdge) const
+{
+    assert(halfEdge < mNonmanifoldVector.size());
+
+    return mNonmanifoldVector[halfEdge];
+}
+
+FacePtr
+HalfEdgeTopology::facePtr(unsigned halfEdge) const
+{
+    assert(halfEdge < mFacePtrVector.size());
+
+    return mFacePtrVector[halfEdge];
+}
+
+unsigned
+HalfEdgeTopology::corner(unsigned halfEdge) const
+{
+    return halfEdge - faceHalfEdgeBegin(facePtr(halfEdge));
+}
+
+VertexPtr
+HalfEdgeTopology::originVertexPtr(unsigned halfEdge) const
+{
+    assert(halfEdge < mOriginVertexPtrVector.size());
+
+    return mOriginVertexPtrVector[halfEdge];
+}
+
+VertexPtr
+HalfEdgeTopology::destinationVertexPtr(unsigned halfEdge) const
+{
+    return mOriginVertexPtrVector[next(halfEdge)];
+}
+
+EdgePtr
+HalfEdgeTopology::edgePtr(unsigned halfEdge) const
+{
+    assert(halfEdge < mEdgePtrVector.size());
+
+    return mEdgePtrVector[halfEdge];
+}
+
+FacePtr
+HalfEdgeTopology::oppositeFacePtr(unsigned halfEdge) const
+{
+    return mFacePtrVector[twin(halfEdge)];
+}
+
+HalfEdgeTopology::EdgeHalfEdgeConstIterator
+HalfEdgeTopology::edgeHalfEdgeBegin(ConstEdgePtr edgePtr) const
+{
+    if (mEdgeHalfEdgeVector.empty()) {
+        return NULL;
+    }
+
+    return &mEdgeHalfEdgeVector[0] + mEdgeOffsetVector[mMesh->edgeIndex(edgePtr)];
+}
+
+HalfEdgeTopology::EdgeHalfEdgeConstIterator
+HalfEdgeTopology::edgeHalfEdgeEnd(ConstEdgePtr edgePtr) const
+{
+    if (mEdgeHalfEdgeVector.empty()) {
+        return NULL;
+    }
+
+    return &mEdgeHalfEdgeVector[0] + mEdgeOffsetVector[mMesh->edgeIndex(edgePtr) + 1];
+}
+
+unsigned
+HalfEdgeTopology::edgeHalfEdgeCount(ConstEdgePtr edgePtr) const
+{
+    unsigned index = mMesh->edgeIndex(edgePtr);
+
+    return mEdgeOffsetVector[index + 1] - mEdgeOffsetVector[index];
+}
+
+HalfEdgeTopology::OutgoingHalfEdgeConstIterator
+HalfEdgeTopology::outgoingHalfEdgeBegin(ConstVertexPtr vertexPtr) const
+{
+    if (mOutgoingHalfEdgeVector.empty()) {
+        return NULL;
+    }
+
+    return &mOutgoingHalfEdgeVector[0] 
+        + mVertexOffsetVector[mMesh->vertexIndex(vertexPtr)];
+}
+
+HalfEdgeTopology::OutgoingHalfEdgeConstIterator
+HalfEdgeTopology::outgoingHalfEdgeEnd(ConstVertexPtr vertexPtr) const
+{
+    if (mOutgoingHalfEdgeVector.empty()) {
+        return NULL;
+    }
+
+    return &mOutgoingHalfEdgeVector[0] 
+        + mVertexOffsetVector[mMesh->vertexIndex(vertexPtr) + 1];
+}
+
+unsigned
+HalfEdgeTopology::outgoingHalfEdgeCount(ConstVertexPtr vertexPtr) const
+{
+    unsigned index = mMesh->vertexIndex(vertexPtr);
+
+    return mVertexOffsetVector[index + 1] - mVertexOffsetVector[index];
+}
+
+bool
+HalfEdgeTopology::isManifold(ConstVertexPtr vertexPtr) const
+{
+    return mManifoldVertexVector[mMesh->vertexIndex(vertexPtr)];
+}
+
+void
+HalfEdgeTopology::buildHalfEdges()
+{
+    unsigned halfEdgeCount = 0;
+    for (ConstFacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+        halfEdgeCount += facePtr->adjacentVertexCount();
+    }
+
+    mFaceBeginVector.resize(mMesh->faceIndexLimit(), 0);
+    mFaceEndVector.resize(mMesh->faceIndexLimit(), 0);
+    mFacePtrVector.reserve(halfEdgeCount);
+    mOriginVertexPtrVector.reserve(halfEdgeCount);
+    mEdgePtrVector.reserve(halfEdgeCount);
+    mNextVector.reserve(halfEdgeCount);
+    mPreviousVector.reserve(halfEdgeCount);
+
+    for (FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+        unsigned begin = mFacePtrVector.size();
+        unsigned count = facePtr->adjacentVertexCount();
+        unsigned faceIndex = mMesh->faceIndex(facePtr);
+        mFaceBeginVector[faceIndex] = begin;
+        mFaceEndVector[faceIndex] = begin + count;
+
+        for (unsigned corner = 0; corner < count; ++corner) {
+            VertexPtr originVertexPtr = facePtr->cornerVertexPtr(corner);
+            VertexPtr destinationVertexPtr
+                = facePtr->cornerVertexPtr(corner + 1 < count ? corner + 1 : 0);
+
+            // Find the edge among the face's edges, rather than among
+            // the vertex's edges, because faces have fewer edges.
+            EdgePtr edgePtr = mMesh->edgeEnd();
+            for (AdjacentEdgeIterator iterator = facePtr->adjacentEdgeBegin();
+                 iterator != facePtr->adjacentEdgeEnd(); ++iterator) {
+                if ((*iterator)->hasAdjacentVertex(originVertexPtr)
+                    && (*iterator)->hasAdjacentVertex(destinationVertexPtr)) {
+                    edgePtr = *iterator;
+                    break;
+                }
+            }
+
+            mFacePtrVector.push_back(facePtr);
+            mOriginVertexPtrVector.push_back(originVertexPtr);
+            mEdgePtrVector.push_back(edgePtr);
+            mNextVector.push_back(begin + (corner + 1 < count ? corner + 1 : 0));
+            mPreviousVector.push_back(begin + (corner > 0 ? corner - 1 : count - 1));
+        }
+    }
+}
+
+void
+HalfEdgeTopology::buildTwins()
+{
+    unsigned halfEdgeCount = mFacePtrVector.size();
+
+    // Initially, no half-edge has a twin.
+    mTwinVector.resize(halfEdgeCount);
+    for (unsigned halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge) {
+        mTwinVector[halfEdge] = halfEdge;
+    }
+    mNonmanifoldVector.assign(halfEdgeCount, false);
+
+    // Group the half-edges by edge with a counting sort, so that
+    // the half-edges along each edge can be compared.
+    mEdgeOffsetVector.assign(mMesh->edgeIndexLimit() + 1, 0);
+    for (unsigned halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge) {
+        if (mEdgePtrVector[halfEdge] != mMesh->edgeEnd()) {
+            ++mEdgeOffsetVector[mMesh->edgeIndex(mEdgePtrVector[halfEdge]) + 1];
+        }
+    }
+    for (unsigned index = 1; index < mEdgeOffsetVector.size(); ++index) {
+        mEdgeOffsetVector[index] += mEdgeOffsetVector[index - 1];
+    }
+    mEdgeHalfEdgeVector.resize(mEdgeOffsetVector.back());
+    std::vector<unsigned> fillVector(mEdgeOffsetVector.begin(), mEdgeOffsetVector.end() - 1);
+    for (unsigned halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge) {
+        if (mEdgePtrVector[halfEdge] != mMesh->edgeEnd()) {
+            unsigned edgeIndex = mMesh->edgeIndex(mEdgePtrVector[halfEdge]);
+            mEdgeHalfEdgeVector[fillVector[edgeIndex]] = halfEdge;
+            ++fillVector[edgeIndex];
+        }
+    }
+
+    for (unsigned edgeIndex = 0; edgeIndex + 1 < mEdgeOffsetVector.size(); ++edgeIndex) {
+        unsigned begin = mEdgeOffsetVector[edgeIndex];
+        unsigned end = mEdgeOffsetVector[edgeIndex + 1];
+        if (end - begin < 2) {
+            // The edge is on a boundary, or has no faces.
+            continue;
+        }
+
+        // Two half-edges are twins if they run in opposite directions.
+        unsigned first = mEdgeHalfEdgeVector[begin];
+        unsigned second = mEdgeHalfEdgeVector[begin + 1];
+        if (end - begin == 2
+            && mOriginVertexPtrVector[first] == destinationVertexPtr(second)
+            && mOriginVertexPtrVector[second] == destinationVertexPtr(first)) {
+            mTwinVector[first] = second;
+            mTwinVector[second] = first;
+            continue;
+        }
+
+        for (unsigned index = begin; index < end; ++index) {
+            mNonmanifoldVector[mEdgeHalfEdgeVector[index]] = true;
+        }
+    }
+}
+
+void
+HalfEdgeTopology::buildOutgoingHalfEdges()
+{
+    unsigned halfEdgeCount = mFacePtrVector.size();
+
+    // Group the half-edges by origin vertex with a counting sort.
+    mVertexOffsetVector.assign(mMesh->vertexIndexLimit() + 1, 0);
+    for (unsigned halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge) {
+        ++mVertexOffsetVector[mMesh->vertexIndex(mOriginVertexPtrVector[halfEdge]) + 1];
+    }
+    for (unsigned index = 1; index < mVertexOffsetVector.size(); ++index) {
+        mVertexOffsetVector[index] += mVertexOffsetVector[index - 1];
+    }
+    mOutgoingHalfEdgeVector.resize(halfEdgeCount);
+    std::vector<unsigned> fillVector(mVertexOffsetVector.begin(),
+        mVertexOffsetVector.end() - 1);
+    for (unsigned halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge) {
+        unsigned vertexIndex = mMesh->vertexIndex(mOriginVertexPtrVector[halfEdge]);
+        mOutgoingHalfEdgeVector[fillVector[vertexIndex]] = halfEdge;
+        ++fillVector[vertexIndex];
+    }
+
+    mManifoldVertexVector.assign(mMesh->vertexIndexLimit(), false);
+    for (unsigned vertexIndex = 0; vertexIndex < mMesh->vertexIndexLimit(); ++vertexIndex) {
+        orderOutgoingHalfEdges(vertexIndex);
+    }
+}
+
+void
+HalfEdgeTopology::orderOutgoingHalfEdges(unsigned vertexIndex)
+{
+    unsigned begin = mVertexOffsetVector[vertexIndex];
+    unsigned end = mVertexOffsetVector[vertexIndex + 1];
+    if (begin == end) {
+        return;
+    }
+
+    // The walk around the vertex begins at the outgoing half-edge
+    // without a twin, if the vertex is on a boundary. If there's more
+    // than one, the faces around the vertex form more than one fan.
+    // Vertices on nonmanifold edges are nonmanifold.
+    unsigned start = mOutgoingHalfEdgeVector[begin];
+    unsigned boundaryCount = 0;
+    for (unsigned index = begin; index < end; ++index) {
+        unsigned halfEdge = mOutgoingHalfEdgeVector[index];
+        if (mNonmanifoldVector[halfEdge]
+            || mNonmanifoldVector[mPreviousVector[halfEdge]]) {
+            return;
+        }
+        if (!hasTwin(halfEdge)) {
+            start = halfEdge;
+            ++boundaryCount;
+        }
+    }
+    if (boundaryCount > 1) {
+        return;
+    }
+
+    // Walk around the vertex from face to face. Because each step
+    // is a permutation of the half-edges, the walk can't revisit
+    // a half-edge before it returns to the start.
+    std::vector<unsigned> orderedVector;
+    orderedVector.reserve(end - begin);
+    unsigned halfEdge = start;
+    do {
+        orderedVector.push_back(halfEdge);
+        unsigned previousHalfEdge = mPreviousVector[halfEdge];
+        if (!hasTwin(previousHalfEdge)) {
+            break;
+        }
+        halfEdge = mTwinVector[previousHalfEdge];
+    } while (halfEdge != start && orderedVector.size() < end - begin);
+
+    // If the walk didn't reach all of the outgoing half-edges,
+    // the faces form more than one fan, and are left as they are.
+    if (orderedVector.size() != end - begin
+        || (boundaryCount == 0 && halfEdge != start)) {
+        return;
+    }
+
+    std::copy(orderedVector.begin(), orderedVector.end(),
+        mOutgoingHalfEdgeVector.begin() + begin);
+    mManifoldVertexVector[vertexIndex] = true;
+}
+
+} // namespace mesh
@@ -0,0 +1,157 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__HALF_EDGE_TOPOLOGY__INCLUDED
+#define MESH__HALF_EDGE_TOPOLOGY__INCLUDED
+
+#include <vector>
+
+#include "Types.h"
+
+namespace mesh {
+
+class Mesh;
+
+// HalfEdgeTopology
+//
+// A half-edge representation of the connectivity of a mesh, built from
+// the mesh's adjacency information, for algorithms that walk around
+// faces and vertices and that would otherwise search the elements'
+// adjacency vectors at each step.
+//
+// Each corner of each face is the origin of one half-edge, which runs
+// to the next corner of the face. Half-edges are identified by unsigned
+// indices, and the half-edges of a face have consecutive indices,
+// in the order of the face's adjacent vertices. The next, previous,
+// and twin half-edges, and the face, edge, and vertices of a half-edge,
+// are found in constant time.
+//
+// The mesh may be nonmanifold. A half-edge only has a twin if its edge
+// is adjacent to exactly two faces that are consistently oriented.
+// Half-edges of edges adjacent to more than two faces, or to two faces
+// with opposite orientations, are flagged as nonmanifold, and algorithms
+// should fall back to the adjacency vectors of the mesh elements for them.
+//
+// The topology is a snapshot. It must be rebuilt after elements
+// are created or destroyed, or their adjacency is changed.
+
+class HalfEdgeTopology
+{
+public:
+    HalfEdgeTopology();
+    ~HalfEdgeTopology();
+
+    // Build the topology of a mesh, replacing any previous topology.
+    void build(Mesh *mesh);
+
+    // Release the topology.
+    void clear();
+
+    // The mesh that the topology was built from, or NULL.
+    Mesh *mesh() const;
+
+    // The total number of half-edges.
+    unsigned halfEdgeCount() const;
+
+    // The half-edges of a face are the range [faceHalfEdgeBegin, faceHalfEdgeEnd).
+    // The half-edge at faceHalfEdgeBegin + n originates at the
+    // face's corner n.
+    unsigned faceHalfEdgeBegin(ConstFacePtr facePtr) const;
+    unsigned faceHalfEdgeEnd(ConstFacePtr facePtr) const;
+
+    // The next and previous half-edges around the face of a half-edge.
+    unsigned next(unsigned halfEdge) const;
+    unsigned previous(unsigned halfEdge) const;
+
+    // Returns true if the half-edge has a twin, the half-edge
+    // of the neighboring face that runs along the same edge
+    // in the opposite direction.
+    bool hasTwin(unsigned halfEdge) const;
+    unsigned twin(unsigned halfEdge) const;
+
+    // Returns true if the half-edge's edge is adjacent to only
+    // the half-edge's face.
+    bool isBoundary(unsigned halfEdge) const;
+
+    // Returns true if the half-edge's edge is adjacent to more than
+    // two faces, or to two faces that aren't consistently oriented.
+    bool isNonmanifold(unsigned halfEdge) const;
+
+    // The face, and the corner of the face, that the half-edge belongs to.
+    FacePtr facePtr(unsigned halfEdge) const;
+    unsigned corner(unsigned halfEdge) const;
+
+    // The vertices that the half-edge runs from and to.
+    VertexPtr originVertexPtr(unsigned halfEdge) const;
+    VertexPtr destinationVertexPtr(unsigned halfEdge) const;
+
+    // The edge that the half-edge runs along. If the face has no
+    // adjacent edge connecting the half-edge's vertices,
+    // Mesh::edgeEnd() is returned.
+    EdgePtr edgePtr(unsigned halfEdge) const;
+
+    // The face on the other side of the half-edge's edge.
+    // The half-edge must have a twin.
+    FacePtr oppositeFacePtr(unsigned halfEdge) const;
+
+    // Iterators over the half-edges that run along an edge,
+    // in either direction, one for each of the edge's adjacent faces.
+    // Dereference these to get a half-edge.
+    typedef const unsigned *EdgeHalfEdgeConstIterator;
+    EdgeHalfEdgeConstIterator edgeHalfEdgeBegin(ConstEdgePtr edgePtr) const;
+    EdgeHalfEdgeConstIterator edgeHalfEdgeEnd(ConstEdgePtr edgePtr) const;
+    unsigned edgeHalfEdgeCount(ConstEdgePtr edgePtr) const;
+
+    // Iterators over the half-edges that originate at a vertex.
+    // Dereference these to get a half-edge.
+    // If the vertex is manifold, the half-edges are in order
+    // around the vertex, each one being the twin of the previous
+    // half-edge of the one before it. If the vertex is on
+    // a boundary, the iteration begins at the half-edge without a twin.
+    typedef const unsigned *OutgoingHalfEdgeConstIterator;
+    OutgoingHalfEdgeConstIterator outgoingHalfEdgeBegin(ConstVertexPtr vertexPtr) const;
+    OutgoingHalfEdgeConstIterator outgoingHalfEdgeEnd(ConstVertexPtr vertexPtr) const;
+    unsigned outgoingHalfEdgeCount(ConstVertexPtr vertexPtr) const;
+
+    // Returns true if the faces adjacent to the vertex form a single
+    // fan connected by manifold edges, so that its outgoing half-edges
+    // are in order around it.
+    bool isManifold(ConstVertexPtr vertexPtr) const;
+
+private:
+    void buildHalfEdges();
+    void buildTwins();
+    void buildOutgoingHalfEdges();
+    void orderOutgoingHalfEdges(unsigned vertexIndex);
+
+    Mesh *mMesh;
+
+    // Indexed by face index.
+    std::vector<unsigned> mFaceBeginVector;
+    std::vector<unsigned> mFaceEndVector;
+
+    // Indexed by half-edge.
+    std::vector<FacePtr> mFacePtrVector;
+    std::vector<VertexPtr> mOriginVertexPtrVector;
+    std::vector<EdgePtr> mEdgePtrVector;
+    std::vector<unsigned> mNextVector;
+    std::vector<unsigned> mPreviousVector;
+    std::vector<unsigned> mTwinVector;
+    std::vector<bool> mNonmanifoldVector;
+
+    // Indexed by edge index. The half-edges along an edge
+    // are mEdgeHalfEdgeVector[mEdgeOffsetVector[index]] through
+    // mEdgeHalfEdgeVector[mEdgeOffsetVector[index + 1] - 1].
+    std::vector<unsigned> mEdgeOffsetVector;
+    std::vector<unsigned> mEdgeHalfEdgeVector;
+
+    // Indexed by vertex index. The outgoing half-edges of a vertex
+    // are mOutgoingHalfEdgeVector[mVertexOffsetVector[index]] through
+    // mOutgoingHalfEdgeVector[mVertexOffsetVector[index + 1] - 1].
+    std::vector<unsigned> mVertexOffsetVector;
+    std::vector<unsigned> mOutgoingHalfEdgeVector;
+    std::vector<bool> mManifoldVertexVector;
+};
+
+} // namespace mesh
+
+#endif // MESH__HALF_EDGE_TOPOLOGY__INCLUDED
@@ -142,16 +142,23 @@ IsConsistent(const Mesh &mesh)
             edgePtrMap.insert(edgePtr);
         }
 
-        // Make sure all of the face vertices reference vertices
-        // that are adjacent to the face.
+        // Make sure all of the face vertices reference the vertices
+        // of the corners they are stored with.
         // If this isn't the case, we probably have dangling pointers.
-        for (Face::FaceVertexVectorConstIterator iterator = facePtr->faceVertexVectorBegin();
-             iterator != facePtr->faceVertexVectorEnd(); ++iterator){
-            const FaceVertex *faceVertexPtr = *iterator;
-            if (!facePtr->hasAdjacentVertex(faceVertexPtr->vertexPtr())) {
+        for (Face::CornerConstIterator iterator = facePtr->cornerBegin();
+             iterator != facePtr->cornerEnd(); ++iterator) {
+            const FaceVertex *faceVertexPtr = iterator.faceVertex();
+            if (faceVertexPtr != NULL
+                && faceVertexPtr->vertexPtr() != iterator.vertexPtr()) {
                 return false;
             }
         }
+
+        // Face vertices that don't correspond to a corner reference
+        // vertices that are not adjacent to the face.
+        if (facePtr->faceVertexVectorSize() > facePtr->adjacentVertexCount()) {
+            return false;
+        }
     }
 
     return true;
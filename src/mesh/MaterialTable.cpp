@@ -24,8 +24,8 @@ MaterialTable::~MaterialTable()
 void
 MaterialTable::initialize(const Mesh &mesh)
 {
-    mMaterialIndexAttributeKey = GetMaterialIndexAttributeKey(mesh);
-    mColor3fAttributeKey = GetColor3fAttributeKey(mesh);
+    mMaterialIndexAttributeKey = GetMaterialIndexTypedAttributeKey(mesh);
+    mColor3fAttributeKey = GetColor3fTypedAttributeKey(mesh);
 
     std::vector<int> materialIndexVector = GetMaterialIndexVector(mesh);
     if (materialIndexVector.empty()) {
@@ -60,7 +60,7 @@ MaterialTable::faceHasValidMaterialIndex(FacePtr facePtr) const
         return false;
     }
 
-    size_t materialIndex = facePtr->getInt(mMaterialIndexAttributeKey);
+    size_t materialIndex = facePtr->getValue(mMaterialIndexAttributeKey);
 
     return materialIndex < mMaterialVector.size();
 }
@@ -70,7 +70,7 @@ MaterialTable::getMaterialFromFace(FacePtr facePtr) const
 {
     assert(faceHasValidMaterialIndex(facePtr));
 
-    size_t materialIndex = facePtr->getInt(mMaterialIndexAttributeKey);
+    size_t materialIndex = facePtr->getValue(mMaterialIndexAttributeKey);
 
     return mMaterialVector[materialIndex];
 }
@@ -82,17 +82,17 @@ MaterialTable::getFaceVertexDiffuseColor(FacePtr facePtr,
     cgmath::Vector3f diffuse(1.0, 1.0, 1.0);
 
     if (facePtr->hasAttribute(mMaterialIndexAttributeKey)) {
-        size_t materialIndex = facePtr->getInt(mMaterialIndexAttributeKey);
+        size_t materialIndex = facePtr->getValue(mMaterialIndexAttributeKey);
         assert(materialIndex < mMaterialVector.size());
         diffuse *= cgmath::Vector3f(mMaterialVector[materialIndex].mDiffuse);
     }
 
     if (facePtr->hasAttribute(mColor3fAttributeKey)) {
-        diffuse *= facePtr->getVector3f(mColor3fAttributeKey);
+        diffuse *= facePtr->getValue(mColor3fAttributeKey);
     }
 
     if (facePtr->hasVertexAttribute(vertexPtr, mColor3fAttributeKey)) {
-        diffuse *= facePtr->getVertexVector3f(vertexPtr, mColor3fAttributeKey);
+        diffuse *= facePtr->getVertexValue(vertexPtr, mColor3fAttributeKey);
     }
 
     return diffuse;
@@ -8,6 +8,7 @@
 #include <cgmath/Vector3f.h>
 #include <mesh/Types.h>
 #include <mesh/AttributeKey.h>
+#include <mesh/TypedAttributeKey.h>
 
 #include "Material.h"
 
@@ -41,8 +42,8 @@ public:
         VertexPtr vertexPtr);
 
 private:
-    AttributeKey mMaterialIndexAttributeKey;
-    AttributeKey mColor3fAttributeKey;
+    TypedAttributeKey<int32_t> mMaterialIndexAttributeKey;
+    TypedAttributeKey<cgmath::Vector3f> mColor3fAttributeKey;
 
     std::vector<Material> mMaterialVector;
 };
@@ -1,10 +1,16 @@
 // Copyright 2008 Drew Olbrich
 
 #include "Mesh.h"
+
+#include <cassert>
+
 #include "Concatenate.h"
 
 namespace mesh {
 
+static void AddAttributeBytes(const AttributePossessor &attributePossessor,
+    std::vector<size_t> *handleBytesVector, size_t *unusedAttributeBytes);
+
 Mesh::Mesh()
     : AttributePossessor(),
       mFilename(),
@@ -69,6 +75,111 @@ Mesh::clear()
     this->swap(emptyMesh);
 }
 
+void
+Mesh::reorderElements(const std::vector<VertexPtr> &vertexPtrVector,
+    const std::vector<EdgePtr> &edgePtrVector,
+    const std::vector<FacePtr> &facePtrVector)
+{
+    assert(vertexPtrVector.size() == vertexCount());
+    assert(edgePtrVector.size() == edgeCount());
+    assert(facePtrVector.size() == faceCount());
+
+    VertexList vertexList;
+    EdgeList edgeList;
+    FaceList faceList;
+    vertexList.reserve(vertexPtrVector.size());
+    edgeList.reserve(edgePtrVector.size());
+    faceList.reserve(facePtrVector.size());
+
+    // The new elements, indexed by the indices of the old ones.
+    std::vector<VertexPtr> newVertexPtrVector(vertexIndexLimit(), vertexList.end());
+    std::vector<EdgePtr> newEdgePtrVector(edgeIndexLimit(), edgeList.end());
+    std::vector<FacePtr> newFacePtrVector(faceIndexLimit(), faceList.end());
+
+    for (size_t index = 0; index < vertexPtrVector.size(); ++index) {
+        VertexPtr vertexPtr = vertexPtrVector[index];
+        assert(newVertexPtrVector[vertexIndex(vertexPtr)] == vertexList.end());
+        VertexPtr newVertexPtr = vertexList.create();
+        newVertexPtr->setPosition(vertexPtr->position());
+        newVertexPtr->copyAttributes(*vertexPtr);
+        newVertexPtrVector[vertexIndex(vertexPtr)] = newVertexPtr;
+    }
+    for (size_t index = 0; index < edgePtrVector.size(); ++index) {
+        EdgePtr edgePtr = edgePtrVector[index];
+        assert(newEdgePtrVector[edgeIndex(edgePtr)] == edgeList.end());
+        EdgePtr newEdgePtr = edgeList.create();
+        newEdgePtr->copyAttributes(*edgePtr);
+        newEdgePtrVector[edgeIndex(edgePtr)] = newEdgePtr;
+    }
+    for (size_t index = 0; index < facePtrVector.size(); ++index) {
+        FacePtr facePtr = facePtrVector[index];
+        assert(newFacePtrVector[faceIndex(facePtr)] == faceList.end());
+        FacePtr newFacePtr = faceList.create();
+        newFacePtr->copyAttributes(*facePtr);
+        newFacePtrVector[faceIndex(facePtr)] = newFacePtr;
+    }
+
+    // Connect the new elements in the same way as the old ones.
+    for (size_t index = 0; index < vertexPtrVector.size(); ++index) {
+        VertexPtr vertexPtr = vertexPtrVector[index];
+        VertexPtr newVertexPtr = newVertexPtrVector[vertexIndex(vertexPtr)];
+        newVertexPtr->reserveAdjacentEdges(vertexPtr->adjacentEdgeCount());
+        for (AdjacentEdgeIterator iterator = vertexPtr->adjacentEdgeBegin();
+             iterator != vertexPtr->adjacentEdgeEnd(); ++iterator) {
+            newVertexPtr->addAdjacentEdge(newEdgePtrVector[edgeIndex(*iterator)]);
+        }
+        newVertexPtr->reserveAdjacentFaces(vertexPtr->adjacentFaceCount());
+        for (AdjacentFaceIterator iterator = vertexPtr->adjacentFaceBegin();
+             iterator != vertexPtr->adjacentFaceEnd(); ++iterator) {
+            newVertexPtr->addAdjacentFace(newFacePtrVector[faceIndex(*iterator)]);
+        }
+    }
+    for (size_t index = 0; index < edgePtrVector.size(); ++index) {
+        EdgePtr edgePtr = edgePtrVector[index];
+        EdgePtr newEdgePtr = newEdgePtrVector[edgeIndex(edgePtr)];
+        for (AdjacentVertexIterator iterator = edgePtr->adjacentVertexBegin();
+             iterator != edgePtr->adjacentVertexEnd(); ++iterator) {
+            newEdgePtr->addAdjacentVertex(newVertexPtrVector[vertexIndex(*iterator)]);
+        }
+        newEdgePtr->reserveAdjacentFaces(edgePtr->adjacentFaceCount());
+        for (AdjacentFaceIterator iterator = edgePtr->adjacentFaceBegin();
+             iterator != edgePtr->adjacentFaceEnd(); ++iterator) {
+            newEdgePtr->addAdjacentFace(newFacePtrVector[faceIndex(*iterator)]);
+        }
+    }
+    for (size_t index = 0; index < facePtrVector.size(); ++index) {
+        FacePtr facePtr = facePtrVector[index];
+        FacePtr newFacePtr = newFacePtrVector[faceIndex(facePtr)];
+        newFacePtr->reserveAdjacentVertices(facePtr->adjacentVertexCount());
+        for (unsigned corner = 0; corner < facePtr->adjacentVertexCount(); ++corner) {
+            newFacePtr->addAdjacentVertex(
+                newVertexPtrVector[vertexIndex(facePtr->cornerVertexPtr(corner))]);
+            const FaceVertex *faceVertex = facePtr->findCornerFaceVertex(corner);
+            if (faceVertex != NULL) {
+                newFacePtr->getCornerFaceVertex(corner)->copyAttributes(*faceVertex);
+            }
+        }
+        // Face vertices of vertices that aren't adjacent to the face
+        // follow those of the corners.
+        for (Face::FaceVertexVectorConstIterator iterator
+                 = facePtr->faceVertexVectorBegin() + facePtr->adjacentVertexCount();
+             iterator != facePtr->faceVertexVectorEnd(); ++iterator) {
+            VertexPtr newVertexPtr = newVertexPtrVector[vertexIndex((*iterator)->vertexPtr())];
+            assert(newVertexPtr != vertexList.end());
+            newFacePtr->getFaceVertex(newVertexPtr)->copyAttributes(**iterator);
+        }
+        newFacePtr->reserveAdjacentEdges(facePtr->adjacentEdgeCount());
+        for (AdjacentEdgeIterator iterator = facePtr->adjacentEdgeBegin();
+             iterator != facePtr->adjacentEdgeEnd(); ++iterator) {
+            newFacePtr->addAdjacentEdge(newEdgePtrVector[edgeIndex(*iterator)]);
+        }
+    }
+
+    mVertexList.swap(vertexList);
+    mEdgeList.swap(edgeList);
+    mFaceList.swap(faceList);
+}
+
 void 
 Mesh::setFilename(const std::string &filename)
 {
@@ -84,10 +195,13 @@ Mesh::filename() const
 VertexPtr 
 Mesh::createVertex()
 {
-    mVertexList.push_back(Vertex());
+    return mVertexList.create();
+}
 
-    // Return an iterator pointing to the last element of the list.
-    return --mVertexList.end();
+void
+Mesh::reserveVertices(VertexList::size_type count)
+{
+    mVertexList.reserve(count);
 }
 
 void 
@@ -126,13 +240,46 @@ Mesh::vertexCount() const
     return mVertexList.size();
 }
 
+unsigned
+Mesh::vertexIndex(ConstVertexPtr vertexPtr) const
+{
+    return mVertexList.index(vertexPtr);
+}
+
+unsigned
+Mesh::vertexIndexLimit() const
+{
+    return mVertexList.indexLimit();
+}
+
+VertexHandle
+Mesh::vertexHandle(ConstVertexPtr vertexPtr) const
+{
+    return mVertexList.handle(vertexPtr);
+}
+
+VertexPtr
+Mesh::findVertex(const VertexHandle &vertexHandle)
+{
+    return mVertexList.find(vertexHandle);
+}
+
+ConstVertexPtr
+Mesh::findVertex(const VertexHandle &vertexHandle) const
+{
+    return mVertexList.find(vertexHandle);
+}
+
 EdgePtr 
 Mesh::createEdge()
 {
-    mEdgeList.push_back(Edge());
+    return mEdgeList.create();
+}
 
-    // Return an iterator pointing to the last element of the list.
-    return --mEdgeList.end();
+void
+Mesh::reserveEdges(EdgeList::size_type count)
+{
+    mEdgeList.reserve(count);
 }
 
 void 
@@ -171,13 +318,46 @@ Mesh::edgeCount() const
     return mEdgeList.size();
 }
 
+unsigned
+Mesh::edgeIndex(ConstEdgePtr edgePtr) const
+{
+    return mEdgeList.index(edgePtr);
+}
+
+unsigned
+Mesh::edgeIndexLimit() const
+{
+    return mEdgeList.indexLimit();
+}
+
+EdgeHandle
+Mesh::edgeHandle(ConstEdgePtr edgePtr) const
+{
+    return mEdgeList.handle(edgePtr);
+}
+
+EdgePtr
+Mesh::findEdge(const EdgeHandle &edgeHandle)
+{
+    return mEdgeList.find(edgeHandle);
+}
+
+ConstEdgePtr
+Mesh::findEdge(const EdgeHandle &edgeHandle) const
+{
+    return mEdgeList.find(edgeHandle);
+}
+
 FacePtr 
 Mesh::createFace()
 {
-    mFaceList.push_back(Face());
+    return mFaceList.create();
+}
 
-    // Return an iterator pointing to the last element of the list.
-    return --mFaceList.end();
+void
+Mesh::reserveFaces(FaceList::size_type count)
+{
+    mFaceList.reserve(count);
 }
 
 void 
@@ -216,6 +396,36 @@ Mesh::faceCount() const
     return mFaceList.size();
 }
 
+unsigned
+Mesh::faceIndex(ConstFacePtr facePtr) const
+{
+    return mFaceList.index(facePtr);
+}
+
+unsigned
+Mesh::faceIndexLimit() const
+{
+    return mFaceList.indexLimit();
+}
+
+FaceHandle
+Mesh::faceHandle(ConstFacePtr facePtr) const
+{
+    return mFaceList.handle(facePtr);
+}
+
+FacePtr
+Mesh::findFace(const FaceHandle &faceHandle)
+{
+    return mFaceList.find(faceHandle);
+}
+
+ConstFacePtr
+Mesh::findFace(const FaceHandle &faceHandle) const
+{
+    return mFaceList.find(faceHandle);
+}
+
 AttributeKey
 Mesh::getAttributeKey(const std::string &name, AttributeKey::Type type,
     unsigned flags) const
@@ -260,4 +470,80 @@ Mesh::attributeKeyMapEnd() const
     return mAttributeKeyMap.end();
 }
 
+MeshMemoryUsage
+Mesh::memoryUsage() const
+{
+    MeshMemoryUsage meshMemoryUsage;
+
+    meshMemoryUsage.mVertexBytes = mVertexList.bytesUsed();
+    meshMemoryUsage.mEdgeBytes = mEdgeList.bytesUsed();
+    meshMemoryUsage.mFaceBytes = mFaceList.bytesUsed();
+
+    // The attribute bytes are accumulated by handle, and then
+    // looked up by name once at the end.
+    std::vector<size_t> handleBytesVector;
+
+    AddAttributeBytes(*this, &handleBytesVector, &meshMemoryUsage.mUnusedAttributeBytes);
+
+    for (ConstVertexPtr vertexPtr = vertexBegin(); vertexPtr != vertexEnd(); ++vertexPtr) {
+        meshMemoryUsage.mAdjacencyBytes += vertexPtr->adjacencyBytesAllocated();
+        AddAttributeBytes(*vertexPtr, &handleBytesVector,
+            &meshMemoryUsage.mUnusedAttributeBytes);
+    }
+
+    for (ConstEdgePtr edgePtr = edgeBegin(); edgePtr != edgeEnd(); ++edgePtr) {
+        meshMemoryUsage.mAdjacencyBytes += edgePtr->adjacencyBytesAllocated();
+        AddAttributeBytes(*edgePtr, &handleBytesVector,
+            &meshMemoryUsage.mUnusedAttributeBytes);
+    }
+
+    for (ConstFacePtr facePtr = faceBegin(); facePtr != faceEnd(); ++facePtr) {
+        meshMemoryUsage.mAdjacencyBytes += facePtr->adjacencyBytesAllocated();
+        AddAttributeBytes(*facePtr, &handleBytesVector,
+            &meshMemoryUsage.mUnusedAttributeBytes);
+
+        meshMemoryUsage.mFaceVertexBytes += facePtr->faceVertexBytesAllocated();
+        for (Face::FaceVertexVectorConstIterator iterator = facePtr->faceVertexVectorBegin();
+             iterator != facePtr->faceVertexVectorEnd(); ++iterator) {
+            if (*iterator != NULL) {
+                AddAttributeBytes(**iterator, &handleBytesVector,
+                    &meshMemoryUsage.mUnusedAttributeBytes);
+            }
+        }
+    }
+
+    for (size_t handle = 0; handle < handleBytesVector.size(); ++handle) {
+        if (handleBytesVector[handle] == 0) {
+            continue;
+        }
+        const std::string *name = NULL;
+        const AttributeKey *attributeKey = NULL;
+        if (!findAttributeNameAndKeyFromHandle(handle, &name, &attributeKey)) {
+            // The attribute's key has been erased from the mesh.
+            meshMemoryUsage.mAttributeBytesMap["(erased)"] += handleBytesVector[handle];
+            continue;
+        }
+        meshMemoryUsage.mAttributeBytesMap[*name] += handleBytesVector[handle];
+    }
+
+    return meshMemoryUsage;
+}
+
+static void
+AddAttributeBytes(const AttributePossessor &attributePossessor,
+    std::vector<size_t> *handleBytesVector, size_t *unusedAttributeBytes)
+{
+    for (AttributePossessor::const_iterator iterator = attributePossessor.attributeDataBegin();
+         iterator != attributePossessor.attributeDataEnd(); ++iterator) {
+        if ((*iterator).handle() >= handleBytesVector->size()) {
+            handleBytesVector->resize((*iterator).handle() + 1, 0);
+        }
+        (*handleBytesVector)[(*iterator).handle()]
+            += sizeof(AttributeData) + (*iterator).bytesAllocated();
+    }
+
+    *unusedAttributeBytes += (attributePossessor.attributeDataCapacity()
+        - attributePossessor.attributeDataCount())*sizeof(AttributeData);
+}
+
 } // namespace mesh
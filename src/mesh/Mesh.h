@@ -4,6 +4,7 @@
 #define MESH__MESH__INCLUDED
 
 #include <string>
+#include <vector>
 
 #include "Vertex.h"
 #include "Edge.h"
@@ -12,6 +13,7 @@
 #include "AttributePossessor.h"
 #include "AttributeKey.h"
 #include "AttributeKeyMap.h"
+#include "MeshMemoryUsage.h"
 
 namespace mesh {
 
@@ -21,6 +23,10 @@ namespace mesh {
 // representing a nonmanifold surface.
 //
 // Holes in polygons are not supported.
+//
+// The elements are stored in ElementLists, so each element also has
+// an index that may be used to keep data about it in an array,
+// and a handle that remains safe to look up after the element is destroyed.
 
 class Mesh : public AttributePossessor
 {
@@ -40,36 +46,71 @@ public:
     // Empty the mesh. The mesh is restored to the state of a newly created Mesh object.
     void clear();
 
+    // Rebuild the mesh's elements so that they're stored, indexed, and
+    // iterated over in the specified orders, in which each element of
+    // the mesh must appear exactly once. Attributes, adjacency, and all
+    // face vertex attributes, including those of vertices that aren't
+    // adjacent to their faces, are preserved. All VertexPtrs,
+    // EdgePtrs, FacePtrs, handles, and indices of the mesh's elements
+    // are invalidated.
+    void reorderElements(const std::vector<VertexPtr> &vertexPtrVector,
+        const std::vector<EdgePtr> &edgePtrVector,
+        const std::vector<FacePtr> &facePtrVector);
+
     // The file that the mesh was loaded from.
     void setFilename(const std::string &filename);
     const std::string &filename() const;
     
-    // Vertices.
+    // Vertices. The index of a vertex is less than vertexIndexLimit(),
+    // and doesn't change while the vertex exists, but it may be reused
+    // after the vertex is destroyed. findVertex returns vertexEnd()
+    // if the vertex that a handle refers to has been destroyed.
+    // reserveVertices allocates memory for the specified total number
+    // of vertices in advance.
+    // Edges and faces are accessed in the same way.
     VertexPtr createVertex();
+    void reserveVertices(VertexList::size_type count);
     void destroyVertex(VertexPtr vertexPtr);
     VertexPtr vertexBegin();
     VertexPtr vertexEnd();
     ConstVertexPtr vertexBegin() const;
     ConstVertexPtr vertexEnd() const;
     VertexList::size_type vertexCount() const;
+    unsigned vertexIndex(ConstVertexPtr vertexPtr) const;
+    unsigned vertexIndexLimit() const;
+    VertexHandle vertexHandle(ConstVertexPtr vertexPtr) const;
+    VertexPtr findVertex(const VertexHandle &vertexHandle);
+    ConstVertexPtr findVertex(const VertexHandle &vertexHandle) const;
 
     // Edges.
     EdgePtr createEdge();
+    void reserveEdges(EdgeList::size_type count);
     void destroyEdge(EdgePtr edgePtr);
     EdgePtr edgeBegin();
     EdgePtr edgeEnd();
     ConstEdgePtr edgeBegin() const;
     ConstEdgePtr edgeEnd() const;
     EdgeList::size_type edgeCount() const;
+    unsigned edgeIndex(ConstEdgePtr edgePtr) const;
+    unsigned edgeIndexLimit() const;
+    EdgeHandle edgeHandle(ConstEdgePtr edgePtr) const;
+    EdgePtr findEdge(const EdgeHandle &edgeHandle);
+    ConstEdgePtr findEdge(const EdgeHandle &edgeHandle) const;
 
     // Faces.
     FacePtr createFace();
+    void reserveFaces(FaceList::size_type count);
     void destroyFace(FacePtr facePtr);
     FacePtr faceBegin();
     FacePtr faceEnd();
     ConstFacePtr faceBegin() const;
     ConstFacePtr faceEnd() const;
     FaceList::size_type faceCount() const;
+    unsigned faceIndex(ConstFacePtr facePtr) const;
+    unsigned faceIndexLimit() const;
+    FaceHandle faceHandle(ConstFacePtr facePtr) const;
+    FacePtr findFace(const FaceHandle &faceHandle);
+    ConstFacePtr findFace(const FaceHandle &faceHandle) const;
 
     // Return an AttributeKey for the Mesh or any of its components.
     // Pass AttributeKey::TEMPORARY for the optional flags argument
@@ -93,6 +134,10 @@ public:
     AttributeKeyMap::const_iterator attributeKeyMapBegin() const;
     AttributeKeyMap::const_iterator attributeKeyMapEnd() const;
 
+    // The number of bytes occupied by the mesh's elements, adjacency,
+    // attributes, and face vertices. This walks the entire mesh.
+    MeshMemoryUsage memoryUsage() const;
+
 private:
     std::string mFilename;
     VertexList mVertexList;
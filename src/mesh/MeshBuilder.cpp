@@ -0,0 +1,181 @@
+// Copyright 2010 Drew Olbrich
+
+#include "MeshBuilder.h"
+
+#include <cassert>
+
+#include <cgmath/Vector2f.h>
+#include <cgmath/Vector3f.h>
+#include <cgmath/Vector4f.h>
+
+#include "Mesh.h"
+#include "FaceVertex.h"
+#include "MeshOperations.h"
+
+namespace mesh {
+
+MeshBuilder::MeshBuilder()
+    : mMesh(NULL),
+      mVertexCount(0),
+      mVertexPositionArray(NULL),
+      mFaceCount(0),
+      mFaceVertexCountArray(NULL),
+      mFaceVertexIndexArray(NULL),
+      mAttributeArrayVector(),
+      mVertexPtrVector(),
+      mEdgePtrVector(),
+      mFacePtrVector()
+{
+}
+
+MeshBuilder::~MeshBuilder()
+{
+}
+
+void
+MeshBuilder::setMesh(Mesh *mesh)
+{
+    mMesh = mesh;
+}
+
+Mesh *
+MeshBuilder::mesh() const
+{
+    return mMesh;
+}
+
+void
+MeshBuilder::setVertexPositionArray(unsigned vertexCount, const float *vertexPositionArray)
+{
+    mVertexCount = vertexCount;
+    mVertexPositionArray = vertexPositionArray;
+}
+
+void
+MeshBuilder::setFaceArray(unsigned faceCount, const unsigned *faceVertexCountArray,
+    const unsigned *faceVertexIndexArray)
+{
+    mFaceCount = faceCount;
+    mFaceVertexCountArray = faceVertexCountArray;
+    mFaceVertexIndexArray = faceVertexIndexArray;
+}
+
+void
+MeshBuilder::addFaceVertexAttributeArray(const AttributeKey &key, const float *valueArray)
+{
+    assert(key.type() == AttributeKey::FLOAT
+        || key.type() == AttributeKey::VECTOR2F
+        || key.type() == AttributeKey::VECTOR3F
+        || key.type() == AttributeKey::VECTOR4F
+        || key.type() == AttributeKey::UNIT_VECTOR3F);
+    assert(valueArray != NULL);
+
+    mAttributeArrayVector.push_back(std::make_pair(key, valueArray));
+}
+
+void
+MeshBuilder::build()
+{
+    assert(mMesh != NULL);
+    assert(mVertexCount == 0 || mVertexPositionArray != NULL);
+    assert(mFaceCount == 0 || mFaceVertexIndexArray != NULL);
+
+    mVertexPtrVector.clear();
+    mEdgePtrVector.clear();
+    mFacePtrVector.clear();
+
+    // Count the faces adjacent to each vertex, so that the vertices'
+    // face vectors can be reserved at their final size.
+    std::vector<unsigned> vertexFaceCountVector(mVertexCount, 0);
+    unsigned faceVertex = 0;
+    for (unsigned face = 0; face < mFaceCount; ++face) {
+        unsigned count = mFaceVertexCountArray != NULL ? mFaceVertexCountArray[face] : 3;
+        for (unsigned corner = 0; corner < count; ++corner) {
+            assert(mFaceVertexIndexArray[faceVertex] < mVertexCount);
+            ++vertexFaceCountVector[mFaceVertexIndexArray[faceVertex]];
+            ++faceVertex;
+        }
+    }
+
+    // Create the vertices.
+    mMesh->reserveVertices(mMesh->vertexCount() + mVertexCount);
+    mVertexPtrVector.reserve(mVertexCount);
+    for (unsigned vertex = 0; vertex < mVertexCount; ++vertex) {
+        VertexPtr vertexPtr = mMesh->createVertex();
+        vertexPtr->setPosition(cgmath::Vector3f(mVertexPositionArray + 3*vertex));
+        vertexPtr->reserveAdjacentFaces(vertexFaceCountVector[vertex]);
+        mVertexPtrVector.push_back(vertexPtr);
+    }
+
+    // Create the faces.
+    mMesh->reserveFaces(mMesh->faceCount() + mFaceCount);
+    mFacePtrVector.reserve(mFaceCount);
+    faceVertex = 0;
+    for (unsigned face = 0; face < mFaceCount; ++face) {
+        unsigned count = mFaceVertexCountArray != NULL ? mFaceVertexCountArray[face] : 3;
+        FacePtr facePtr = mMesh->createFace();
+        facePtr->reserveAdjacentVertices(count);
+        for (unsigned corner = 0; corner < count; ++corner) {
+            VertexPtr vertexPtr = mVertexPtrVector[mFaceVertexIndexArray[faceVertex]];
+            facePtr->addAdjacentVertex(vertexPtr);
+            vertexPtr->addAdjacentFace(facePtr);
+            if (!mAttributeArrayVector.empty()) {
+                setFaceVertexAttributes(faceVertex, facePtr->getCornerFaceVertex(corner));
+            }
+            ++faceVertex;
+        }
+        mFacePtrVector.push_back(facePtr);
+    }
+
+    CreateFaceEdges(mMesh, mFacePtrVector, &mEdgePtrVector);
+}
+
+const std::vector<VertexPtr> &
+MeshBuilder::vertexPtrVector() const
+{
+    return mVertexPtrVector;
+}
+
+const std::vector<FacePtr> &
+MeshBuilder::facePtrVector() const
+{
+    return mFacePtrVector;
+}
+
+const std::vector<EdgePtr> &
+MeshBuilder::edgePtrVector() const
+{
+    return mEdgePtrVector;
+}
+
+void
+MeshBuilder::setFaceVertexAttributes(unsigned faceVertex, FaceVertex *faceVertexPtr)
+{
+    for (unsigned index = 0; index < mAttributeArrayVector.size(); ++index) {
+        const AttributeKey &key = mAttributeArrayVector[index].first;
+        const float *valueArray = mAttributeArrayVector[index].second;
+        switch (key.type()) {
+        case AttributeKey::FLOAT:
+            faceVertexPtr->setFloat(key, valueArray[faceVertex]);
+            break;
+        case AttributeKey::VECTOR2F:
+            faceVertexPtr->setVector2f(key, cgmath::Vector2f(valueArray + 2*faceVertex));
+            break;
+        case AttributeKey::VECTOR3F:
+            faceVertexPtr->setVector3f(key, cgmath::Vector3f(valueArray + 3*faceVertex));
+            break;
+        case AttributeKey::VECTOR4F:
+            faceVertexPtr->setVector4f(key, cgmath::Vector4f(valueArray + 4*faceVertex));
+            break;
+        case AttributeKey::UNIT_VECTOR3F:
+            faceVertexPtr->setUnitVector3f(key,
+                cgmath::Vector3f(valueArray + 3*faceVertex));
+            break;
+        default:
+            assert(0);
+            break;
+        }
+    }
+}
+
+} // namespace mesh
@@ -0,0 +1,86 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__MESH_BUILDER__INCLUDED
+#define MESH__MESH_BUILDER__INCLUDED
+
+#include <vector>
+
+#include "Types.h"
+#include "AttributeKey.h"
+
+namespace mesh {
+
+class Mesh;
+class FaceVertex;
+
+// MeshBuilder
+//
+// Adds vertices, edges, and faces to a mesh from flat arrays of vertex
+// positions and face vertex indices, for loaders and generators that
+// know the elements they'll create in advance. All of the elements are
+// created in one pass, with their adjacency vectors reserved at their
+// exact sizes, and the edges are derived from the faces by CreateFaceEdges.
+//
+// The elements and their adjacency are in the same order as if each face
+// had been created in turn, and its edges created as they were first
+// encountered.
+
+class MeshBuilder
+{
+public:
+    MeshBuilder();
+    ~MeshBuilder();
+
+    // The mesh to add the elements to.
+    void setMesh(Mesh *mesh);
+    Mesh *mesh() const;
+
+    // The positions of the vertices, three floats per vertex.
+    void setVertexPositionArray(unsigned vertexCount, const float *vertexPositionArray);
+
+    // The faces. The face vertex index array lists the indices of the
+    // vertices of each face, one face after another. The face vertex count
+    // array holds the number of vertices of each face. If it is NULL,
+    // every face is a triangle.
+    void setFaceArray(unsigned faceCount, const unsigned *faceVertexCountArray,
+        const unsigned *faceVertexIndexArray);
+
+    // Optional face vertex attributes, with one value for each element
+    // of the face vertex index array. The key's type must be FLOAT,
+    // VECTOR2F, VECTOR3F, VECTOR4F, or UNIT_VECTOR3F, and the array
+    // holds the corresponding number of floats for each value.
+    void addFaceVertexAttributeArray(const AttributeKey &key, const float *valueArray);
+
+    // Create the elements and add them to the mesh.
+    void build();
+
+    // The created vertices and faces, in the order of the arrays.
+    const std::vector<VertexPtr> &vertexPtrVector() const;
+    const std::vector<FacePtr> &facePtrVector() const;
+
+    // The created edges, in the order they were first encountered
+    // around the faces.
+    const std::vector<EdgePtr> &edgePtrVector() const;
+
+private:
+    void setFaceVertexAttributes(unsigned faceVertex, FaceVertex *faceVertexPtr);
+
+    Mesh *mMesh;
+
+    unsigned mVertexCount;
+    const float *mVertexPositionArray;
+
+    unsigned mFaceCount;
+    const unsigned *mFaceVertexCountArray;
+    const unsigned *mFaceVertexIndexArray;
+
+    std::vector<std::pair<AttributeKey, const float *> > mAttributeArrayVector;
+
+    std::vector<VertexPtr> mVertexPtrVector;
+    std::vector<EdgePtr> mEdgePtrVector;
+    std::vector<FacePtr> mFacePtrVector;
+};
+
+} // namespace mesh
+
+#endif // MESH__MESH_BUILDER__INCLUDED
@@ -0,0 +1,60 @@
+// Copyright 2010 Drew Olbrich
+
+#include "MeshMemoryUsage.h"
+
+#include <sstream>
+
+namespace mesh {
+
+MeshMemoryUsage::MeshMemoryUsage()
+    : mVertexBytes(0),
+      mEdgeBytes(0),
+      mFaceBytes(0),
+      mAdjacencyBytes(0),
+      mAttributeBytesMap(),
+      mUnusedAttributeBytes(0),
+      mFaceVertexBytes(0)
+{
+}
+
+size_t
+MeshMemoryUsage::attributeBytes() const
+{
+    size_t bytes = 0;
+    for (AttributeBytesMap::const_iterator iterator = mAttributeBytesMap.begin();
+         iterator != mAttributeBytesMap.end(); ++iterator) {
+        bytes += (*iterator).second;
+    }
+
+    return bytes;
+}
+
+size_t
+MeshMemoryUsage::totalBytes() const
+{
+    return mVertexBytes + mEdgeBytes + mFaceBytes + mAdjacencyBytes
+        + attributeBytes() + mUnusedAttributeBytes + mFaceVertexBytes;
+}
+
+std::string
+MeshMemoryUsage::asString() const
+{
+    std::ostringstream ostr;
+
+    ostr << "Vertices: " << mVertexBytes << " bytes" << std::endl;
+    ostr << "Edges: " << mEdgeBytes << " bytes" << std::endl;
+    ostr << "Faces: " << mFaceBytes << " bytes" << std::endl;
+    ostr << "Adjacency: " << mAdjacencyBytes << " bytes" << std::endl;
+    for (AttributeBytesMap::const_iterator iterator = mAttributeBytesMap.begin();
+         iterator != mAttributeBytesMap.end(); ++iterator) {
+        ostr << "Attribute \"" << (*iterator).first << "\": "
+            << (*iterator).second << " bytes" << std::endl;
+    }
+    ostr << "Unused attribute slots: " << mUnusedAttributeBytes << " bytes" << std::endl;
+    ostr << "Face vertices: " << mFaceVertexBytes << " bytes" << std::endl;
+    ostr << "Total: " << totalBytes() << " bytes";
+
+    return ostr.str();
+}
+
+} // namespace mesh
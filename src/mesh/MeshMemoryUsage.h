@@ -0,0 +1,58 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__MESH_MEMORY_USAGE__INCLUDED
+#define MESH__MESH_MEMORY_USAGE__INCLUDED
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace mesh {
+
+// MeshMemoryUsage
+//
+// The number of bytes occupied by a mesh, broken down by what
+// they hold, as returned by Mesh::memoryUsage.
+//
+// The memory of the ElementLists themselves includes the adjacency
+// and attribute vectors that fit inside the elements. Each of the other
+// categories counts only memory allocated separately, so that none
+// of it is counted twice.
+
+struct MeshMemoryUsage {
+    MeshMemoryUsage();
+
+    // Bytes occupied by the ElementLists of vertices, edges, and faces.
+    size_t mVertexBytes;
+    size_t mEdgeBytes;
+    size_t mFaceBytes;
+
+    // Bytes of adjacency vectors too large to fit inside their elements.
+    size_t mAdjacencyBytes;
+
+    // Bytes of the AttributeData objects of each attribute, including
+    // the attributes of the mesh and of face vertices, and of the values
+    // allocated separately from them, by attribute name.
+    typedef std::map<std::string, size_t> AttributeBytesMap;
+    AttributeBytesMap mAttributeBytesMap;
+
+    // Bytes of attribute vectors that are reserved but not used.
+    size_t mUnusedAttributeBytes;
+
+    // Bytes of FaceVertex objects, and of face vertex vectors too large
+    // to fit inside their faces.
+    size_t mFaceVertexBytes;
+
+    // The total of all the attributes in mAttributeBytesMap.
+    size_t attributeBytes() const;
+
+    // The total of all the categories.
+    size_t totalBytes() const;
+
+    // A string describing the memory usage, one category per line.
+    std::string asString() const;
+};
+
+} // namespace mesh
+
+#endif // MESH__MESH_MEMORY_USAGE__INCLUDED
@@ -3,8 +3,11 @@
 #include "MeshOperations.h"
 
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 #include <cgmath/Matrix4f.h>
+#include <cgmath/BoundingBox3fOperations.h>
 
 #include "Mesh.h"
 #include "VertexOperations.h"
@@ -72,6 +75,233 @@ DeleteOrphanedFaces(Mesh *mesh)
     }
 }
 
+void
+CreateFaceEdges(Mesh *mesh, const std::vector<FacePtr> &facePtrVector,
+    std::vector<EdgePtr> *edgePtrVector)
+{
+    // Number the face vertices of the faces that don't have edges,
+    // one face after another.
+    std::vector<unsigned> faceOffsetVector(facePtrVector.size() + 1, 0);
+    for (unsigned index = 0; index < facePtrVector.size(); ++index) {
+        ConstFacePtr facePtr = facePtrVector[index];
+        unsigned count = 0;
+        if (facePtr->adjacentEdgeCount() == 0) {
+            count = facePtr->adjacentVertexCount();
+        }
+        faceOffsetVector[index + 1] = faceOffsetVector[index] + count;
+    }
+    unsigned faceVertexCount = faceOffsetVector.back();
+
+    // Sort the pairs of vertex indices spanned by each face vertex
+    // and the face vertex that follows it. The face vertex number
+    // breaks ties, so the first face vertex to span each pair
+    // of vertices comes first.
+    typedef std::pair<std::pair<unsigned, unsigned>, unsigned> VertexPairRecord;
+    std::vector<VertexPairRecord> recordVector;
+    recordVector.reserve(faceVertexCount);
+    for (unsigned index = 0; index < facePtrVector.size(); ++index) {
+        ConstFacePtr facePtr = facePtrVector[index];
+        unsigned count = faceOffsetVector[index + 1] - faceOffsetVector[index];
+        for (unsigned corner = 0; corner < count; ++corner) {
+            unsigned v0 = mesh->vertexIndex(facePtr->cornerVertexPtr(corner));
+            unsigned v1 = mesh->vertexIndex(facePtr->cornerVertexPtr(
+                    corner + 1 < count ? corner + 1 : 0));
+            recordVector.push_back(std::make_pair(
+                    std::make_pair(std::min(v0, v1), std::max(v0, v1)),
+                    faceOffsetVector[index] + corner));
+        }
+    }
+    std::sort(recordVector.begin(), recordVector.end());
+
+    // Each run of equal vertex pairs becomes one edge.
+    std::vector<unsigned> faceVertexEdgeVector(faceVertexCount);
+    std::vector<unsigned> edgeFirstFaceVertexVector;
+    std::vector<unsigned> edgeFaceCountVector;
+    for (unsigned index = 0; index < recordVector.size(); ++index) {
+        if (index == 0 
+            || recordVector[index].first != recordVector[index - 1].first) {
+            edgeFirstFaceVertexVector.push_back(recordVector[index].second);
+            edgeFaceCountVector.push_back(0);
+        }
+        faceVertexEdgeVector[recordVector[index].second] 
+            = edgeFirstFaceVertexVector.size() - 1;
+        ++edgeFaceCountVector.back();
+    }
+    std::vector<VertexPairRecord>().swap(recordVector);
+    unsigned edgeCount = edgeFirstFaceVertexVector.size();
+
+    // Visit the edges in the order they're first encountered around
+    // the faces, reusing existing edges, and counting the new edges
+    // of each vertex.
+    std::vector<EdgePtr> edgeNumberEdgePtrVector(edgeCount, mesh->edgeEnd());
+    std::vector<unsigned> newEdgeNumberVector;
+    std::vector<unsigned> vertexNewEdgeCountVector(mesh->vertexIndexLimit(), 0);
+    for (unsigned index = 0; index < facePtrVector.size(); ++index) {
+        ConstFacePtr facePtr = facePtrVector[index];
+        unsigned count = faceOffsetVector[index + 1] - faceOffsetVector[index];
+        for (unsigned corner = 0; corner < count; ++corner) {
+            unsigned faceVertex = faceOffsetVector[index] + corner;
+            unsigned edgeNumber = faceVertexEdgeVector[faceVertex];
+            if (edgeFirstFaceVertexVector[edgeNumber] != faceVertex) {
+                continue;
+            }
+
+            VertexPtr v0 = facePtr->cornerVertexPtr(corner);
+            VertexPtr v1 = facePtr->cornerVertexPtr(corner + 1 < count ? corner + 1 : 0);
+            AdjacentEdgeIterator iterator = v0->findAdjacentEdgeByVertex(v1);
+            if (iterator != v0->adjacentEdgeEnd()) {
+                edgeNumberEdgePtrVector[edgeNumber] = *iterator;
+            } else {
+                newEdgeNumberVector.push_back(edgeNumber);
+                ++vertexNewEdgeCountVector[mesh->vertexIndex(v0)];
+                ++vertexNewEdgeCountVector[mesh->vertexIndex(v1)];
+            }
+        }
+    }
+
+    // Create the new edges.
+    mesh->reserveEdges(mesh->edgeCount() + newEdgeNumberVector.size());
+    if (edgePtrVector != NULL) {
+        edgePtrVector->reserve(edgePtrVector->size() + newEdgeNumberVector.size());
+    }
+    for (unsigned index = 0; index < newEdgeNumberVector.size(); ++index) {
+        unsigned edgeNumber = newEdgeNumberVector[index];
+
+        // Find the face vertex that first spans the edge's vertices,
+        // so the edge's vertices are in the same order as that face's.
+        unsigned faceVertex = edgeFirstFaceVertexVector[edgeNumber];
+        unsigned faceIndex = std::upper_bound(faceOffsetVector.begin(),
+            faceOffsetVector.end(), faceVertex) - faceOffsetVector.begin() - 1;
+        FacePtr facePtr = facePtrVector[faceIndex];
+        unsigned count = faceOffsetVector[faceIndex + 1] - faceOffsetVector[faceIndex];
+        unsigned corner = faceVertex - faceOffsetVector[faceIndex];
+        VertexPtr v0 = facePtr->cornerVertexPtr(corner);
+        VertexPtr v1 = facePtr->cornerVertexPtr(corner + 1 < count ? corner + 1 : 0);
+
+        EdgePtr edgePtr = mesh->createEdge();
+        edgePtr->addAdjacentVertex(v0);
+        edgePtr->addAdjacentVertex(v1);
+        edgePtr->reserveAdjacentFaces(edgeFaceCountVector[edgeNumber]);
+
+        // Reserve room for all of a vertex's new edges
+        // when the first one is added.
+        unsigned &v0Count = vertexNewEdgeCountVector[mesh->vertexIndex(v0)];
+        if (v0Count > 0) {
+            v0->reserveAdjacentEdges(v0->adjacentEdgeCount() + v0Count);
+            v0Count = 0;
+        }
+        v0->addAdjacentEdge(edgePtr);
+        unsigned &v1Count = vertexNewEdgeCountVector[mesh->vertexIndex(v1)];
+        if (v1Count > 0) {
+            v1->reserveAdjacentEdges(v1->adjacentEdgeCount() + v1Count);
+            v1Count = 0;
+        }
+        v1->addAdjacentEdge(edgePtr);
+
+        edgeNumberEdgePtrVector[edgeNumber] = edgePtr;
+        if (edgePtrVector != NULL) {
+            edgePtrVector->push_back(edgePtr);
+        }
+    }
+
+    // Connect the edges to the faces.
+    for (unsigned index = 0; index < facePtrVector.size(); ++index) {
+        FacePtr facePtr = facePtrVector[index];
+        unsigned count = faceOffsetVector[index + 1] - faceOffsetVector[index];
+        facePtr->reserveAdjacentEdges(count);
+        for (unsigned corner = 0; corner < count; ++corner) {
+            EdgePtr edgePtr = edgeNumberEdgePtrVector[
+                faceVertexEdgeVector[faceOffsetVector[index] + corner]];
+            edgePtr->addAdjacentFace(facePtr);
+            facePtr->addAdjacentEdge(edgePtr);
+        }
+    }
+}
+
+void
+SortElementsAlongMortonCurve(Mesh *mesh)
+{
+    cgmath::BoundingBox3f bbox = ComputeBoundingBox(*mesh);
+
+    // Each element is sorted by its Morton code and then by its position
+    // in the mesh's current order.
+    typedef std::pair<unsigned, unsigned> SortKey;
+
+    std::vector<VertexPtr> vertexPtrVector;
+    std::vector<SortKey> vertexSortKeyVector;
+    vertexPtrVector.reserve(mesh->vertexCount());
+    vertexSortKeyVector.reserve(mesh->vertexCount());
+    for (VertexPtr vertexPtr = mesh->vertexBegin();
+         vertexPtr != mesh->vertexEnd(); ++vertexPtr) {
+        vertexSortKeyVector.push_back(SortKey(
+                cgmath::GetMortonCode(vertexPtr->position(), bbox),
+                vertexPtrVector.size()));
+        vertexPtrVector.push_back(vertexPtr);
+    }
+
+    std::vector<EdgePtr> edgePtrVector;
+    std::vector<SortKey> edgeSortKeyVector;
+    edgePtrVector.reserve(mesh->edgeCount());
+    edgeSortKeyVector.reserve(mesh->edgeCount());
+    for (EdgePtr edgePtr = mesh->edgeBegin();
+         edgePtr != mesh->edgeEnd(); ++edgePtr) {
+        cgmath::Vector3f centroid = cgmath::Vector3f::ZERO;
+        for (AdjacentVertexIterator iterator = edgePtr->adjacentVertexBegin();
+             iterator != edgePtr->adjacentVertexEnd(); ++iterator) {
+            centroid += (*iterator)->position();
+        }
+        if (edgePtr->adjacentVertexCount() > 0) {
+            centroid /= edgePtr->adjacentVertexCount();
+        }
+        edgeSortKeyVector.push_back(SortKey(
+                cgmath::GetMortonCode(centroid, bbox), edgePtrVector.size()));
+        edgePtrVector.push_back(edgePtr);
+    }
+
+    std::vector<FacePtr> facePtrVector;
+    std::vector<SortKey> faceSortKeyVector;
+    facePtrVector.reserve(mesh->faceCount());
+    faceSortKeyVector.reserve(mesh->faceCount());
+    for (FacePtr facePtr = mesh->faceBegin();
+         facePtr != mesh->faceEnd(); ++facePtr) {
+        cgmath::Vector3f centroid = cgmath::Vector3f::ZERO;
+        for (AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            centroid += (*iterator)->position();
+        }
+        if (facePtr->adjacentVertexCount() > 0) {
+            centroid /= facePtr->adjacentVertexCount();
+        }
+        faceSortKeyVector.push_back(SortKey(
+                cgmath::GetMortonCode(centroid, bbox), facePtrVector.size()));
+        facePtrVector.push_back(facePtr);
+    }
+
+    std::sort(vertexSortKeyVector.begin(), vertexSortKeyVector.end());
+    std::sort(edgeSortKeyVector.begin(), edgeSortKeyVector.end());
+    std::sort(faceSortKeyVector.begin(), faceSortKeyVector.end());
+
+    std::vector<VertexPtr> sortedVertexPtrVector;
+    sortedVertexPtrVector.reserve(vertexPtrVector.size());
+    for (size_t index = 0; index < vertexSortKeyVector.size(); ++index) {
+        sortedVertexPtrVector.push_back(vertexPtrVector[vertexSortKeyVector[index].second]);
+    }
+
+    std::vector<EdgePtr> sortedEdgePtrVector;
+    sortedEdgePtrVector.reserve(edgePtrVector.size());
+    for (size_t index = 0; index < edgeSortKeyVector.size(); ++index) {
+        sortedEdgePtrVector.push_back(edgePtrVector[edgeSortKeyVector[index].second]);
+    }
+
+    std::vector<FacePtr> sortedFacePtrVector;
+    sortedFacePtrVector.reserve(facePtrVector.size());
+    for (size_t index = 0; index < faceSortKeyVector.size(); ++index) {
+        sortedFacePtrVector.push_back(facePtrVector[faceSortKeyVector[index].second]);
+    }
+
+    mesh->reorderElements(sortedVertexPtrVector, sortedEdgePtrVector, sortedFacePtrVector);
+}
+
 void
 Transform(Mesh *mesh, const cgmath::Matrix4f &matrix)
 {
@@ -159,4 +389,42 @@ AllFacesAreTriangles(const Mesh &mesh)
     return true;
 }
 
+// Add a 32-bit value to a 64-bit FNV-1a hash, one byte at a time.
+static void
+AddToGeometryHash(uint64_t *hash, uint32_t value)
+{
+    // The FNV prime, 0x100000001b3, assembled from 32-bit halves,
+    // because 64-bit literals aren't part of C++98.
+    const uint64_t prime = (uint64_t(0x00000100) << 32) | uint64_t(0x000001b3);
+
+    for (unsigned byte = 0; byte < 4; ++byte) {
+        *hash ^= (value >> byte*8) & 0xff;
+        *hash *= prime;
+    }
+}
+
+uint64_t
+ComputeGeometryHash(const Mesh &mesh)
+{
+    // The FNV offset basis, 0xcbf29ce484222325.
+    uint64_t hash = (uint64_t(0xcbf29ce4) << 32) | uint64_t(0x84222325);
+
+    AddToGeometryHash(&hash, mesh.faceCount());
+    for (ConstFacePtr facePtr = mesh.faceBegin(); facePtr != mesh.faceEnd(); ++facePtr) {
+        AddToGeometryHash(&hash, facePtr->adjacentVertexCount());
+        for (AdjacentVertexConstIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            const cgmath::Vector3f &position = (*iterator)->position();
+            for (unsigned axis = 0; axis < 3; ++axis) {
+                float coordinate = position[axis];
+                uint32_t bits;
+                std::memcpy(&bits, &coordinate, sizeof(bits));
+                AddToGeometryHash(&hash, bits);
+            }
+        }
+    }
+
+    return hash;
+}
+
 } // namespace mesh
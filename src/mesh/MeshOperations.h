@@ -3,6 +3,9 @@
 #ifndef MESH__MESH_OPERATIONS__INCLUDED
 #define MESH__MESH_OPERATIONS__INCLUDED
 
+#include <stdint.h>
+#include <vector>
+
 #include "Types.h"
 #include "AttributeKey.h"
 
@@ -26,6 +29,25 @@ void DeleteOrphanedEdges(Mesh *mesh);
 // Delete all faces in the mesh that have no adjacent vertices or edges.
 void DeleteOrphanedFaces(Mesh *mesh);
 
+// Create the edges of faces that have vertices but no edges yet.
+// An edge is created between each pair of consecutive vertices around
+// each face, and faces that share a pair of vertices share the edge.
+// Existing edges between the vertices are reused. The vertex pairs
+// are matched by sorting them, rather than by searching the vertices'
+// adjacent edges, and the adjacency vectors are reserved with their
+// exact sizes. If edgePtrVector is not NULL, the created edges are
+// appended to it in the order they were encountered around the faces.
+void CreateFaceEdges(Mesh *mesh, const std::vector<FacePtr> &facePtrVector,
+    std::vector<EdgePtr> *edgePtrVector);
+
+// Reorder the vertices, edges, and faces of a mesh along a Morton curve
+// through the mesh's bounding box, by the positions of the vertices and
+// the centroids of the edges and faces, so that elements that are near
+// each other in space are also near each other in memory. Elements
+// with the same Morton code keep their relative order.
+// See Mesh::reorderElements.
+void SortElementsAlongMortonCurve(Mesh *mesh);
+
 // Transform a mesh by a transformation matrix.
 // Normals are transformed by the inverse transpose of the matrix.
 void Transform(Mesh *mesh, const cgmath::Matrix4f &matrix);
@@ -40,6 +62,12 @@ cgmath::BoundingBox3f ComputeBoundingBox(const Mesh &mesh);
 // Returns true if all of the mesh's faces are triangles.
 bool AllFacesAreTriangles(const Mesh &mesh);
 
+// Compute a 64-bit hash of the positions of the vertices of each of
+// the mesh's faces, in order. Meshes with the same hash almost certainly
+// have identical face geometry, so data derived from the geometry of one,
+// like an AABB tree of its faces, can be reused with the other.
+uint64_t ComputeGeometryHash(const Mesh &mesh);
+
 } // namespace mesh
 
 #endif // MESH__MESH_OPERATIONS__INCLUDED
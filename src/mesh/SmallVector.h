@@ -0,0 +1,312 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__SMALL_VECTOR__INCLUDED
+#define MESH__SMALL_VECTOR__INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+namespace mesh {
+
+// SmallVector
+//
+// The container used by the mesh elements to keep track of their
+// adjacent elements. It behaves like the subset of std::vector
+// that the elements rely on, except that up to N elements are stored
+// inside the SmallVector itself, so memory is only allocated when
+// an element has more adjacent elements than usual.
+//
+// Iterators are plain pointers, so SmallVectors with different inline
+// capacities have the same iterator types. As with std::vector,
+// iterators are invalidated when elements are inserted or erased.
+//
+// T must be default constructible and assignable. The elements beyond
+// size() are default constructed values that aren't used.
+
+template<typename T, unsigned N>
+class SmallVector
+{
+public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef unsigned size_type;
+
+    SmallVector();
+    SmallVector(const SmallVector &rhs);
+    ~SmallVector();
+
+    SmallVector &operator=(const SmallVector &rhs);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    reverse_iterator rbegin();
+    reverse_iterator rend();
+    const_reverse_iterator rbegin() const;
+    const_reverse_iterator rend() const;
+
+    size_type size() const;
+    bool empty() const;
+
+    // The number of elements that can be stored without
+    // allocating more memory.
+    size_type capacity() const;
+
+    // Returns true if the elements are stored inside the SmallVector,
+    // rather than in separately allocated memory.
+    bool isInline() const;
+
+    // The number of bytes of separately allocated memory,
+    // which is zero while the elements are stored inline.
+    size_t bytesAllocated() const;
+
+    T &operator[](size_type index);
+    const T &operator[](size_type index) const;
+
+    void push_back(const T &value);
+    iterator insert(iterator position, const T &value);
+    iterator erase(iterator position);
+
+    // Remove all elements. Memory that was allocated is released.
+    void clear();
+
+    // Ensure that at least the specified number of elements can
+    // be stored without allocating more memory.
+    void reserve(size_type capacity);
+
+private:
+    T *mData;
+    size_type mSize;
+    size_type mCapacity;
+    T mInlineArray[N];
+};
+
+template<typename T, unsigned N>
+SmallVector<T, N>::SmallVector()
+    : mData(mInlineArray),
+      mSize(0),
+      mCapacity(N)
+{
+}
+
+template<typename T, unsigned N>
+SmallVector<T, N>::SmallVector(const SmallVector &rhs)
+    : mData(mInlineArray),
+      mSize(0),
+      mCapacity(N)
+{
+    reserve(rhs.mSize);
+    std::copy(rhs.begin(), rhs.end(), mData);
+    mSize = rhs.mSize;
+}
+
+template<typename T, unsigned N>
+SmallVector<T, N>::~SmallVector()
+{
+    if (mData != mInlineArray) {
+        delete [] mData;
+    }
+}
+
+template<typename T, unsigned N>
+SmallVector<T, N> &
+SmallVector<T, N>::operator=(const SmallVector &rhs)
+{
+    if (this != &rhs) {
+        mSize = 0;
+        reserve(rhs.mSize);
+        std::copy(rhs.begin(), rhs.end(), mData);
+        mSize = rhs.mSize;
+    }
+
+    return *this;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::iterator
+SmallVector<T, N>::begin()
+{
+    return mData;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::iterator
+SmallVector<T, N>::end()
+{
+    return mData + mSize;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::const_iterator
+SmallVector<T, N>::begin() const
+{
+    return mData;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::const_iterator
+SmallVector<T, N>::end() const
+{
+    return mData + mSize;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::reverse_iterator
+SmallVector<T, N>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::reverse_iterator
+SmallVector<T, N>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::rbegin() const
+{
+    return const_reverse_iterator(end());
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::rend() const
+{
+    return const_reverse_iterator(begin());
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::size_type
+SmallVector<T, N>::size() const
+{
+    return mSize;
+}
+
+template<typename T, unsigned N>
+bool
+SmallVector<T, N>::empty() const
+{
+    return mSize == 0;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::size_type
+SmallVector<T, N>::capacity() const
+{
+    return mCapacity;
+}
+
+template<typename T, unsigned N>
+bool
+SmallVector<T, N>::isInline() const
+{
+    return mData == mInlineArray;
+}
+
+template<typename T, unsigned N>
+size_t
+SmallVector<T, N>::bytesAllocated() const
+{
+    return isInline() ? 0 : mCapacity*sizeof(T);
+}
+
+template<typename T, unsigned N>
+T &
+SmallVector<T, N>::operator[](size_type index)
+{
+    assert(index < mSize);
+
+    return mData[index];
+}
+
+template<typename T, unsigned N>
+const T &
+SmallVector<T, N>::operator[](size_type index) const
+{
+    assert(index < mSize);
+
+    return mData[index];
+}
+
+template<typename T, unsigned N>
+void
+SmallVector<T, N>::push_back(const T &value)
+{
+    insert(end(), value);
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::iterator
+SmallVector<T, N>::insert(iterator position, const T &value)
+{
+    assert(position >= begin() && position <= end());
+
+    // The value is copied first, because it may be one of the elements
+    // that is about to be moved.
+    T copy(value);
+    size_type index = position - mData;
+
+    if (mSize == mCapacity) {
+        reserve(2*mCapacity);
+    }
+
+    std::copy_backward(mData + index, mData + mSize, mData + mSize + 1);
+    mData[index] = copy;
+    ++mSize;
+
+    return mData + index;
+}
+
+template<typename T, unsigned N>
+typename SmallVector<T, N>::iterator
+SmallVector<T, N>::erase(iterator position)
+{
+    assert(position >= begin() && position < end());
+
+    std::copy(position + 1, end(), position);
+    --mSize;
+
+    return position;
+}
+
+template<typename T, unsigned N>
+void
+SmallVector<T, N>::clear()
+{
+    if (mData != mInlineArray) {
+        delete [] mData;
+        mData = mInlineArray;
+        mCapacity = N;
+    }
+    mSize = 0;
+}
+
+template<typename T, unsigned N>
+void
+SmallVector<T, N>::reserve(size_type capacity)
+{
+    if (capacity <= mCapacity) {
+        return;
+    }
+
+    T *data = new T[capacity];
+    std::copy(begin(), end(), data);
+    if (mData != mInlineArray) {
+        delete [] mData;
+    }
+    mData = data;
+    mCapacity = capacity;
+}
+
+} // namespace mesh
+
+#endif // MESH__SMALL_VECTOR__INCLUDED
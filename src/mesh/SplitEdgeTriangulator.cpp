@@ -71,7 +71,6 @@ SplitEdgeTriangulator::triangulate()
 
     // Put all the untriangulated faces in a vector, so we can loop over them again later
     // as new faces are being created without worrying about invalidated iterators.
-    typedef std::vector<FacePtr> FacePtrVector;
     FacePtrVector facePtrVector;
     for (FacePtr facePtr = mMesh->faceBegin(); 
          facePtr != mMesh->faceEnd(); ++facePtr) {
@@ -85,7 +84,7 @@ SplitEdgeTriangulator::triangulate()
     for (FacePtrVector::iterator iterator = facePtrVector.begin();
          iterator != facePtrVector.end(); ++iterator) {
         FacePtr facePtr = *iterator;
-        triangulateFace(facePtr);
+        triangulateFace(facePtr, NULL);
     }
 
     // Remove the split edge vertex attribute from all the vertices
@@ -94,7 +93,44 @@ SplitEdgeTriangulator::triangulate()
 }
 
 void
-SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
+SplitEdgeTriangulator::triangulateFaces(const FacePtrVector &facePtrVector,
+    FacePtrVector *newFacePtrVector)
+{
+    assert(mMesh != NULL);
+    assert(mSplitEdgeVertexAttributeKey.isDefined());
+
+    // Every split edge vertex is adjacent to one of the faces,
+    // so this finds all the vertices whose attribute must be removed.
+    typedef std::vector<VertexPtr> VertexPtrVector;
+    VertexPtrVector splitEdgeVertexPtrVector;
+
+    for (FacePtrVector::const_iterator iterator = facePtrVector.begin();
+         iterator != facePtrVector.end(); ++iterator) {
+        FacePtr facePtr = *iterator;
+        if (facePtr->adjacentVertexCount() <= 3) {
+            continue;
+        }
+
+        for (AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            VertexPtr vertexPtr = *iterator;
+            if (vertexPtr->getBool(mSplitEdgeVertexAttributeKey)) {
+                splitEdgeVertexPtrVector.push_back(vertexPtr);
+            }
+        }
+
+        triangulateFace(facePtr, newFacePtrVector);
+    }
+
+    for (VertexPtrVector::const_iterator iterator = splitEdgeVertexPtrVector.begin();
+         iterator != splitEdgeVertexPtrVector.end(); ++iterator) {
+        VertexPtr vertexPtr = *iterator;
+        vertexPtr->eraseAttribute(mSplitEdgeVertexAttributeKey);
+    }
+}
+
+void
+SplitEdgeTriangulator::triangulateFace(FacePtr facePtr, FacePtrVector *newFacePtrVector)
 {
     // We're assuming that the face was a triangle and one to three of its
     // edges have been split.
@@ -139,8 +175,7 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
     }
 
     // Vector of new faces that are created by this function.
-    typedef std::vector<FacePtr> FacePtrVector;
-    FacePtrVector newFacePtrVector;
+    FacePtrVector createdFacePtrVector;
 
     // There are three cases.
     switch (facePtr->adjacentVertexCount()) {
@@ -153,10 +188,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
             // 4-------2
             assert(vertexPtrArray[3] == mMesh->vertexEnd());
             assert(vertexPtrArray[5] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[4], vertexPtrArray[0], vertexPtrArray[1]));
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[1], vertexPtrArray[2], vertexPtrArray[4]));
         } else if (vertexPtrArray[3] != mMesh->vertexEnd()) {
@@ -167,10 +202,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
             // 4---3---2
             assert(vertexPtrArray[1] == mMesh->vertexEnd());
             assert(vertexPtrArray[5] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[2], vertexPtrArray[3], vertexPtrArray[0]));
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[3], vertexPtrArray[4], vertexPtrArray[0]));
         } else {
@@ -182,10 +217,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
             assert(vertexPtrArray[5] != mMesh->vertexEnd());
             assert(vertexPtrArray[1] == mMesh->vertexEnd());
             assert(vertexPtrArray[3] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[2], vertexPtrArray[5], vertexPtrArray[0]));
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[4], vertexPtrArray[5], vertexPtrArray[2]));
         }
@@ -194,7 +229,7 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
         if (vertexPtrArray[1] != mMesh->vertexEnd()
             && vertexPtrArray[3] != mMesh->vertexEnd()) {
             assert(vertexPtrArray[5] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[1], vertexPtrArray[2], vertexPtrArray[3]));
             if ((vertexPtrArray[4]->position() - vertexPtrArray[1]->position()).length()
@@ -204,10 +239,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   / __1
                 //  /_/ / \ .
                 // 4---3---2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[0], vertexPtrArray[1], vertexPtrArray[4]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[1], vertexPtrArray[3], vertexPtrArray[4]));
             } else {
@@ -216,17 +251,17 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   / | 1
                 //  /  |/ \ .
                 // 4---3---2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[0], vertexPtrArray[1], vertexPtrArray[3]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[0], vertexPtrArray[3], vertexPtrArray[4]));
             }
         } else if (vertexPtrArray[3] != mMesh->vertexEnd()
             && vertexPtrArray[5] != mMesh->vertexEnd()) {
             assert(vertexPtrArray[1] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[5], vertexPtrArray[3], vertexPtrArray[4]));
             if ((vertexPtrArray[5]->position() - vertexPtrArray[2]->position()).length()
@@ -236,10 +271,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   5__ \  .
                 //  / \ \_\ .
                 // 4---3---2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[0], vertexPtrArray[2], vertexPtrArray[5]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[2], vertexPtrArray[3], vertexPtrArray[5]));
             } else {
@@ -248,10 +283,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   5 | \  .
                 //  / \|  \ .
                 // 4---3---2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[0], vertexPtrArray[3], vertexPtrArray[5]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[2], vertexPtrArray[3], vertexPtrArray[0]));
             }
@@ -259,7 +294,7 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
             assert(vertexPtrArray[5] != mMesh->vertexEnd());
             assert(vertexPtrArray[1] != mMesh->vertexEnd());
             assert(vertexPtrArray[3] == mMesh->vertexEnd());
-            newFacePtrVector.push_back(
+            createdFacePtrVector.push_back(
                 CreateTriangularFaceAndEdgesFromVertices(mMesh,
                     vertexPtrArray[0], vertexPtrArray[1], vertexPtrArray[5]));
             if ((vertexPtrArray[5]->position() - vertexPtrArray[2]->position()).length()
@@ -269,10 +304,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   5---1
                 //  / \___\ .
                 // 4-------2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[1], vertexPtrArray[2], vertexPtrArray[5]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[2], vertexPtrArray[4], vertexPtrArray[5]));
             } else {
@@ -281,10 +316,10 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
                 //   5---1
                 //  /___/ \ .
                 // 4-------2
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[5], vertexPtrArray[1], vertexPtrArray[4]));
-                newFacePtrVector.push_back(
+                createdFacePtrVector.push_back(
                     CreateTriangularFaceAndEdgesFromVertices(mMesh,
                         vertexPtrArray[1], vertexPtrArray[2], vertexPtrArray[4]));
             }
@@ -296,24 +331,24 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
         //   5---1
         //  / \ / \ .
         // 4---3---2
-        newFacePtrVector.push_back(
+        createdFacePtrVector.push_back(
             CreateTriangularFaceAndEdgesFromVertices(mMesh,
                 vertexPtrArray[1], vertexPtrArray[5], vertexPtrArray[0]));
-        newFacePtrVector.push_back(
+        createdFacePtrVector.push_back(
             CreateTriangularFaceAndEdgesFromVertices(mMesh,
                 vertexPtrArray[3], vertexPtrArray[4], vertexPtrArray[5]));
-        newFacePtrVector.push_back(
+        createdFacePtrVector.push_back(
             CreateTriangularFaceAndEdgesFromVertices(mMesh,
                 vertexPtrArray[1], vertexPtrArray[2], vertexPtrArray[3]));
-        newFacePtrVector.push_back(
+        createdFacePtrVector.push_back(
             CreateTriangularFaceAndEdgesFromVertices(mMesh,
                 vertexPtrArray[3], vertexPtrArray[5], vertexPtrArray[1]));
         break;
     }
 
     // Copy all attributes from the old face to the new faces.
-    for (FacePtrVector::iterator iterator = newFacePtrVector.begin();
-         iterator != newFacePtrVector.end(); ++iterator) {
+    for (FacePtrVector::iterator iterator = createdFacePtrVector.begin();
+         iterator != createdFacePtrVector.end(); ++iterator) {
         FacePtr newFacePtr = *iterator;
         newFacePtr->copyAttributes(*facePtr);
     }
@@ -322,8 +357,8 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
     for (AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
          iterator != facePtr->adjacentVertexEnd(); ++iterator) {
         VertexPtr vertexPtr = *iterator;
-        for (FacePtrVector::iterator iterator = newFacePtrVector.begin();
-             iterator != newFacePtrVector.end(); ++iterator) {
+        for (FacePtrVector::iterator iterator = createdFacePtrVector.begin();
+             iterator != createdFacePtrVector.end(); ++iterator) {
             FacePtr newFacePtr = *iterator;
             if (newFacePtr->hasAdjacentVertex(vertexPtr)) {
                 if (facePtr->hasFaceVertex(vertexPtr)) {
@@ -334,6 +369,11 @@ SplitEdgeTriangulator::triangulateFace(FacePtr facePtr)
         }
     }
 
+    if (newFacePtrVector != NULL) {
+        newFacePtrVector->insert(newFacePtrVector->end(), createdFacePtrVector.begin(),
+            createdFacePtrVector.end());
+    }
+
     // Delete the original face from the mesh.
     DeleteFace(mMesh, facePtr, mElementTracker);
 }
@@ -3,6 +3,8 @@
 #ifndef MESH__SPLIT_EDGE_TRIANGULATOR__INCLUDED
 #define MESH__SPLIT_EDGE_TRIANGULATOR__INCLUDED
 
+#include <vector>
+
 #include "Types.h"
 #include "AttributeKey.h"
 
@@ -46,8 +48,16 @@ public:
     // Triangulate the mesh.
     void triangulate();
 
+    // Triangulate only the specified faces, which must include all the faces
+    // adjacent to split edges. Faces that are already triangles are ignored.
+    // If newFacePtrVector is not NULL, the faces that are created are appended to it.
+    // This avoids visiting the entire mesh when only a few edges were split.
+    typedef std::vector<FacePtr> FacePtrVector;
+    void triangulateFaces(const FacePtrVector &facePtrVector,
+        FacePtrVector *newFacePtrVector);
+
 private:
-    void triangulateFace(FacePtr facePtr);
+    void triangulateFace(FacePtr facePtr, FacePtrVector *newFacePtrVector);
 
     Mesh *mMesh;
     DeletedElementTracker *mElementTracker;
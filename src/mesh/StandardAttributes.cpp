@@ -74,6 +74,36 @@ GetTextureIndexAttributeKey(const Mesh &mesh)
         AttributeKey::INT, AttributeKey::STANDARD);
 }
 
+TypedAttributeKey<cgmath::Vector2f>
+GetTexCoord2fTypedAttributeKey(const Mesh &mesh)
+{
+    return TypedAttributeKey<cgmath::Vector2f>(GetTexCoord2fAttributeKey(mesh));
+}
+
+TypedAttributeKey<cgmath::Vector3f>
+GetNormal3fTypedAttributeKey(const Mesh &mesh)
+{
+    return TypedAttributeKey<cgmath::Vector3f>(GetNormal3fAttributeKey(mesh));
+}
+
+TypedAttributeKey<cgmath::Vector3f>
+GetColor3fTypedAttributeKey(const Mesh &mesh)
+{
+    return TypedAttributeKey<cgmath::Vector3f>(GetColor3fAttributeKey(mesh));
+}
+
+TypedAttributeKey<int32_t>
+GetMaterialIndexTypedAttributeKey(const Mesh &mesh)
+{
+    return TypedAttributeKey<int32_t>(GetMaterialIndexAttributeKey(mesh));
+}
+
+TypedAttributeKey<int32_t>
+GetTextureIndexTypedAttributeKey(const Mesh &mesh)
+{
+    return TypedAttributeKey<int32_t>(GetTextureIndexAttributeKey(mesh));
+}
+
 AttributeKey 
 GetMaterialNameAttributeKey(const Mesh &mesh, int materialIndex)
 {
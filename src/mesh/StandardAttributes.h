@@ -5,9 +5,12 @@
 
 #include <vector>
 
+#include <stdint.h>
+
 // This file defines functions for accessing standard mesh attribute keys.
 
 #include "AttributeKey.h"
+#include "TypedAttributeKey.h"
 
 namespace mesh {
 
@@ -27,6 +30,15 @@ AttributeKey GetColor3fAttributeKey(const Mesh &mesh);
 AttributeKey GetMaterialIndexAttributeKey(const Mesh &mesh);
 AttributeKey GetTextureIndexAttributeKey(const Mesh &mesh);
 
+// The same keys, as TypedAttributeKeys. Each call looks up the attribute
+// by name, so loops over the elements of a mesh should get the keys
+// once, beforehand.
+TypedAttributeKey<cgmath::Vector2f> GetTexCoord2fTypedAttributeKey(const Mesh &mesh);
+TypedAttributeKey<cgmath::Vector3f> GetNormal3fTypedAttributeKey(const Mesh &mesh);
+TypedAttributeKey<cgmath::Vector3f> GetColor3fTypedAttributeKey(const Mesh &mesh);
+TypedAttributeKey<int32_t> GetMaterialIndexTypedAttributeKey(const Mesh &mesh);
+TypedAttributeKey<int32_t> GetTextureIndexTypedAttributeKey(const Mesh &mesh);
+
 // Mesh material table attribute keys. These are assigned to
 // the Mesh object, not to its individual elements.
 AttributeKey GetMaterialNameAttributeKey(const Mesh &mesh, int materialIndex);
@@ -0,0 +1,157 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESH__TYPED_ATTRIBUTE_KEY__INCLUDED
+#define MESH__TYPED_ATTRIBUTE_KEY__INCLUDED
+
+#include <cassert>
+#include <string>
+
+#include <stdint.h>
+
+#include "AttributeKey.h"
+
+namespace mesh {
+
+// AttributeValueTraits
+//
+// Associates each type of attribute value with the AttributeKey types
+// that hold it, and with the value returned when the attribute isn't
+// defined. cgmath::Vector3f is held by both VECTOR3F and UNIT_VECTOR3F
+// attributes.
+
+template<typename VALUE>
+struct AttributeValueTraits
+{
+};
+
+template<>
+struct AttributeValueTraits<bool>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::BOOL; }
+    static const bool &defaultValue() { return AttributeKey::DEFAULT_BOOL; }
+};
+
+template<>
+struct AttributeValueTraits<int32_t>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::INT; }
+    static int32_t defaultValue() { return AttributeKey::DEFAULT_INT; }
+};
+
+template<>
+struct AttributeValueTraits<float>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::FLOAT; }
+    static const float &defaultValue() { return AttributeKey::DEFAULT_FLOAT; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::Vector2f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::VECTOR2F; }
+    static const cgmath::Vector2f &defaultValue() { return AttributeKey::DEFAULT_VECTOR2F; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::Vector3f>
+{
+    static bool holds(AttributeKey::Type type) {
+        return type == AttributeKey::VECTOR3F || type == AttributeKey::UNIT_VECTOR3F;
+    }
+    static const cgmath::Vector3f &defaultValue() { return AttributeKey::DEFAULT_VECTOR3F; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::Vector4f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::VECTOR4F; }
+    static const cgmath::Vector4f &defaultValue() { return AttributeKey::DEFAULT_VECTOR4F; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::Matrix3f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::MATRIX3F; }
+    static const cgmath::Matrix3f &defaultValue() { return AttributeKey::DEFAULT_MATRIX3F; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::Matrix4f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::MATRIX4F; }
+    static const cgmath::Matrix4f &defaultValue() { return AttributeKey::DEFAULT_MATRIX4F; }
+};
+
+template<>
+struct AttributeValueTraits<std::string>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::STRING; }
+    static const std::string &defaultValue() { return AttributeKey::DEFAULT_STRING; }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::BoundingBox2f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::BOUNDINGBOX2F; }
+    static const cgmath::BoundingBox2f &defaultValue() {
+        return AttributeKey::DEFAULT_BOUNDINGBOX2F;
+    }
+};
+
+template<>
+struct AttributeValueTraits<cgmath::BoundingBox3f>
+{
+    static bool holds(AttributeKey::Type type) { return type == AttributeKey::BOUNDINGBOX3F; }
+    static const cgmath::BoundingBox3f &defaultValue() {
+        return AttributeKey::DEFAULT_BOUNDINGBOX3F;
+    }
+};
+
+// TypedAttributeKey
+//
+// An AttributeKey whose value type is part of its C++ type.
+// The type of the AttributeKey is checked once, when the
+// TypedAttributeKey is created. AttributePossessor::getValue and
+// setValue then copy the value with a single templated function,
+// rather than through the type-specific get and set functions and
+// their switch on the attribute type. The attribute is still found by
+// searching the possessor's attributes for the key's handle.
+// Hot loops should look up their keys once, for example with
+// GetNormal3fTypedAttributeKey and the other accessors in
+// StandardAttributes.h, and keep the TypedAttributeKeys.
+
+template<typename VALUE>
+class TypedAttributeKey
+{
+public:
+    TypedAttributeKey();
+    explicit TypedAttributeKey(const AttributeKey &attributeKey);
+
+    // The untyped key, for use with functions that accept an AttributeKey.
+    const AttributeKey &key() const { return mAttributeKey; }
+    operator const AttributeKey &() const { return mAttributeKey; }
+
+    AttributeKey::Handle handle() const { return mAttributeKey.handle(); }
+    bool isDefined() const { return mAttributeKey.isDefined(); }
+
+private:
+    AttributeKey mAttributeKey;
+};
+
+template<typename VALUE>
+TypedAttributeKey<VALUE>::TypedAttributeKey()
+    : mAttributeKey()
+{
+}
+
+template<typename VALUE>
+TypedAttributeKey<VALUE>::TypedAttributeKey(const AttributeKey &attributeKey)
+    : mAttributeKey(attributeKey)
+{
+    // The AttributeKey must hold values of this TypedAttributeKey's type.
+    assert(AttributeValueTraits<VALUE>::holds(attributeKey.type()));
+}
+
+} // namespace mesh
+
+#endif // MESH__TYPED_ATTRIBUTE_KEY__INCLUDED
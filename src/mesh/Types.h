@@ -3,10 +3,12 @@
 #ifndef MESH__TYPES__INCLUDED
 #define MESH__TYPES__INCLUDED
 
-#include <list>
-#include <vector>
+#include <iterator>
 #include <ostream>
 
+#include "ElementList.h"
+#include "SmallVector.h"
+
 namespace mesh {
 
 // Forward declarations of the mesh element types.
@@ -15,9 +17,9 @@ class Edge;
 class Face;
 
 // List of elements owned by the mesh.
-typedef std::list<Vertex> VertexList;
-typedef std::list<Edge> EdgeList;
-typedef std::list<Face> FaceList;
+typedef ElementList<Vertex> VertexList;
+typedef ElementList<Edge> EdgeList;
+typedef ElementList<Face> FaceList;
 
 // Iterators for the mesh's element lists.
 typedef VertexList::iterator VertexPtr;
@@ -27,28 +29,41 @@ typedef VertexList::const_iterator ConstVertexPtr;
 typedef EdgeList::const_iterator ConstEdgePtr;
 typedef FaceList::const_iterator ConstFacePtr;
 
+// Handles that identify the mesh's elements by index, and that can
+// be tested to determine whether their elements still exist.
+typedef ElementHandle<Vertex> VertexHandle;
+typedef ElementHandle<Edge> EdgeHandle;
+typedef ElementHandle<Face> FaceHandle;
+
 // Vectors of element pointers that the mesh elements use to 
-// keep track of adjacent elements.
-typedef std::vector<VertexPtr> AdjacentVertexVector;
-typedef std::vector<EdgePtr> AdjacentEdgeVector;
-typedef std::vector<FacePtr> AdjacentFaceVector;
+// keep track of adjacent elements. Each has room inside it for
+// the number of adjacent elements that elements of a triangle mesh
+// usually have, so that memory is rarely allocated for them:
+// a face has three vertices and three edges, an edge has two vertices
+// and two faces, and a vertex typically has six edges and six faces.
+typedef SmallVector<VertexPtr, 3> FaceAdjacentVertexVector;
+typedef SmallVector<EdgePtr, 3> FaceAdjacentEdgeVector;
+typedef SmallVector<VertexPtr, 2> EdgeAdjacentVertexVector;
+typedef SmallVector<FacePtr, 2> EdgeAdjacentFaceVector;
+typedef SmallVector<EdgePtr, 6> VertexAdjacentEdgeVector;
+typedef SmallVector<FacePtr, 6> VertexAdjacentFaceVector;
 
 // Iterators for the vectors of pointers to adjacent elements.
 // Dereference these to get a VertexPtr, EdgePtr, or FacePtr.
-typedef AdjacentVertexVector::iterator AdjacentVertexIterator;
-typedef AdjacentEdgeVector::iterator AdjacentEdgeIterator;
-typedef AdjacentFaceVector::iterator AdjacentFaceIterator;
-typedef AdjacentVertexVector::const_iterator AdjacentVertexConstIterator;
-typedef AdjacentEdgeVector::const_iterator AdjacentEdgeConstIterator;
-typedef AdjacentFaceVector::const_iterator AdjacentFaceConstIterator;
-typedef AdjacentVertexVector::reverse_iterator AdjacentVertexReverseIterator;
-typedef AdjacentEdgeVector::reverse_iterator AdjacentEdgeReverseIterator;
-typedef AdjacentFaceVector::reverse_iterator AdjacentFaceReverseIterator;
-typedef AdjacentVertexVector::const_reverse_iterator 
+typedef VertexPtr *AdjacentVertexIterator;
+typedef EdgePtr *AdjacentEdgeIterator;
+typedef FacePtr *AdjacentFaceIterator;
+typedef const VertexPtr *AdjacentVertexConstIterator;
+typedef const EdgePtr *AdjacentEdgeConstIterator;
+typedef const FacePtr *AdjacentFaceConstIterator;
+typedef std::reverse_iterator<AdjacentVertexIterator> AdjacentVertexReverseIterator;
+typedef std::reverse_iterator<AdjacentEdgeIterator> AdjacentEdgeReverseIterator;
+typedef std::reverse_iterator<AdjacentFaceIterator> AdjacentFaceReverseIterator;
+typedef std::reverse_iterator<AdjacentVertexConstIterator> 
     AdjacentVertexConstReverseIterator;
-typedef AdjacentEdgeVector::const_reverse_iterator 
+typedef std::reverse_iterator<AdjacentEdgeConstIterator> 
     AdjacentEdgeConstReverseIterator;
-typedef AdjacentFaceVector::const_reverse_iterator 
+typedef std::reverse_iterator<AdjacentFaceConstIterator> 
     AdjacentFaceConstReverseIterator;
 
 bool operator<(const VertexPtr &lhs, const VertexPtr &rhs);
@@ -45,6 +45,12 @@ Vertex::addAdjacentEdge(EdgePtr edgePtr)
     mEdgePtrVector.push_back(edgePtr);
 }
 
+void
+Vertex::reserveAdjacentEdges(unsigned count)
+{
+    mEdgePtrVector.reserve(count);
+}
+
 void 
 Vertex::removeAdjacentEdge(EdgePtr edgePtr)
 {
@@ -103,6 +109,12 @@ Vertex::addAdjacentFace(FacePtr face)
     mFacePtrVector.push_back(face);
 }
 
+void
+Vertex::reserveAdjacentFaces(unsigned count)
+{
+    mFacePtrVector.reserve(count);
+}
+
 void 
 Vertex::removeAdjacentFace(FacePtr face)
 {
@@ -110,14 +122,14 @@ Vertex::removeAdjacentFace(FacePtr face)
     assert(hasAdjacentFace(face));
 
     // Remove the face from the vertex's face list.
-    mFacePtrVector.erase(find(mFacePtrVector.begin(), mFacePtrVector.end(), face));
+    mFacePtrVector.erase(std::find(mFacePtrVector.begin(), mFacePtrVector.end(), face));
 }
 
 bool 
 Vertex::hasAdjacentFace(ConstFacePtr face) const
 {
     // Return true if the face is in the vertex's face list.
-    return find(mFacePtrVector.begin(), mFacePtrVector.end(), face) != mFacePtrVector.end();
+    return std::find(mFacePtrVector.begin(), mFacePtrVector.end(), face) != mFacePtrVector.end();
 }
 
 unsigned int
@@ -174,4 +186,10 @@ Vertex::findAdjacentEdgeByVertex(ConstVertexPtr vertexPtr) const
     return (const_cast<Vertex *>(this))->findAdjacentEdgeByVertex(vertexPtr);
 }
 
+size_t
+Vertex::adjacencyBytesAllocated() const
+{
+    return mEdgePtrVector.bytesAllocated() + mFacePtrVector.bytesAllocated();
+}
+
 } // namespace mesh
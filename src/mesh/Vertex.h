@@ -26,6 +26,7 @@ public:
 
     // Adjacent edges.
     void addAdjacentEdge(EdgePtr edgePtr);
+    void reserveAdjacentEdges(unsigned count);
     void removeAdjacentEdge(EdgePtr edgePtr);
     bool hasAdjacentEdge(ConstEdgePtr edgePtr) const;
     unsigned int adjacentEdgeCount() const;
@@ -36,6 +37,7 @@ public:
 
     // Adjacent faces.
     void addAdjacentFace(FacePtr facePtr);
+    void reserveAdjacentFaces(unsigned count);
     void removeAdjacentFace(FacePtr facePtr);
     bool hasAdjacentFace(ConstFacePtr facePtr) const;
     unsigned int adjacentFaceCount() const;
@@ -49,12 +51,16 @@ public:
     // returned.
     AdjacentEdgeIterator findAdjacentEdgeByVertex(ConstVertexPtr vertexPtr);
     AdjacentEdgeConstIterator findAdjacentEdgeByVertex(ConstVertexPtr vertexPtr) const;
+
+    // The number of bytes allocated separately from the vertex
+    // for its adjacent edges and faces.
+    size_t adjacencyBytesAllocated() const;
     
 private:
     cgmath::Vector3f mPosition;
 
-    AdjacentEdgeVector mEdgePtrVector;
-    AdjacentFaceVector mFacePtrVector;
+    VertexAdjacentEdgeVector mEdgePtrVector;
+    VertexAdjacentFaceVector mFacePtrVector;
 };
 
 } // namespace mesh
@@ -2,6 +2,10 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <string>
+
+#include <cgmath/Vector3f.h>
+#include <cgmath/Matrix4f.h>
 #include <mesh/AttributeData.h>
 #include <mesh/AttributeKey.h>
 
@@ -12,6 +16,7 @@ class AttributeDataTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE(AttributeDataTest);
     CPPUNIT_TEST(testAttributeData);
+    CPPUNIT_TEST(testCopy);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -29,6 +34,39 @@ public:
         CPPUNIT_ASSERT(attributeData.handle() == 100);
         CPPUNIT_ASSERT(attributeData.type() == AttributeKey::VECTOR3F);
     }
+
+    void testCopy() {
+        // A value stored within the AttributeData object.
+        AttributeData vectorData(AttributeKey(100, AttributeKey::VECTOR3F));
+        *static_cast<cgmath::Vector3f *>(vectorData.data()) = cgmath::Vector3f(1, 2, 3);
+
+        // Values allocated separately.
+        AttributeData matrixData(AttributeKey(101, AttributeKey::MATRIX4F));
+        *static_cast<cgmath::Matrix4f *>(matrixData.data()) = cgmath::Matrix4f::IDENTITY;
+        AttributeData stringData(AttributeKey(102, AttributeKey::STRING));
+        *static_cast<std::string *>(stringData.data()) = "test";
+
+        AttributeData vectorCopy(vectorData);
+        CPPUNIT_ASSERT(vectorCopy.data() != vectorData.data());
+        CPPUNIT_ASSERT(*static_cast<cgmath::Vector3f *>(vectorCopy.data())
+            == cgmath::Vector3f(1, 2, 3));
+
+        AttributeData matrixCopy(matrixData);
+        CPPUNIT_ASSERT(matrixCopy.data() != matrixData.data());
+        CPPUNIT_ASSERT(*static_cast<cgmath::Matrix4f *>(matrixCopy.data())
+            == cgmath::Matrix4f::IDENTITY);
+
+        // Assignment between values stored in different ways.
+        vectorCopy = stringData;
+        CPPUNIT_ASSERT(vectorCopy.handle() == 102);
+        CPPUNIT_ASSERT(vectorCopy.type() == AttributeKey::STRING);
+        CPPUNIT_ASSERT(*static_cast<std::string *>(vectorCopy.data()) == "test");
+
+        matrixCopy = vectorData;
+        CPPUNIT_ASSERT(matrixCopy.type() == AttributeKey::VECTOR3F);
+        CPPUNIT_ASSERT(*static_cast<cgmath::Vector3f *>(matrixCopy.data())
+            == cgmath::Vector3f(1, 2, 3));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(AttributeDataTest);
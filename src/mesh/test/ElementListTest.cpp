@@ -0,0 +1,226 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include <mesh/ElementList.h>
+
+using mesh::ElementList;
+using mesh::ElementHandle;
+
+class ElementListTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ElementListTest);
+    CPPUNIT_TEST(testCreate);
+    CPPUNIT_TEST(testErase);
+    CPPUNIT_TEST(testManyElements);
+    CPPUNIT_TEST(testHandles);
+    CPPUNIT_TEST(testSwap);
+    CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST(testClearDestroysElements);
+    CPPUNIT_TEST(testClearTrivialElements);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    typedef ElementList<std::vector<int> > IntVectorList;
+
+    // An element that counts how many of its kind exist.
+    struct CountedElement {
+        CountedElement() { ++sCount; }
+        ~CountedElement() { --sCount; }
+        static int sCount;
+    };
+
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testCreate() {
+        IntVectorList list;
+        CPPUNIT_ASSERT(list.empty());
+        CPPUNIT_ASSERT(list.begin() == list.end());
+
+        for (int index = 0; index < 3; ++index) {
+            IntVectorList::iterator iterator = list.create();
+            CPPUNIT_ASSERT((*iterator).empty());
+            iterator->push_back(index);
+        }
+
+        CPPUNIT_ASSERT(list.size() == 3);
+        CPPUNIT_ASSERT(list.indexLimit() == 3);
+
+        // Elements are iterated over in the order they were created.
+        int expected = 0;
+        for (IntVectorList::const_iterator iterator = list.begin();
+             iterator != list.end(); ++iterator) {
+            CPPUNIT_ASSERT((*iterator)[0] == expected);
+            CPPUNIT_ASSERT(list.index(iterator) == unsigned(expected));
+            ++expected;
+        }
+        CPPUNIT_ASSERT(expected == 3);
+
+        IntVectorList::iterator last = list.end();
+        --last;
+        CPPUNIT_ASSERT((*last)[0] == 2);
+    }
+
+    void testErase() {
+        IntVectorList list;
+        IntVectorList::iterator first = list.create();
+        IntVectorList::iterator second = list.create();
+        IntVectorList::iterator third = list.create();
+        first->push_back(0);
+        second->push_back(1);
+        third->push_back(2);
+
+        unsigned secondIndex = list.index(second);
+        list.erase(second);
+        CPPUNIT_ASSERT(list.size() == 2);
+
+        IntVectorList::iterator iterator = list.begin();
+        CPPUNIT_ASSERT(iterator == first);
+        ++iterator;
+        CPPUNIT_ASSERT(iterator == third);
+        ++iterator;
+        CPPUNIT_ASSERT(iterator == list.end());
+
+        // The slot of the erased element is reused,
+        // but the new element is still created at the end of the list.
+        IntVectorList::iterator fourth = list.create();
+        CPPUNIT_ASSERT(fourth->empty());
+        CPPUNIT_ASSERT(list.index(fourth) == secondIndex);
+        CPPUNIT_ASSERT(list.indexLimit() == 3);
+        CPPUNIT_ASSERT(--list.end() == fourth);
+    }
+
+    void testManyElements() {
+        IntVectorList list;
+        std::vector<IntVectorList::iterator> iteratorVector;
+        for (int index = 0; index < 20000; ++index) {
+            iteratorVector.push_back(list.create());
+            iteratorVector.back()->push_back(index);
+        }
+
+        // Erase every other element.
+        for (int index = 0; index < 20000; index += 2) {
+            list.erase(iteratorVector[index]);
+        }
+        CPPUNIT_ASSERT(list.size() == 10000);
+
+        int expected = 1;
+        for (IntVectorList::iterator iterator = list.begin();
+             iterator != list.end(); ++iterator) {
+            CPPUNIT_ASSERT((*iterator)[0] == expected);
+            CPPUNIT_ASSERT(list.index(iterator) == unsigned(expected));
+            CPPUNIT_ASSERT(list.find(list.handle(iterator)) == iterator);
+            expected += 2;
+        }
+        CPPUNIT_ASSERT(expected == 20001);
+    }
+
+    void testHandles() {
+        IntVectorList list;
+        IntVectorList::iterator first = list.create();
+        IntVectorList::iterator second = list.create();
+
+        ElementHandle<std::vector<int> > firstHandle = list.handle(first);
+        ElementHandle<std::vector<int> > secondHandle = list.handle(second);
+        CPPUNIT_ASSERT(firstHandle != secondHandle);
+        CPPUNIT_ASSERT(list.find(firstHandle) == first);
+        CPPUNIT_ASSERT(list.find(secondHandle) == second);
+
+        // A handle to an erased element isn't found,
+        // even after its slot has been reused.
+        list.erase(first);
+        CPPUNIT_ASSERT(list.find(firstHandle) == list.end());
+        IntVectorList::iterator third = list.create();
+        CPPUNIT_ASSERT(list.index(third) == firstHandle.index());
+        CPPUNIT_ASSERT(list.find(firstHandle) == list.end());
+        CPPUNIT_ASSERT(list.find(list.handle(third)) == third);
+
+        // Default-constructed handles and handles beyond the end
+        // of the list aren't found.
+        CPPUNIT_ASSERT(list.find(ElementHandle<std::vector<int> >()) == list.end());
+        CPPUNIT_ASSERT(list.find(ElementHandle<std::vector<int> >(100, 1)) == list.end());
+    }
+
+    void testSwap() {
+        IntVectorList list1;
+        IntVectorList list2;
+        list1.create()->push_back(1);
+        list1.create()->push_back(2);
+
+        list1.swap(list2);
+        CPPUNIT_ASSERT(list1.empty());
+        CPPUNIT_ASSERT(list1.begin() == list1.end());
+        CPPUNIT_ASSERT(list2.size() == 2);
+        CPPUNIT_ASSERT((*list2.begin())[0] == 1);
+        CPPUNIT_ASSERT((*--list2.end())[0] == 2);
+
+        list1.create()->push_back(3);
+        list1.swap(list2);
+        CPPUNIT_ASSERT(list1.size() == 2);
+        CPPUNIT_ASSERT(list2.size() == 1);
+        CPPUNIT_ASSERT((*list2.begin())[0] == 3);
+        CPPUNIT_ASSERT(++list2.begin() == list2.end());
+
+        int expected = 1;
+        for (IntVectorList::iterator iterator = list1.begin();
+             iterator != list1.end(); ++iterator) {
+            CPPUNIT_ASSERT((*iterator)[0] == expected);
+            ++expected;
+        }
+        CPPUNIT_ASSERT(expected == 3);
+    }
+
+    void testClear() {
+        IntVectorList list;
+        list.create();
+        list.create();
+        list.clear();
+
+        CPPUNIT_ASSERT(list.empty());
+        CPPUNIT_ASSERT(list.begin() == list.end());
+        CPPUNIT_ASSERT(list.indexLimit() == 0);
+        CPPUNIT_ASSERT(list.bytesUsed() == 0);
+    }
+
+    void testClearDestroysElements() {
+        ElementList<CountedElement> list;
+        std::vector<ElementList<CountedElement>::iterator> iteratorVector;
+        for (int index = 0; index < 1000; ++index) {
+            iteratorVector.push_back(list.create());
+        }
+        for (int index = 0; index < 1000; index += 3) {
+            list.erase(iteratorVector[index]);
+        }
+        list.create();
+        CPPUNIT_ASSERT(CountedElement::sCount == 667);
+
+        list.clear();
+        CPPUNIT_ASSERT(CountedElement::sCount == 0);
+        CPPUNIT_ASSERT(list.empty());
+    }
+
+    void testClearTrivialElements() {
+        ElementList<int> list;
+        for (int index = 0; index < 1000; ++index) {
+            *list.create() = index;
+        }
+        list.clear();
+
+        CPPUNIT_ASSERT(list.empty());
+        CPPUNIT_ASSERT(list.begin() == list.end());
+        CPPUNIT_ASSERT(list.bytesUsed() == 0);
+
+        *list.create() = 1;
+        CPPUNIT_ASSERT(*list.begin() == 1);
+    }
+};
+
+int ElementListTest::CountedElement::sCount = 0;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ElementListTest);
@@ -5,16 +5,20 @@
 
 #include <mesh/Face.h>
 #include <mesh/Mesh.h>
+#include <mesh/FaceVertex.h>
 
 using mesh::Mesh;
 using mesh::VertexPtr;
 using mesh::FacePtr;
 using mesh::AttributeKey;
+using mesh::Face;
 
 class FaceTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE(FaceTest);
     CPPUNIT_TEST(testIntAttribute);
+    CPPUNIT_TEST(testCorners);
+    CPPUNIT_TEST(testCornerInsertion);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -62,6 +66,65 @@ public:
     
         CPPUNIT_ASSERT(!mF1->hasVertexAttribute(mV1, key));
     }
+
+    void testCorners() {
+        AttributeKey key = mMeshPtr->getAttributeKey("key", AttributeKey::INT);
+
+        CPPUNIT_ASSERT(mF1->findCorner(mV2) == 1);
+        CPPUNIT_ASSERT(mF1->findCorner(mMeshPtr->createVertex()) == 3);
+        CPPUNIT_ASSERT(mF1->cornerVertexPtr(2) == mV3);
+
+        // Corners without attributes have no FaceVertex.
+        CPPUNIT_ASSERT(mF1->findCornerFaceVertex(1) == NULL);
+        CPPUNIT_ASSERT(!mF1->cornerAttributes(1).hasAttribute(key));
+
+        mF1->setVertexInt(mV2, key, 100);
+        CPPUNIT_ASSERT(mF1->findCornerFaceVertex(1) == mF1->findFaceVertex(mV2));
+        CPPUNIT_ASSERT(mF1->cornerAttributes(1).getInt(key) == 100);
+        CPPUNIT_ASSERT(mF1->getCornerFaceVertex(2)->vertexPtr() == mV3);
+
+        unsigned corner = 0;
+        for (Face::CornerConstIterator iterator = mF1->cornerBegin();
+             iterator != mF1->cornerEnd(); ++iterator) {
+            CPPUNIT_ASSERT(iterator.corner() == corner);
+            CPPUNIT_ASSERT(iterator.vertexPtr() == mF1->cornerVertexPtr(corner));
+            CPPUNIT_ASSERT(iterator.attributes().hasAttribute(key) == (corner == 1));
+            ++corner;
+        }
+        CPPUNIT_ASSERT(corner == 3);
+
+        // Erasing the last attribute of a corner removes its FaceVertex.
+        mF1->eraseVertexAttribute(mV2, key);
+        CPPUNIT_ASSERT(mF1->findCornerFaceVertex(1) == NULL);
+    }
+
+    void testCornerInsertion() {
+        AttributeKey key = mMeshPtr->getAttributeKey("key", AttributeKey::INT);
+
+        mF1->setVertexInt(mV2, key, 2);
+        mF1->setVertexInt(mV3, key, 3);
+
+        // A face vertex may be created for a vertex before it
+        // is adjacent to the face.
+        VertexPtr v4 = mMeshPtr->createVertex();
+        mF1->setVertexInt(v4, key, 4);
+        CPPUNIT_ASSERT(mF1->getVertexInt(v4, key) == 4);
+
+        // Face vertices follow their vertices' corners.
+        mF1->prependAdjacentVertex(v4);
+        CPPUNIT_ASSERT(mF1->findCorner(v4) == 0);
+        CPPUNIT_ASSERT(mF1->cornerAttributes(0).getInt(key) == 4);
+        CPPUNIT_ASSERT(mF1->findCornerFaceVertex(1) == NULL);
+        CPPUNIT_ASSERT(mF1->cornerAttributes(2).getInt(key) == 2);
+        CPPUNIT_ASSERT(mF1->cornerAttributes(3).getInt(key) == 3);
+        CPPUNIT_ASSERT(mF1->faceVertexVectorSize() == 4);
+
+        mF1->removeAdjacentVertex(mV2);
+        CPPUNIT_ASSERT(mF1->adjacentVertexCount() == 3);
+        CPPUNIT_ASSERT(mF1->cornerAttributes(0).getInt(key) == 4);
+        CPPUNIT_ASSERT(mF1->cornerAttributes(2).getInt(key) == 3);
+        CPPUNIT_ASSERT(!mF1->hasFaceVertex(mV2));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FaceTest);
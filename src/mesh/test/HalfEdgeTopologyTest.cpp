@@ -0,0 +1,219 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include <mesh/HalfEdgeTopology.h>
+#include <mesh/Mesh.h>
+#include <mesh/IsConsistent.h>
+#include <meshprim/CreateTriangleMesh.h>
+
+using mesh::HalfEdgeTopology;
+
+class HalfEdgeTopologyTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(HalfEdgeTopologyTest);
+    CPPUNIT_TEST(testFan);
+    CPPUNIT_TEST(testNonmanifoldEdge);
+    CPPUNIT_TEST(testNonmanifoldVertex);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testFan() {
+        mesh::Mesh mesh;
+
+        // 3-------2
+        // |\     /|
+        // | \   / |
+        // |  \ /  |
+        // |   4   |
+        // |  / \  |
+        // | /   \ |
+        // |/     \|
+        // 0-------1
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            2, 0, 0,
+            2, 2, 0,
+            0, 2, 0,
+            1, 1, 0
+        };
+        int faceVertexIndexArray[] = {
+            0, 1, 4,
+            1, 2, 4,
+            2, 3, 4,
+            3, 0, 4
+        };
+        std::vector<mesh::VertexPtr> vertexPtrVector;
+        std::vector<mesh::EdgePtr> edgePtrVector;
+        std::vector<mesh::FacePtr> facePtrVector;
+        meshprim::CreateTriangleMesh(&mesh,
+            sizeof(vertexPositionArray)/sizeof(float)/3, vertexPositionArray,
+            sizeof(faceVertexIndexArray)/sizeof(int)/3, faceVertexIndexArray,
+            &vertexPtrVector, &edgePtrVector, &facePtrVector);
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+
+        HalfEdgeTopology topology;
+        topology.build(&mesh);
+        CPPUNIT_ASSERT(topology.mesh() == &mesh);
+        CPPUNIT_ASSERT(topology.halfEdgeCount() == 12);
+
+        // Walk around the first face.
+        mesh::FacePtr facePtr = facePtrVector[0];
+        unsigned begin = topology.faceHalfEdgeBegin(facePtr);
+        CPPUNIT_ASSERT(topology.faceHalfEdgeEnd(facePtr) == begin + 3);
+        for (unsigned halfEdge = begin; halfEdge < begin + 3; ++halfEdge) {
+            CPPUNIT_ASSERT(topology.facePtr(halfEdge) == facePtr);
+            CPPUNIT_ASSERT(topology.originVertexPtr(halfEdge)
+                == facePtr->cornerVertexPtr(topology.corner(halfEdge)));
+            CPPUNIT_ASSERT(topology.destinationVertexPtr(halfEdge)
+                == topology.originVertexPtr(topology.next(halfEdge)));
+            CPPUNIT_ASSERT(topology.previous(topology.next(halfEdge)) == halfEdge);
+            CPPUNIT_ASSERT(topology.edgePtr(halfEdge)->hasAdjacentVertex(
+                    topology.originVertexPtr(halfEdge)));
+            CPPUNIT_ASSERT(topology.edgePtr(halfEdge)->hasAdjacentVertex(
+                    topology.destinationVertexPtr(halfEdge)));
+        }
+        CPPUNIT_ASSERT(topology.next(topology.next(topology.next(begin))) == begin);
+
+        // The outer edges are boundaries, and the inner edges have twins.
+        for (unsigned halfEdge = 0; halfEdge < topology.halfEdgeCount(); ++halfEdge) {
+            CPPUNIT_ASSERT(!topology.isNonmanifold(halfEdge));
+            bool isInner = topology.originVertexPtr(halfEdge) == vertexPtrVector[4]
+                || topology.destinationVertexPtr(halfEdge) == vertexPtrVector[4];
+            CPPUNIT_ASSERT(topology.hasTwin(halfEdge) == isInner);
+            CPPUNIT_ASSERT(topology.isBoundary(halfEdge) == !isInner);
+            if (isInner) {
+                unsigned twin = topology.twin(halfEdge);
+                CPPUNIT_ASSERT(topology.twin(twin) == halfEdge);
+                CPPUNIT_ASSERT(topology.edgePtr(twin) == topology.edgePtr(halfEdge));
+                CPPUNIT_ASSERT(topology.originVertexPtr(twin)
+                    == topology.destinationVertexPtr(halfEdge));
+                CPPUNIT_ASSERT(topology.oppositeFacePtr(halfEdge)
+                    == topology.facePtr(twin));
+            }
+        }
+
+        // Each edge has a half-edge for each of its faces.
+        for (mesh::EdgePtr edgePtr = mesh.edgeBegin(); edgePtr != mesh.edgeEnd(); ++edgePtr) {
+            CPPUNIT_ASSERT(topology.edgeHalfEdgeCount(edgePtr) == edgePtr->adjacentFaceCount());
+            for (HalfEdgeTopology::EdgeHalfEdgeConstIterator iterator
+                     = topology.edgeHalfEdgeBegin(edgePtr);
+                 iterator != topology.edgeHalfEdgeEnd(edgePtr); ++iterator) {
+                CPPUNIT_ASSERT(topology.edgePtr(*iterator) == edgePtr);
+            }
+        }
+
+        // The half-edges around the center vertex are in order.
+        CPPUNIT_ASSERT(topology.isManifold(vertexPtrVector[4]));
+        CPPUNIT_ASSERT(topology.outgoingHalfEdgeCount(vertexPtrVector[4]) == 4);
+        HalfEdgeTopology::OutgoingHalfEdgeConstIterator iterator
+            = topology.outgoingHalfEdgeBegin(vertexPtrVector[4]);
+        for (int count = 0; count < 4; ++count) {
+            unsigned halfEdge = *iterator;
+            CPPUNIT_ASSERT(topology.originVertexPtr(halfEdge) == vertexPtrVector[4]);
+            ++iterator;
+            if (iterator == topology.outgoingHalfEdgeEnd(vertexPtrVector[4])) {
+                iterator = topology.outgoingHalfEdgeBegin(vertexPtrVector[4]);
+            }
+            CPPUNIT_ASSERT(*iterator == topology.twin(topology.previous(halfEdge)));
+        }
+
+        // A boundary vertex's half-edges begin with the one without a twin.
+        CPPUNIT_ASSERT(topology.isManifold(vertexPtrVector[0]));
+        CPPUNIT_ASSERT(topology.outgoingHalfEdgeCount(vertexPtrVector[0]) == 2);
+        unsigned first = *topology.outgoingHalfEdgeBegin(vertexPtrVector[0]);
+        CPPUNIT_ASSERT(!topology.hasTwin(first));
+        CPPUNIT_ASSERT(topology.destinationVertexPtr(first) == vertexPtrVector[1]);
+
+        topology.clear();
+        CPPUNIT_ASSERT(topology.mesh() == NULL);
+        CPPUNIT_ASSERT(topology.halfEdgeCount() == 0);
+    }
+
+    void testNonmanifoldEdge() {
+        mesh::Mesh mesh;
+
+        // Three triangles share the edge from vertex 0 to vertex 1.
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            0, 1, 0,
+            0, -1, 0,
+            0, 0, 1
+        };
+        int faceVertexIndexArray[] = {
+            0, 1, 2,
+            1, 0, 3,
+            0, 1, 4
+        };
+        std::vector<mesh::VertexPtr> vertexPtrVector;
+        std::vector<mesh::EdgePtr> edgePtrVector;
+        std::vector<mesh::FacePtr> facePtrVector;
+        meshprim::CreateTriangleMesh(&mesh,
+            sizeof(vertexPositionArray)/sizeof(float)/3, vertexPositionArray,
+            sizeof(faceVertexIndexArray)/sizeof(int)/3, faceVertexIndexArray,
+            &vertexPtrVector, &edgePtrVector, &facePtrVector);
+
+        HalfEdgeTopology topology;
+        topology.build(&mesh);
+
+        for (unsigned halfEdge = 0; halfEdge < topology.halfEdgeCount(); ++halfEdge) {
+            bool isShared = topology.edgePtr(halfEdge)->adjacentFaceCount() == 3;
+            CPPUNIT_ASSERT(topology.isNonmanifold(halfEdge) == isShared);
+            CPPUNIT_ASSERT(!topology.hasTwin(halfEdge));
+        }
+        CPPUNIT_ASSERT(!topology.isManifold(vertexPtrVector[0]));
+        CPPUNIT_ASSERT(!topology.isManifold(vertexPtrVector[1]));
+        CPPUNIT_ASSERT(topology.isManifold(vertexPtrVector[2]));
+        CPPUNIT_ASSERT(topology.outgoingHalfEdgeCount(vertexPtrVector[0]) == 3);
+        for (mesh::EdgePtr edgePtr = mesh.edgeBegin(); edgePtr != mesh.edgeEnd(); ++edgePtr) {
+            CPPUNIT_ASSERT(topology.edgeHalfEdgeCount(edgePtr) == edgePtr->adjacentFaceCount());
+        }
+    }
+
+    void testNonmanifoldVertex() {
+        mesh::Mesh mesh;
+
+        // Two triangles share only vertex 0.
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            -1, 0, 0,
+            -1, -1, 0
+        };
+        int faceVertexIndexArray[] = {
+            0, 1, 2,
+            0, 3, 4
+        };
+        std::vector<mesh::VertexPtr> vertexPtrVector;
+        std::vector<mesh::EdgePtr> edgePtrVector;
+        std::vector<mesh::FacePtr> facePtrVector;
+        meshprim::CreateTriangleMesh(&mesh,
+            sizeof(vertexPositionArray)/sizeof(float)/3, vertexPositionArray,
+            sizeof(faceVertexIndexArray)/sizeof(int)/3, faceVertexIndexArray,
+            &vertexPtrVector, &edgePtrVector, &facePtrVector);
+
+        HalfEdgeTopology topology;
+        topology.build(&mesh);
+
+        CPPUNIT_ASSERT(!topology.isManifold(vertexPtrVector[0]));
+        CPPUNIT_ASSERT(topology.isManifold(vertexPtrVector[1]));
+        CPPUNIT_ASSERT(topology.outgoingHalfEdgeCount(vertexPtrVector[0]) == 2);
+        for (HalfEdgeTopology::OutgoingHalfEdgeConstIterator iterator
+                 = topology.outgoingHalfEdgeBegin(vertexPtrVector[0]);
+             iterator != topology.outgoingHalfEdgeEnd(vertexPtrVector[0]); ++iterator) {
+            CPPUNIT_ASSERT(topology.isBoundary(*iterator));
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HalfEdgeTopologyTest);
@@ -0,0 +1,197 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include <cgmath/Vector2f.h>
+#include <mesh/MeshBuilder.h>
+#include <mesh/MeshOperations.h>
+#include <mesh/Mesh.h>
+#include <mesh/IsConsistent.h>
+
+using mesh::MeshBuilder;
+
+class MeshBuilderTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(MeshBuilderTest);
+    CPPUNIT_TEST(testTriangles);
+    CPPUNIT_TEST(testPolygons);
+    CPPUNIT_TEST(testFaceVertexAttributes);
+    CPPUNIT_TEST(testCreateFaceEdges);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testTriangles() {
+        mesh::Mesh mesh;
+
+        // 3-------2
+        // |\      |
+        // |  \    |
+        // |    \  |
+        // |      \|
+        // 0-------1
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            0, 1, 0
+        };
+        unsigned faceVertexIndexArray[] = {
+            0, 1, 3,
+            1, 2, 3
+        };
+
+        MeshBuilder meshBuilder;
+        meshBuilder.setMesh(&mesh);
+        meshBuilder.setVertexPositionArray(4, vertexPositionArray);
+        meshBuilder.setFaceArray(2, NULL, faceVertexIndexArray);
+        meshBuilder.build();
+
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+        CPPUNIT_ASSERT(mesh.vertexCount() == 4);
+        CPPUNIT_ASSERT(mesh.edgeCount() == 5);
+        CPPUNIT_ASSERT(mesh.faceCount() == 2);
+
+        const std::vector<mesh::VertexPtr> &vertexPtrVector = meshBuilder.vertexPtrVector();
+        const std::vector<mesh::EdgePtr> &edgePtrVector = meshBuilder.edgePtrVector();
+        const std::vector<mesh::FacePtr> &facePtrVector = meshBuilder.facePtrVector();
+        CPPUNIT_ASSERT(vertexPtrVector.size() == 4);
+        CPPUNIT_ASSERT(edgePtrVector.size() == 5);
+        CPPUNIT_ASSERT(facePtrVector.size() == 2);
+
+        CPPUNIT_ASSERT(vertexPtrVector[2]->position() == cgmath::Vector3f(1, 1, 0));
+        CPPUNIT_ASSERT(facePtrVector[1]->cornerVertexPtr(0) == vertexPtrVector[1]);
+
+        // The edges are in the order they were first encountered,
+        // and their vertices are in the order of the first face.
+        CPPUNIT_ASSERT(edgePtrVector[0]->adjacentVertexCount() == 2);
+        CPPUNIT_ASSERT(*edgePtrVector[0]->adjacentVertexBegin() == vertexPtrVector[0]);
+        CPPUNIT_ASSERT(*(edgePtrVector[0]->adjacentVertexBegin() + 1) == vertexPtrVector[1]);
+
+        // The diagonal edge is shared by both faces.
+        mesh::EdgePtr diagonalEdgePtr = edgePtrVector[1];
+        CPPUNIT_ASSERT(diagonalEdgePtr->hasAdjacentVertex(vertexPtrVector[1]));
+        CPPUNIT_ASSERT(diagonalEdgePtr->hasAdjacentVertex(vertexPtrVector[3]));
+        CPPUNIT_ASSERT(diagonalEdgePtr->adjacentFaceCount() == 2);
+        CPPUNIT_ASSERT(vertexPtrVector[1]->adjacentEdgeCount() == 3);
+        CPPUNIT_ASSERT(vertexPtrVector[1]->adjacentFaceCount() == 2);
+    }
+
+    void testPolygons() {
+        mesh::Mesh mesh;
+
+        // A quadrilateral and a triangle that share the edge from
+        // vertex 1 to vertex 2.
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            0, 1, 0,
+            2, 0, 0
+        };
+        unsigned faceVertexCountArray[] = {
+            4, 3
+        };
+        unsigned faceVertexIndexArray[] = {
+            0, 1, 2, 3,
+            1, 4, 2
+        };
+
+        MeshBuilder meshBuilder;
+        meshBuilder.setMesh(&mesh);
+        meshBuilder.setVertexPositionArray(5, vertexPositionArray);
+        meshBuilder.setFaceArray(2, faceVertexCountArray, faceVertexIndexArray);
+        meshBuilder.build();
+
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+        CPPUNIT_ASSERT(mesh.edgeCount() == 6);
+        CPPUNIT_ASSERT(meshBuilder.facePtrVector()[0]->adjacentVertexCount() == 4);
+        CPPUNIT_ASSERT(meshBuilder.facePtrVector()[0]->adjacentEdgeCount() == 4);
+        CPPUNIT_ASSERT(meshBuilder.facePtrVector()[1]->adjacentVertexCount() == 3);
+        CPPUNIT_ASSERT(meshBuilder.facePtrVector()[1]->adjacentEdgeCount() == 3);
+    }
+
+    void testFaceVertexAttributes() {
+        mesh::Mesh mesh;
+
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            0, 1, 0
+        };
+        unsigned faceVertexIndexArray[] = {
+            0, 1, 2
+        };
+        float textureCoordinateArray[] = {
+            0.0, 0.0,
+            0.5, 0.0,
+            0.0, 0.5
+        };
+
+        mesh::AttributeKey key = mesh.getAttributeKey("texture2f",
+            mesh::AttributeKey::VECTOR2F);
+
+        MeshBuilder meshBuilder;
+        meshBuilder.setMesh(&mesh);
+        meshBuilder.setVertexPositionArray(3, vertexPositionArray);
+        meshBuilder.setFaceArray(1, NULL, faceVertexIndexArray);
+        meshBuilder.addFaceVertexAttributeArray(key, textureCoordinateArray);
+        meshBuilder.build();
+
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+        mesh::FacePtr facePtr = meshBuilder.facePtrVector()[0];
+        CPPUNIT_ASSERT(facePtr->cornerAttributes(1).getVector2f(key)
+            == cgmath::Vector2f(0.5, 0.0));
+        CPPUNIT_ASSERT(facePtr->cornerAttributes(2).getVector2f(key)
+            == cgmath::Vector2f(0.0, 0.5));
+    }
+
+    void testCreateFaceEdges() {
+        mesh::Mesh mesh;
+
+        // Two triangles, one of which already has its edges, share
+        // the edge from vertex 1 to vertex 2.
+        mesh::VertexPtr vertexPtrArray[4];
+        for (int index = 0; index < 4; ++index) {
+            vertexPtrArray[index] = mesh.createVertex();
+        }
+        std::vector<mesh::FacePtr> facePtrVector;
+        int faceVertexIndexArray[] = {
+            0, 1, 2,
+            2, 1, 3
+        };
+        for (int face = 0; face < 2; ++face) {
+            mesh::FacePtr facePtr = mesh.createFace();
+            for (int corner = 0; corner < 3; ++corner) {
+                mesh::VertexPtr vertexPtr = vertexPtrArray[faceVertexIndexArray[3*face + corner]];
+                facePtr->addAdjacentVertex(vertexPtr);
+                vertexPtr->addAdjacentFace(facePtr);
+            }
+            facePtrVector.push_back(facePtr);
+        }
+
+        std::vector<mesh::EdgePtr> edgePtrVector;
+        mesh::CreateFaceEdges(&mesh, std::vector<mesh::FacePtr>(1, facePtrVector[0]),
+            &edgePtrVector);
+        CPPUNIT_ASSERT(edgePtrVector.size() == 3);
+        CPPUNIT_ASSERT(mesh.edgeCount() == 3);
+
+        // The existing edge is reused, and only two are created.
+        edgePtrVector.clear();
+        mesh::CreateFaceEdges(&mesh, facePtrVector, &edgePtrVector);
+        CPPUNIT_ASSERT(edgePtrVector.size() == 2);
+        CPPUNIT_ASSERT(mesh.edgeCount() == 5);
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+        CPPUNIT_ASSERT(facePtrVector[0]->adjacentEdgeCount() == 3);
+        CPPUNIT_ASSERT(facePtrVector[1]->adjacentEdgeCount() == 3);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MeshBuilderTest);
@@ -2,7 +2,13 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <string>
+#include <vector>
+
 #include <mesh/Mesh.h>
+#include <mesh/MeshBuilder.h>
+#include <mesh/MeshOperations.h>
+#include <mesh/IsConsistent.h>
 
 using mesh::Mesh;
 
@@ -12,6 +18,12 @@ class MeshTest : public CppUnit::TestFixture
     CPPUNIT_TEST(testCopyConstructor);
     CPPUNIT_TEST(testAssignment);
     CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST(testElementHandles);
+    CPPUNIT_TEST(testSwap);
+    CPPUNIT_TEST(testReorderElements);
+    CPPUNIT_TEST(testReorderNonadjacentFaceVertex);
+    CPPUNIT_TEST(testSortElementsAlongMortonCurve);
+    CPPUNIT_TEST(testMemoryUsage);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -63,6 +75,202 @@ public:
         CPPUNIT_ASSERT(mesh1.vertexCount() == 0);
         CPPUNIT_ASSERT(mesh1.faceCount() == 0);
     }
+
+    void testElementHandles() {
+        Mesh mesh;
+        mesh::VertexPtr vertexPtr0 = mesh.createVertex();
+        mesh::VertexPtr vertexPtr1 = mesh.createVertex();
+        mesh::EdgePtr edgePtr = mesh.createEdge();
+        mesh::FacePtr facePtr = mesh.createFace();
+
+        CPPUNIT_ASSERT(mesh.vertexIndex(vertexPtr0) == 0);
+        CPPUNIT_ASSERT(mesh.vertexIndex(vertexPtr1) == 1);
+        CPPUNIT_ASSERT(mesh.vertexIndexLimit() == 2);
+        CPPUNIT_ASSERT(mesh.edgeIndex(edgePtr) == 0);
+        CPPUNIT_ASSERT(mesh.faceIndex(facePtr) == 0);
+
+        mesh::VertexHandle vertexHandle = mesh.vertexHandle(vertexPtr0);
+        mesh::EdgeHandle edgeHandle = mesh.edgeHandle(edgePtr);
+        mesh::FaceHandle faceHandle = mesh.faceHandle(facePtr);
+        CPPUNIT_ASSERT(mesh.findVertex(vertexHandle) == vertexPtr0);
+        CPPUNIT_ASSERT(mesh.findEdge(edgeHandle) == edgePtr);
+        CPPUNIT_ASSERT(mesh.findFace(faceHandle) == facePtr);
+
+        mesh.destroyVertex(vertexPtr0);
+        mesh.destroyEdge(edgePtr);
+        mesh.destroyFace(facePtr);
+        CPPUNIT_ASSERT(mesh.findVertex(vertexHandle) == mesh.vertexEnd());
+        CPPUNIT_ASSERT(mesh.findEdge(edgeHandle) == mesh.edgeEnd());
+        CPPUNIT_ASSERT(mesh.findFace(faceHandle) == mesh.faceEnd());
+
+        // The index of the destroyed vertex is reused.
+        mesh::VertexPtr vertexPtr2 = mesh.createVertex();
+        CPPUNIT_ASSERT(mesh.vertexIndex(vertexPtr2) == 0);
+        CPPUNIT_ASSERT(mesh.findVertex(vertexHandle) == mesh.vertexEnd());
+    }
+
+    void testSwap() {
+        Mesh mesh1;
+        mesh1.createVertex()->setPosition(cgmath::Vector3f(1, 2, 3));
+        Mesh mesh2;
+        mesh1.swap(mesh2);
+
+        CPPUNIT_ASSERT(mesh1.vertexCount() == 0);
+        CPPUNIT_ASSERT(mesh1.vertexBegin() == mesh1.vertexEnd());
+        CPPUNIT_ASSERT(mesh2.vertexCount() == 1);
+        CPPUNIT_ASSERT(mesh2.vertexBegin()->position() == cgmath::Vector3f(1, 2, 3));
+        CPPUNIT_ASSERT(++mesh2.vertexBegin() == mesh2.vertexEnd());
+    }
+
+    void testReorderElements() {
+        Mesh mesh;
+
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            0, 1, 0
+        };
+        unsigned faceVertexIndexArray[] = {
+            0, 1, 3,
+            1, 2, 3
+        };
+        float valueArray[] = {
+            0, 1, 2,
+            3, 4, 5
+        };
+        mesh::AttributeKey key = mesh.getAttributeKey("value", mesh::AttributeKey::FLOAT);
+        mesh::MeshBuilder meshBuilder;
+        meshBuilder.setMesh(&mesh);
+        meshBuilder.setVertexPositionArray(4, vertexPositionArray);
+        meshBuilder.setFaceArray(2, NULL, faceVertexIndexArray);
+        meshBuilder.addFaceVertexAttributeArray(key, valueArray);
+        meshBuilder.build();
+        meshBuilder.facePtrVector()[1]->setInt(mesh.getAttributeKey("face",
+                mesh::AttributeKey::INT), 7);
+
+        // Reverse the order of all the elements.
+        std::vector<mesh::VertexPtr> vertexPtrVector(meshBuilder.vertexPtrVector().rbegin(),
+            meshBuilder.vertexPtrVector().rend());
+        std::vector<mesh::EdgePtr> edgePtrVector(meshBuilder.edgePtrVector().rbegin(),
+            meshBuilder.edgePtrVector().rend());
+        std::vector<mesh::FacePtr> facePtrVector(meshBuilder.facePtrVector().rbegin(),
+            meshBuilder.facePtrVector().rend());
+        mesh.reorderElements(vertexPtrVector, edgePtrVector, facePtrVector);
+
+        CPPUNIT_ASSERT(mesh::IsConsistent(mesh));
+        CPPUNIT_ASSERT(mesh.vertexCount() == 4);
+        CPPUNIT_ASSERT(mesh.edgeCount() == 5);
+        CPPUNIT_ASSERT(mesh.faceCount() == 2);
+
+        CPPUNIT_ASSERT(mesh.vertexBegin()->position() == cgmath::Vector3f(0, 1, 0));
+        CPPUNIT_ASSERT(mesh.vertexIndex(mesh.vertexBegin()) == 0);
+
+        // The face that was last is now first, with its attributes
+        // and the face vertex attributes of its corners.
+        mesh::FacePtr facePtr = mesh.faceBegin();
+        CPPUNIT_ASSERT(facePtr->getInt(mesh.getAttributeKey("face",
+                    mesh::AttributeKey::INT)) == 7);
+        CPPUNIT_ASSERT(facePtr->cornerVertexPtr(0)->position() == cgmath::Vector3f(1, 0, 0));
+        for (unsigned corner = 0; corner < 3; ++corner) {
+            CPPUNIT_ASSERT(facePtr->cornerAttributes(corner).getFloat(key) == 3 + corner);
+        }
+        CPPUNIT_ASSERT(facePtr->adjacentEdgeCount() == 3);
+    }
+
+    void testReorderNonadjacentFaceVertex() {
+        Mesh mesh;
+
+        // A face with a face vertex attribute of a vertex that isn't
+        // adjacent to it, as a mesh might briefly have while it's edited.
+        mesh::AttributeKey key = mesh.getAttributeKey("value", mesh::AttributeKey::FLOAT);
+        mesh::VertexPtr vertexPtr = mesh.createVertex();
+        mesh::FacePtr facePtr = mesh.createFace();
+        facePtr->setVertexFloat(vertexPtr, key, 9);
+
+        mesh.reorderElements(std::vector<mesh::VertexPtr>(1, vertexPtr),
+            std::vector<mesh::EdgePtr>(), std::vector<mesh::FacePtr>(1, facePtr));
+
+        CPPUNIT_ASSERT(mesh.faceBegin()->faceVertexVectorSize() == 1);
+        CPPUNIT_ASSERT(mesh.faceBegin()->getVertexFloat(mesh.vertexBegin(), key) == 9);
+    }
+
+    void testSortElementsAlongMortonCurve() {
+        Mesh mesh;
+
+        // Vertices along a line, created out of order.
+        float positionArray[] = { 3, 0, 4, 1, 2 };
+        for (int index = 0; index < 5; ++index) {
+            mesh.createVertex()->setPosition(cgmath::Vector3f(positionArray[index], 0, 0));
+        }
+
+        mesh::SortElementsAlongMortonCurve(&mesh);
+
+        CPPUNIT_ASSERT(mesh.vertexCount() == 5);
+        float x = 0;
+        for (mesh::VertexPtr vertexPtr = mesh.vertexBegin();
+             vertexPtr != mesh.vertexEnd(); ++vertexPtr) {
+            CPPUNIT_ASSERT(vertexPtr->position()[0] == x);
+            x += 1;
+        }
+    }
+
+    void testMemoryUsage() {
+        Mesh mesh;
+
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            0, 1, 0
+        };
+        unsigned faceVertexIndexArray[] = {
+            0, 1, 3,
+            1, 2, 3
+        };
+        float valueArray[] = {
+            0, 1, 2,
+            3, 4, 5
+        };
+        mesh::AttributeKey key = mesh.getAttributeKey("value", mesh::AttributeKey::FLOAT);
+        mesh::MeshBuilder meshBuilder;
+        meshBuilder.setMesh(&mesh);
+        meshBuilder.setVertexPositionArray(4, vertexPositionArray);
+        meshBuilder.setFaceArray(2, NULL, faceVertexIndexArray);
+        meshBuilder.addFaceVertexAttributeArray(key, valueArray);
+        meshBuilder.build();
+
+        // A string is allocated separately from its AttributeData.
+        std::string name(100, 'x');
+        mesh.setString(mesh.getAttributeKey("name", mesh::AttributeKey::STRING), name);
+
+        mesh::MeshMemoryUsage memoryUsage = mesh.memoryUsage();
+        CPPUNIT_ASSERT(memoryUsage.mVertexBytes > 0);
+        CPPUNIT_ASSERT(memoryUsage.mEdgeBytes > 0);
+        CPPUNIT_ASSERT(memoryUsage.mFaceBytes > 0);
+
+        // Every vertex has few enough neighbors to fit inline.
+        CPPUNIT_ASSERT(memoryUsage.mAdjacencyBytes == 0);
+
+        CPPUNIT_ASSERT(memoryUsage.mAttributeBytesMap.size() == 2);
+        CPPUNIT_ASSERT(memoryUsage.mAttributeBytesMap["value"]
+            == 6*sizeof(mesh::AttributeData));
+        CPPUNIT_ASSERT(memoryUsage.mAttributeBytesMap["name"]
+            >= sizeof(mesh::AttributeData) + sizeof(std::string) + name.size());
+        CPPUNIT_ASSERT(memoryUsage.mFaceVertexBytes == 6*sizeof(mesh::FaceVertex));
+
+        CPPUNIT_ASSERT(memoryUsage.totalBytes() == memoryUsage.mVertexBytes
+            + memoryUsage.mEdgeBytes + memoryUsage.mFaceBytes + memoryUsage.mAdjacencyBytes
+            + memoryUsage.attributeBytes() + memoryUsage.mUnusedAttributeBytes
+            + memoryUsage.mFaceVertexBytes);
+
+        // A vertex with more adjacent faces than fit inline
+        // allocates its adjacency separately.
+        mesh::VertexPtr vertexPtr = mesh.vertexBegin();
+        vertexPtr->reserveAdjacentFaces(100);
+        CPPUNIT_ASSERT(mesh.memoryUsage().mAdjacencyBytes
+            == 100*sizeof(mesh::FacePtr));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(MeshTest);
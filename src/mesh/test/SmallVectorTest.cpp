@@ -0,0 +1,139 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <mesh/SmallVector.h>
+
+using mesh::SmallVector;
+
+class SmallVectorTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(SmallVectorTest);
+    CPPUNIT_TEST(testPushBack);
+    CPPUNIT_TEST(testInsert);
+    CPPUNIT_TEST(testErase);
+    CPPUNIT_TEST(testCopy);
+    CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    typedef SmallVector<int, 3> IntVector;
+
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testPushBack() {
+        IntVector vector;
+        CPPUNIT_ASSERT(vector.empty());
+        CPPUNIT_ASSERT(vector.begin() == vector.end());
+        CPPUNIT_ASSERT(vector.isInline());
+
+        for (int index = 0; index < 3; ++index) {
+            vector.push_back(index);
+        }
+        CPPUNIT_ASSERT(vector.size() == 3);
+        CPPUNIT_ASSERT(vector.isInline());
+
+        // Memory is only allocated when the inline capacity is exceeded.
+        for (int index = 3; index < 10; ++index) {
+            vector.push_back(index);
+        }
+        CPPUNIT_ASSERT(vector.size() == 10);
+        CPPUNIT_ASSERT(!vector.isInline());
+        CPPUNIT_ASSERT(vector.capacity() >= 10);
+
+        int expected = 0;
+        for (IntVector::const_iterator iterator = vector.begin();
+             iterator != vector.end(); ++iterator) {
+            CPPUNIT_ASSERT(*iterator == expected);
+            ++expected;
+        }
+        CPPUNIT_ASSERT(expected == 10);
+
+        expected = 9;
+        for (IntVector::reverse_iterator iterator = vector.rbegin();
+             iterator != vector.rend(); ++iterator) {
+            CPPUNIT_ASSERT(*iterator == expected);
+            --expected;
+        }
+        CPPUNIT_ASSERT(expected == -1);
+    }
+
+    void testInsert() {
+        IntVector vector;
+        vector.push_back(1);
+        vector.push_back(3);
+        CPPUNIT_ASSERT(*vector.insert(vector.begin() + 1, 2) == 2);
+        CPPUNIT_ASSERT(*vector.insert(vector.begin(), 0) == 0);
+        CPPUNIT_ASSERT(vector.size() == 4);
+        for (int index = 0; index < 4; ++index) {
+            CPPUNIT_ASSERT(vector[index] == index);
+        }
+
+        // Inserting an element of the vector into itself while
+        // the vector grows.
+        vector.insert(vector.begin(), vector[3]);
+        CPPUNIT_ASSERT(vector.size() == 5);
+        CPPUNIT_ASSERT(vector[0] == 3);
+        CPPUNIT_ASSERT(vector[4] == 3);
+    }
+
+    void testErase() {
+        IntVector vector;
+        for (int index = 0; index < 5; ++index) {
+            vector.push_back(index);
+        }
+
+        IntVector::iterator iterator = vector.erase(vector.begin() + 1);
+        CPPUNIT_ASSERT(*iterator == 2);
+        vector.erase(vector.end() - 1);
+        CPPUNIT_ASSERT(vector.size() == 3);
+        CPPUNIT_ASSERT(vector[0] == 0);
+        CPPUNIT_ASSERT(vector[1] == 2);
+        CPPUNIT_ASSERT(vector[2] == 3);
+    }
+
+    void testCopy() {
+        IntVector small;
+        small.push_back(1);
+
+        IntVector large;
+        for (int index = 0; index < 5; ++index) {
+            large.push_back(index);
+        }
+
+        IntVector smallCopy(small);
+        CPPUNIT_ASSERT(smallCopy.size() == 1);
+        CPPUNIT_ASSERT(smallCopy.isInline());
+        CPPUNIT_ASSERT(smallCopy[0] == 1);
+
+        IntVector largeCopy(large);
+        CPPUNIT_ASSERT(largeCopy.size() == 5);
+        CPPUNIT_ASSERT(largeCopy.begin() != large.begin());
+        CPPUNIT_ASSERT(largeCopy[4] == 4);
+
+        smallCopy = large;
+        CPPUNIT_ASSERT(smallCopy.size() == 5);
+        CPPUNIT_ASSERT(smallCopy[4] == 4);
+
+        largeCopy = small;
+        CPPUNIT_ASSERT(largeCopy.size() == 1);
+        CPPUNIT_ASSERT(largeCopy[0] == 1);
+    }
+
+    void testClear() {
+        IntVector vector;
+        for (int index = 0; index < 5; ++index) {
+            vector.push_back(index);
+        }
+        vector.clear();
+        CPPUNIT_ASSERT(vector.empty());
+        CPPUNIT_ASSERT(vector.isInline());
+        CPPUNIT_ASSERT(vector.capacity() == 3);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SmallVectorTest);
@@ -7,6 +7,7 @@
 #include <mesh/SplitEdgeTriangulator.h>
 #include <mesh/Mesh.h>
 #include <mesh/EdgeOperations.h>
+#include <mesh/VertexOperations.h>
 #include <meshprim/CreateTriangleMesh.h>
 
 class SplitEdgeTriangulatorTest : public CppUnit::TestFixture
@@ -16,6 +17,7 @@ class SplitEdgeTriangulatorTest : public CppUnit::TestFixture
     CPPUNIT_TEST(testTriangulateOneEdgeSplit);
     CPPUNIT_TEST(testTriangulateTwoEdgesSplit);
     CPPUNIT_TEST(testTriangulateThreeEdgesSplit);
+    CPPUNIT_TEST(testTriangulateFaces);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -57,6 +59,50 @@ public:
         CPPUNIT_ASSERT(mesh.faceCount() == 4);
     }
 
+    void testTriangulateFaces() {
+        // Two triangles sharing the edge from vertex 1 to vertex 2.
+        float vertexPositionArray[] = {
+            0, 0, 0,
+            5, 0, 0,
+            5, 5, 0,
+            10, 5, 0
+        };
+        int faceVertexIndexArray[] = {
+            0, 1, 2,
+            1, 3, 2
+        };
+        mesh::Mesh mesh;
+        std::vector<mesh::VertexPtr> vertexPtrVector;
+        std::vector<mesh::EdgePtr> edgePtrVector;
+        std::vector<mesh::FacePtr> facePtrVector;
+        meshprim::CreateTriangleMesh(&mesh,
+            sizeof(vertexPositionArray)/sizeof(float)/3, vertexPositionArray,
+            sizeof(faceVertexIndexArray)/sizeof(int)/3, faceVertexIndexArray,
+            &vertexPtrVector, &edgePtrVector, &facePtrVector);
+
+        mesh::SplitEdgeTriangulator splitEdgeTriangulator;
+        splitEdgeTriangulator.setMesh(&mesh);
+        splitEdgeTriangulator.initialize();
+
+        mesh::EdgePtr edgeToSplit;
+        CPPUNIT_ASSERT(mesh::FindEdgeConnectingVertices(vertexPtrVector[1],
+                vertexPtrVector[2], &edgeToSplit));
+        mesh::VertexPtr newVertexPtr;
+        mesh::SplitEdge(&mesh, edgeToSplit, cgmath::Vector3f(5, 2.5, 0), 
+            &newVertexPtr, NULL);
+        newVertexPtr->setBool(splitEdgeTriangulator.splitEdgeVertexAttributeKey(), true);
+
+        mesh::SplitEdgeTriangulator::FacePtrVector newFacePtrVector;
+        splitEdgeTriangulator.triangulateFaces(facePtrVector, &newFacePtrVector);
+
+        CPPUNIT_ASSERT(mesh.vertexCount() == 5);
+        CPPUNIT_ASSERT(mesh.edgeCount() == 8);
+        CPPUNIT_ASSERT(mesh.faceCount() == 4);
+        CPPUNIT_ASSERT(newFacePtrVector.size() == 4);
+        CPPUNIT_ASSERT(!newVertexPtr->hasAttribute(
+                splitEdgeTriangulator.splitEdgeVertexAttributeKey()));
+    }
+
     // Add a triangle to the mesh, and then split the specified number
     // of edges of the triangle using SplitEdgeTriangulator.
     void createSplitTriangle(mesh::Mesh *mesh, unsigned edgesToSplit) {
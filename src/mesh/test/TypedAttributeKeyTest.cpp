@@ -0,0 +1,93 @@
+// Copyright 2010 Drew Olbrich
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cgmath/Vector2f.h>
+#include <cgmath/Vector3f.h>
+#include <mesh/TypedAttributeKey.h>
+#include <mesh/StandardAttributes.h>
+#include <mesh/Mesh.h>
+
+using mesh::TypedAttributeKey;
+
+class TypedAttributeKeyTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TypedAttributeKeyTest);
+    CPPUNIT_TEST(testAttributePossessor);
+    CPPUNIT_TEST(testFaceVertex);
+    CPPUNIT_TEST(testStandardAttributes);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+
+    void tearDown() {
+    }
+
+    void testAttributePossessor() {
+        mesh::Mesh mesh;
+        mesh::AttributeKey attributeKey = mesh.getAttributeKey("test", 
+            mesh::AttributeKey::VECTOR3F);
+        TypedAttributeKey<cgmath::Vector3f> key(attributeKey);
+        CPPUNIT_ASSERT(key.isDefined());
+        CPPUNIT_ASSERT(key.handle() == attributeKey.handle());
+
+        mesh::VertexPtr vertexPtr = mesh.createVertex();
+        CPPUNIT_ASSERT(vertexPtr->getValue(key) == mesh::AttributeKey::DEFAULT_VECTOR3F);
+
+        // Values set through the typed key are seen through the untyped
+        // key, and vice versa.
+        vertexPtr->setValue(key, cgmath::Vector3f(1, 2, 3));
+        CPPUNIT_ASSERT(vertexPtr->hasAttribute(key));
+        CPPUNIT_ASSERT(vertexPtr->getVector3f(attributeKey) == cgmath::Vector3f(1, 2, 3));
+        vertexPtr->setVector3f(attributeKey, cgmath::Vector3f(4, 5, 6));
+        CPPUNIT_ASSERT(vertexPtr->getValue(key) == cgmath::Vector3f(4, 5, 6));
+
+        TypedAttributeKey<int32_t> intKey(mesh.getAttributeKey("int", 
+                mesh::AttributeKey::INT));
+        vertexPtr->setValue(intKey, 7);
+        CPPUNIT_ASSERT(vertexPtr->getValue(intKey) == 7);
+        CPPUNIT_ASSERT(vertexPtr->getValue(key) == cgmath::Vector3f(4, 5, 6));
+    }
+
+    void testFaceVertex() {
+        mesh::Mesh mesh;
+        TypedAttributeKey<cgmath::Vector2f> key(mesh.getAttributeKey("test", 
+                mesh::AttributeKey::VECTOR2F));
+
+        mesh::VertexPtr vertexPtr = mesh.createVertex();
+        mesh::FacePtr facePtr = mesh.createFace();
+        facePtr->addAdjacentVertex(vertexPtr);
+        vertexPtr->addAdjacentFace(facePtr);
+
+        CPPUNIT_ASSERT(facePtr->getVertexValue(vertexPtr, key) 
+            == mesh::AttributeKey::DEFAULT_VECTOR2F);
+        facePtr->setVertexValue(vertexPtr, key, cgmath::Vector2f(1, 2));
+        CPPUNIT_ASSERT(facePtr->hasVertexAttribute(vertexPtr, key));
+        CPPUNIT_ASSERT(facePtr->getVertexValue(vertexPtr, key) == cgmath::Vector2f(1, 2));
+        CPPUNIT_ASSERT(facePtr->getVertexVector2f(vertexPtr, key) == cgmath::Vector2f(1, 2));
+        CPPUNIT_ASSERT(!facePtr->hasAttribute(key));
+    }
+
+    void testStandardAttributes() {
+        mesh::Mesh mesh;
+
+        // The typed keys refer to the same attributes as the untyped keys.
+        CPPUNIT_ASSERT(mesh::GetNormal3fTypedAttributeKey(mesh).key()
+            == mesh::GetNormal3fAttributeKey(mesh));
+        CPPUNIT_ASSERT(mesh::GetColor3fTypedAttributeKey(mesh).key()
+            == mesh::GetColor3fAttributeKey(mesh));
+        CPPUNIT_ASSERT(mesh::GetMaterialIndexTypedAttributeKey(mesh).key()
+            == mesh::GetMaterialIndexAttributeKey(mesh));
+
+        mesh::FacePtr facePtr = mesh.createFace();
+        TypedAttributeKey<cgmath::Vector3f> normal3fKey 
+            = mesh::GetNormal3fTypedAttributeKey(mesh);
+        facePtr->setValue(normal3fKey, cgmath::Vector3f(0, 0, 1));
+        CPPUNIT_ASSERT(facePtr->getUnitVector3f(mesh::GetNormal3fAttributeKey(mesh))
+            == cgmath::Vector3f(0, 0, 1));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TypedAttributeKeyTest);
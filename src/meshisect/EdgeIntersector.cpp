@@ -2,6 +2,8 @@
 
 #include "EdgeIntersector.h"
 
+#include <cassert>
+
 #include <mesh/Mesh.h>
 
 namespace meshisect {
@@ -49,18 +51,37 @@ EdgeIntersector::initialize()
 bool
 EdgeIntersector::applyToTetrahedronIntersection(const cgmath::Vector3f &v0,
     const cgmath::Vector3f &v1, const cgmath::Vector3f &v2, const cgmath::Vector3f &v3,
-    TetrahedronListener *tetrahedronListener) const
+    TetrahedronListener *tetrahedronListener,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics) const
 {
     return mEdgeIntersectorAabbTree.applyToTetrahedronIntersection(v0, v1, v2, v3,
-        tetrahedronListener);
+        tetrahedronListener, aabbTreeStatistics);
 }
 
 bool
 EdgeIntersector::applyToBoundingBoxIntersection(const cgmath::BoundingBox3f &boundingBox,
-    BoundingBoxListener *boundingBoxListener) const
+    BoundingBoxListener *boundingBoxListener,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics) const
 {
     return mEdgeIntersectorAabbTree.applyToBoundingBoxIntersection(boundingBox, 
-        boundingBoxListener);
+        boundingBoxListener, aabbTreeStatistics);
+}
+
+void
+EdgeIntersector::findBoundingBoxIntersections(const BoundingBox3fVector &boundingBoxVector,
+    std::vector<unsigned> *offsetVector, std::vector<unsigned> *edgeIndexVector,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics) const
+{
+    mEdgeIntersectorAabbTree.findBoundingBoxIntersections(boundingBoxVector, offsetVector,
+        edgeIndexVector, aabbTreeStatistics);
+}
+
+const EdgeIntersectorAabbTreeNode &
+EdgeIntersector::edgeIntersectorAabbTreeNode(unsigned edgeIndex) const
+{
+    assert(edgeIndex < mEdgeIntersectorAabbTree.objectVector().size());
+
+    return mEdgeIntersectorAabbTree.objectVector()[edgeIndex];
 }
 
 } // namespace meshisect
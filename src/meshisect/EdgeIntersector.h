@@ -3,6 +3,8 @@
 #ifndef MESHISECT__EDGE_INTERSECTOR__INCLUDED
 #define MESHISECT__EDGE_INTERSECTOR__INCLUDED
 
+#include <vector>
+
 #include <cgmath/BoundingBox3f.h>
 #include <mesh/Types.h>
 
@@ -19,6 +21,9 @@ namespace meshisect {
 //
 // Class that uses an axis aligned bounding box hierarchy to accelerate 
 // intersection tests of edges and tetrahedrons.
+//
+// The queries may optionally add the number of tests they perform
+// to an AabbTreeStatistics object.
 
 class EdgeIntersector
 {
@@ -40,7 +45,8 @@ public:
     // Returns true if any listener function call returns true.
     bool applyToTetrahedronIntersection(const cgmath::Vector3f &v0, 
         const cgmath::Vector3f &v1, const cgmath::Vector3f &v2, const cgmath::Vector3f &v3,
-        TetrahedronListener *tetrahedronListener) const;
+        TetrahedronListener *tetrahedronListener,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     typedef cgmath::AabbTree<
         EdgeIntersectorAabbTreeNode>::BoundingBoxListener BoundingBoxListener;
@@ -48,7 +54,20 @@ public:
     // Apply the BoundingBoxListener to all edges that intersect a bounding box.
     // Returns true if any listener function call returns true.
     bool applyToBoundingBoxIntersection(const cgmath::BoundingBox3f &boundingBox,
-        BoundingBoxListener *boundingBoxListener) const;
+        BoundingBoxListener *boundingBoxListener,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    typedef EdgeIntersectorAabbTree::BoundingBox3fVector BoundingBox3fVector;
+
+    // Find the edges that intersect each of a vector of bounding boxes,
+    // as with cgmath::AabbTree::findBoundingBoxIntersections. The edges are
+    // returned as indices that are passed to edgeIntersectorAabbTreeNode.
+    void findBoundingBoxIntersections(const BoundingBox3fVector &boundingBoxVector,
+        std::vector<unsigned> *offsetVector, std::vector<unsigned> *edgeIndexVector,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // The AABB tree node of an edge returned by findBoundingBoxIntersections.
+    const EdgeIntersectorAabbTreeNode &edgeIntersectorAabbTreeNode(unsigned edgeIndex) const;
 
 private:
     mesh::Mesh *mMesh;
@@ -2,17 +2,26 @@
 
 #include "FaceIntersector.h"
 
+#include <cassert>
 #include <cstdlib>
+#include <sstream>
 
+#include <except/Exception.h>
+#include <con/Streams.h>
 #include <mesh/Mesh.h>
 #include <mesh/FaceOperations.h>
 
+#include "FaceIntersectorAabbTreeFile.h"
+
 namespace meshisect {
 
 FaceIntersector::FaceIntersector()
     : mMesh(NULL),
       mFaceIntersectorAabbTree(),
-      mFaceIntersectorAabbTreeNodeVector(),
+      mFaceIntersectorWideAabbTree(),
+      mFaceIntersectorQuantizedAabbTree(),
+      mQuantizeAabbTree(false),
+      mAabbTreeFilename(),
       mFaceIntersectorListener(NULL)
 {
 }
@@ -40,63 +49,265 @@ FaceIntersector::setIntersectorFaceListener(
     mFaceIntersectorListener = faceIntersectorListener;
 }
 
+void
+FaceIntersector::setSplitStrategy(SplitStrategy splitStrategy)
+{
+    mFaceIntersectorAabbTree.setSplitStrategy(splitStrategy);
+}
+
+FaceIntersector::SplitStrategy
+FaceIntersector::splitStrategy() const
+{
+    return mFaceIntersectorAabbTree.splitStrategy();
+}
+
+void
+FaceIntersector::setQuantizeAabbTree(bool quantizeAabbTree)
+{
+    mQuantizeAabbTree = quantizeAabbTree;
+}
+
+bool
+FaceIntersector::quantizeAabbTree() const
+{
+    return mQuantizeAabbTree;
+}
+
+void
+FaceIntersector::setAabbTreeFilename(const std::string &aabbTreeFilename)
+{
+    mAabbTreeFilename = aabbTreeFilename;
+}
+
+const std::string &
+FaceIntersector::aabbTreeFilename() const
+{
+    return mAabbTreeFilename;
+}
+
 void
 FaceIntersector::initialize()
 {
     mFaceIntersectorAabbTree.clear();
+    mFaceIntersectorWideAabbTree.clear();
+    mFaceIntersectorQuantizedAabbTree.clear();
+
+    buildAabbTree();
 
-    mFaceIntersectorAabbTreeNodeVector.clear();
-    mFaceIntersectorAabbTreeNodeVector.reserve(mMesh->faceCount());
+    if (mQuantizeAabbTree) {
+        // The quantized tree is built from the AABB tree, which is then
+        // discarded, so that only the quantized tree occupies memory.
+        mFaceIntersectorQuantizedAabbTree.initialize(mFaceIntersectorAabbTree);
+        mFaceIntersectorAabbTree.clear();
+    } else {
+        mFaceIntersectorWideAabbTree.initialize(mFaceIntersectorAabbTree);
+    }
+}
+
+void
+FaceIntersector::buildAabbTree()
+{
+    if (!mAabbTreeFilename.empty()
+        && ReadFaceIntersectorAabbTreeFile(&mFaceIntersectorAabbTree, mMesh,
+            mAabbTreeFilename)) {
+        return;
+    }
+
+    // The AABB tree copies the nodes, so this vector is only needed
+    // while it's being built.
+    FaceIntersectorAabbTree::ObjectVector faceIntersectorAabbTreeNodeVector;
+    faceIntersectorAabbTreeNodeVector.reserve(mMesh->faceCount());
 
     for (mesh::FacePtr facePtr = mMesh->faceBegin(); facePtr != mMesh->faceEnd(); ++facePtr) {
         FaceIntersectorAabbTreeNode faceIntersectorAabbTreeNode;
         faceIntersectorAabbTreeNode.setFacePtr(facePtr);
-        mFaceIntersectorAabbTreeNodeVector.push_back(faceIntersectorAabbTreeNode);
+        faceIntersectorAabbTreeNodeVector.push_back(faceIntersectorAabbTreeNode);
     }
 
-    mFaceIntersectorAabbTree.initialize(mFaceIntersectorAabbTreeNodeVector);
+    mFaceIntersectorAabbTree.initialize(faceIntersectorAabbTreeNodeVector);
+
+    if (!mAabbTreeFilename.empty()) {
+        // The file is only an optimization, so failing to write it
+        // isn't an error.
+        try {
+            WriteFaceIntersectorAabbTreeFile(mFaceIntersectorAabbTree, *mMesh,
+                mAabbTreeFilename);
+        } catch (const except::Exception &exception) {
+            con::warn << exception.what() << std::endl;
+        }
+    }
+}
+
+void
+FaceIntersector::insertFace(mesh::FacePtr facePtr)
+{
+    expandQuantizedAabbTree();
+
+    FaceIntersectorAabbTreeNode faceIntersectorAabbTreeNode;
+    faceIntersectorAabbTreeNode.setFacePtr(facePtr);
+    mFaceIntersectorAabbTree.insertObject(faceIntersectorAabbTreeNode);
+    mFaceIntersectorWideAabbTree.clear();
+}
+
+bool
+FaceIntersector::removeFace(mesh::FacePtr facePtr)
+{
+    expandQuantizedAabbTree();
+
+    FaceIntersectorAabbTreeNode faceIntersectorAabbTreeNode;
+    faceIntersectorAabbTreeNode.setFacePtr(facePtr);
+    mFaceIntersectorWideAabbTree.clear();
+    return mFaceIntersectorAabbTree.removeObject(faceIntersectorAabbTreeNode);
 }
 
 bool
 FaceIntersector::occludesRaySegment(const cgmath::Vector3f &origin, 
-    const cgmath::Vector3f &endpoint) const
+    const cgmath::Vector3f &endpoint, cgmath::AabbTreeStatistics *aabbTreeStatistics,
+    OccluderCache *occluderCache) const
 {
-    return mFaceIntersectorAabbTree.occludesRaySegment(origin, endpoint, this);
+    if (occluderCache == NULL) {
+        return occludesRaySegmentWithListener(origin, endpoint, this, aabbTreeStatistics);
+    }
+
+    if (occluderCache->hasFacePtr()
+        && faceOccludesRaySegment(occluderCache->facePtr(), origin, endpoint)) {
+        if (aabbTreeStatistics != NULL) {
+            aabbTreeStatistics->addQuery(0, 1);
+        }
+        return true;
+    }
+
+    OccluderRecorder occluderRecorder(this);
+    if (occludesRaySegmentWithListener(origin, endpoint, &occluderRecorder,
+            aabbTreeStatistics)) {
+        occluderCache->setFacePtr(occluderRecorder.facePtr());
+        return true;
+    }
+
+    return false;
+}
+
+void
+FaceIntersector::occludesRaySegments(const Vector3fVector &originVector,
+    const Vector3fVector &endpointVector, std::vector<bool> *occludedVector,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics, OccluderCache *occluderCache) const
+{
+    assert(originVector.size() == endpointVector.size());
+
+    // Even without a cache from the caller, rays in the same batch
+    // are assumed to be coherent enough to share one.
+    OccluderCache localOccluderCache;
+    if (occluderCache == NULL) {
+        occluderCache = &localOccluderCache;
+    }
+
+    occludedVector->resize(originVector.size());
+    for (size_t index = 0; index < originVector.size(); ++index) {
+        (*occludedVector)[index] = occludesRaySegment(originVector[index],
+            endpointVector[index], aabbTreeStatistics, occluderCache);
+    }
 }
 
 bool
 FaceIntersector::objectOccludesRaySegment(
     const FaceIntersectorAabbTreeNode &faceIntersectorAabbTreeNode,
     const cgmath::Vector3f &origin, const cgmath::Vector3f &endpoint) const
+{
+    return faceOccludesRaySegment(faceIntersectorAabbTreeNode.facePtr(), origin, endpoint);
+}
+
+bool
+FaceIntersector::faceOccludesRaySegment(mesh::FacePtr facePtr,
+    const cgmath::Vector3f &origin, const cgmath::Vector3f &endpoint) const
 {
     float t = 0.0;
-    if (!mesh::RaySegmentIntersectsFace(faceIntersectorAabbTreeNode.facePtr(),
-            origin, endpoint, &t)) {
+    if (!mesh::RaySegmentIntersectsFace(facePtr, origin, endpoint, &t)) {
         return false;
     }
 
     if (mFaceIntersectorListener != NULL
-        && !mFaceIntersectorListener->allowFaceIntersectionTest(
-            faceIntersectorAabbTreeNode.facePtr(), t)) {
+        && !mFaceIntersectorListener->allowFaceIntersectionTest(facePtr, t)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool
+FaceIntersector::occludesRaySegmentWithListener(const cgmath::Vector3f &origin,
+    const cgmath::Vector3f &endpoint,
+    const cgmath::AabbTree<FaceIntersectorAabbTreeNode>::RaySegmentOcclusionListener
+        *raySegmentOcclusionListener,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics) const
+{
+    if (!mFaceIntersectorWideAabbTree.empty()) {
+        return mFaceIntersectorWideAabbTree.occludesRaySegment(origin, endpoint,
+            raySegmentOcclusionListener, aabbTreeStatistics);
+    }
+
+    if (!mFaceIntersectorQuantizedAabbTree.empty()) {
+        return mFaceIntersectorQuantizedAabbTree.occludesRaySegment(origin, endpoint,
+            raySegmentOcclusionListener, aabbTreeStatistics);
+    }
+
+    return mFaceIntersectorAabbTree.occludesRaySegment(origin, endpoint,
+        raySegmentOcclusionListener, aabbTreeStatistics);
+}
+
+FaceIntersector::OccluderRecorder::OccluderRecorder(const FaceIntersector *faceIntersector)
+    : mFaceIntersector(faceIntersector),
+      mFacePtr()
+{
+}
+
+FaceIntersector::OccluderRecorder::~OccluderRecorder()
+{
+}
+
+const mesh::FacePtr &
+FaceIntersector::OccluderRecorder::facePtr() const
+{
+    return mFacePtr;
+}
+
+bool
+FaceIntersector::OccluderRecorder::objectOccludesRaySegment(
+    const FaceIntersectorAabbTreeNode &faceIntersectorAabbTreeNode,
+    const cgmath::Vector3f &origin, const cgmath::Vector3f &endpoint) const
+{
+    if (!mFaceIntersector->faceOccludesRaySegment(faceIntersectorAabbTreeNode.facePtr(),
+            origin, endpoint)) {
         return false;
     }
 
+    mFacePtr = faceIntersectorAabbTreeNode.facePtr();
+
     return true;
 }
 
 bool
 FaceIntersector::intersectsRaySegment(const cgmath::Vector3f &origin,
     const cgmath::Vector3f &endpoint, cgmath::Vector3f *intersectionPoint,
-    mesh::FacePtr *facePtr)
+    mesh::FacePtr *facePtr, cgmath::AabbTreeStatistics *aabbTreeStatistics) const
 {
     FaceIntersectorAabbTreeNode *faceIntersectorAabbTreeNode = NULL;
-    if (mFaceIntersectorAabbTree.intersectsRaySegment(origin, endpoint, this,
-            intersectionPoint, &faceIntersectorAabbTreeNode)) {
+    bool result = false;
+    if (!mFaceIntersectorWideAabbTree.empty()) {
+        result = mFaceIntersectorWideAabbTree.intersectsRaySegment(origin, endpoint, this,
+            intersectionPoint, &faceIntersectorAabbTreeNode, aabbTreeStatistics);
+    } else if (!mFaceIntersectorQuantizedAabbTree.empty()) {
+        result = mFaceIntersectorQuantizedAabbTree.intersectsRaySegment(origin, endpoint,
+            this, intersectionPoint, &faceIntersectorAabbTreeNode, aabbTreeStatistics);
+    } else {
+        result = mFaceIntersectorAabbTree.intersectsRaySegment(origin, endpoint, this,
+            intersectionPoint, &faceIntersectorAabbTreeNode, aabbTreeStatistics);
+    }
+
+    if (result) {
         *facePtr = faceIntersectorAabbTreeNode->facePtr();
-        return true;
     }
 
-    return false;
+    return result;
 }
 
 bool
@@ -131,18 +342,36 @@ FaceIntersector::objectIntersectsRaySegment(
 
 void
 FaceIntersector::applyToTriangleVectorIntersection(const TriangleVector &triangleVector,
-    TriangleListener *triangleListener) const
+    TriangleListener *triangleListener, cgmath::AabbTreeStatistics *aabbTreeStatistics) const
 {
+    if (!mFaceIntersectorQuantizedAabbTree.empty()) {
+        mFaceIntersectorQuantizedAabbTree.applyToTriangleVectorIntersection(triangleVector,
+            triangleListener, aabbTreeStatistics);
+        return;
+    }
+
     mFaceIntersectorAabbTree.applyToTriangleVectorIntersection(triangleVector,
-        triangleListener);
+        triangleListener, aabbTreeStatistics);
 }
 
 bool
 FaceIntersector::applyToBoundingBoxIntersection(const cgmath::BoundingBox3f &boundingBox,
-    BoundingBoxListener *boundingBoxListener) const
+    BoundingBoxListener *boundingBoxListener,
+    cgmath::AabbTreeStatistics *aabbTreeStatistics) const
 {
+    if (!mFaceIntersectorQuantizedAabbTree.empty()) {
+        return mFaceIntersectorQuantizedAabbTree.applyToBoundingBoxIntersection(boundingBox,
+            boundingBoxListener, aabbTreeStatistics);
+    }
+
     return mFaceIntersectorAabbTree.applyToBoundingBoxIntersection(boundingBox,
-        boundingBoxListener);
+        boundingBoxListener, aabbTreeStatistics);
+}
+
+const FaceIntersectorAabbTree &
+FaceIntersector::faceIntersectorAabbTree() const
+{
+    return mFaceIntersectorAabbTree;
 }
 
 std::string
@@ -151,16 +380,37 @@ FaceIntersector::aabbSizeStatistics() const
     return mFaceIntersectorAabbTree.sizeStatistics();
 }
 
+size_t
+FaceIntersector::bytesUsed() const
+{
+    return mFaceIntersectorAabbTree.bytesUsed()
+        + mFaceIntersectorWideAabbTree.bytesUsed()
+        + mFaceIntersectorQuantizedAabbTree.bytesUsed();
+}
+
 std::string
-FaceIntersector::aabbQueryStatistics() const
+FaceIntersector::aabbMemoryStatistics() const
 {
-    return mFaceIntersectorAabbTree.queryStatistics();
+    std::ostringstream ostr;
+
+    ostr << mFaceIntersectorAabbTree.memoryStatistics() << std::endl;
+    ostr << "Wide AABB tree: " << mFaceIntersectorWideAabbTree.bytesUsed()
+        << " bytes" << std::endl;
+    ostr << "Quantized AABB tree: " << mFaceIntersectorQuantizedAabbTree.bytesUsed()
+        << " bytes";
+
+    return ostr.str();
 }
 
-unsigned
-FaceIntersector::queries() const
+void
+FaceIntersector::expandQuantizedAabbTree()
 {
-    return mFaceIntersectorAabbTree.queries();
+    if (mFaceIntersectorQuantizedAabbTree.empty()) {
+        return;
+    }
+
+    mFaceIntersectorAabbTree.initialize(mFaceIntersectorQuantizedAabbTree.objectVector());
+    mFaceIntersectorQuantizedAabbTree.clear();
 }
 
 } // namespace meshisect
@@ -3,12 +3,16 @@
 #ifndef MESHISECT__FACE_INTERSECTOR__INCLUDED
 #define MESHISECT__FACE_INTERSECTOR__INCLUDED
 
+#include <string>
+#include <vector>
+
 #include <cgmath/BoundingBox3f.h>
 #include <mesh/Types.h>
 
 #include "FaceIntersectorAabbTree.h"
 #include "FaceIntersectorAabbTreeNode.h"
 #include "FaceIntersectorListener.h"
+#include "OccluderCache.h"
 
 namespace mesh {
 class Mesh;
@@ -20,6 +24,21 @@ namespace meshisect {
 //
 // Handles efficient AABB-based intersection of rays, triangles, and bounding boxes
 // with meshisect faces.
+//
+// The queries may optionally add the number of tests they perform
+// to an AabbTreeStatistics object.
+//
+// Ray segment queries use a WideAabbTree built by initialize. Once faces
+// are inserted or removed, they fall back on the AABB tree, which is
+// updated incrementally, until initialize is called again.
+//
+// For large meshes, initialize may instead build a QuantizedAabbTree,
+// which occupies a fraction of the memory of the other two trees,
+// at the expense of somewhat slower queries. In that case, the AABB tree
+// is only rebuilt from it when faces are first inserted or removed.
+//
+// Occlusion queries may be passed an OccluderCache, in which case
+// the face that last occluded a ray segment is tested before the tree.
 
 class FaceIntersector 
     : public cgmath::AabbTree<FaceIntersectorAabbTreeNode>::RaySegmentOcclusionListener,
@@ -36,12 +55,55 @@ public:
     // Set an optional listener to ignore certain faces.
     void setIntersectorFaceListener(FaceIntersectorListener *faceIntersectorListener);
 
+    // The strategy used to build the AABB hierarchy.
+    typedef FaceIntersectorAabbTree::SplitStrategy SplitStrategy;
+    void setSplitStrategy(SplitStrategy splitStrategy);
+    SplitStrategy splitStrategy() const;
+
+    // If true, initialize builds a QuantizedAabbTree rather than an AABB tree
+    // and a WideAabbTree, to reduce memory use. The default is false.
+    void setQuantizeAabbTree(bool quantizeAabbTree);
+    bool quantizeAabbTree() const;
+
+    // An optional file in which to save the AABB tree, so that it's
+    // not rebuilt the next time the same mesh is initialized.
+    // If the file matches the mesh, initialize reads the tree from it.
+    // Otherwise, initialize builds the tree and writes it to the file.
+    // The default is an empty string, for no file.
+    void setAabbTreeFilename(const std::string &aabbTreeFilename);
+    const std::string &aabbTreeFilename() const;
+
     // Creates the AABB hierachy used for the intersection test.
     void initialize();
 
+    // Add a face that was created after the call to initialize to the AABB hierarchy.
+    void insertFace(mesh::FacePtr facePtr);
+
+    // Remove a face from the AABB hierarchy. This must be called before the face
+    // is deleted from the mesh, or its vertices are moved.
+    // Returns false if the face was not in the AABB hierarchy.
+    bool removeFace(mesh::FacePtr facePtr);
+
     // Returns true if the specified ray intersects one or more of the mesh faces.
+    // If an OccluderCache is specified, its face is tested first,
+    // and it's updated with the occluding face.
     bool occludesRaySegment(const cgmath::Vector3f &origin, 
-        const cgmath::Vector3f &endpoint) const;
+        const cgmath::Vector3f &endpoint,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL,
+        OccluderCache *occluderCache = NULL) const;
+
+    typedef std::vector<cgmath::Vector3f> Vector3fVector;
+
+    // Test an array of ray segments, each from an element of originVector
+    // to the corresponding element of endpointVector, as with occludesRaySegment.
+    // Element n of occludedVector is set to true if ray segment n is occluded.
+    // The ray segments are tested in order, so coherent ray segments,
+    // such as those cast toward the same light source, should be
+    // adjacent in the arrays and share an OccluderCache.
+    void occludesRaySegments(const Vector3fVector &originVector,
+        const Vector3fVector &endpointVector, std::vector<bool> *occludedVector,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL,
+        OccluderCache *occluderCache = NULL) const;
 
     // For cgmath:AabbTree::RaySegmentOcclusionListener:
     virtual bool objectOccludesRaySegment(
@@ -54,7 +116,8 @@ public:
     // face is also returned.
     bool intersectsRaySegment(const cgmath::Vector3f &origin, 
         const cgmath::Vector3f &endpoint, cgmath::Vector3f *intersectionPoint,
-        mesh::FacePtr *facePtr);
+        mesh::FacePtr *facePtr,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     // For cgmath::AabbTree::RaySegmentIntersectionListener:
     virtual bool objectIntersectsRaySegment(
@@ -67,7 +130,8 @@ public:
 
     // Apply the TriangleListener to all faces that intersect an array of triangles.
     void applyToTriangleVectorIntersection(const TriangleVector &triangleVector,
-        TriangleListener *triangleListener) const;
+        TriangleListener *triangleListener,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
 
     typedef cgmath::AabbTree<
         FaceIntersectorAabbTreeNode>::BoundingBoxListener BoundingBoxListener;
@@ -75,23 +139,80 @@ public:
     // Apply the BoundingBoxListener to all faces that intersect a bounding box.
     // Returns true if any listener function call returns true.
     bool applyToBoundingBoxIntersection(const cgmath::BoundingBox3f &boundingBox,
-        BoundingBoxListener *boundingBoxListener) const;
+        BoundingBoxListener *boundingBoxListener,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics = NULL) const;
+
+    // The AABB tree of the mesh's faces, for queries such as
+    // cgmath::AabbTree::findOverlappingPairs that FaceIntersector doesn't
+    // provide itself. The tree is empty if the QuantizedAabbTree is in use.
+    const FaceIntersectorAabbTree &faceIntersectorAabbTree() const;
 
     // Returns statistics about the AABB tree.
     std::string aabbSizeStatistics() const;
 
-    // Returns statistics about queries of the AABB tree.
-    std::string aabbQueryStatistics() const;
+    // Number of bytes occupied by the AABB trees.
+    size_t bytesUsed() const;
 
-    // Returns number of AABB tree queries.
-    unsigned queries() const;
+    // A string describing the memory occupied by each of the AABB trees.
+    std::string aabbMemoryStatistics() const;
 
 private:
+    // Returns true if a face occludes a ray segment and isn't ignored
+    // by the FaceIntersectorListener.
+    bool faceOccludesRaySegment(mesh::FacePtr facePtr, const cgmath::Vector3f &origin,
+        const cgmath::Vector3f &endpoint) const;
+
+    // Occlusion listener that records the face that occludes the ray segment,
+    // so that it can be stored in an OccluderCache.
+    class OccluderRecorder
+        : public cgmath::AabbTree<FaceIntersectorAabbTreeNode>::RaySegmentOcclusionListener
+    {
+    public:
+        OccluderRecorder(const FaceIntersector *faceIntersector);
+        virtual ~OccluderRecorder();
+
+        const mesh::FacePtr &facePtr() const;
+
+        virtual bool objectOccludesRaySegment(
+            const FaceIntersectorAabbTreeNode &faceIntersectorAabbTreeNode,
+            const cgmath::Vector3f &origin, const cgmath::Vector3f &endpoint) const;
+
+    private:
+        const FaceIntersector *mFaceIntersector;
+        mutable mesh::FacePtr mFacePtr;
+    };
+
+    // Test the ray segment against the AABB tree in use,
+    // with the specified listener.
+    bool occludesRaySegmentWithListener(const cgmath::Vector3f &origin,
+        const cgmath::Vector3f &endpoint,
+        const cgmath::AabbTree<FaceIntersectorAabbTreeNode>::RaySegmentOcclusionListener
+            *raySegmentOcclusionListener,
+        cgmath::AabbTreeStatistics *aabbTreeStatistics) const;
+
+    // Build the AABB tree of the mesh's faces, or read it from
+    // the AABB tree file, if there is one and it matches the mesh.
+    void buildAabbTree();
+
+    // Replace the QuantizedAabbTree, if there is one, by an AABB tree
+    // containing the same faces, so that faces can be inserted or removed.
+    void expandQuantizedAabbTree();
+
     mesh::Mesh *mMesh;
 
+    // The AABB tree, which is empty if the QuantizedAabbTree is in use.
     FaceIntersectorAabbTree mFaceIntersectorAabbTree;
 
-    FaceIntersectorAabbTree::ObjectVector mFaceIntersectorAabbTreeNodeVector;
+    // The four-way tree used for ray segment queries, which is
+    // empty if faces have been inserted or removed since initialize.
+    FaceIntersectorWideAabbTree mFaceIntersectorWideAabbTree;
+
+    // The compressed tree used for all queries when mQuantizeAabbTree
+    // is true, until faces are inserted or removed.
+    FaceIntersectorQuantizedAabbTree mFaceIntersectorQuantizedAabbTree;
+
+    bool mQuantizeAabbTree;
+    std::string mAabbTreeFilename;
 
     FaceIntersectorListener *mFaceIntersectorListener;
 };
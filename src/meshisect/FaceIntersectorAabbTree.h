@@ -4,12 +4,17 @@
 #define MESHISECT__FACE_INTERSECTOR_AABB_TREE__INCLUDED
 
 #include <cgmath/AabbTree.h>
+#include <cgmath/WideAabbTree.h>
+#include <cgmath/QuantizedAabbTree.h>
 
 #include "FaceIntersectorAabbTreeNode.h"
 
 namespace meshisect {
 
 typedef cgmath::AabbTree<FaceIntersectorAabbTreeNode> FaceIntersectorAabbTree;
+typedef cgmath::WideAabbTree<FaceIntersectorAabbTreeNode> FaceIntersectorWideAabbTree;
+typedef cgmath::QuantizedAabbTree<FaceIntersectorAabbTreeNode>
+    FaceIntersectorQuantizedAabbTree;
 
 } // namespace meshisect
 
@@ -0,0 +1,271 @@
+// Copyright 2010 Drew Olbrich
+
+#include "FaceIntersectorAabbTreeFile.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+#include <stdint.h>
+
+#include <except/FailedOperationException.h>
+#include <except/OpenFileException.h>
+#include <os/Error.h>
+#include <mesh/Mesh.h>
+#include <mesh/MeshOperations.h>
+
+using except::FailedOperationException;
+using except::OpenFileException;
+using os::Error;
+
+namespace meshisect {
+
+// The file format's magic number, encoded as a character array so
+// that it's never byte-swapped.
+static const uint8_t MAGIC_NUMBER[4] = { 'F', 'I', 'A', 'T' };
+
+// The header that follows the magic number. It's followed by
+// the nodes of the tree, each written as the six coordinates of its
+// bounding box followed by its index and object count, and then
+// by the index in the mesh of the face of each object.
+struct FileHeader {
+
+    // As with RfmFileHeader, a file written on a machine with
+    // the opposite byte order reads back as FOREIGN_BYTE_ORDER.
+    // Such files are rejected rather than byte-swapped, because
+    // the tree can always be rebuilt instead.
+    static const uint16_t NATIVE_BYTE_ORDER = 0x0f;
+    static const uint16_t FOREIGN_BYTE_ORDER = 0xf0;
+    uint16_t mByteOrder;
+
+    // Files with other versions are ignored.
+    //
+    // 1 10/18/2010 - Initial version
+    static const uint16_t VERSION = 1;
+    uint16_t mVersion;
+
+    uint32_t mSplitStrategy;
+    uint32_t mFaceCount;
+    uint64_t mGeometryHash;
+    uint32_t mNodeCount;
+    uint32_t mObjectCount;
+};
+
+// Write one value to the file.
+template<typename TYPE>
+static void
+WriteValue(FILE *file, const TYPE &value, const std::string &filename)
+{
+    if (fwrite(&value, sizeof(value), 1, file) != 1) {
+        throw FailedOperationException(SOURCE_LINE, Error::fromSystemError())
+            << "Could not write to AABB tree file \"" << filename << "\".";
+    }
+}
+
+// Read one value from the file, returning false if it couldn't be read.
+template<typename TYPE>
+static bool
+ReadValue(FILE *file, TYPE *value)
+{
+    return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+static void
+WriteFile(FILE *file, const FaceIntersectorAabbTree &faceIntersectorAabbTree,
+    const mesh::Mesh &mesh, const std::string &filename)
+{
+    const FaceIntersectorAabbTree::NodeVector &nodeVector
+        = faceIntersectorAabbTree.nodeVector();
+    const FaceIntersectorAabbTree::ObjectVector &objectVector
+        = faceIntersectorAabbTree.objectVector();
+
+    for (unsigned index = 0; index < 4; ++index) {
+        WriteValue(file, MAGIC_NUMBER[index], filename);
+    }
+
+    FileHeader fileHeader;
+    fileHeader.mByteOrder = FileHeader::NATIVE_BYTE_ORDER;
+    fileHeader.mVersion = FileHeader::VERSION;
+    fileHeader.mSplitStrategy = faceIntersectorAabbTree.splitStrategy();
+    fileHeader.mFaceCount = mesh.faceCount();
+    fileHeader.mGeometryHash = mesh::ComputeGeometryHash(mesh);
+    fileHeader.mNodeCount = nodeVector.size();
+    fileHeader.mObjectCount = objectVector.size();
+
+    WriteValue(file, fileHeader.mByteOrder, filename);
+    WriteValue(file, fileHeader.mVersion, filename);
+    WriteValue(file, fileHeader.mSplitStrategy, filename);
+    WriteValue(file, fileHeader.mFaceCount, filename);
+    WriteValue(file, fileHeader.mGeometryHash, filename);
+    WriteValue(file, fileHeader.mNodeCount, filename);
+    WriteValue(file, fileHeader.mObjectCount, filename);
+
+    for (size_t index = 0; index < nodeVector.size(); ++index) {
+        const FaceIntersectorAabbTree::Node &node = nodeVector[index];
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            WriteValue(file, node.mBoundingBox.min()[axis], filename);
+        }
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            WriteValue(file, node.mBoundingBox.max()[axis], filename);
+        }
+        uint32_t nodeIndex = node.mIndex;
+        WriteValue(file, nodeIndex, filename);
+        uint32_t objectCount = node.mObjectCount;
+        WriteValue(file, objectCount, filename);
+    }
+
+    // Sort the faces by address, so that the index of each object's
+    // face can be found by binary search.
+    typedef std::pair<const mesh::Face *, uint32_t> FaceIndexPair;
+    std::vector<FaceIndexPair> faceIndexPairVector;
+    faceIndexPairVector.reserve(mesh.faceCount());
+    uint32_t faceIndex = 0;
+    for (mesh::ConstFacePtr facePtr = mesh.faceBegin(); facePtr != mesh.faceEnd();
+         ++facePtr) {
+        faceIndexPairVector.push_back(FaceIndexPair(&*facePtr, faceIndex));
+        ++faceIndex;
+    }
+    std::sort(faceIndexPairVector.begin(), faceIndexPairVector.end());
+
+    for (size_t index = 0; index < objectVector.size(); ++index) {
+        const mesh::Face *face = &*objectVector[index].facePtr();
+        std::vector<FaceIndexPair>::const_iterator iterator = std::lower_bound(
+            faceIndexPairVector.begin(), faceIndexPairVector.end(),
+            FaceIndexPair(face, 0));
+        if (iterator == faceIndexPairVector.end() || (*iterator).first != face) {
+            throw FailedOperationException(SOURCE_LINE)
+                << "Could not write AABB tree file \"" << filename
+                << "\", because the tree refers to a face that is not in the mesh.";
+        }
+        WriteValue(file, (*iterator).second, filename);
+    }
+}
+
+void
+WriteFaceIntersectorAabbTreeFile(const FaceIntersectorAabbTree &faceIntersectorAabbTree,
+    const mesh::Mesh &mesh, const std::string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        throw OpenFileException(SOURCE_LINE, Error::fromSystemError())
+            << "Could not open AABB tree file \"" << filename << "\" for writing.";
+    }
+
+    try {
+        WriteFile(file, faceIntersectorAabbTree, mesh, filename);
+    } catch (...) {
+        fclose(file);
+
+        // Delete the file because it has only partially been
+        // written out, and is therefore corrupt.
+        unlink(filename.c_str());
+
+        throw;
+    }
+
+    if (fclose(file) != 0) {
+        unlink(filename.c_str());
+        throw FailedOperationException(SOURCE_LINE, Error::fromSystemError())
+            << "Could not close AABB tree file \"" << filename << "\".";
+    }
+}
+
+static bool
+ReadFile(FILE *file, FaceIntersectorAabbTree *faceIntersectorAabbTree,
+    mesh::Mesh *mesh)
+{
+    for (unsigned index = 0; index < 4; ++index) {
+        uint8_t value;
+        if (!ReadValue(file, &value) || value != MAGIC_NUMBER[index]) {
+            return false;
+        }
+    }
+
+    FileHeader fileHeader;
+    if (!ReadValue(file, &fileHeader.mByteOrder)
+        || fileHeader.mByteOrder != FileHeader::NATIVE_BYTE_ORDER
+        || !ReadValue(file, &fileHeader.mVersion)
+        || fileHeader.mVersion != FileHeader::VERSION
+        || !ReadValue(file, &fileHeader.mSplitStrategy)
+        || !ReadValue(file, &fileHeader.mFaceCount)
+        || !ReadValue(file, &fileHeader.mGeometryHash)
+        || !ReadValue(file, &fileHeader.mNodeCount)
+        || !ReadValue(file, &fileHeader.mObjectCount)) {
+        return false;
+    }
+
+    // Computing the hash is much faster than building the tree,
+    // but it still requires visiting every vertex of every face,
+    // so the cheaper tests are made first.
+    if (fileHeader.mSplitStrategy
+        != static_cast<uint32_t>(faceIntersectorAabbTree->splitStrategy())
+        || fileHeader.mFaceCount != mesh->faceCount()
+        || fileHeader.mGeometryHash != mesh::ComputeGeometryHash(*mesh)) {
+        return false;
+    }
+
+    // Every face appears in the tree once, so a valid file can't have
+    // more objects than the mesh has faces, or more nodes than twice that.
+    if (fileHeader.mObjectCount > fileHeader.mFaceCount
+        || fileHeader.mNodeCount > 2*fileHeader.mFaceCount) {
+        return false;
+    }
+
+    FaceIntersectorAabbTree::NodeVector nodeVector(fileHeader.mNodeCount);
+    for (size_t index = 0; index < nodeVector.size(); ++index) {
+        float bounds[2][3];
+        uint32_t nodeIndex;
+        uint32_t objectCount;
+        if (fread(bounds, sizeof(bounds), 1, file) != 1
+            || !ReadValue(file, &nodeIndex)
+            || !ReadValue(file, &objectCount)) {
+            return false;
+        }
+        FaceIntersectorAabbTree::Node &node = nodeVector[index];
+        node.mBoundingBox = cgmath::BoundingBox3f(
+            cgmath::Vector3f(bounds[0][0], bounds[0][1], bounds[0][2]),
+            cgmath::Vector3f(bounds[1][0], bounds[1][1], bounds[1][2]));
+        node.mIndex = nodeIndex;
+        node.mObjectCount = objectCount;
+    }
+
+    std::vector<mesh::FacePtr> facePtrVector;
+    facePtrVector.reserve(mesh->faceCount());
+    for (mesh::FacePtr facePtr = mesh->faceBegin(); facePtr != mesh->faceEnd(); ++facePtr) {
+        facePtrVector.push_back(facePtr);
+    }
+
+    FaceIntersectorAabbTree::ObjectVector objectVector(fileHeader.mObjectCount);
+    for (size_t index = 0; index < objectVector.size(); ++index) {
+        uint32_t faceIndex;
+        if (!ReadValue(file, &faceIndex)
+            || faceIndex >= facePtrVector.size()) {
+            return false;
+        }
+        objectVector[index].setFacePtr(facePtrVector[faceIndex]);
+    }
+
+    return faceIntersectorAabbTree->restore(nodeVector, objectVector);
+}
+
+bool
+ReadFaceIntersectorAabbTreeFile(FaceIntersectorAabbTree *faceIntersectorAabbTree,
+    mesh::Mesh *mesh, const std::string &filename)
+{
+    faceIntersectorAabbTree->clear();
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool result = ReadFile(file, faceIntersectorAabbTree, mesh);
+
+    fclose(file);
+
+    return result;
+}
+
+} // namespace meshisect
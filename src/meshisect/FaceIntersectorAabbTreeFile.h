@@ -0,0 +1,43 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESHISECT__FACE_INTERSECTOR_AABB_TREE_FILE__INCLUDED
+#define MESHISECT__FACE_INTERSECTOR_AABB_TREE_FILE__INCLUDED
+
+#include <string>
+
+#include "FaceIntersectorAabbTree.h"
+
+namespace mesh {
+class Mesh;
+}
+
+namespace meshisect {
+
+// Functions to save the AABB tree of a mesh's faces to a file,
+// typically alongside the mesh's .rfm file, so that programs that read
+// the same mesh repeatedly don't have to rebuild the tree each time.
+//
+// The file records a hash of the geometry of the mesh's faces,
+// computed by mesh::ComputeGeometryHash, and faces are identified by
+// their order in the mesh, so the file can only be read back
+// for a mesh with the same faces in the same order.
+
+// Write an AABB tree built from the faces of a mesh to a file.
+// The tree must not refer to faces that aren't in the mesh.
+// If the file cannot be opened, an OpenFileException is thrown.
+// If the file cannot be written, a FailedOperationException is thrown,
+// and the file is deleted.
+void WriteFaceIntersectorAabbTreeFile(const FaceIntersectorAabbTree &faceIntersectorAabbTree,
+    const mesh::Mesh &mesh, const std::string &filename);
+
+// Read an AABB tree of a mesh's faces from a file. Returns false, leaving
+// the tree empty, if the file doesn't exist, can't be read,
+// was written on a machine with a different byte order, or doesn't
+// match the mesh's geometry or the tree's split strategy,
+// in which case the tree should be rebuilt.
+bool ReadFaceIntersectorAabbTreeFile(FaceIntersectorAabbTree *faceIntersectorAabbTree,
+    mesh::Mesh *mesh, const std::string &filename);
+
+} // namespace meshisect
+
+#endif // MESHISECT__FACE_INTERSECTOR_AABB_TREE_FILE__INCLUDED
@@ -36,4 +36,10 @@ FaceIntersectorAabbTreeNode::boundingBox() const
     return mBoundingBox;
 }
 
+bool
+FaceIntersectorAabbTreeNode::operator==(const FaceIntersectorAabbTreeNode &rhs) const
+{
+    return mFacePtr == rhs.mFacePtr;
+}
+
 } // namespace meshisect
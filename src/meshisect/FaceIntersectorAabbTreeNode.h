@@ -25,6 +25,9 @@ public:
     // Required by the cgmath::AabbTree template.
     const cgmath::BoundingBox3f &boundingBox() const;
 
+    // Required by cgmath::AabbTree::removeObject.
+    bool operator==(const FaceIntersectorAabbTreeNode &rhs) const;
+
 private:
     mesh::FacePtr mFacePtr;
     cgmath::BoundingBox3f mBoundingBox;
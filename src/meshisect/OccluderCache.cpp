@@ -0,0 +1,47 @@
+// Copyright 2010 Drew Olbrich
+
+#include "OccluderCache.h"
+
+#include <cassert>
+
+namespace meshisect {
+
+OccluderCache::OccluderCache()
+    : mFacePtr(),
+      mHasFacePtr(false)
+{
+}
+
+OccluderCache::~OccluderCache()
+{
+}
+
+void
+OccluderCache::clear()
+{
+    mFacePtr = mesh::FacePtr();
+    mHasFacePtr = false;
+}
+
+void
+OccluderCache::setFacePtr(const mesh::FacePtr &facePtr)
+{
+    mFacePtr = facePtr;
+    mHasFacePtr = true;
+}
+
+const mesh::FacePtr &
+OccluderCache::facePtr() const
+{
+    assert(mHasFacePtr);
+
+    return mFacePtr;
+}
+
+bool
+OccluderCache::hasFacePtr() const
+{
+    return mHasFacePtr;
+}
+
+} // namespace meshisect
@@ -0,0 +1,44 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef MESHISECT__OCCLUDER_CACHE__INCLUDED
+#define MESHISECT__OCCLUDER_CACHE__INCLUDED
+
+#include <mesh/Types.h>
+
+namespace meshisect {
+
+// OccluderCache
+//
+// Remembers the face that last occluded a ray segment tested by
+// FaceIntersector::occludesRaySegment. Shadow rays cast toward the same
+// light source from nearby points tend to be blocked by the same face,
+// so testing that face first often avoids traversing the AABB tree at all.
+//
+// Each light source should have its own cache. The cache must be cleared
+// if its face is removed from the FaceIntersector.
+
+class OccluderCache
+{
+public:
+    OccluderCache();
+    ~OccluderCache();
+
+    // Forget the last occluder.
+    void clear();
+
+    // The face that last occluded a ray segment.
+    void setFacePtr(const mesh::FacePtr &facePtr);
+    const mesh::FacePtr &facePtr() const;
+
+    // Returns true if a ray segment has been occluded since
+    // the cache was created or last cleared.
+    bool hasFacePtr() const;
+
+private:
+    mesh::FacePtr mFacePtr;
+    bool mHasFacePtr;
+};
+
+} // namespace meshisect
+
+#endif // MESHISECT__OCCLUDER_CACHE__INCLUDED
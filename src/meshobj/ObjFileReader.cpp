@@ -3,15 +3,15 @@
 #include "ObjFileReader.h"
 
 #include <cassert>
+#include <vector>
 
 #include <except/OpenFileException.h>
 #include <except/FailedOperationException.h>
 #include <mesh/StandardAttributes.h>
 #include <mesh/IsConsistent.h>
+#include <mesh/MeshOperations.h>
 #include <str/FilenameOperations.h>
 
-#include "CreateEdgesFromFace.h"
-
 using cgmath::Vector3f;
 using cgmath::Vector4f;
 using except::OpenFileException;
@@ -217,10 +217,13 @@ ObjFileReader::readObjFile(mesh::Mesh *mesh, const std::string &objFilename)
 
     // Create all the edges, and wire them up to the
     // faces and vertices.
+    std::vector<mesh::FacePtr> facePtrVector;
+    facePtrVector.reserve(mMesh.faceCount());
     for (mesh::FacePtr facePtr = mMesh.faceBegin(); 
          facePtr != mMesh.faceEnd(); ++facePtr) {
-        CreateEdgesFromFace(mMesh, facePtr);
+        facePtrVector.push_back(facePtr);
     }
+    mesh::CreateFaceEdges(&mMesh, facePtrVector, NULL);
 
     // TODO: Check for vertices that never had any faces
     // reference them, and delete them.
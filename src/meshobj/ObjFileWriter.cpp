@@ -10,6 +10,7 @@
 
 #include <mesh/Mesh.h>
 #include <mesh/Vertex.h>
+#include <mesh/Face.h>
 #include <mesh/StandardAttributes.h>
 #include <mesh/IsConsistent.h>
 #include <cgmath/Vector2f.h>
@@ -24,6 +25,8 @@ using mesh::VertexPtr;
 using mesh::ConstVertexPtr;
 using mesh::ConstFacePtr;
 using mesh::AdjacentVertexConstIterator;
+using mesh::Face;
+using mesh::AttributePossessor;
 using mesh::AttributeKey;
 using cgmath::Vector2f;
 using cgmath::Vector3f;
@@ -241,10 +244,11 @@ ObjFileWriter::writeFaces()
             assert(texCoordCount == vertexCount || texCoordCount == 0);
 #endif
             
-            // Loop over all the Face's adjacent vertices.
-            for (AdjacentVertexConstIterator iterator = facePtr->adjacentVertexBegin();
-                 iterator != facePtr->adjacentVertexEnd(); ++iterator) {
-                const VertexPtr &vertexPtr = *iterator;
+            // Loop over all the Face's corners.
+            for (Face::CornerConstIterator iterator = facePtr->cornerBegin();
+                 iterator != facePtr->cornerEnd(); ++iterator) {
+                VertexPtr vertexPtr = iterator.vertexPtr();
+                const AttributePossessor &attributes = iterator.attributes();
 
                 // The VertexPtr must exist in the map.
                 VertexPtrIndexMap::iterator vertexPtrIndexMapIterator
@@ -255,9 +259,8 @@ ObjFileWriter::writeFaces()
                 *mFile << " " << vertexIndex;
 
                 // Write out texture coordinates.
-                if (facePtr->hasVertexAttribute(vertexPtr, texCoord2fKey)) {
-                    const Vector2f &texCoord = facePtr->getVertexVector2f(
-                        vertexPtr, texCoord2fKey);
+                if (attributes.hasAttribute(texCoord2fKey)) {
+                    const Vector2f &texCoord = attributes.getVector2f(texCoord2fKey);
                     TexCoordIndexMap::iterator texCoordIndexMapIterator
                         = mTexCoordIndexMap.find(texCoord);
                     assert(texCoordIndexMapIterator != mTexCoordIndexMap.end());
@@ -269,9 +272,9 @@ ObjFileWriter::writeFaces()
                 // Write out the vertex normal.
                 bool normalIsDefined = false;
                 Vector3f normal;
-                if (facePtr->hasVertexAttribute(vertexPtr, normal3fKey)) {
+                if (attributes.hasAttribute(normal3fKey)) {
                     normalIsDefined = true;
-                    normal = facePtr->getVertexUnitVector3f(vertexPtr, normal3fKey);
+                    normal = attributes.getUnitVector3f(normal3fKey);
                 } else if (facePtr->hasAttribute(normal3fKey)) {
                     normalIsDefined = true;
                     normal = facePtr->getUnitVector3f(normal3fKey);
@@ -283,7 +286,7 @@ ObjFileWriter::writeFaces()
                     // If we didn't yet write out a texture coordinate
                     // for this vertex, an extra slash must be
                     // output to account for it's absence.
-                    if (!facePtr->hasVertexAttribute(vertexPtr, texCoord2fKey)) {
+                    if (!attributes.hasAttribute(texCoord2fKey)) {
                         *mFile << "/";
                     }
                     
@@ -516,17 +519,17 @@ ObjFileWriter::writeNormalVertices()
     for (ConstFacePtr facePtr = mMesh->faceBegin();
          facePtr != mMesh->faceEnd(); ++facePtr) {
 
-        // Loop over all the Face's adjacent vertices.
-        for (AdjacentVertexConstIterator iterator = facePtr->adjacentVertexBegin();
-             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
-            const VertexPtr &vertexPtr = *iterator;
+        // Loop over all the Face's corners.
+        for (Face::CornerConstIterator iterator = facePtr->cornerBegin();
+             iterator != facePtr->cornerEnd(); ++iterator) {
+            const AttributePossessor &attributes = iterator.attributes();
 
             // Write out the face vertex normal, or face normal if no face vertex normal
             // is defined.
             bool normalIsDefined = false;
             Vector3f normal;
-            if (facePtr->hasVertexAttribute(vertexPtr, normal3fKey)) {
-                normal = facePtr->getVertexUnitVector3f(vertexPtr, normal3fKey);
+            if (attributes.hasAttribute(normal3fKey)) {
+                normal = attributes.getUnitVector3f(normal3fKey);
                 normalIsDefined = true;
             } else if (facePtr->hasAttribute(normal3fKey)) {
                 normal = facePtr->getUnitVector3f(normal3fKey);
@@ -567,16 +570,15 @@ ObjFileWriter::writeTextureVertices()
     for (ConstFacePtr facePtr = mMesh->faceBegin(); 
          facePtr != mMesh->faceEnd(); ++facePtr) {
 
-        // Loop over all the Face's adjacent vertices.
-        for (AdjacentVertexConstIterator iterator = facePtr->adjacentVertexBegin();
-             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
-            const VertexPtr &vertexPtr = *iterator;
+        // Loop over all the Face's corners.
+        for (Face::CornerConstIterator iterator = facePtr->cornerBegin();
+             iterator != facePtr->cornerEnd(); ++iterator) {
+            const AttributePossessor &attributes = iterator.attributes();
 
             // Only attempt to write out the face's texture coordinate
             // vector if it has one defined.
-            if (facePtr->hasVertexAttribute(vertexPtr, texCoord2fKey)) {
-                const Vector2f &texCoord = facePtr->getVertexVector2f(
-                    vertexPtr, texCoord2fKey);
+            if (attributes.hasAttribute(texCoord2fKey)) {
+                const Vector2f &texCoord = attributes.getVector2f(texCoord2fKey);
 
                 // Only insert the texture coordinate into the map and
                 // write it into the file if we haven't encountered a
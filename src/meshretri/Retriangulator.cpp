@@ -5,11 +5,13 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 
 #include <boost/lexical_cast.hpp>
 
 #include <con/Streams.h>
+#include <con/LogLevel.h>
 #include <cgmath/Vector3fOperations.h>
 #include <cgmath/LineOperations.h>
 #include <cgmath/Tolerance.h>
@@ -40,6 +42,55 @@ Retriangulator::~Retriangulator()
 {
 }
 
+size_t
+Retriangulator::bytesUsed() const
+{
+    return retriangulatorFaceVectorBytesUsed(mRetriangulatorFaceVector)
+        + retriangulatorFaceVectorBytesUsed(mAdditionalRetriangulatorFaceVector)
+        + retriangulatorEdgeVectorBytesUsed();
+}
+
+std::string
+Retriangulator::memoryStatistics() const
+{
+    std::ostringstream ostr;
+
+    ostr << "Faces: " << mRetriangulatorFaceVector.size() << " ("
+        << retriangulatorFaceVectorBytesUsed(mRetriangulatorFaceVector)
+        << " bytes)" << std::endl;
+    ostr << "Additional faces: " << mAdditionalRetriangulatorFaceVector.size() << " ("
+        << retriangulatorFaceVectorBytesUsed(mAdditionalRetriangulatorFaceVector)
+        << " bytes)" << std::endl;
+    ostr << "Edges: " << mRetriangulatorEdgeVector.size() << " ("
+        << retriangulatorEdgeVectorBytesUsed() << " bytes)" << std::endl;
+    ostr << "Total: " << bytesUsed() << " bytes";
+
+    return ostr.str();
+}
+
+size_t
+Retriangulator::retriangulatorFaceVectorBytesUsed(
+    const RetriangulatorFaceVector &retriangulatorFaceVector) const
+{
+    size_t bytes = retriangulatorFaceVector.capacity()*sizeof(RetriangulatorFace);
+    for (size_t index = 0; index < retriangulatorFaceVector.size(); ++index) {
+        bytes += retriangulatorFaceVector[index].bytesAllocated();
+    }
+
+    return bytes;
+}
+
+size_t
+Retriangulator::retriangulatorEdgeVectorBytesUsed() const
+{
+    size_t bytes = mRetriangulatorEdgeVector.capacity()*sizeof(RetriangulatorEdge);
+    for (size_t index = 0; index < mRetriangulatorEdgeVector.size(); ++index) {
+        bytes += mRetriangulatorEdgeVector[index].bytesAllocated();
+    }
+
+    return bytes;
+}
+
 void
 Retriangulator::setMesh(mesh::Mesh *mesh)
 {
@@ -135,6 +186,10 @@ Retriangulator::retriangulate()
         mesh::IsConsistent(*mMesh);
 #endif
 
+        if (con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)) {
+            con::debug << "Retriangulator memory usage:\n" << memoryStatistics() << std::endl;
+        }
+
         reset();
 
     } catch (...) {
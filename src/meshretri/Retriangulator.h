@@ -66,6 +66,13 @@ public:
     // problematic geometry, like a degenerate face.
     void retriangulateBackprojectionFace(mesh::FacePtr facePtr, TriangleVector *triangleVector);
 
+    // Number of bytes occupied by the RetriangulatorFaces and
+    // RetriangulatorEdges, including their FaceLineSegments and EdgePoints.
+    size_t bytesUsed() const;
+
+    // A string describing the memory occupied by the faces and edges.
+    std::string memoryStatistics() const;
+
 private:
     friend class ::RetriangulatorTest;
     friend class ::RetriangulatorFaceTest;
@@ -218,6 +225,12 @@ private:
     typedef std::vector<RetriangulatorEdge> RetriangulatorEdgeVector;
     RetriangulatorEdgeVector mRetriangulatorEdgeVector;
 
+    // The number of bytes occupied by a vector of RetriangulatorFaces,
+    // and by mRetriangulatorEdgeVector.
+    size_t retriangulatorFaceVectorBytesUsed(
+        const RetriangulatorFaceVector &retriangulatorFaceVector) const;
+    size_t retriangulatorEdgeVectorBytesUsed() const;
+
     bool mRetriangulatingBackprojectionFace;
 };
 
@@ -26,6 +26,12 @@ RetriangulatorEdge::~RetriangulatorEdge()
 {
 }
 
+size_t
+RetriangulatorEdge::bytesAllocated() const
+{
+    return mEdgePointVector.capacity()*sizeof(EdgePoint);
+}
+
 void
 RetriangulatorEdge::setEdgePtr(const mesh::EdgePtr &edgePtr)
 {
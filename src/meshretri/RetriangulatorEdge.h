@@ -77,6 +77,10 @@ public:
     // specified EdgePoint index.
     size_t getFarthestEdgePointFromSpan(size_t spanIndex, size_t edgePointIndex) const;
 
+    // The number of bytes allocated separately from the object
+    // for its EdgePoints.
+    size_t bytesAllocated() const;
+
 private:
     // Backpointer to the Edge.
     mesh::EdgePtr mEdgePtr;
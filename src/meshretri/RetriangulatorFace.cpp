@@ -54,6 +54,13 @@ RetriangulatorFace::~RetriangulatorFace()
 {
 }
 
+size_t
+RetriangulatorFace::bytesAllocated() const
+{
+    return mFaceLineSegmentVector.capacity()*sizeof(FaceLineSegment)
+        + mOriginalVertexPtrVector.capacity()*sizeof(mesh::ConstVertexPtr);
+}
+
 void
 RetriangulatorFace::setFacePtr(const mesh::FacePtr &facePtr)
 {
@@ -112,6 +112,10 @@ public:
     void writeToSvgFile(Retriangulator *retriangulator, 
         const std::string &filename = "/var/tmp/retriangulator_dump.svg");
 
+    // The number of bytes allocated separately from the object
+    // for its FaceLineSegments and original vertices.
+    size_t bytesAllocated() const;
+
 private:
     friend class ::RetriangulatorTest;
     friend class ::RetriangulatorFaceTest;
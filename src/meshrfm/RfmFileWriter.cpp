@@ -338,20 +338,30 @@ RfmFileWriter::writeFace(const mesh::Face &face)
         write(index);
     }
 
+    // Count the FaceVertex objects, used to hold per-vertex face
+    // attribute data. Corners without attributes don't have one.
+    uint16_t faceVertexCount = 0;
+    for (mesh::Face::CornerConstIterator iterator = face.cornerBegin();
+         iterator != face.cornerEnd(); ++iterator) {
+        if (iterator.faceVertex() != NULL) {
+            ++faceVertexCount;
+        }
+    }
+
     // The face vertex count is written out as a 16 bit number,
     // so at most there can be 65535 adjacent edges.
-    assert(face.faceVertexVectorSize() < 65536);
+    assert(face.adjacentVertexCount() < 65536);
 
-    // Write out the number of FaceVertex objects, used to
-    // hold per-vertex face attribute data.
-    uint16_t faceVertexCount = face.faceVertexVectorSize();
     write(faceVertexCount);
 
     // Write out the FaceVertex attributes.
-    for (mesh::Face::FaceVertexVectorConstIterator iterator = face.faceVertexVectorBegin();
-         iterator != face.faceVertexVectorEnd(); ++iterator) {
-        const mesh::FaceVertex *faceVertex = *iterator;
-        uint32_t index = faceVertex->vertexPtr()->getInt(mIndexKey);
+    for (mesh::Face::CornerConstIterator iterator = face.cornerBegin();
+         iterator != face.cornerEnd(); ++iterator) {
+        const mesh::FaceVertex *faceVertex = iterator.faceVertex();
+        if (faceVertex == NULL) {
+            continue;
+        }
+        uint32_t index = iterator.vertexPtr()->getInt(mIndexKey);
         write(index);
         writeAttributes(*faceVertex);
     }
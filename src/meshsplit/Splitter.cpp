@@ -3,18 +3,25 @@
 #include "Splitter.h"
 
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 #include <cgmath/Tolerance.h>
 #include <cgmath/BoundingBox3fOperations.h>
 #include <cgmath/TriangleOperations.h>
 #include <cgmath/Matrix4fOperations.h>
+#include <cgmath/ParallelAlgorithms.h>
+#include <con/Streams.h>
+#include <con/LogLevel.h>
 #include <mesh/MeshOperations.h>
 #include <mesh/EdgeOperations.h>
 #include <mesh/FaceOperations.h>
 #include <mesh/StandardAttributes.h>
 #include <mesh/AttributePossessor.h>
 #include <meshisect/FaceIntersector.h>
+#include <meshisect/EdgeIntersectorAabbTree.h>
 #include <meshprim/CylinderCreator.h>
 
 namespace meshsplit {
@@ -25,7 +32,7 @@ Splitter::Splitter()
       mRelativeTolerance(cgmath::TOLERANCE),
       mMarkIntersectionsWithCylinders(false),
       mFlaggedEdgeBooleanAttributeKey(),
-      mCurrentEdgePtr(),
+      mAabbTreeFilename(),
       mRetriangulator(),
       mDebugEdgeVector(),
       mEndpointIdentifierIndex(0)
@@ -97,6 +104,18 @@ Splitter::flaggedEdgeBooleanAttributeKey() const
     return mFlaggedEdgeBooleanAttributeKey;
 }
 
+void
+Splitter::setAabbTreeFilename(const std::string &aabbTreeFilename)
+{
+    mAabbTreeFilename = aabbTreeFilename;
+}
+
+const std::string &
+Splitter::aabbTreeFilename() const
+{
+    return mAabbTreeFilename;
+}
+
 void
 Splitter::splitFaces()
 {
@@ -111,6 +130,7 @@ Splitter::splitFaces()
 
     meshisect::FaceIntersector faceIntersector;
     faceIntersector.setMesh(mMesh);
+    faceIntersector.setAabbTreeFilename(mAabbTreeFilename);
     faceIntersector.initialize();
 
     mRetriangulator.setMesh(mMesh);
@@ -118,19 +138,75 @@ Splitter::splitFaces()
     mRetriangulator.setRelativeTolerance(mRelativeTolerance);
     mRetriangulator.setNewEdgeBooleanAttributeKey(mFlaggedEdgeBooleanAttributeKey);
 
-    for (mCurrentEdgePtr = mMesh->edgeBegin();
-         mCurrentEdgePtr != mMesh->edgeEnd(); ++mCurrentEdgePtr) {
+    // Build an AABB tree of the edges, and traverse it together with
+    // the tree of faces to find every edge and face whose bounding boxes
+    // overlap, rather than querying the tree of faces once per edge.
+    meshisect::EdgeIntersectorAabbTree::ObjectVector edgeObjectVector;
+    edgeObjectVector.reserve(mMesh->edgeCount());
+    for (mesh::EdgePtr edgePtr = mMesh->edgeBegin();
+         edgePtr != mMesh->edgeEnd(); ++edgePtr) {
+        meshisect::EdgeIntersectorAabbTreeNode edgeIntersectorAabbTreeNode;
+        edgeIntersectorAabbTreeNode.setEdgePtr(edgePtr);
+        edgeObjectVector.push_back(edgeIntersectorAabbTreeNode);
+    }
+    meshisect::EdgeIntersectorAabbTree edgeIntersectorAabbTree;
+    edgeIntersectorAabbTree.initialize(edgeObjectVector);
+
+    // The relative tolerance is converted to an absolute one
+    // at the largest coordinate in the mesh, which finds at least the faces
+    // that GrowBoundingBox3fByAbsoluteAndRelativeTolerance would for each edge.
+    cgmath::BoundingBox3f meshBoundingBox = mesh::ComputeBoundingBox(*mMesh);
+    float tolerance = mAbsoluteTolerance;
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        float maxAbs = std::max(fabsf(meshBoundingBox.min()[axis]),
+            fabsf(meshBoundingBox.max()[axis]));
+        tolerance = std::max(tolerance, maxAbs*mRelativeTolerance);
+    }
+
+    meshisect::EdgeIntersectorAabbTree::ObjectIndexPairVector objectIndexPairVector;
+    edgeIntersectorAabbTree.findOverlappingPairs(faceIntersector.faceIntersectorAabbTree(),
+        tolerance, cgmath::GetDefaultThreadCount(), &objectIndexPairVector);
 
-        // Get the bounding box of the edge we're testing for intersections.
-        cgmath::BoundingBox3f boundingBox = mesh::GetEdgeBoundingBox(mCurrentEdgePtr);
+    if (con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)) {
+        con::debug << "Face AABB tree memory usage:\n"
+            << faceIntersector.aabbMemoryStatistics() << std::endl;
+        con::debug << "Edge AABB tree memory usage:\n"
+            << edgeIntersectorAabbTree.memoryStatistics() << std::endl;
+    }
 
-        // Grow the bounding box to account for the tolerances.
-        boundingBox = cgmath::GrowBoundingBox3fByAbsoluteAndRelativeTolerance(
-            boundingBox, mAbsoluteTolerance, mRelativeTolerance);
+    // The order in which intersections are recorded affects the retriangulation,
+    // so the pairs are processed in the order of the edges in the mesh,
+    // and for each edge, in the order of the faces in their tree,
+    // independent of the shape of the tree of edges.
+    const meshisect::EdgeIntersectorAabbTree::ObjectVector &edgeTreeObjectVector
+        = edgeIntersectorAabbTree.objectVector();
+    typedef std::pair<const mesh::Edge *, unsigned> EdgeIndexPair;
+    std::vector<EdgeIndexPair> edgeIndexPairVector;
+    edgeIndexPairVector.reserve(edgeObjectVector.size());
+    for (unsigned index = 0; index < edgeObjectVector.size(); ++index) {
+        edgeIndexPairVector.push_back(
+            EdgeIndexPair(&*edgeObjectVector[index].edgePtr(), index));
+    }
+    std::sort(edgeIndexPairVector.begin(), edgeIndexPairVector.end());
+    std::vector<unsigned> meshEdgeIndexVector(edgeTreeObjectVector.size());
+    for (unsigned index = 0; index < edgeTreeObjectVector.size(); ++index) {
+        const mesh::Edge *edge = &*edgeTreeObjectVector[index].edgePtr();
+        std::vector<EdgeIndexPair>::const_iterator iterator = std::lower_bound(
+            edgeIndexPairVector.begin(), edgeIndexPairVector.end(), EdgeIndexPair(edge, 0));
+        assert(iterator != edgeIndexPairVector.end() && (*iterator).first == edge);
+        meshEdgeIndexVector[index] = (*iterator).second;
+    }
+    for (size_t index = 0; index < objectIndexPairVector.size(); ++index) {
+        objectIndexPairVector[index].first
+            = meshEdgeIndexVector[objectIndexPairVector[index].first];
+    }
+    std::sort(objectIndexPairVector.begin(), objectIndexPairVector.end());
 
-        // Call applyObjectToBoundingBox (see below) on all faces
-        // that intersect the bounding box.
-        faceIntersector.applyToBoundingBoxIntersection(boundingBox, this);
+    const meshisect::FaceIntersectorAabbTree::ObjectVector &faceTreeObjectVector
+        = faceIntersector.faceIntersectorAabbTree().objectVector();
+    for (size_t index = 0; index < objectIndexPairVector.size(); ++index) {
+        intersectEdgeWithFace(edgeObjectVector[objectIndexPairVector[index].first].edgePtr(),
+            faceTreeObjectVector[objectIndexPairVector[index].second].facePtr());
     }
 
     // Split all faces on the recorded lines of intesection.
@@ -141,27 +217,22 @@ Splitter::splitFaces()
     }
 }
 
-bool
-Splitter::applyObjectToBoundingBox(meshisect::FaceIntersectorAabbTreeNode
-    &faceIntersectorAabbTreeNode, const cgmath::BoundingBox3f &)
+void
+Splitter::intersectEdgeWithFace(mesh::EdgePtr edgePtr, mesh::FacePtr facePtr)
 {
-    mesh::FacePtr facePtr = faceIntersectorAabbTreeNode.facePtr();
-
-    // Find all intersections between mCurrentEdgePtr and facePtr,
-    // and record them on mCurrentFacePtr using the meshretri library.
+    // Find all intersections between edgePtr and facePtr,
+    // and record them on facePtr using the meshretri library.
 
     mesh::VertexPtr v0;
     mesh::VertexPtr v1;
-    mesh::GetEdgeAdjacentVertices(mCurrentEdgePtr, &v0, &v1);
+    mesh::GetEdgeAdjacentVertices(edgePtr, &v0, &v1);
 
-    if (facePtr->hasAdjacentEdge(mCurrentEdgePtr)
+    if (facePtr->hasAdjacentEdge(edgePtr)
         || facePtr->hasAdjacentVertex(v0)
         || facePtr->hasAdjacentVertex(v1)) {
         // The two faces are adjacent to each other, so don't test
         // if they intersect.
-        // Returning false means that we don't stop traversing the AABB tree.
-        // We want to consider all possible intersections.
-        return false;
+        return;
     }
 
     cgmath::Vector3f p0;
@@ -171,7 +242,7 @@ Splitter::applyObjectToBoundingBox(meshisect::FaceIntersectorAabbTreeNode
 
     cgmath::Vector3f q0;
     cgmath::Vector3f q1;
-    mesh::GetEdgeVertexPositions(mCurrentEdgePtr, &q0, &q1);
+    mesh::GetEdgeVertexPositions(edgePtr, &q0, &q1);
 
     EdgePtrVector adjacentEdgePtrVector;
     getAdjacentEdgePtrVector(facePtr, &adjacentEdgePtrVector);
@@ -185,7 +256,7 @@ Splitter::applyObjectToBoundingBox(meshisect::FaceIntersectorAabbTreeNode
             &r0, &r1, &clippingEdgeIndex0, &clippingEdgeIndex1)) {
 
         if (mFlaggedEdgeBooleanAttributeKey.isDefined()) {
-            mCurrentEdgePtr->setBool(mFlaggedEdgeBooleanAttributeKey, true);
+            edgePtr->setBool(mFlaggedEdgeBooleanAttributeKey, true);
         }
 
         if (mMarkIntersectionsWithCylinders) {
@@ -218,10 +289,6 @@ Splitter::applyObjectToBoundingBox(meshisect::FaceIntersectorAabbTreeNode
 
         mRetriangulator.addFaceLineSegmentToFace(faceLineSegment, facePtr);
     }
-
-    // Returning false means that we don't stop traversing the AABB tree.
-    // We want to consider all possible intersections.
-    return false;
 }
 
 void
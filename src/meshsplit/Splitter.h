@@ -3,6 +3,7 @@
 #ifndef MESHSPLIT__SPLITTER__INCLUDED
 #define MESHSPLIT__SPLITTER__INCLUDED
 
+#include <string>
 #include <vector>
 
 #include <mesh/Mesh.h>
@@ -17,7 +18,7 @@ namespace meshsplit {
 // Splits the faces of a mesh where they intersect.
 // All of the input faces must be triangles.
 
-class Splitter : public meshisect::FaceIntersector::BoundingBoxListener
+class Splitter
 {
 public:
     Splitter();
@@ -46,14 +47,19 @@ public:
         const mesh::AttributeKey &flaggedEdgeBooleanAttributeKey);
     const mesh::AttributeKey &flaggedEdgeBooleanAttributeKey() const;
 
+    // An optional file in which to save the AABB tree of the mesh's faces,
+    // as with meshisect::FaceIntersector::setAabbTreeFilename.
+    void setAabbTreeFilename(const std::string &aabbTreeFilename);
+    const std::string &aabbTreeFilename() const;
+
     // Split faces where they intersect.
     void splitFaces();
 
-    // For meshisect::FaceIntersector::BoundingBoxListener:
-    virtual bool applyObjectToBoundingBox(meshisect::FaceIntersectorAabbTreeNode
-        &faceIntersectorAabbTreeNode, const cgmath::BoundingBox3f &boundingBox);
-
 private:
+    // Record where an edge intersects a face, if it does,
+    // so that the face is split there by mRetriangulator.
+    void intersectEdgeWithFace(mesh::EdgePtr edgePtr, mesh::FacePtr facePtr);
+
     void resetDebugEdgeVector();
     void addDebugEdge(const cgmath::Vector3f &p0, const cgmath::Vector3f &p1);
     void markDebugEdges();
@@ -70,7 +76,7 @@ private:
 
     mesh::AttributeKey mFlaggedEdgeBooleanAttributeKey;
 
-    mesh::EdgePtr mCurrentEdgePtr;
+    std::string mAabbTreeFilename;
 
     meshretri::Retriangulator mRetriangulator;
 
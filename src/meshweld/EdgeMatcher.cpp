@@ -53,19 +53,17 @@ EdgeMatcher::setEdgePtr(mesh::EdgePtr edgePtr)
 }
 
 void
-EdgeMatcher::testAgainstEdgeAabbTree(const EdgeAabbTree &edgeAabbTree)
+EdgeMatcher::testCandidateEdges(const EdgePtrVector &candidateEdgePtrVector)
 {
-    cgmath::BoundingBox3f boundingBox = cgmath::GrowBoundingBox3fByAbsoluteAndRelativeTolerance(
-        mesh::GetEdgeBoundingBox(mEdgePtr), mAbsoluteTolerance, mRelativeTolerance);
-
     mesh::GetEdgeVertexPositions(mEdgePtr, &mEndpoint0, &mEndpoint1);
 
     mMatchingEdgePtrVector.clear();
     mMatchingEdgePtrVector.reserve(4);
 
-    // This calls EdgeMatcher::applyObjectToBoundingBox
-    // for each edge whose bounding box intersects 'boundingBox'.
-    edgeAabbTree.applyToBoundingBoxIntersection(boundingBox, this);
+    for (EdgePtrVector::const_iterator iterator = candidateEdgePtrVector.begin();
+         iterator != candidateEdgePtrVector.end(); ++iterator) {
+        testCandidateEdge(*iterator);
+    }
 }
 
 const EdgeMatcher::EdgePtrVector &
@@ -74,15 +72,12 @@ EdgeMatcher::matchingEdgePtrVector() const
     return mMatchingEdgePtrVector;
 }
 
-bool
-EdgeMatcher::applyObjectToBoundingBox(Edge &edge,
-    const cgmath::BoundingBox3f &)
+void
+EdgeMatcher::testCandidateEdge(mesh::EdgePtr edgePtr)
 {
-    mesh::EdgePtr edgePtr = edge.edgePtr();
-
     if (edgePtr == mEdgePtr) {
         // Don't bother comparing the edge we're looking for against itself.
-        return false;
+        return;
     }
 
     assert(mDeletedElementTracker != NULL);
@@ -90,7 +85,7 @@ EdgeMatcher::applyObjectToBoundingBox(Edge &edge,
         // Don't compare the edge against one that is already known
         // to have been deleted. Otherwise, we'd be accessing memory
         // that was already freed up.
-        return false;
+        return;
     }
 
     assert(edgePtr->adjacentVertexCount() == 2);
@@ -103,11 +98,9 @@ EdgeMatcher::applyObjectToBoundingBox(Edge &edge,
             && pointsAreEquivalent(endpoint1, mEndpoint1))
         || (pointsAreEquivalent(endpoint1, mEndpoint0)
             && pointsAreEquivalent(endpoint0, mEndpoint1))) {
+        // There may be multiple matches, so keep going.
         mMatchingEdgePtrVector.push_back(edgePtr);
     }
-
-    // Continue testing against other edges. There may be multiple matches.
-    return false;
 }
 
 bool
@@ -3,19 +3,21 @@
 #ifndef MESHWELD__EDGE_MATCHER__INCLUDED
 #define MESHWELD__EDGE_MATCHER__INCLUDED
 
+#include <vector>
+
 #include <cgmath/Vector3f.h>
+#include <mesh/Types.h>
 #include <mesh/DeletedElementTracker.h>
 
-#include "EdgeAabbTree.h"
-
 namespace meshweld {
 
 // EdgeMatcher
 //
-// This class works with the AABB tree to find edges
-// that are nearly coincident with a reference edge.
+// This class tests candidate edges, found by searching an EdgeAabbTree
+// for overlapping pairs, to find edges that are nearly coincident
+// with a reference edge.
 
-class EdgeMatcher : public EdgeAabbTree::BoundingBoxListener
+class EdgeMatcher
 {
 public:
     EdgeMatcher();
@@ -34,18 +36,16 @@ public:
     // The edge being tested. We don't want to bother matching it with itself.
     void setEdgePtr(mesh::EdgePtr edgePtr);
 
-    // Test the specified edge against a EdgeAabbTree.
-    void testAgainstEdgeAabbTree(const EdgeAabbTree &edgeAabbTree);
+    typedef std::vector<mesh::EdgePtr> EdgePtrVector;
+
+    // Test the specified edge against a vector of candidate edges.
+    void testCandidateEdges(const EdgePtrVector &candidateEdgePtrVector);
 
     // The vector of edges that match the edge we're testing.
-    typedef std::vector<mesh::EdgePtr> EdgePtrVector;
     const EdgePtrVector &matchingEdgePtrVector() const;
 
-    // For EdgeAabbTree::BoundingBoxListener:
-    virtual bool applyObjectToBoundingBox(Edge &edge,
-        const cgmath::BoundingBox3f &boundingBox);
-
 private:
+    void testCandidateEdge(mesh::EdgePtr edgePtr);
     bool pointsAreEquivalent(const cgmath::Vector3f &a, const cgmath::Vector3f &b) const;
 
     float mAbsoluteTolerance;
@@ -3,11 +3,16 @@
 #include "Welder.h"
 
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "EdgeMatcher.h"
 
 #include <cgmath/Tolerance.h>
+#include <cgmath/ParallelAlgorithms.h>
 #include <mesh/StandardAttributes.h>
 #include <mesh/VertexOperations.h>
 #include <mesh/EdgeOperations.h>
@@ -226,6 +231,56 @@ Welder::weldEdges(float absoluteTolerance, float relativeTolerance)
     edgeMatcher.setRelativeTolerance(relativeTolerance);
     edgeMatcher.setDeletedElementTracker(&deletedElementTracker);
 
+    // Find all the pairs of edges that might be merged in a single
+    // traversal of the AABB tree, rather than querying the tree once per edge.
+    // The relative tolerance is converted to an absolute one at the largest
+    // coordinate in the mesh, and the result is doubled, because the edges'
+    // bounding boxes aren't updated as vertices are moved by earlier merges.
+    // The candidates are only a superset of the matches, which are found
+    // by EdgeMatcher from the edges' current vertex positions.
+    const EdgeAabbTree::ObjectVector &objectVector = mEdgeAabbTree.objectVector();
+    float candidateTolerance = absoluteTolerance;
+    if (!mEdgeAabbTree.nodeVector().empty()) {
+        const cgmath::BoundingBox3f &boundingBox
+            = mEdgeAabbTree.nodeVector()[0].mBoundingBox;
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            float maxAbs = std::max(fabsf(boundingBox.min()[axis]),
+                fabsf(boundingBox.max()[axis]));
+            candidateTolerance = std::max(candidateTolerance, maxAbs*relativeTolerance);
+        }
+    }
+    candidateTolerance *= 2.0;
+
+    EdgeAabbTree::ObjectIndexPairVector objectIndexPairVector;
+    mEdgeAabbTree.findSelfOverlappingPairs(candidateTolerance,
+        cgmath::GetDefaultThreadCount(), &objectIndexPairVector);
+
+    // Each pair is reported once, so list it under both of its edges,
+    // sorted so that each edge's candidates are contiguous.
+    std::vector<EdgeAabbTree::ObjectIndexPair> candidatePairVector;
+    candidatePairVector.reserve(2*objectIndexPairVector.size());
+    for (EdgeAabbTree::ObjectIndexPairVector::const_iterator iterator
+             = objectIndexPairVector.begin();
+         iterator != objectIndexPairVector.end(); ++iterator) {
+        candidatePairVector.push_back(*iterator);
+        candidatePairVector.push_back(
+            EdgeAabbTree::ObjectIndexPair((*iterator).second, (*iterator).first));
+    }
+    std::sort(candidatePairVector.begin(), candidatePairVector.end());
+
+    // Sort the edges in the tree by address, so that the index
+    // of each edge's object can be found by binary search.
+    typedef std::pair<const mesh::Edge *, unsigned> EdgeIndexPair;
+    std::vector<EdgeIndexPair> edgeIndexPairVector;
+    edgeIndexPairVector.reserve(objectVector.size());
+    for (unsigned index = 0; index < objectVector.size(); ++index) {
+        edgeIndexPairVector.push_back(
+            EdgeIndexPair(&*objectVector[index].edgePtr(), index));
+    }
+    std::sort(edgeIndexPairVector.begin(), edgeIndexPairVector.end());
+
+    EdgeMatcher::EdgePtrVector candidateEdgePtrVector;
+
     // Build a vector of all the EdgePtrs first. This lets us skip
     // over edges that are deleted as we go along, without
     // having to worry about tripping over invalidated iterators
@@ -249,8 +304,28 @@ Welder::weldEdges(float absoluteTolerance, float relativeTolerance)
             continue;
         }
 
+        // Edges that weren't candidates for merging when the tree was built
+        // have no candidate pairs.
+        std::vector<EdgeIndexPair>::const_iterator edgeIndexIterator = std::lower_bound(
+            edgeIndexPairVector.begin(), edgeIndexPairVector.end(),
+            EdgeIndexPair(&*edgePtr, 0));
+        if (edgeIndexIterator == edgeIndexPairVector.end()
+            || (*edgeIndexIterator).first != &*edgePtr) {
+            continue;
+        }
+        unsigned objectIndex = (*edgeIndexIterator).second;
+
+        candidateEdgePtrVector.clear();
+        for (std::vector<EdgeAabbTree::ObjectIndexPair>::const_iterator iterator
+                 = std::lower_bound(candidatePairVector.begin(), candidatePairVector.end(),
+                     EdgeAabbTree::ObjectIndexPair(objectIndex, 0));
+             iterator != candidatePairVector.end() && (*iterator).first == objectIndex;
+             ++iterator) {
+            candidateEdgePtrVector.push_back(objectVector[(*iterator).second].edgePtr());
+        }
+
         edgeMatcher.setEdgePtr(edgePtr);
-        edgeMatcher.testAgainstEdgeAabbTree(mEdgeAabbTree);
+        edgeMatcher.testCandidateEdges(candidateEdgePtrVector);
 
         const EdgeMatcher::EdgePtrVector &matchingEdgePtrVector
             = edgeMatcher.matchingEdgePtrVector();
@@ -173,9 +173,9 @@ WrlFileWriter::writeColors()
     for (mesh::ConstFacePtr facePtr = mMesh->faceBegin();
          facePtr != mMesh->faceEnd(); ++facePtr) {
 
-        for (mesh::AdjacentVertexConstIterator iterator = facePtr->adjacentVertexBegin();
-             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
-            const mesh::FaceVertex *faceVertex = facePtr->findFaceVertex(*iterator);
+        for (mesh::Face::CornerConstIterator iterator = facePtr->cornerBegin();
+             iterator != facePtr->cornerEnd(); ++iterator) {
+            const mesh::FaceVertex *faceVertex = iterator.faceVertex();
 
             // This color is used when a face's vertex color is undefined.
             Vector3f color(0.2, 0.2, 0.2);
@@ -41,8 +41,11 @@ DiscontinuityMesher::DiscontinuityMesher()
       mDebugLineSegmentCollection(),
       mLightVertexIndex(0),
       mRetriangulator(),
+      mHalfEdgeTopology(),
+      mFaceNormalVector(),
       mDebugPointVector(),
-      mMarkDegreeZeroDiscontinuityVertices(false)
+      mMarkDegreeZeroDiscontinuityVertices(false),
+      mAabbTreeFilename()
 {
 }
 
@@ -200,6 +203,7 @@ DiscontinuityMesher::shadeMeshVertices()
     mMeshShader.setDiscontinuityMesher(this);
     mMeshShader.setMesh(mMesh);
     mMeshShader.setMaterialTable(&mMaterialTable);
+    mMeshShader.setAabbTreeFilename(mAabbTreeFilename);
     mMeshShader.shadeMeshVertices();
 
     if (mMarkDegreeZeroDiscontinuityVertices) {
@@ -256,6 +260,18 @@ DiscontinuityMesher::setMarkDegreeZeroDiscontinuityVertices(
     mMarkDegreeZeroDiscontinuityVertices = markDegreeZeroDiscontinuityVertices;
 }
 
+void
+DiscontinuityMesher::setAabbTreeFilename(const std::string &aabbTreeFilename)
+{
+    mAabbTreeFilename = aabbTreeFilename;
+}
+
+const std::string &
+DiscontinuityMesher::aabbTreeFilename() const
+{
+    return mAabbTreeFilename;
+}
+
 const DiscontinuityMesher::DistantAreaLightVector &
 DiscontinuityMesher::distantAreaLightVector() const
 {
@@ -280,11 +296,37 @@ DiscontinuityMesher::calculateCriticalLineSegments()
             << "No light sources were defined.";
     }
 
+    buildSilhouetteTopology();
+
     if (mEmissiveFaceLightSourcesAreEnabled) {
         projectEmissiveFaceLightSources();
     }
 
     projectDistantAreaLightSources();
+
+    clearSilhouetteTopology();
+}
+
+void
+DiscontinuityMesher::buildSilhouetteTopology()
+{
+    // The mesh isn't modified until it's retriangulated, so its
+    // connectivity and face normals can be computed once here,
+    // rather than each time an edge or vertex is tested.
+    mHalfEdgeTopology.build(mMesh);
+
+    mFaceNormalVector.assign(mMesh->faceIndexLimit(), cgmath::Vector3f::ZERO);
+    for (mesh::FacePtr facePtr = mMesh->faceBegin(); 
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+        mFaceNormalVector[mMesh->faceIndex(facePtr)] = mesh::GetFaceGeometricNormal(facePtr);
+    }
+}
+
+void
+DiscontinuityMesher::clearSilhouetteTopology()
+{
+    mHalfEdgeTopology.clear();
+    std::vector<cgmath::Vector3f>().swap(mFaceNormalVector);
 }
 
 void
@@ -662,6 +704,16 @@ DiscontinuityMesher::edgeIsAdjacentToOccluder(mesh::EdgePtr edgePtr) const
     return false;
 }
 
+bool
+DiscontinuityMesher::faceIsFrontfacing(mesh::FacePtr facePtr,
+    const cgmath::Vector3f &vectorTowardLight) const
+{
+    // The value 0.001 below helps avoid projecting unnecessary edges
+    // into the scene when the light source consists of multiple
+    // nearly coplanar polygons.
+    return mFaceNormalVector[mMesh->faceIndex(facePtr)].dot(vectorTowardLight) > 0.001;
+}
+
 bool 
 DiscontinuityMesher::edgeIsSilhouette(mesh::EdgePtr edgePtr, 
     const cgmath::Vector3f &vectorTowardLight) const
@@ -669,7 +721,14 @@ DiscontinuityMesher::edgeIsSilhouette(mesh::EdgePtr edgePtr,
     // Returns true if the specified edge is a silhouette edge on the mesh
     // from the point of view of the specified vertex.
 
-    if (edgePtr->adjacentFaceCount() < 2) {
+    assert(mHalfEdgeTopology.mesh() == mMesh);
+
+    // Each half-edge along the edge belongs to one of its adjacent faces.
+    mesh::HalfEdgeTopology::EdgeHalfEdgeConstIterator begin
+        = mHalfEdgeTopology.edgeHalfEdgeBegin(edgePtr);
+    mesh::HalfEdgeTopology::EdgeHalfEdgeConstIterator end
+        = mHalfEdgeTopology.edgeHalfEdgeEnd(edgePtr);
+    if (end - begin < 2) {
         // The edge has less than two adjacent faces, so by definition
         // it has to be a silhouette edge.
         return true;
@@ -681,17 +740,15 @@ DiscontinuityMesher::edgeIsSilhouette(mesh::EdgePtr edgePtr,
     int backfacingCount = 0;
     int lightSourceCount = 0;
     int occluderCount = 0;
-    for (mesh::AdjacentFaceIterator iterator = edgePtr->adjacentFaceBegin();
-         iterator != edgePtr->adjacentFaceEnd(); ++iterator) {
-        // The value 0.001 below helps avoid projecting unnecessary edges
-        // into the scene when the light source consists of multiple
-        // nearly coplanar polygons.
-        if (mesh::GetFaceGeometricNormal(*iterator).dot(vectorTowardLight) > 0.001) {
+    for (mesh::HalfEdgeTopology::EdgeHalfEdgeConstIterator iterator = begin;
+         iterator != end; ++iterator) {
+        mesh::FacePtr facePtr = mHalfEdgeTopology.facePtr(*iterator);
+        if (faceIsFrontfacing(facePtr, vectorTowardLight)) {
             ++frontfacingCount;
         } else {
             ++backfacingCount;
         }
-        if (faceIsLightSource(*iterator)) {
+        if (faceIsLightSource(facePtr)) {
             ++lightSourceCount;
         } else {
             ++occluderCount;
@@ -719,6 +776,42 @@ bool
 DiscontinuityMesher::vertexIsSilhouette(mesh::VertexPtr vertexPtr,
     const cgmath::Vector3f &vectorTowardLight) const
 {
+    assert(mHalfEdgeTopology.mesh() == mMesh);
+
+    // If the faces around the vertex form a single fan, the vertex's
+    // edges are found by walking around it.
+    if (mHalfEdgeTopology.isManifold(vertexPtr)) {
+        mesh::HalfEdgeTopology::OutgoingHalfEdgeConstIterator begin
+            = mHalfEdgeTopology.outgoingHalfEdgeBegin(vertexPtr);
+        mesh::HalfEdgeTopology::OutgoingHalfEdgeConstIterator end
+            = mHalfEdgeTopology.outgoingHalfEdgeEnd(vertexPtr);
+        assert(begin != end);
+
+        // If the vertex is on a boundary, the walk begins at a boundary edge.
+        // If the vertex has more edges than outgoing half-edges, 
+        // some of its edges have no faces. Either way, one of its edges 
+        // has less than two faces, and is a silhouette edge.
+        if (!mHalfEdgeTopology.hasTwin(*begin)
+            || vertexPtr->adjacentEdgeCount() != unsigned(end - begin)) {
+            return true;
+        }
+
+        // Otherwise, each edge has the face of an outgoing half-edge
+        // on one side and the face of its twin on the other.
+        for (mesh::HalfEdgeTopology::OutgoingHalfEdgeConstIterator iterator = begin;
+             iterator != end; ++iterator) {
+            mesh::FacePtr facePtr = mHalfEdgeTopology.facePtr(*iterator);
+            mesh::FacePtr oppositeFacePtr = mHalfEdgeTopology.oppositeFacePtr(*iterator);
+            if (faceIsFrontfacing(facePtr, vectorTowardLight)
+                != faceIsFrontfacing(oppositeFacePtr, vectorTowardLight)
+                || faceIsLightSource(facePtr) != faceIsLightSource(oppositeFacePtr)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     for (mesh::AdjacentEdgeIterator iterator = vertexPtr->adjacentEdgeBegin();
          iterator != vertexPtr->adjacentEdgeEnd(); ++iterator) {
         if (edgeIsSilhouette(*iterator, vectorTowardLight)) {
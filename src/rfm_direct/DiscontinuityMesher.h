@@ -9,6 +9,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include <mesh/Mesh.h>
+#include <mesh/HalfEdgeTopology.h>
 #include <mesh/MaterialTable.h>
 #include <meshretri/Retriangulator.h>
 #include <light/DistantAreaLight.h>
@@ -69,6 +70,11 @@ public:
     // Mark D0 discontinuity vertices with red boxes in the output mesh.
     void setMarkDegreeZeroDiscontinuityVertices(bool markDegreeZeroDiscontinuityVertices);
 
+    // An optional file in which to save the AABB tree of the faces
+    // of the shaded mesh, as with meshisect::FaceIntersector::setAabbTreeFilename.
+    void setAabbTreeFilename(const std::string &aabbTreeFilename);
+    const std::string &aabbTreeFilename() const;
+
     // The distant area lights used to illuminate the mesh.
     typedef std::vector<light::DistantAreaLight> DistantAreaLightVector;
     const DistantAreaLightVector &distantAreaLightVector() const;
@@ -86,12 +92,16 @@ private:
     void ensureThatAllFacesAreTriangles();
     void buildMaterialVector();
     bool emissiveFacesExist();
+    void buildSilhouetteTopology();
+    void clearSilhouetteTopology();
     void projectEmissiveFaceLightSources();
     void projectDistantAreaLightSources();
     void projectDistantAreaLight(const light::DistantAreaLight &distantAreaLight);
     void traceWedge(WedgeIntersector &wedgeIntersector);
     bool vertexIsAdjacentToOccluder(mesh::VertexPtr vertexPtr) const;
     bool edgeIsAdjacentToOccluder(mesh::EdgePtr edgePtr) const;
+    bool faceIsFrontfacing(mesh::FacePtr facePtr,
+        const cgmath::Vector3f &vectorTowardLight) const;
     bool edgeIsSilhouette(mesh::EdgePtr edgePtr, 
         const cgmath::Vector3f &vectorTowardLight) const;
     bool vertexIsSilhouette(mesh::VertexPtr vertexPtr, 
@@ -159,10 +169,19 @@ private:
 
     meshretri::Retriangulator mRetriangulator;
 
+    // A snapshot of the connectivity of the mesh, and the geometric
+    // normals of its faces, indexed by face index, for the silhouette tests,
+    // which are made many times for each element before the mesh is
+    // retriangulated.
+    mesh::HalfEdgeTopology mHalfEdgeTopology;
+    std::vector<cgmath::Vector3f> mFaceNormalVector;
+
     typedef std::vector<cgmath::Vector3f> DebugPointVector;
     DebugPointVector mDebugPointVector;
 
     bool mMarkDegreeZeroDiscontinuityVertices;
+
+    std::string mAabbTreeFilename;
 };
 
 #endif // RFM_DISCMESH__DISCONTINUITY_MESHER__INCLUDED
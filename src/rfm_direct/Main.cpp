@@ -9,6 +9,7 @@
 
 #include <opt/ProgramOptionsParser.h>
 #include <con/Streams.h>
+#include <con/LogLevel.h>
 #include <mesh/Mesh.h>
 #include <mesh/Face.h>
 #include <mesh/StandardAttributes.h>
@@ -96,6 +97,11 @@ main(int argc, char **argv)
 
                 if (!gOptions.specified("no-shade")) {
 
+                    if (gOptions.specified("aabb-cache")) {
+                        discontinuityMesher.setAabbTreeFilename(
+                            gOptions.get("aabb-cache").as<std::string>());
+                    }
+
                     if (gOptions.specified("mark-d0-vertices")) {
                         discontinuityMesher.setMarkDegreeZeroDiscontinuityVertices(true);
                     }
@@ -104,6 +110,11 @@ main(int argc, char **argv)
                 }
             }
 
+            if (con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)) {
+                con::debug << "Mesh memory usage:\n" << mesh.memoryUsage().asString()
+                    << std::endl;
+            }
+
             con::info << "Writing RFM file \"" << gOptions.get("output-file").as<std::string>()
                 << "\"." << std::endl;
             meshrfm::WriteRfmFile(mesh, gOptions.get("output-file").as<std::string>());
@@ -157,6 +168,9 @@ ParseCommandLineArguments(int argc, char **argv)
         ("sun-intensity", opt::value<float>(), "Sun intensity")
         ("sun-color", opt::value<cgmath::Vector3f>()->set_name("r g b"), "Sun color (0..1)")
         ("no-emissive", "Disable emissive face light sources")
+        ("aabb-cache", opt::value<std::string>(),
+            "File in which to save the AABB tree of faces, so that it's not rebuilt "
+            "when the same mesh is processed again")
         ;
 
     gOptions.addDebugOptions()
@@ -33,6 +33,21 @@
 #include "LocalLightFace.h"
 #include "DistantLightFace.h"
 
+// Returns the bounding box of a vertex being shaded and the triangle
+// of a light face. Only edges that intersect it can cast shadows
+// on the vertex from the light face.
+static cgmath::BoundingBox3f
+GetBackprojectionBoundingBox(const cgmath::Vector3f &vertexPosition,
+    const cgmath::Vector3f &p0, const cgmath::Vector3f &p1, const cgmath::Vector3f &p2)
+{
+    cgmath::BoundingBox3f boundingBox = cgmath::BoundingBox3f::EMPTY_SET;
+    boundingBox.extendByVector3f(vertexPosition);
+    boundingBox.extendByVector3f(p0);
+    boundingBox.extendByVector3f(p1);
+    boundingBox.extendByVector3f(p2);
+    return boundingBox;
+}
+
 MeshShader::MeshShader()
     : mDiscontinuityMesher(NULL),
       mMesh(NULL),
@@ -45,11 +60,15 @@ MeshShader::MeshShader()
       mLocalLightFaceVector(),
       mFaceIntersector(),
       mEdgeIntersector(),
+      mFaceIntersectorStatistics(),
+      mFaceIntersectorStatisticsPtr(NULL),
       mTriangleLineSegmentCollection(NULL),
       mTriangleLightFacePtr(),
-      mBoundingBoxWedgeIntersector(NULL),
-      mBoundingBoxVertexPtr(),
-      mBoundingBoxLightFacePtr(),
+      mBackprojectionBoundingBoxVector(),
+      mOccluderEdgeOffsetVector(),
+      mOccluderEdgeIndexVector(),
+      mBackprojectionBoundingBoxIndex(0),
+      mOccluderCacheVector(),
       mIsDegreeZeroDiscontinuityAttributeKey(),
       mDistantAreaLightFace(),
       mDistantAreaLightVertex0(),
@@ -78,12 +97,12 @@ MeshShader::setMesh(mesh::Mesh *mesh)
 {
     mMesh = mesh;
 
-    mIlluminatedColor3fAttributeKey = mMesh->getAttributeKey("illuminatedColor3f",
-        mesh::AttributeKey::VECTOR3F);
+    mIlluminatedColor3fAttributeKey = mesh::TypedAttributeKey<cgmath::Vector3f>(
+        mMesh->getAttributeKey("illuminatedColor3f", mesh::AttributeKey::VECTOR3F));
 
-    mMaterialIndexAttributeKey = mesh::GetMaterialIndexAttributeKey(*mMesh);
-    mColor3fAttributeKey = mesh::GetColor3fAttributeKey(*mMesh);
-    mNormal3fAttributeKey = mesh::GetNormal3fAttributeKey(*mMesh);
+    mMaterialIndexAttributeKey = mesh::GetMaterialIndexTypedAttributeKey(*mMesh);
+    mColor3fAttributeKey = mesh::GetColor3fTypedAttributeKey(*mMesh);
+    mNormal3fAttributeKey = mesh::GetNormal3fTypedAttributeKey(*mMesh);
 
     mRetriangulator.setMesh(mesh);
 
@@ -97,6 +116,18 @@ MeshShader::setMaterialTable(mesh::MaterialTable *materialTable)
     mMaterialTable = materialTable;
 }
 
+void
+MeshShader::setAabbTreeFilename(const std::string &aabbTreeFilename)
+{
+    mFaceIntersector.setAabbTreeFilename(aabbTreeFilename);
+}
+
+const std::string &
+MeshShader::aabbTreeFilename() const
+{
+    return mFaceIntersector.aabbTreeFilename();
+}
+
 void
 MeshShader::shadeMeshVertices()
 {
@@ -109,6 +140,10 @@ MeshShader::shadeMeshVertices()
     mFaceIntersector.setMesh(mMesh);
     mFaceIntersector.initialize();
 
+    mFaceIntersectorStatistics.reset();
+    mFaceIntersectorStatisticsPtr = con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)
+        ? &mFaceIntersectorStatistics : NULL;
+
     con::debug << "Distant area light sources: "
         << mDiscontinuityMesher->distantAreaLightVector().size() << std::endl;
 
@@ -127,21 +162,51 @@ MeshShader::shadeMeshVertices()
     // Create the temporary face used to represent distant area lights.
     createDistantAreaLightFace();
 
+    mOccluderCacheVector.clear();
+    mOccluderCacheVector.resize(mLocalLightFaceVector.size() + getDistantLightFaceCount());
+
+    std::vector<mesh::VertexPtr> vertexPtrVector;
+    vertexPtrVector.reserve(mMesh->vertexCount());
     for (mesh::VertexPtr vertexPtr = mMesh->vertexBegin();
          vertexPtr != mMesh->vertexEnd(); ++vertexPtr) {
-        shadeMeshVertex(vertexPtr);
+        vertexPtrVector.push_back(vertexPtr);
+    }
+
+    size_t first = 0;
+    while (first < vertexPtrVector.size()) {
+        size_t last = first;
+        mBackprojectionBoundingBoxVector.clear();
+        do {
+            addBackprojectionBoundingBoxes(vertexPtrVector[last]);
+            ++last;
+        } while (last < vertexPtrVector.size()
+            && mBackprojectionBoundingBoxVector.size() < MAXIMUM_BLOCK_BOUNDING_BOXES);
+
+        mEdgeIntersector.findBoundingBoxIntersections(mBackprojectionBoundingBoxVector,
+            &mOccluderEdgeOffsetVector, &mOccluderEdgeIndexVector);
+
+        mBackprojectionBoundingBoxIndex = 0;
+        for (size_t index = first; index < last; ++index) {
+            shadeMeshVertex(vertexPtrVector[index]);
+        }
+        assert(mBackprojectionBoundingBoxIndex == mBackprojectionBoundingBoxVector.size());
+
+        first = last;
     }
 
     destroyDistantAreaLightFace();
 
+    mOccluderCacheVector.clear();
+
     con::debug << "AABB tree query statistics:\n"
-        << mFaceIntersector.aabbQueryStatistics() << std::endl;
+        << mFaceIntersectorStatistics.asString() << std::endl;
 
     con::debug << "AABB queries per mesh vertex: "
-        << int((10.0*mFaceIntersector.queries())/mMesh->vertexCount())/10.0 << std::endl;
+        << int((10.0*mFaceIntersectorStatistics.queries())/mMesh->vertexCount())/10.0
+        << std::endl;
 
     con::debug << "AABB queries per mesh vertex per light source face: "
-        << int((10.0*mFaceIntersector.queries())/mMesh->vertexCount()
+        << int((10.0*mFaceIntersectorStatistics.queries())/mMesh->vertexCount()
             /(mLocalLightFaceVector.size() + getDistantLightFaceCount()))/10.0 << std::endl;
 
     copyIlluminatedVertexColorsToStandardVertexColors();
@@ -184,26 +249,6 @@ MeshShader::applyObjectToTriangleVector(
     return false;
 }
 
-bool
-MeshShader::applyObjectToBoundingBox(
-    meshisect::EdgeIntersectorAabbTreeNode &edgeIntersectorAabbTreeNode,
-    const cgmath::BoundingBox3f &)
-{
-    mesh::EdgePtr occluderEdgePtr = edgeIntersectorAabbTreeNode.edgePtr();
-
-    if (!mDiscontinuityMesher->edgeIsAdjacentToLightSource(occluderEdgePtr)) {
-        if (mBoundingBoxWedgeIntersector->setVeEventWedge(mBoundingBoxVertexPtr, 
-                occluderEdgePtr)) {
-            traceBackprojectionWedge(*mBoundingBoxWedgeIntersector, 
-                mBoundingBoxLightFacePtr);
-        }   
-    }
-
-    // Don't halt the AABB traversal. We want to consider every edge
-    // that may intersect the tetrahedron.
-    return false;
-}
-
 void
 MeshShader::initializeFaceVertexColors()
 {
@@ -214,7 +259,7 @@ MeshShader::initializeFaceVertexColors()
         for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
              iterator != facePtr->adjacentVertexEnd(); ++iterator) {
             mesh::VertexPtr vertexPtr = *iterator;
-            facePtr->setVertexVector3f(vertexPtr, mIlluminatedColor3fAttributeKey,
+            facePtr->setVertexValue(vertexPtr, mIlluminatedColor3fAttributeKey,
                 cgmath::Vector3f::ZERO);
         }
     }
@@ -238,7 +283,7 @@ MeshShader::shadeLocalLightFaces()
         for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
              iterator != facePtr->adjacentVertexEnd(); ++iterator) {
             mesh::VertexPtr vertexPtr = *iterator;
-            facePtr->setVertexVector3f(vertexPtr, mIlluminatedColor3fAttributeKey,
+            facePtr->setVertexValue(vertexPtr, mIlluminatedColor3fAttributeKey,
                 localLightFace.intensity());
         }
     }    
@@ -272,8 +317,40 @@ MeshShader::copyIlluminatedVertexColorsToStandardVertexColors()
         for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
              iterator != facePtr->adjacentVertexEnd(); ++iterator) {
             mesh::VertexPtr vertexPtr = *iterator;
-            facePtr->setVertexVector3f(vertexPtr, mColor3fAttributeKey,
-                facePtr->getVertexVector3f(vertexPtr, mIlluminatedColor3fAttributeKey));
+            facePtr->setVertexValue(vertexPtr, mColor3fAttributeKey,
+                facePtr->getVertexValue(vertexPtr, mIlluminatedColor3fAttributeKey));
+        }
+    }
+}
+
+void
+MeshShader::addBackprojectionBoundingBoxes(mesh::VertexPtr vertexPtr)
+{
+    // The boxes are added in the same order as shadeMeshVertex
+    // calls shadeMeshVertexWithLightFace.
+    const cgmath::Vector3f &position = vertexPtr->position();
+
+    for (LocalLightFaceVector::iterator iterator = mLocalLightFaceVector.begin();
+         iterator != mLocalLightFaceVector.end(); ++iterator) {
+        cgmath::Vector3f p0;
+        cgmath::Vector3f p1;
+        cgmath::Vector3f p2;
+        mesh::GetTriangularFaceVertexPositions((*iterator).facePtr(), &p0, &p1, &p2);
+        mBackprojectionBoundingBoxVector.push_back(
+            GetBackprojectionBoundingBox(position, p0, p1, p2));
+    }
+
+    const DiscontinuityMesher::DistantAreaLightVector &distantAreaLightVector
+        = mDiscontinuityMesher->distantAreaLightVector();
+    for (size_t index = 0; index < distantAreaLightVector.size(); ++index) {
+        const light::DistantAreaLight &distantAreaLight = distantAreaLightVector[index];
+        for (int index = 0; index < distantAreaLight.sides(); ++index) {
+            mBackprojectionBoundingBoxVector.push_back(
+                GetBackprojectionBoundingBox(position,
+                    distantAreaLight.getCenter(position),
+                    distantAreaLight.calculateVertex(position,
+                        (index + 1) % distantAreaLight.sides()),
+                    distantAreaLight.calculateVertex(position, index)));
         }
     }
 }
@@ -281,10 +358,14 @@ MeshShader::copyIlluminatedVertexColorsToStandardVertexColors()
 void
 MeshShader::shadeMeshVertex(mesh::VertexPtr vertexPtr)
 {
+    unsigned lightFaceIndex = 0;
+
     for (LocalLightFaceVector::iterator iterator = mLocalLightFaceVector.begin();
          iterator != mLocalLightFaceVector.end(); ++iterator) {
         const LocalLightFace &localLightFace = *iterator;
-        shadeMeshVertexWithLightFace(vertexPtr, localLightFace);
+        shadeMeshVertexWithLightFace(vertexPtr, localLightFace,
+            &mOccluderCacheVector[lightFaceIndex]);
+        ++lightFaceIndex;
     }
 
     const DiscontinuityMesher::DistantAreaLightVector &distantAreaLightVector
@@ -314,17 +395,23 @@ MeshShader::shadeMeshVertex(mesh::VertexPtr vertexPtr)
                     mDistantAreaLightVertex2->position()));
             distantLightFace.setCenter(lightCenter);
 
-            shadeMeshVertexWithLightFace(vertexPtr, distantLightFace);
+            shadeMeshVertexWithLightFace(vertexPtr, distantLightFace,
+                &mOccluderCacheVector[lightFaceIndex]);
+            ++lightFaceIndex;
         }
     }
 }
 
 void
 MeshShader::shadeMeshVertexWithLightFace(mesh::VertexPtr vertexPtr,
-    const LightFace &lightFace)
+    const LightFace &lightFace, meshisect::OccluderCache *occluderCache)
 {
     mesh::FacePtr lightFacePtr = lightFace.facePtr();
 
+    assert(mBackprojectionBoundingBoxIndex < mBackprojectionBoundingBoxVector.size());
+    unsigned boundingBoxIndex = mBackprojectionBoundingBoxIndex;
+    ++mBackprojectionBoundingBoxIndex;
+
     // If the vertex is on the back side of the emissive face,
     // the vertex can't be directly illuminated by the face,
     // so we return immediately.
@@ -336,28 +423,31 @@ MeshShader::shadeMeshVertexWithLightFace(mesh::VertexPtr vertexPtr,
 
     WedgeIntersector wedgeIntersector;
 
-    mBoundingBoxWedgeIntersector = &wedgeIntersector;
-    mBoundingBoxVertexPtr = vertexPtr;
-    mBoundingBoxLightFacePtr = lightFacePtr;
-
-    cgmath::BoundingBox3f boundingBox = cgmath::BoundingBox3f::EMPTY_SET;
-    boundingBox.extendByVector3f(vertexPtr->position());
-    assert(lightFacePtr->adjacentVertexCount() == 3);
-    mesh::AdjacentVertexIterator iterator = lightFacePtr->adjacentVertexBegin();
-    boundingBox.extendByVector3f((*iterator)->position());
-    ++iterator;
-    boundingBox.extendByVector3f((*iterator)->position());
-    ++iterator;
-    boundingBox.extendByVector3f((*iterator)->position());
-
-    // Call applyObjectToBoundingBox on all edges that intersect
-    // the bounding box.
-    mEdgeIntersector.applyToBoundingBoxIntersection(boundingBox, this);
+    // Consider every edge that intersects the bounding box
+    // of the vertex and the light face.
+    for (unsigned index = mOccluderEdgeOffsetVector[boundingBoxIndex];
+         index < mOccluderEdgeOffsetVector[boundingBoxIndex + 1]; ++index) {
+        traceOccluderEdge(wedgeIntersector, vertexPtr,
+            mEdgeIntersector.edgeIntersectorAabbTreeNode(
+                mOccluderEdgeIndexVector[index]).edgePtr(),
+            lightFacePtr);
+    }
 
     meshretri::TriangleVector triangleVector;
     mRetriangulator.retriangulateBackprojectionFace(lightFacePtr, &triangleVector);
 
-    shadeFaceVerticesAdjacentToVertex(vertexPtr, lightFace, triangleVector);
+    shadeFaceVerticesAdjacentToVertex(vertexPtr, lightFace, triangleVector, occluderCache);
+}
+
+void
+MeshShader::traceOccluderEdge(WedgeIntersector &wedgeIntersector, mesh::VertexPtr vertexPtr,
+    mesh::EdgePtr occluderEdgePtr, mesh::FacePtr lightFacePtr)
+{
+    if (!mDiscontinuityMesher->edgeIsAdjacentToLightSource(occluderEdgePtr)) {
+        if (wedgeIntersector.setVeEventWedge(vertexPtr, occluderEdgePtr)) {
+            traceBackprojectionWedge(wedgeIntersector, lightFacePtr);
+        }
+    }
 }
 
 void
@@ -392,7 +482,8 @@ MeshShader::traceBackprojectionWedge(WedgeIntersector &wedgeIntersector,
     // that intersect the VE wedge.
     meshisect::FaceIntersector::TriangleVector triangleVector;
     triangleVector.push_back(triangle);
-    mFaceIntersector.applyToTriangleVectorIntersection(triangleVector, this);
+    mFaceIntersector.applyToTriangleVectorIntersection(triangleVector, this,
+        mFaceIntersectorStatisticsPtr);
 
     // From the set of all critical line segments, calculate the subsections
     // of those line segments that are visible from the point being shaded.
@@ -420,7 +511,8 @@ MeshShader::traceBackprojectionWedge(WedgeIntersector &wedgeIntersector,
 
 void
 MeshShader::shadeFaceVerticesAdjacentToVertex(mesh::VertexPtr vertexPtr,
-    const LightFace &lightFace, const meshretri::TriangleVector &triangleVector)
+    const LightFace &lightFace, const meshretri::TriangleVector &triangleVector,
+    meshisect::OccluderCache *occluderCache)
 {
     bool shouldDumpBackprojectionTriangle = false;
 
@@ -443,7 +535,7 @@ MeshShader::shadeFaceVerticesAdjacentToVertex(mesh::VertexPtr vertexPtr,
             + triangle.mPointArray[1] + triangle.mPointArray[2])/3.0;
 
         bool vertexIsIlluminated = !rayIntersectsMesh(rayOrigin, 
-            triangleCenter, vertexPtr, lightFacePtr, mMesh->faceEnd());
+            triangleCenter, vertexPtr, lightFacePtr, mMesh->faceEnd(), occluderCache);
 
         if (shouldDumpBackprojectionTriangle) {
             dumpBackprojectionTriangle(triangle, vertexIsIlluminated ? ILLUMINATED : OCCLUDED);
@@ -504,9 +596,9 @@ MeshShader::shadeFaceVerticesAdjacentToVertex(mesh::VertexPtr vertexPtr,
                     = lightFace.computeIntensityAtPoint(vertexPtr->position(), normal, triangle)
                     *mMaterialTable->getFaceVertexDiffuseColor(facePtr, vertexPtr);
 
-                cgmath::Vector3f oldIntensity = facePtr->getVertexVector3f(vertexPtr, 
+                cgmath::Vector3f oldIntensity = facePtr->getVertexValue(vertexPtr, 
                     mIlluminatedColor3fAttributeKey);
-                facePtr->setVertexVector3f(vertexPtr, mIlluminatedColor3fAttributeKey,
+                facePtr->setVertexValue(vertexPtr, mIlluminatedColor3fAttributeKey,
                     oldIntensity + intensity);
             }
         }
@@ -516,7 +608,8 @@ MeshShader::shadeFaceVerticesAdjacentToVertex(mesh::VertexPtr vertexPtr,
 bool
 MeshShader::rayIntersectsMesh(const cgmath::Vector3f &rayOrigin,
     const cgmath::Vector3f &rayEndpoint, mesh::VertexPtr localVertexToIgnore,
-    mesh::FacePtr emissiveFaceToIgnore, mesh::FacePtr localFaceToIgnore)
+    mesh::FacePtr emissiveFaceToIgnore, mesh::FacePtr localFaceToIgnore,
+    meshisect::OccluderCache *occluderCache)
 {
     MeshShaderFaceListener meshShaderFaceListener;
     meshShaderFaceListener.setMesh(mMesh);
@@ -529,7 +622,8 @@ MeshShader::rayIntersectsMesh(const cgmath::Vector3f &rayOrigin,
     meshShaderFaceListener.initialize();
 
     mFaceIntersector.setIntersectorFaceListener(&meshShaderFaceListener);
-    bool result = mFaceIntersector.occludesRaySegment(rayOrigin, rayEndpoint);
+    bool result = mFaceIntersector.occludesRaySegment(rayOrigin, rayEndpoint,
+        mFaceIntersectorStatisticsPtr, occluderCache);
     mFaceIntersector.setIntersectorFaceListener(NULL);
 
     return result;
@@ -633,7 +727,7 @@ MeshShader::printShadingStatistics()
                 continue;
             }
 
-            cgmath::Vector3f intensity = facePtr->getVertexVector3f(vertexPtr, 
+            cgmath::Vector3f intensity = facePtr->getVertexValue(vertexPtr, 
                 mIlluminatedColor3fAttributeKey);
 
             for (unsigned index = 0; index < 3; ++index) {
@@ -3,7 +3,10 @@
 #ifndef RFM_DISCMESH__MESH_SHADER__INCLUDED
 #define RFM_DISCMESH__MESH_SHADER__INCLUDED
 
+#include <string>
+
 #include <mesh/AttributeKey.h>
+#include <mesh/TypedAttributeKey.h>
 #include <mesh/Types.h>
 #include <meshisect/FaceIntersector.h>
 #include <meshisect/EdgeIntersector.h>
@@ -26,8 +29,7 @@ class LineSegmentCollection;
 //
 // Class that shades mesh vertices.
 
-class MeshShader : public meshisect::FaceIntersector::TriangleListener,
-                     public meshisect::EdgeIntersector::BoundingBoxListener
+class MeshShader : public meshisect::FaceIntersector::TriangleListener
 {
 public:
     MeshShader();
@@ -42,6 +44,11 @@ public:
     // Table of materials defined in the mesh.
     void setMaterialTable(mesh::MaterialTable *materialTable);
 
+    // An optional file in which to save the AABB tree of the mesh's faces,
+    // as with meshisect::FaceIntersector::setAabbTreeFilename.
+    void setAabbTreeFilename(const std::string &aabbTreeFilename);
+    const std::string &aabbTreeFilename() const;
+
     // Shade the mesh face vertices.
     void shadeMeshVertices();
 
@@ -50,25 +57,26 @@ public:
         meshisect::FaceIntersectorAabbTreeNode &faceIntersectorAabbTreeNode,
         const meshisect::FaceIntersector::TriangleVector &triangleVector); 
 
-    // For mesh::EdgeIntersector::BoundingBoxListener:
-    virtual bool applyObjectToBoundingBox(
-        meshisect::EdgeIntersectorAabbTreeNode &edgeIntersectorAabbTreeNode,
-        const cgmath::BoundingBox3f &boundingBox);
-
 private:
     void initializeFaceVertexColors();
     void shadeLocalLightFaces();
     void createLocalLightFaceVector();
     void copyIlluminatedVertexColorsToStandardVertexColors();
+    void addBackprojectionBoundingBoxes(mesh::VertexPtr vertexPtr);
     void shadeMeshVertex(mesh::VertexPtr vertexPtr);
-    void shadeMeshVertexWithLightFace(mesh::VertexPtr vertexPtr, const LightFace &lightFace);
+    void shadeMeshVertexWithLightFace(mesh::VertexPtr vertexPtr, const LightFace &lightFace,
+        meshisect::OccluderCache *occluderCache);
+    void traceOccluderEdge(WedgeIntersector &wedgeIntersector, mesh::VertexPtr vertexPtr,
+        mesh::EdgePtr occluderEdgePtr, mesh::FacePtr lightFacePtr);
     void traceBackprojectionWedge(WedgeIntersector &wedgeIntersector, 
         mesh::FacePtr lightFacePtr);
     void shadeFaceVerticesAdjacentToVertex(mesh::VertexPtr vertexPtr, 
-        const LightFace &lightFace, const meshretri::TriangleVector &triangleVector);
+        const LightFace &lightFace, const meshretri::TriangleVector &triangleVector,
+        meshisect::OccluderCache *occluderCache);
     bool rayIntersectsMesh(const cgmath::Vector3f &rayOrigin, 
         const cgmath::Vector3f &rayEndpoint, mesh::VertexPtr localVertexToIgnore,
-        mesh::FacePtr emissiveFaceToIgnore, mesh::FacePtr localFaceToIgnore);
+        mesh::FacePtr emissiveFaceToIgnore, mesh::FacePtr localFaceToIgnore,
+        meshisect::OccluderCache *occluderCache = NULL);
 
     // Returns true if a face is backfacing with respect to any of the vertices
     // of a triangle on an emissive face.
@@ -104,10 +112,10 @@ private:
 
     mesh::MaterialTable *mMaterialTable;
 
-    mesh::AttributeKey mIlluminatedColor3fAttributeKey;
-    mesh::AttributeKey mMaterialIndexAttributeKey;
-    mesh::AttributeKey mColor3fAttributeKey;
-    mesh::AttributeKey mNormal3fAttributeKey;
+    mesh::TypedAttributeKey<cgmath::Vector3f> mIlluminatedColor3fAttributeKey;
+    mesh::TypedAttributeKey<int32_t> mMaterialIndexAttributeKey;
+    mesh::TypedAttributeKey<cgmath::Vector3f> mColor3fAttributeKey;
+    mesh::TypedAttributeKey<cgmath::Vector3f> mNormal3fAttributeKey;
 
     meshretri::Retriangulator mRetriangulator;
 
@@ -117,14 +125,34 @@ private:
     meshisect::FaceIntersector mFaceIntersector;
     meshisect::EdgeIntersector mEdgeIntersector;
 
+    // Statistics about the queries of mFaceIntersector. These are only
+    // gathered when they'll be reported, and mFaceIntersectorStatisticsPtr
+    // is NULL otherwise.
+    cgmath::AabbTreeStatistics mFaceIntersectorStatistics;
+    cgmath::AabbTreeStatistics *mFaceIntersectorStatisticsPtr;
+
     // Used by traceBackprojectionWedge.
     LineSegmentCollection *mTriangleLineSegmentCollection;
     mesh::FacePtr mTriangleLightFacePtr;
 
-    // Used by shadeMeshVertexWithLightFace.
-    WedgeIntersector *mBoundingBoxWedgeIntersector;
-    mesh::VertexPtr mBoundingBoxVertexPtr;
-    mesh::FacePtr mBoundingBoxLightFacePtr;
+    // The vertices are shaded in blocks. For each block, the bounding boxes
+    // of each vertex and each light face it's shaded with are listed
+    // in the order they're shaded in, and the edges that may occlude
+    // the light faces are found by a single query of mEdgeIntersector.
+    // The edges that intersect the box with index
+    // mBackprojectionBoundingBoxIndex are used by the next call
+    // to shadeMeshVertexWithLightFace.
+    enum {
+        MAXIMUM_BLOCK_BOUNDING_BOXES = 1024
+    };
+    meshisect::EdgeIntersector::BoundingBox3fVector mBackprojectionBoundingBoxVector;
+    std::vector<unsigned> mOccluderEdgeOffsetVector;
+    std::vector<unsigned> mOccluderEdgeIndexVector;
+    unsigned mBackprojectionBoundingBoxIndex;
+
+    // The face that last occluded a shadow ray cast toward each light face,
+    // in the order shadeMeshVertex shades the light faces.
+    std::vector<meshisect::OccluderCache> mOccluderCacheVector;
 
     mesh::AttributeKey mIsDegreeZeroDiscontinuityAttributeKey;
 
@@ -6,7 +6,6 @@
 
 #include <mesh/Face.h>
 #include <mesh/Vertex.h>
-#include <mesh/FaceOperations.h>
 
 cgmath::Vector3f
 GetFaceVertexSamplePosition(mesh::ConstFacePtr facePtr, mesh::ConstVertexPtr vertexPtr)
@@ -30,18 +29,11 @@ GetFaceOtherVertices(mesh::ConstFacePtr facePtr, mesh::ConstVertexPtr vertexPtr,
     // We're assuming the face is a triangle.
     assert(facePtr->adjacentVertexCount() == 3);
 
-    // Find the adjacent vertices.
-    mesh::VertexPtr vertexPtrArray[3];
-    mesh::GetTriangularFaceAdjacentVertices(facePtr, 
-        &vertexPtrArray[0], &vertexPtrArray[1], &vertexPtrArray[2]);
-    int vertexIndex = -1;
-    for (int index = 0; index < 3; ++index) {
-        if (vertexPtrArray[index] == vertexPtr) {
-            vertexIndex = index;
-        }
-    }
-    assert(vertexIndex != -1);
-
-    *nextVertexPtr = vertexPtrArray[(vertexIndex + 1) % 3];
-    *previousVertexPtr = vertexPtrArray[(vertexIndex + 2) % 3];
+    // The corner of the vertex is found without copying
+    // the face's vertices.
+    unsigned corner = facePtr->findCorner(vertexPtr);
+    assert(corner < 3);
+
+    *nextVertexPtr = facePtr->cornerVertexPtr((corner + 1) % 3);
+    *previousVertexPtr = facePtr->cornerVertexPtr((corner + 2) % 3);
 }
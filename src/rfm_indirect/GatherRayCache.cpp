@@ -0,0 +1,198 @@
+// Copyright 2010 Drew Olbrich
+
+#include "GatherRayCache.h"
+
+#include <cassert>
+
+#include <mesh/Mesh.h>
+
+GatherRayCache::GatherRayCache()
+    : mMesh(NULL),
+      mRaysPerFace(0),
+      mRecordIndexAttributeKey(),
+      mHitVector(),
+      mOwnerFacePtrVector(),
+      mDeletedElementTracker()
+{
+    mDeletedElementTracker.setElementMask(mesh::DeletedElementTracker::FACES);
+}
+
+GatherRayCache::~GatherRayCache()
+{
+}
+
+void
+GatherRayCache::setMesh(mesh::Mesh *mesh)
+{
+    mMesh = mesh;
+
+    mRecordIndexAttributeKey = mMesh->getAttributeKey(
+        "__GatherRayCache_recordIndex", mesh::AttributeKey::INT,
+        mesh::AttributeKey::TEMPORARY);
+
+    clear();
+}
+
+mesh::Mesh *
+GatherRayCache::mesh() const
+{
+    return mMesh;
+}
+
+void
+GatherRayCache::setRaysPerFace(unsigned raysPerFace)
+{
+    if (raysPerFace != mRaysPerFace) {
+        mRaysPerFace = raysPerFace;
+        clear();
+    }
+}
+
+unsigned
+GatherRayCache::raysPerFace() const
+{
+    return mRaysPerFace;
+}
+
+void
+GatherRayCache::clear()
+{
+    // Swap with empty vectors to actually release the memory.
+    HitVector().swap(mHitVector);
+    FacePtrVector().swap(mOwnerFacePtrVector);
+
+    mDeletedElementTracker.clear();
+
+    // The record index attributes left on the faces become stale,
+    // but they will never match an owner in mOwnerFacePtrVector.
+}
+
+const GatherRayCache::Hit *
+GatherRayCache::findFaceHitArray(mesh::ConstFacePtr facePtr) const
+{
+    assert(mMesh != NULL);
+
+    if (!facePtr->hasAttribute(mRecordIndexAttributeKey)) {
+        return NULL;
+    }
+
+    int32_t recordIndex = facePtr->getInt(mRecordIndexAttributeKey);
+    if (recordIndex < 0
+        || size_t(recordIndex) >= mOwnerFacePtrVector.size()) {
+        return NULL;
+    }
+
+    // Faces created by SplitEdgeTriangulator inherit the record index
+    // of the face they replaced, so we must make sure the face
+    // is actually the owner of the record.
+    if (mesh::ConstFacePtr(mOwnerFacePtrVector[recordIndex]) != facePtr) {
+        return NULL;
+    }
+
+    return &mHitVector[recordIndex*mRaysPerFace];
+}
+
+GatherRayCache::Hit *
+GatherRayCache::createFaceHitArray(mesh::FacePtr facePtr)
+{
+    assert(mMesh != NULL);
+    assert(mRaysPerFace > 0);
+
+    // Reuse the face's existing record if it has one.
+    if (facePtr->hasAttribute(mRecordIndexAttributeKey)) {
+        int32_t recordIndex = facePtr->getInt(mRecordIndexAttributeKey);
+        if (recordIndex >= 0
+            && size_t(recordIndex) < mOwnerFacePtrVector.size()
+            && mOwnerFacePtrVector[recordIndex] == facePtr) {
+            return &mHitVector[recordIndex*mRaysPerFace];
+        }
+    }
+
+    size_t recordIndex = mOwnerFacePtrVector.size();
+    mOwnerFacePtrVector.push_back(facePtr);
+    mHitVector.resize(mHitVector.size() + mRaysPerFace);
+
+    facePtr->setInt(mRecordIndexAttributeKey, int32_t(recordIndex));
+
+    return &mHitVector[recordIndex*mRaysPerFace];
+}
+
+void
+GatherRayCache::setHit(Hit *hit, mesh::FacePtr facePtr,
+    const cgmath::Vector3f &barycentricCoordinates) const
+{
+    hit->mFacePtr = facePtr;
+    hit->mBarycentricCoordinates[0] = barycentricCoordinates[0];
+    hit->mBarycentricCoordinates[1] = barycentricCoordinates[1];
+}
+
+void
+GatherRayCache::setMiss(Hit *hit) const
+{
+    hit->mFacePtr = mMesh->faceEnd();
+}
+
+mesh::DeletedElementTracker *
+GatherRayCache::deletedElementTracker()
+{
+    return &mDeletedElementTracker;
+}
+
+unsigned
+GatherRayCache::invalidateDeletedFaces()
+{
+    if (mDeletedElementTracker.faceBegin() == mDeletedElementTracker.faceEnd()) {
+        return 0;
+    }
+
+    unsigned invalidatedRecordCount = 0;
+
+    for (size_t recordIndex = 0; recordIndex < mOwnerFacePtrVector.size(); ++recordIndex) {
+        mesh::FacePtr ownerFacePtr = mOwnerFacePtrVector[recordIndex];
+        if (ownerFacePtr == mMesh->faceEnd()) {
+            continue;
+        }
+
+        // The owner itself was deleted. We must also forget about the owner,
+        // because a new face may have been allocated at the same address.
+        bool invalid = mDeletedElementTracker.hasFace(ownerFacePtr);
+
+        // The geometry that one of the rays hit no longer exists.
+        const Hit *hitArray = &mHitVector[recordIndex*mRaysPerFace];
+        for (unsigned ray = 0; !invalid && ray < mRaysPerFace; ++ray) {
+            if (hitArray[ray].mFacePtr != mMesh->faceEnd()
+                && mDeletedElementTracker.hasFace(hitArray[ray].mFacePtr)) {
+                invalid = true;
+            }
+        }
+
+        if (invalid) {
+            mOwnerFacePtrVector[recordIndex] = mMesh->faceEnd();
+            ++invalidatedRecordCount;
+        }
+    }
+
+    mDeletedElementTracker.clear();
+
+    return invalidatedRecordCount;
+}
+
+unsigned
+GatherRayCache::validRecordCount() const
+{
+    unsigned count = 0;
+    for (size_t recordIndex = 0; recordIndex < mOwnerFacePtrVector.size(); ++recordIndex) {
+        if (mOwnerFacePtrVector[recordIndex] != mMesh->faceEnd()) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+size_t
+GatherRayCache::bytesUsed() const
+{
+    return mHitVector.capacity()*sizeof(Hit)
+        + mOwnerFacePtrVector.capacity()*sizeof(mesh::FacePtr);
+}
@@ -0,0 +1,102 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__GATHER_RAY_CACHE__INCLUDED
+#define RFM_INDIRECT__GATHER_RAY_CACHE__INCLUDED
+
+#include <vector>
+
+#include <cgmath/Vector3f.h>
+#include <mesh/Types.h>
+#include <mesh/AttributeKey.h>
+#include <mesh/DeletedElementTracker.h>
+
+namespace mesh {
+class Mesh;
+}
+
+// GatherRayCache
+//
+// Records the outcome of every gather ray fired by MeshShader from a face,
+// so that later bounces, where only the input illumination changes,
+// can be computed without tracing any rays.
+//
+// Each face that is shaded owns a record, which is a contiguous block of
+// hits in a single array. The record index is stored on the face as a temporary
+// attribute. Because SplitEdgeTriangulator copies face attributes to the
+// faces that replace a subdivided face, the owner of each record is also
+// stored, so that records inherited by new faces are not mistaken for their own.
+
+class GatherRayCache
+{
+public:
+    GatherRayCache();
+    ~GatherRayCache();
+
+    // The mesh whose faces are cached.
+    void setMesh(mesh::Mesh *mesh);
+    mesh::Mesh *mesh() const;
+
+    // The number of rays fired from each face. Changing this value
+    // clears the cache.
+    void setRaysPerFace(unsigned raysPerFace);
+    unsigned raysPerFace() const;
+
+    // Discard all records.
+    void clear();
+
+    // The outcome of a single gather ray. If the ray did not hit anything,
+    // mFacePtr is equal to mesh()->faceEnd(). Otherwise, the first two
+    // barycentric coordinates of the point of intersection are stored,
+    // relative to the vertices of the face in adjacency order.
+    // The third is implied.
+    struct Hit {
+        mesh::FacePtr mFacePtr;
+        float mBarycentricCoordinates[2];
+    };
+
+    // Returns the hits recorded for a face, or NULL if the face
+    // has no valid record.
+    const Hit *findFaceHitArray(mesh::ConstFacePtr facePtr) const;
+
+    // Creates a new record for the face and returns its array of hits,
+    // which the caller must fill in. Any previous record for the face is discarded.
+    Hit *createFaceHitArray(mesh::FacePtr facePtr);
+
+    // Helper functions for filling in a hit array.
+    void setHit(Hit *hit, mesh::FacePtr facePtr,
+        const cgmath::Vector3f &barycentricCoordinates) const;
+    void setMiss(Hit *hit) const;
+
+    // Tracks faces deleted during adaptive subdivision. This should be passed to
+    // SplitEdgeTriangulator::setDeletedElementTracker.
+    mesh::DeletedElementTracker *deletedElementTracker();
+
+    // Invalidate all records that were created by, or contain hits against,
+    // faces that have been deleted since the last call.
+    // Returns the number of records invalidated.
+    unsigned invalidateDeletedFaces();
+
+    // The number of valid records.
+    unsigned validRecordCount() const;
+
+    // Number of bytes occupied by the hit array.
+    size_t bytesUsed() const;
+
+private:
+    mesh::Mesh *mMesh;
+    unsigned mRaysPerFace;
+
+    mesh::AttributeKey mRecordIndexAttributeKey;
+
+    typedef std::vector<Hit> HitVector;
+    HitVector mHitVector;
+
+    // The face that owns each record, or mesh()->faceEnd() if the record
+    // has been invalidated.
+    typedef std::vector<mesh::FacePtr> FacePtrVector;
+    FacePtrVector mOwnerFacePtrVector;
+
+    mesh::DeletedElementTracker mDeletedElementTracker;
+};
+
+#endif // RFM_INDIRECT__GATHER_RAY_CACHE__INCLUDED
@@ -11,10 +11,12 @@
 
 #include <opt/ProgramOptionsParser.h>
 #include <con/Streams.h>
+#include <con/LogLevel.h>
 #include <mesh/Mesh.h>
 #include <meshrfm/ReadRfmFile.h>
 #include <meshrfm/WriteRfmFile.h>
 #include <cgmath/Vector3fProgramOption.h>
+#include <light/DistantAreaLight.h>
 
 #include "MeshShader.h"
 
@@ -23,6 +25,9 @@ static opt::ProgramOptionsParser gOptions;
 // Parse the command line arguments.
 static void ParseCommandLineArguments(int argc, char **argv);
 
+// Parse arguments defining distant area light source that represents the sun.
+static void ParseSunArguments(MeshShader &meshShader);
+
 int
 main(int argc, char **argv)
 {
@@ -77,8 +82,62 @@ main(int argc, char **argv)
             meshShader.setBounces(gOptions.get("bounces").as<unsigned>());
         }
 
+        if (gOptions.specified("no-ray-cache")) {
+            meshShader.setCacheGatherRays(false);
+        }
+
+        if (gOptions.specified("aabb-sah")) {
+            meshShader.setSurfaceAreaHeuristic(true);
+        }
+
+        if (gOptions.specified("aabb-quantize")) {
+            meshShader.setQuantizeAabbTree(true);
+        }
+
+        if (gOptions.specified("aabb-cache")) {
+            meshShader.setAabbTreeFilename(gOptions.get("aabb-cache").as<std::string>());
+        }
+
+        if (gOptions.specified("photons")) {
+            meshShader.setPhotonCount(gOptions.get("photons").as<unsigned>());
+        }
+
+        if (gOptions.specified("photons-per-estimate")) {
+            meshShader.setPhotonsPerEstimate(
+                gOptions.get("photons-per-estimate").as<unsigned>());
+        }
+
+        if (gOptions.specified("photon-radius")) {
+            meshShader.setPhotonSearchRadius(gOptions.get("photon-radius").as<float>());
+        }
+
+        if (gOptions.specified("final-gather")) {
+            meshShader.setPhotonFinalGather(true);
+        }
+
+        if (gOptions.specified("radiosity")) {
+            meshShader.setRadiosity(true);
+        }
+
+        if (gOptions.specified("radiosity-epsilon")) {
+            meshShader.setRadiosityRefinementEpsilon(
+                gOptions.get("radiosity-epsilon").as<float>());
+        }
+
+        if (gOptions.specified("radiosity-rays")) {
+            meshShader.setRadiosityRaysPerLink(
+                gOptions.get("radiosity-rays").as<unsigned>());
+        }
+
+        ParseSunArguments(meshShader);
+
         meshShader.shadeMesh();
 
+        if (con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)) {
+            con::debug << "Mesh memory usage:\n" << mesh.memoryUsage().asString()
+                << std::endl;
+        }
+
         con::info << "Writing RFM file \"" << gOptions.get("output-file").as<std::string>()
             << "\"." << std::endl;
         meshrfm::WriteRfmFile(mesh, gOptions.get("output-file").as<std::string>());
@@ -124,7 +183,126 @@ ParseCommandLineArguments(int argc, char **argv)
         ("direct-illumination-scale", opt::value<float>(), "Direct illumination scale")
         ("diffuse-coefficient", opt::value<float>(), "Diffuse coefficient")
         ("bounces", opt::value<unsigned>(), "Indirect illumination bounces")
+        ("no-ray-cache", "Retrace the gather rays on every bounce, rather than "
+            "caching them to save time at the expense of memory")
+        ("aabb-sah", "Build the AABB tree of faces with the surface area heuristic, "
+            "rather than by median splits")
+        ("aabb-quantize", "Compress the AABB tree of faces to save memory, "
+            "at the expense of speed")
+        ("aabb-cache", opt::value<std::string>(),
+            "File in which to save the AABB tree of faces, so that it's not rebuilt "
+            "when the same mesh is processed again")
+        ("photons", opt::value<unsigned>(), 
+            "Number of photons to trace, instead of gathering (default 0)")
+        ("photons-per-estimate", opt::value<unsigned>(),
+            (std::string("Maximum photons per density estimate (default ")
+                + boost::lexical_cast<std::string>(MeshShader::DEFAULT_PHOTONS_PER_ESTIMATE)
+                + ")").c_str())
+        ("photon-radius", opt::value<float>(),
+            (std::string("Photon search radius, relative to the mesh size (default ")
+                + boost::lexical_cast<std::string>(MeshShader::DEFAULT_PHOTON_SEARCH_RADIUS)
+                + ")").c_str())
+        ("final-gather", "Gather one bounce of illumination from the photon estimate")
+        ("radiosity", "Solve for the indirect illumination with hierarchical radiosity, "
+            "instead of gathering")
+        ("radiosity-epsilon", opt::value<float>(),
+            (std::string("Radiosity link refinement threshold (default ")
+                + boost::lexical_cast<std::string>(
+                    MeshShader::DEFAULT_RADIOSITY_REFINEMENT_EPSILON)
+                + ")").c_str())
+        ("radiosity-rays", opt::value<unsigned>(),
+            (std::string("Visibility rays per radiosity link (default ")
+                + boost::lexical_cast<std::string>(MeshShader::DEFAULT_RADIOSITY_RAYS_PER_LINK)
+                + ")").c_str())
+        ("sun-azimuth", opt::value<float>(), "Sun azimuth (degrees), for photon emission")
+        ("sun-elevation", opt::value<float>(), "Sun elevation (degrees), for photon emission")
+        ("sun-diameter", opt::value<float>(), 
+            (std::string("Sun angular diameter (arcminutes, default ")
+                + boost::lexical_cast<std::string>(
+                    light::DistantAreaLight::DEFAULT_ANGULAR_DIAMETER) 
+                + "), for photon emission").c_str())
+        ("sun-sides", opt::value<int>(), 
+            (std::string("Number of sides of sun polygon (default ")
+                + boost::lexical_cast<std::string>(
+                    light::DistantAreaLight::DEFAULT_SIDES) 
+                + "), for photon emission").c_str())
+        ("sun-intensity", opt::value<float>(), "Sun intensity, for photon emission")
+        ("sun-color", opt::value<cgmath::Vector3f>()->set_name("r g b"), 
+            "Sun color (0..1), for photon emission")
         ;
 
     gOptions.parse(argc, argv);
+
+    if (gOptions.specified("final-gather")
+        && !gOptions.specified("photons")) {
+        con::error << "The --final-gather flag may only be specified "
+            << "in combination with the --photons flag." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (gOptions.specified("radiosity")
+        && gOptions.specified("photons")) {
+        con::error << "The --radiosity and --photons flags may not be specified "
+            << "together." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Only photons are emitted by the sun. Gathering and radiosity
+    // pick up the sunlight from the direct illumination in the mesh.
+    if ((gOptions.specified("sun-azimuth")
+            || gOptions.specified("sun-elevation")
+            || gOptions.specified("sun-diameter")
+            || gOptions.specified("sun-sides")
+            || gOptions.specified("sun-intensity")
+            || gOptions.specified("sun-color"))
+        && !gOptions.specified("photons")) {
+        con::error << "The --sun-* flags may only be specified "
+            << "in combination with the --photons flag." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void 
+ParseSunArguments(MeshShader &meshShader)
+{
+    light::DistantAreaLight distantAreaLight;
+    bool defined = false;
+
+    if (gOptions.specified("sun-azimuth")
+        || gOptions.specified("sun-elevation")) {
+        if (gOptions.specified("sun-azimuth")
+            + gOptions.specified("sun-elevation") != 2) {
+            con::error << "Both the --sun-azimuth and --sun-elevation flags must be "
+                << "specified together." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        defined = true;
+        distantAreaLight.setPositionFromAzimuthAndElevation(
+            gOptions.get("sun-azimuth").as<float>(),
+            gOptions.get("sun-elevation").as<float>());
+    }
+
+    if (gOptions.specified("sun-diameter")) {
+        defined = true;
+        distantAreaLight.setAngularDiameter(gOptions.get("sun-diameter").as<float>());
+    }
+
+    if (gOptions.specified("sun-sides")) {
+        defined = true;
+        distantAreaLight.setSides(gOptions.get("sun-sides").as<int>());
+    }
+
+    if (gOptions.specified("sun-intensity")) {
+        defined = true;
+        distantAreaLight.setIntensity(gOptions.get("sun-intensity").as<float>());
+    }
+
+    if (gOptions.specified("sun-color")) {
+        defined = true;
+        distantAreaLight.setColor(gOptions.get("sun-color").as<cgmath::Vector3f>());
+    }
+
+    if (defined) {
+        meshShader.addDistantAreaLight(distantAreaLight);
+    }
 }
@@ -3,10 +3,11 @@
 #include <cstdlib>
 #include <cassert>
 #include <cmath>
-#include <set>
 #include <algorithm>
 
 #include <con/Streams.h>
+#include <con/LogLevel.h>
+#include <os/Time.h>
 #include <mesh/Types.h>
 #include <mesh/Mesh.h>
 #include <mesh/StandardAttributes.h>
@@ -20,6 +21,9 @@
 
 #include "MeshShader.h"
 #include "FaceOperations.h"
+#include "PhotonMap.h"
+#include "PhotonTracer.h"
+#include "RadiositySolver.h"
 
 // This must be a perfect square.
 const unsigned MeshShader::DEFAULT_SAMPLES_PER_VERTEX = 100;
@@ -35,6 +39,20 @@ const float MeshShader::DEFAULT_ADAPTIVE_SUBDIVISION_MINIMUM_EDGE_LENGTH = 0.5;
 // Default maximum pass number for adaptive subdivision.
 const int MeshShader::DEFAULT_ADAPTIVE_SUBDIVISION_MAXIMUM_PASS = 1;
 
+// Default maximum number of photons per density estimate.
+const unsigned MeshShader::DEFAULT_PHOTONS_PER_ESTIMATE = 100;
+
+// Default photon search radius, relative to the mesh bounding box diameter.
+// (This is a multiple of a power of two so that it prints out nicely in the usage message.)
+const float MeshShader::DEFAULT_PHOTON_SEARCH_RADIUS = 0.0625;
+
+// Default radiosity link refinement threshold.
+// (This is a multiple of a power of two so that it prints out nicely in the usage message.)
+const float MeshShader::DEFAULT_RADIOSITY_REFINEMENT_EPSILON = 0.00048828125;
+
+// Default number of visibility rays per radiosity link.
+const unsigned MeshShader::DEFAULT_RADIOSITY_RAYS_PER_LINK = 4;
+
 // Used to determine which adjacent face vertex normals are equivalent.
 static const float NORMAL_EPSILON = 0.001;
 
@@ -52,7 +70,7 @@ MeshShader::MeshShader()
       mHemisphericalPointDistributor(),
       mAdaptiveSubdivisionErrorTolerance(DEFAULT_ADAPTIVE_SUBDIVISION_ERROR_TOLERANCE),
       mAdaptiveSubdivisionMinimumEdgeLength(DEFAULT_ADAPTIVE_SUBDIVISION_MINIMUM_EDGE_LENGTH),
-      mAdaptiveSubdivisionMaximumPass(DEFAULT_ADAPTIVE_SUBDIVISION_MINIMUM_EDGE_LENGTH),
+      mAdaptiveSubdivisionMaximumPass(DEFAULT_ADAPTIVE_SUBDIVISION_MAXIMUM_PASS),
       mSkyColor(1, 1, 1),
       mDirectIlluminationScale(0.7),
       mDiffuseCoefficient(0.3),
@@ -63,7 +81,23 @@ MeshShader::MeshShader()
       mInputIlluminationAttributeKey(),
       mSampledIlluminationAttributeKey(),
       mOutputIlluminationAttributeKey(),
-      mCurrentBounce(0)
+      mCurrentBounce(0),
+      mCacheGatherRays(true),
+      mGatherRayCache(),
+      mGatherRayCacheIsActive(false),
+      mReplayedSamples(0),
+      mFaceIntersectorInitializationTime(),
+      mFaceIntersectorStatistics(),
+      mFaceIntersectorStatisticsPtr(NULL),
+      mFaceIntersectorIsCurrent(false),
+      mPhotonCount(0),
+      mPhotonsPerEstimate(DEFAULT_PHOTONS_PER_ESTIMATE),
+      mPhotonSearchRadius(DEFAULT_PHOTON_SEARCH_RADIUS),
+      mPhotonFinalGather(false),
+      mRadiosity(false),
+      mRadiosityRefinementEpsilon(DEFAULT_RADIOSITY_REFINEMENT_EPSILON),
+      mRadiosityRaysPerLink(DEFAULT_RADIOSITY_RAYS_PER_LINK),
+      mDistantAreaLightVector()
 {
 }
 
@@ -102,6 +136,10 @@ MeshShader::setMesh(mesh::Mesh *mesh)
     mMeshBoundingBoxDiameter = (bbox.max() - bbox.min()).length();
 
     mMaterialTable.initialize(*mesh);
+
+    mGatherRayCache.setMesh(mMesh);
+
+    mFaceIntersectorIsCurrent = false;
 }
 
 void
@@ -196,6 +234,149 @@ MeshShader::bounces() const
     return mBounces;
 }
 
+void
+MeshShader::setCacheGatherRays(bool cacheGatherRays)
+{
+    mCacheGatherRays = cacheGatherRays;
+}
+
+bool
+MeshShader::cacheGatherRays() const
+{
+    return mCacheGatherRays;
+}
+
+void
+MeshShader::setSurfaceAreaHeuristic(bool surfaceAreaHeuristic)
+{
+    mFaceIntersector.setSplitStrategy(surfaceAreaHeuristic
+        ? meshisect::FaceIntersector::SplitStrategy(
+            meshisect::FaceIntersectorAabbTree::SURFACE_AREA_HEURISTIC)
+        : meshisect::FaceIntersector::SplitStrategy(
+            meshisect::FaceIntersectorAabbTree::MEDIAN_SPLIT));
+}
+
+bool
+MeshShader::surfaceAreaHeuristic() const
+{
+    return mFaceIntersector.splitStrategy()
+        == meshisect::FaceIntersectorAabbTree::SURFACE_AREA_HEURISTIC;
+}
+
+void
+MeshShader::setQuantizeAabbTree(bool quantizeAabbTree)
+{
+    mFaceIntersector.setQuantizeAabbTree(quantizeAabbTree);
+}
+
+bool
+MeshShader::quantizeAabbTree() const
+{
+    return mFaceIntersector.quantizeAabbTree();
+}
+
+void
+MeshShader::setAabbTreeFilename(const std::string &aabbTreeFilename)
+{
+    mFaceIntersector.setAabbTreeFilename(aabbTreeFilename);
+}
+
+const std::string &
+MeshShader::aabbTreeFilename() const
+{
+    return mFaceIntersector.aabbTreeFilename();
+}
+
+void
+MeshShader::setPhotonCount(unsigned photonCount)
+{
+    mPhotonCount = photonCount;
+}
+
+unsigned
+MeshShader::photonCount() const
+{
+    return mPhotonCount;
+}
+
+void
+MeshShader::setPhotonsPerEstimate(unsigned photonsPerEstimate)
+{
+    mPhotonsPerEstimate = photonsPerEstimate;
+}
+
+unsigned
+MeshShader::photonsPerEstimate() const
+{
+    return mPhotonsPerEstimate;
+}
+
+void
+MeshShader::setPhotonSearchRadius(float photonSearchRadius)
+{
+    mPhotonSearchRadius = photonSearchRadius;
+}
+
+float
+MeshShader::photonSearchRadius() const
+{
+    return mPhotonSearchRadius;
+}
+
+void
+MeshShader::setPhotonFinalGather(bool photonFinalGather)
+{
+    mPhotonFinalGather = photonFinalGather;
+}
+
+bool
+MeshShader::photonFinalGather() const
+{
+    return mPhotonFinalGather;
+}
+
+void
+MeshShader::setRadiosity(bool radiosity)
+{
+    mRadiosity = radiosity;
+}
+
+bool
+MeshShader::radiosity() const
+{
+    return mRadiosity;
+}
+
+void
+MeshShader::setRadiosityRefinementEpsilon(float radiosityRefinementEpsilon)
+{
+    mRadiosityRefinementEpsilon = radiosityRefinementEpsilon;
+}
+
+float
+MeshShader::radiosityRefinementEpsilon() const
+{
+    return mRadiosityRefinementEpsilon;
+}
+
+void
+MeshShader::setRadiosityRaysPerLink(unsigned radiosityRaysPerLink)
+{
+    mRadiosityRaysPerLink = radiosityRaysPerLink;
+}
+
+unsigned
+MeshShader::radiosityRaysPerLink() const
+{
+    return mRadiosityRaysPerLink;
+}
+
+void
+MeshShader::addDistantAreaLight(const light::DistantAreaLight &distantAreaLight)
+{
+    mDistantAreaLightVector.push_back(distantAreaLight);
+}
+
 void
 MeshShader::shadeMesh()
 {
@@ -206,6 +387,66 @@ MeshShader::shadeMesh()
     mSplitEdgeTriangulator.initialize();
 
     mTotalSamples = 0;
+    mReplayedSamples = 0;
+    mFaceIntersectorInitializationTime = os::TimeValue();
+    mFaceIntersectorStatistics.reset();
+    mFaceIntersectorStatisticsPtr = con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)
+        ? &mFaceIntersectorStatistics : NULL;
+
+    resetIndirectIllumination();
+
+    // The number of bounces computed by gathering. When photons are traced,
+    // they account for all the bounces, and at most one bounce of final
+    // gathering is performed on top of them.
+    unsigned gatherBounces = mBounces;
+
+    if (mRadiosity) {
+        copyDirectIlluminationToInputIllumination();
+        shadeFacesWithRadiosity();
+        convertSampledIlluminationToOutputIllumination();
+        addOutputIlluminationToIndirectIllumination();
+        calculateColorAttributes();
+        reportFaceIntersectorStatistics();
+        return;
+    }
+
+    if (mPhotonCount > 0) {
+
+        if (!shadeFaceVerticesWithPhotons()) {
+            con::warn << "The mesh has no emissive faces and no distant area lights "
+                << "were specified, so no photons were traced." << std::endl;
+        }
+
+        if (!mPhotonFinalGather) {
+            addOutputIlluminationToIndirectIllumination();
+            calculateColorAttributes();
+            reportFaceIntersectorStatistics();
+            return;
+        }
+
+        // The final gather samples the direct illumination together with
+        // the photon estimate of the indirect illumination.
+        copyDirectIlluminationToInputIllumination();
+        addOutputIlluminationToInputIllumination();
+
+        gatherBounces = 1;
+
+    } else {
+        copyDirectIlluminationToInputIllumination();
+    }
+
+    // The gather rays are only worth recording if they'll be replayed
+    // on a later bounce. Each face fires rays from its midpoint and from
+    // a point near each of its three vertices.
+    mGatherRayCache.clear();
+    mGatherRayCacheIsActive = mCacheGatherRays && gatherBounces > 1;
+    if (mGatherRayCacheIsActive) {
+        mGatherRayCache.setRaysPerFace(4*mSamplesPerVertex);
+        mSplitEdgeTriangulator.setDeletedElementTracker(
+            mGatherRayCache.deletedElementTracker());
+    } else {
+        mSplitEdgeTriangulator.setDeletedElementTracker(NULL);
+    }
 
     con::info << "Samples per unique normal per vertex: " 
         << mHemisphericalPointDistributor.pointCount() << std::endl;
@@ -217,11 +458,7 @@ MeshShader::shadeMesh()
             << mAdaptiveSubdivisionMinimumEdgeLength << std::endl;
     }
 
-    resetIndirectIllumination();
-
-    copyDirectIlluminationToInputIllumination();
-
-    for (mCurrentBounce = 1; mCurrentBounce <= mBounces; ++mCurrentBounce) {
+    for (mCurrentBounce = 1; mCurrentBounce <= gatherBounces; ++mCurrentBounce) {
 
         con::info << "Bounce " << mCurrentBounce << "." << std::endl;
 
@@ -238,7 +475,11 @@ MeshShader::shadeMesh()
                     << adaptiveSubdivisionPass << "." << std::endl;
             }
 
-            initializeFaceIntersector();
+            // The AABB tree is updated incrementally by adaptive subdivision,
+            // so it usually carries over from the previous pass and bounce.
+            if (!mFaceIntersectorIsCurrent) {
+                initializeFaceIntersector();
+            }
 
             shadeFaces();
 
@@ -258,7 +499,17 @@ MeshShader::shadeMesh()
 
     calculateColorAttributes();
 
+    reportFaceIntersectorStatistics();
+
     con::info << "Total samples: " << mTotalSamples << std::endl;
+    if (mReplayedSamples > 0) {
+        con::info << "Replayed samples: " << mReplayedSamples << std::endl;
+    }
+
+    con::debug << "Gather ray cache size: " << mGatherRayCache.bytesUsed()
+        << " bytes." << std::endl;
+
+    mGatherRayCache.clear();
 }
 
 void
@@ -266,7 +517,32 @@ MeshShader::initializeFaceIntersector()
 {
     mFaceIntersector.setMesh(mMesh);
     mFaceIntersector.setIntersectorFaceListener(&mMeshShaderFaceListener);
+
+    os::TimeValue start = os::GetProcessUserTime();
     mFaceIntersector.initialize();
+    mFaceIntersectorInitializationTime += os::GetProcessUserTime() - start;
+
+    // Once the mesh is subdivided, its tree won't match the next time
+    // the same input mesh is shaded, so it's not worth saving.
+    mFaceIntersector.setAabbTreeFilename("");
+
+    mFaceIntersectorIsCurrent = true;
+}
+
+void
+MeshShader::reportFaceIntersectorStatistics()
+{
+    con::debug << "AABB tree construction time: "
+        << mFaceIntersectorInitializationTime.asDouble() << " seconds." << std::endl;
+
+    con::debug << "AABB tree size: " << mFaceIntersector.bytesUsed()
+        << " bytes." << std::endl;
+
+    con::debug << "AABB tree memory usage:\n"
+        << mFaceIntersector.aabbMemoryStatistics() << std::endl;
+
+    con::debug << "AABB tree query statistics:\n"
+        << mFaceIntersectorStatistics.asString() << std::endl;
 }
 
 void
@@ -303,18 +579,49 @@ MeshShader::shadeFaces()
 void
 MeshShader::shadeFace(mesh::FacePtr facePtr)
 {
+    // If the rays fired from this face were recorded on a previous bounce,
+    // and nothing they hit has since been subdivided, 
+    // the samples can be replayed without any ray tracing.
+    if (mGatherRayCacheIsActive) {
+        const GatherRayCache::Hit *cachedHitArray 
+            = mGatherRayCache.findFaceHitArray(facePtr);
+        if (cachedHitArray != NULL) {
+            facePtr->setVector3f(mSampledIlluminationAttributeKey, 
+                replayIndirectIllumination(facePtr, cachedHitArray));
+
+            unsigned index = 1;
+            for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+                 iterator != facePtr->adjacentVertexEnd(); ++iterator, ++index) {
+                mesh::VertexPtr vertexPtr = *iterator;
+                facePtr->setVertexVector3f(vertexPtr, mSampledIlluminationAttributeKey, 
+                    replayIndirectIllumination(facePtr, 
+                        cachedHitArray + index*mSamplesPerVertex));
+            }
+
+            facePtr->setBool(mShouldShadeFaceAttributeKey, false);
+            return;
+        }
+    }
+
+    // Record the rays for later bounces.
+    GatherRayCache::Hit *hitArray = NULL;
+    if (mGatherRayCacheIsActive) {
+        hitArray = mGatherRayCache.createFaceHitArray(facePtr);
+    }
+
     // Sample the midpoint of the face.
     cgmath::Vector3f position = mesh::GetFaceAverageVertexPosition(facePtr);
     cgmath::Vector3f normal = mesh::GetFaceGeometricNormal(facePtr);
 
     cgmath::Vector3f indirectIllumination = sampleIndirectIllumination(
-        position, normal, facePtr);
+        position, normal, facePtr, hitArray);
 
     facePtr->setVector3f(mSampledIlluminationAttributeKey, indirectIllumination);
 
     // Sample points near the vertices of the face.
+    unsigned index = 1;
     for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
-         iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+         iterator != facePtr->adjacentVertexEnd(); ++iterator, ++index) {
         mesh::VertexPtr vertexPtr = *iterator;
 
         mesh::VertexPtr nextVertexPtr;
@@ -330,7 +637,8 @@ MeshShader::shadeFace(mesh::FacePtr facePtr)
             + nextEdgeMidpoint + previousEdgeMidpoint)/3.0;
 
         cgmath::Vector3f indirectIllumination = sampleIndirectIllumination(
-            position, normal, facePtr);
+            position, normal, facePtr, 
+            hitArray != NULL ? hitArray + index*mSamplesPerVertex : NULL);
 
         facePtr->setVertexVector3f(vertexPtr, mSampledIlluminationAttributeKey, 
             indirectIllumination);
@@ -339,17 +647,103 @@ MeshShader::shadeFace(mesh::FacePtr facePtr)
     facePtr->setBool(mShouldShadeFaceAttributeKey, false);
 }
 
+bool
+MeshShader::shadeFaceVerticesWithPhotons()
+{
+    if (!mFaceIntersectorIsCurrent) {
+        initializeFaceIntersector();
+    }
+
+    con::info << "Tracing " << mPhotonCount << " photons." << std::endl;
+
+    PhotonMap photonMap;
+
+    PhotonTracer photonTracer;
+    photonTracer.setMesh(mMesh);
+    photonTracer.setFaceIntersector(&mFaceIntersector, &mMeshShaderFaceListener);
+    photonTracer.setAabbTreeStatistics(mFaceIntersectorStatisticsPtr);
+    photonTracer.setMaterialTable(&mMaterialTable);
+    photonTracer.setDiffuseCoefficient(mDiffuseCoefficient);
+    // The final gather accounts for the last bounce itself.
+    photonTracer.setBounces(mPhotonFinalGather ? mBounces - 1 : mBounces);
+    photonTracer.setDistantAreaLightVector(mDistantAreaLightVector);
+    photonTracer.setPhotonMap(&photonMap);
+    bool result = photonTracer.tracePhotons(mPhotonCount);
+
+    con::info << "Stored " << photonTracer.storedPhotonCount() 
+        << " photons." << std::endl;
+
+    photonMap.balance();
+
+    con::debug << "Photon map size: " << photonMap.bytesUsed() 
+        << " bytes." << std::endl;
+
+    float maximumDistance = mPhotonSearchRadius*mMeshBoundingBoxDiameter;
+
+    con::info << "Estimating illumination from photon density." << std::endl;
+
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+
+        // The photons are stored with the geometric normals
+        // of the faces they land on.
+        cgmath::Vector3f normal = mesh::GetFaceGeometricNormal(facePtr);
+
+        for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            mesh::VertexPtr vertexPtr = *iterator;
+
+            cgmath::Vector3f irradiance = photonMap.estimateIrradiance(
+                vertexPtr->position(), normal, mPhotonsPerEstimate, maximumDistance);
+
+            facePtr->setVertexVector3f(vertexPtr, mOutputIlluminationAttributeKey,
+                irradiance*mDiffuseCoefficient
+                *cgmath::Vector3f(mMaterialTable.getMaterialFromFace(facePtr).mDiffuse));
+        }
+    }
+
+    return result;
+}
+
+void
+MeshShader::shadeFacesWithRadiosity()
+{
+    if (!mFaceIntersectorIsCurrent) {
+        initializeFaceIntersector();
+    }
+
+    con::info << "Solving radiosity." << std::endl;
+
+    RadiositySolver radiositySolver;
+    radiositySolver.setMesh(mMesh);
+    radiositySolver.setFaceIntersector(&mFaceIntersector, &mMeshShaderFaceListener);
+    radiositySolver.setAabbTreeStatistics(mFaceIntersectorStatisticsPtr);
+    radiositySolver.setMaterialTable(&mMaterialTable);
+    radiositySolver.setDiffuseCoefficient(mDiffuseCoefficient);
+    radiositySolver.setSkyColor(mSkyColor);
+    radiositySolver.setInputIlluminationAttributeKey(mInputIlluminationAttributeKey);
+    radiositySolver.setSampledIlluminationAttributeKey(mSampledIlluminationAttributeKey);
+    radiositySolver.setRefinementEpsilon(mRadiosityRefinementEpsilon);
+    radiositySolver.setRaysPerLink(mRadiosityRaysPerLink);
+    radiositySolver.setMaximumIterations(mBounces);
+    radiositySolver.solve();
+}
+
 bool
 MeshShader::subdivideFaces()
 {
     con::info << "Subdividing faces." << std::endl;
 
-    // Set of edges to split.
-    typedef std::set<mesh::EdgePtr> SplitEdgePtrSet;
-    SplitEdgePtrSet splitEdgePtrSet;
+    // Edges to split. Edges shared by two faces may be added twice,
+    // so duplicates are removed below.
+    typedef std::vector<mesh::EdgePtr> EdgePtrVector;
+    EdgePtrVector splitEdgePtrVector;
 
     unsigned splitFaceCount = 0;
 
+    // Every face is tested, not just the faces near the ones subdivided 
+    // on the previous pass, because the output illumination is filtered 
+    // over a radius that may reach beyond their neighbors.
     for (mesh::FacePtr facePtr = mMesh->faceBegin();
          facePtr != mMesh->faceEnd(); ++facePtr) {
 
@@ -382,7 +776,7 @@ MeshShader::subdivideFaces()
 
                 if (mesh::GetEdgeLength(edgePtr) > mAdaptiveSubdivisionMinimumEdgeLength) {
                     // We'll split this edge.
-                    splitEdgePtrSet.insert(edgePtr);
+                    splitEdgePtrVector.push_back(edgePtr);
                     foundEdgeToSplit = true;
                 }
             }
@@ -393,11 +787,15 @@ MeshShader::subdivideFaces()
         }
     }
 
-    if (!splitEdgePtrSet.empty()) {
+    std::sort(splitEdgePtrVector.begin(), splitEdgePtrVector.end());
+    splitEdgePtrVector.erase(std::unique(splitEdgePtrVector.begin(), 
+            splitEdgePtrVector.end()), splitEdgePtrVector.end());
+
+    if (!splitEdgePtrVector.empty()) {
 
         // Split the edges.
-        for (SplitEdgePtrSet::const_iterator iterator = splitEdgePtrSet.begin();
-             iterator != splitEdgePtrSet.end(); ++iterator) {
+        for (EdgePtrVector::const_iterator iterator = splitEdgePtrVector.begin();
+             iterator != splitEdgePtrVector.end(); ++iterator) {
             mesh::EdgePtr edgePtr = *iterator;
 
             mesh::VertexPtr v0;
@@ -412,14 +810,55 @@ MeshShader::subdivideFaces()
             newVertexPtr->setBool(mSplitEdgeTriangulator.splitEdgeVertexAttributeKey(), true);
         }
 
-        // Retriangulate the mesh.
-        mSplitEdgeTriangulator.triangulate();
+        // The faces adjacent to the split edges now have more than three vertices,
+        // and will be replaced when the mesh is retriangulated. They're collected
+        // in mesh order, so the new faces are created in the same order
+        // as they would be by SplitEdgeTriangulator::triangulate.
+        typedef std::vector<mesh::FacePtr> FacePtrVector;
+        FacePtrVector splitFacePtrVector;
+        for (mesh::FacePtr facePtr = mMesh->faceBegin();
+             facePtr != mMesh->faceEnd(); ++facePtr) {
+            if (facePtr->adjacentVertexCount() > 3) {
+                splitFacePtrVector.push_back(facePtr);
+            }
+        }
+
+        // Remove the faces from the AABB tree while they still exist.
+        // Splitting the edges doesn't change the bounding boxes of the faces.
+        if (mFaceIntersectorIsCurrent) {
+            for (FacePtrVector::const_iterator iterator = splitFacePtrVector.begin();
+                 iterator != splitFacePtrVector.end(); ++iterator) {
+                if (!mFaceIntersector.removeFace(*iterator)) {
+                    // This shouldn't happen, but if it does, 
+                    // the AABB tree will be rebuilt from scratch.
+                    mFaceIntersectorIsCurrent = false;
+                }
+            }
+        }
+
+        // Retriangulate the faces that had edges split.
+        FacePtrVector newFacePtrVector;
+        mSplitEdgeTriangulator.triangulateFaces(splitFacePtrVector, &newFacePtrVector);
+
+        if (mFaceIntersectorIsCurrent) {
+            for (FacePtrVector::const_iterator iterator = newFacePtrVector.begin();
+                 iterator != newFacePtrVector.end(); ++iterator) {
+                mFaceIntersector.insertFace(*iterator);
+            }
+        }
+
+        // Forget about any recorded rays that hit the faces that were replaced.
+        if (mGatherRayCacheIsActive) {
+            unsigned invalidatedRecordCount = mGatherRayCache.invalidateDeletedFaces();
+            con::debug << "Invalidated " << invalidatedRecordCount 
+                << " gather ray cache records." << std::endl;
+        }
     }
 
     con::info << "Subdivided " << splitFaceCount << " faces." << std::endl;
-    con::info << "Split " << splitEdgePtrSet.size() << " edges." << std::endl;
+    con::info << "Split " << splitEdgePtrVector.size() << " edges." << std::endl;
 
-    return !splitEdgePtrSet.empty();
+    return !splitEdgePtrVector.empty();
 }
 
 void
@@ -455,7 +894,8 @@ MeshShader::createUniqueAdjacentFaceVertexNormalVectorFromVertex(mesh::VertexPtr
 
 cgmath::Vector3f
 MeshShader::sampleIndirectIllumination(const cgmath::Vector3f &point,
-    const cgmath::Vector3f &normal, mesh::FacePtr facePtr)
+    const cgmath::Vector3f &normal, mesh::FacePtr facePtr,
+    GatherRayCache::Hit *hitArray)
 {
     // HemisphericalPointDistributor creates a hemisphere pointing
     // in the direction of the Z axis. To orient the hemisphere in the right direction,
@@ -482,7 +922,7 @@ MeshShader::sampleIndirectIllumination(const cgmath::Vector3f &point,
         mMeshShaderFaceListener.setFacePtrToIgnore(facePtr);
 
         if (mFaceIntersector.intersectsRaySegment(point, endpoint,
-                &intersectionPoint, &intersectedFacePtr)) {
+                &intersectionPoint, &intersectedFacePtr, mFaceIntersectorStatisticsPtr)) {
 
             // The ray intersects scene geometry. We sample the direct illumination
             // assumed to be already encoded in the discontinuity mesh.
@@ -496,28 +936,51 @@ MeshShader::sampleIndirectIllumination(const cgmath::Vector3f &point,
                 = cgmath::GetBarycentricCoordinatesOfPointOnTriangle3f(intersectionPoint, 
                     p0, p1, p2);
 
-            mesh::VertexPtr v0;
-            mesh::VertexPtr v1;
-            mesh::VertexPtr v2;
-            mesh::GetTriangularFaceAdjacentVertices(intersectedFacePtr, &v0, &v1, &v2);
+            if (hitArray != NULL) {
+                mGatherRayCache.setHit(&hitArray[sample], intersectedFacePtr,
+                    barycentricCoordinates);
+            }
+
+            totalIllumination += getInputIllumination(intersectedFacePtr, 
+                barycentricCoordinates);
+
+        } else {
+
+            if (hitArray != NULL) {
+                mGatherRayCache.setMiss(&hitArray[sample]);
+            }
+
+            // Ray intersects the sky.
+            if (mCurrentBounce == 1) {
+                // Only receive illumination from the sky on the first bounce.
+                totalIllumination += mSkyColor;
+            }
+        }
+    }
+
+    return getReflectedIllumination(totalIllumination, facePtr);
+}
+
+cgmath::Vector3f
+MeshShader::replayIndirectIllumination(mesh::FacePtr facePtr,
+    const GatherRayCache::Hit *hitArray)
+{
+    cgmath::Vector3f totalIllumination(0, 0, 0);
+    for (unsigned sample = 0; sample < mSamplesPerVertex; ++sample) {
 
-            assert(intersectedFacePtr->hasVertexAttribute(v0, mInputIlluminationAttributeKey));
-            assert(intersectedFacePtr->hasVertexAttribute(v1, mInputIlluminationAttributeKey));
-            assert(intersectedFacePtr->hasVertexAttribute(v2, mInputIlluminationAttributeKey));
+        ++mReplayedSamples;
 
-            cgmath::Vector3f direct0 = intersectedFacePtr->getVertexVector3f(
-                v0, mInputIlluminationAttributeKey);
-            cgmath::Vector3f direct1 = intersectedFacePtr->getVertexVector3f(
-                v1, mInputIlluminationAttributeKey);
-            cgmath::Vector3f direct2 = intersectedFacePtr->getVertexVector3f(
-                v2, mInputIlluminationAttributeKey);
+        const GatherRayCache::Hit &hit = hitArray[sample];
 
-            cgmath::Vector3f directIllumination
-                = barycentricCoordinates[0]*direct0
-                + barycentricCoordinates[1]*direct1
-                + barycentricCoordinates[2]*direct2;
+        if (hit.mFacePtr != mMesh->faceEnd()) {
 
-            totalIllumination += directIllumination;
+            cgmath::Vector3f barycentricCoordinates(
+                hit.mBarycentricCoordinates[0],
+                hit.mBarycentricCoordinates[1],
+                1.0 - hit.mBarycentricCoordinates[0] - hit.mBarycentricCoordinates[1]);
+
+            totalIllumination += getInputIllumination(hit.mFacePtr, 
+                barycentricCoordinates);
 
         } else {
 
@@ -529,6 +992,38 @@ MeshShader::sampleIndirectIllumination(const cgmath::Vector3f &point,
         }
     }
 
+    return getReflectedIllumination(totalIllumination, facePtr);
+}
+
+cgmath::Vector3f
+MeshShader::getInputIllumination(mesh::FacePtr facePtr, 
+    const cgmath::Vector3f &barycentricCoordinates)
+{
+    mesh::VertexPtr v0;
+    mesh::VertexPtr v1;
+    mesh::VertexPtr v2;
+    mesh::GetTriangularFaceAdjacentVertices(facePtr, &v0, &v1, &v2);
+
+    assert(facePtr->hasVertexAttribute(v0, mInputIlluminationAttributeKey));
+    assert(facePtr->hasVertexAttribute(v1, mInputIlluminationAttributeKey));
+    assert(facePtr->hasVertexAttribute(v2, mInputIlluminationAttributeKey));
+
+    cgmath::Vector3f input0 = facePtr->getVertexVector3f(
+        v0, mInputIlluminationAttributeKey);
+    cgmath::Vector3f input1 = facePtr->getVertexVector3f(
+        v1, mInputIlluminationAttributeKey);
+    cgmath::Vector3f input2 = facePtr->getVertexVector3f(
+        v2, mInputIlluminationAttributeKey);
+
+    return barycentricCoordinates[0]*input0
+        + barycentricCoordinates[1]*input1
+        + barycentricCoordinates[2]*input2;
+}
+
+cgmath::Vector3f
+MeshShader::getReflectedIllumination(const cgmath::Vector3f &totalIllumination,
+    mesh::FacePtr facePtr)
+{
     cgmath::Vector3f illumination = totalIllumination/mSamplesPerVertex;
 
     // TODO: The following calculation does not yet incorporate
@@ -691,6 +1186,23 @@ MeshShader::addOutputIlluminationToIndirectIllumination()
     }
 }
 
+void
+MeshShader::addOutputIlluminationToInputIllumination()
+{
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+
+        for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            mesh::VertexPtr vertexPtr = *iterator;
+
+            facePtr->setVertexVector3f(vertexPtr, mInputIlluminationAttributeKey,
+                facePtr->getVertexVector3f(vertexPtr, mInputIlluminationAttributeKey)
+                + facePtr->getVertexVector3f(vertexPtr, mOutputIlluminationAttributeKey));
+        }
+    }
+}
+
 void
 MeshShader::calculateColorAttributes()
 {
@@ -3,6 +3,7 @@
 #ifndef RFM_INDIRECT__MESH_SHADER__INCLUDED
 #define RFM_INDIRECT__MESH_SHADER__INCLUDED
 
+#include <string>
 #include <vector>
 #include <set>
 #include <map>
@@ -15,9 +16,12 @@
 #include <mesh/MaterialTable.h>
 #include <mesh/SplitEdgeTriangulator.h>
 #include <meshisect/FaceIntersector.h>
+#include <light/DistantAreaLight.h>
+#include <os/TimeValue.h>
 
 #include "MeshShaderFaceListener.h"
 #include "OutputIlluminationAssigner.h"
+#include "GatherRayCache.h"
 
 namespace mesh {
 class Mesh;
@@ -71,6 +75,74 @@ public:
     void setBounces(unsigned bounces);
     unsigned bounces() const;
 
+    // If true, the faces and barycentric coordinates hit by the gather rays
+    // are recorded, and replayed on subsequent bounces instead of tracing
+    // the rays again. This costs 16 bytes per ray.
+    void setCacheGatherRays(bool cacheGatherRays);
+    bool cacheGatherRays() const;
+
+    // If true, the AABB tree of faces is built with the surface area heuristic
+    // rather than by splitting its nodes at the median face.
+    void setSurfaceAreaHeuristic(bool surfaceAreaHeuristic);
+    bool surfaceAreaHeuristic() const;
+
+    // If true, the AABB tree of faces is compressed by quantizing the bounding
+    // boxes of its nodes, which saves memory at the expense of speed.
+    void setQuantizeAabbTree(bool quantizeAabbTree);
+    bool quantizeAabbTree() const;
+
+    // An optional file in which to save the AABB tree of the mesh's faces,
+    // as with meshisect::FaceIntersector::setAabbTreeFilename. Only the tree
+    // of the mesh before adaptive subdivision is saved.
+    void setAabbTreeFilename(const std::string &aabbTreeFilename);
+    const std::string &aabbTreeFilename() const;
+
+    // The number of photons to emit. If nonzero, the indirect illumination
+    // is estimated from the density of photons traced through the mesh,
+    // rather than by gathering.
+    void setPhotonCount(unsigned photonCount);
+    unsigned photonCount() const;
+
+    // The maximum number of photons used to estimate the illumination
+    // at each face vertex.
+    static const unsigned DEFAULT_PHOTONS_PER_ESTIMATE;
+    void setPhotonsPerEstimate(unsigned photonsPerEstimate);
+    unsigned photonsPerEstimate() const;
+
+    // The maximum distance from a face vertex that photons are gathered from,
+    // as a fraction of the diameter of the mesh bounding box.
+    static const float DEFAULT_PHOTON_SEARCH_RADIUS;
+    void setPhotonSearchRadius(float photonSearchRadius);
+    float photonSearchRadius() const;
+
+    // If true, the illumination estimated from the photon map is used as the input
+    // to a single bounce of gathering, which hides the noise of the density
+    // estimate. The gathering samples the sky, which the photons do not.
+    void setPhotonFinalGather(bool photonFinalGather);
+    bool photonFinalGather() const;
+
+    // If true, the indirect illumination is solved with hierarchical radiosity,
+    // rather than by gathering. The number of bounces limits the number
+    // of Gauss-Seidel sweeps, each of which accounts for at least one bounce.
+    void setRadiosity(bool radiosity);
+    bool radiosity() const;
+
+    // Radiosity links are refined until their form factor multiplied by the
+    // luminance of their source is less than this value.
+    static const float DEFAULT_RADIOSITY_REFINEMENT_EPSILON;
+    void setRadiosityRefinementEpsilon(float radiosityRefinementEpsilon);
+    float radiosityRefinementEpsilon() const;
+
+    // The number of rays fired to estimate the visibility of each radiosity link.
+    static const unsigned DEFAULT_RADIOSITY_RAYS_PER_LINK;
+    void setRadiosityRaysPerLink(unsigned radiosityRaysPerLink);
+    unsigned radiosityRaysPerLink() const;
+
+    // Distant area light sources, which emit photons along with the emissive faces.
+    // These should match the light sources that the direct illumination
+    // was calculated with.
+    void addDistantAreaLight(const light::DistantAreaLight &distantAreaLight);
+
     // Shade the mesh.
     void shadeMesh();
 
@@ -78,9 +150,22 @@ private:
     // Initialize the AABB tree of faces with the current mesh.
     void initializeFaceIntersector();
 
+    // Log the time spent building the AABB tree of faces,
+    // and the number of tests performed by its queries.
+    void reportFaceIntersectorStatistics();
+
     // Shade the mesh faces.
     void shadeFaces();
 
+    // Trace photons through the mesh and estimate the indirect illumination
+    // at the face vertices from their density, storing the result as output illumination.
+    // Returns false if the mesh has no light sources.
+    bool shadeFaceVerticesWithPhotons();
+
+    // Solve for the indirect illumination with hierarchical radiosity,
+    // storing the result as output illumination.
+    void shadeFacesWithRadiosity();
+
     // Shade an individual face.
     void shadeFace(mesh::FacePtr facePtr);
 
@@ -94,8 +179,24 @@ private:
         UniqueNormalVector *uniqueNormalVector);
 
     // Calculate the indirect illumination for a given point and normal.
+    // If hitArray is not NULL, the outcome of each ray is recorded in it.
     cgmath::Vector3f sampleIndirectIllumination(const cgmath::Vector3f &point,
-        const cgmath::Vector3f &normal, mesh::FacePtr facePtr);
+        const cgmath::Vector3f &normal, mesh::FacePtr facePtr,
+        GatherRayCache::Hit *hitArray);
+
+    // Calculate the indirect illumination for a face from the
+    // gather rays previously recorded by sampleIndirectIllumination.
+    cgmath::Vector3f replayIndirectIllumination(mesh::FacePtr facePtr,
+        const GatherRayCache::Hit *hitArray);
+
+    // Interpolate the input illumination at a point on a face.
+    cgmath::Vector3f getInputIllumination(mesh::FacePtr facePtr, 
+        const cgmath::Vector3f &barycentricCoordinates);
+
+    // Convert the illumination gathered by all the samples from a point
+    // into the illumination reflected by the face.
+    cgmath::Vector3f getReflectedIllumination(const cgmath::Vector3f &totalIllumination,
+        mesh::FacePtr facePtr);
 
     // Create a 3x3 orientation matrix that points the Z axis in a particular direction.
     cgmath::Matrix3f getZAxisOrientationMatrix(const cgmath::Vector3f &zAxisDirection);
@@ -112,6 +213,7 @@ private:
     void resetSampledIllumination();
     void convertSampledIlluminationToOutputIllumination();
     void addOutputIlluminationToIndirectIllumination();
+    void addOutputIlluminationToInputIllumination();
     void calculateColorAttributes();
 
     mesh::Mesh *mMesh;
@@ -156,6 +258,34 @@ private:
     mesh::AttributeKey mOutputIlluminationAttributeKey;
 
     unsigned mCurrentBounce;
+
+    bool mCacheGatherRays;
+    GatherRayCache mGatherRayCache;
+    // True if the gather rays of the current call to shadeMesh are being recorded.
+    bool mGatherRayCacheIsActive;
+    unsigned mReplayedSamples;
+
+    // Total time spent building the AABB tree of faces.
+    os::TimeValue mFaceIntersectorInitializationTime;
+
+    // Statistics about the queries of mFaceIntersector. These are only
+    // gathered when they'll be reported, and mFaceIntersectorStatisticsPtr
+    // is NULL otherwise.
+    cgmath::AabbTreeStatistics mFaceIntersectorStatistics;
+    cgmath::AabbTreeStatistics *mFaceIntersectorStatisticsPtr;
+
+    // False if the mesh has changed since the face intersector was initialized.
+    bool mFaceIntersectorIsCurrent;
+
+    unsigned mPhotonCount;
+    unsigned mPhotonsPerEstimate;
+    float mPhotonSearchRadius;
+    bool mPhotonFinalGather;
+    bool mRadiosity;
+    float mRadiosityRefinementEpsilon;
+    unsigned mRadiosityRaysPerLink;
+    typedef std::vector<light::DistantAreaLight> DistantAreaLightVector;
+    DistantAreaLightVector mDistantAreaLightVector;
 };
 
 #endif // RFM_INDIRECT__MESH_SHADER__INCLUDED
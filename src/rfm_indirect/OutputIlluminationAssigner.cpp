@@ -24,9 +24,9 @@ OutputIlluminationAssigner::OutputIlluminationAssigner()
       mRadiusAttributeKey(),
       mFaceSet(),
       mVertexSet(),
-      mSampleAabbTreeObjectVector(),
-      mSampleAabbTree(),
-      mVertexAabbTree(),
+      mSamplePointTreeObjectVector(),
+      mSamplePointTree(),
+      mVertexPointTree(),
       mFilterNormal(),
       mFilterTotalWeight(0.0),
       mFilterTotalIllumination(0.0, 0.0, 0.0)
@@ -115,13 +115,13 @@ OutputIlluminationAssigner::shadeContinuousRegionFromFace(mesh::FacePtr facePtr)
 {
     mFaceSet.clear();
     mVertexSet.clear();
-    mSampleAabbTreeObjectVector.clear();
+    mSamplePointTreeObjectVector.clear();
 
     buildContinousRegion(facePtr);
 
-    mSampleAabbTree.initialize(mSampleAabbTreeObjectVector);
+    mSamplePointTree.initialize(mSamplePointTreeObjectVector);
 
-    initializeVertexAabbTree();
+    initializeVertexPointTree();
 
     for (VertexSet::iterator iterator = mVertexSet.begin();
          iterator != mVertexSet.end(); ++iterator) {
@@ -234,7 +234,7 @@ OutputIlluminationAssigner::addSamplesFromFace(mesh::FacePtr facePtr)
     sample.setNormal(mesh::GetFaceGeometricNormal(facePtr));
     sample.setIllumination(facePtr->getVector3f(mSampledIlluminationAttributeKey));
     sample.setFaceArea(faceArea);
-    mSampleAabbTreeObjectVector.push_back(sample);
+    mSamplePointTreeObjectVector.push_back(sample);
 
     for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
          iterator != facePtr->adjacentVertexEnd(); ++iterator) {
@@ -246,47 +246,43 @@ OutputIlluminationAssigner::addSamplesFromFace(mesh::FacePtr facePtr)
         sample.setIllumination(facePtr->getVertexVector3f(vertexPtr, 
                 mSampledIlluminationAttributeKey));
         sample.setFaceArea(faceArea);
-        mSampleAabbTreeObjectVector.push_back(sample);
+        mSamplePointTreeObjectVector.push_back(sample);
     }
 }
 
 void
-OutputIlluminationAssigner::initializeVertexAabbTree()
+OutputIlluminationAssigner::initializeVertexPointTree()
 {
-    VertexAabbTree::ObjectVector vertexAabbTreeNodeVector;
+    VertexPointTree::ObjectVector vertexPointTreeNodeVector;
+    vertexPointTreeNodeVector.reserve(mVertexSet.size());
     for (VertexSet::iterator iterator = mVertexSet.begin();
          iterator != mVertexSet.end(); ++iterator) {
         mesh::VertexPtr vertexPtr = *iterator;
-        VertexAabbTreeNode vertexAabbTreeNode;
-        vertexAabbTreeNode.setVertexPtr(vertexPtr);
-        vertexAabbTreeNodeVector.push_back(vertexAabbTreeNode);
+        VertexPointTreeNode vertexPointTreeNode;
+        vertexPointTreeNode.setVertexPtr(vertexPtr);
+        vertexPointTreeNodeVector.push_back(vertexPointTreeNode);
     }
 
-    mVertexAabbTree.initialize(vertexAabbTreeNodeVector);
+    mVertexPointTree.initialize(vertexPointTreeNodeVector);
 }
 
 void
 OutputIlluminationAssigner::applyRadiusToVerticesInSphere(const cgmath::Vector3f &center, 
     float radius)
 {
-    cgmath::BoundingBox3f boundingBox(center - cgmath::Vector3f::UNIT*radius,
-        center + cgmath::Vector3f::UNIT*radius);
-    mVertexAabbTree.applyToBoundingBoxIntersection(boundingBox, this);
+    mVertexPointTree.applyToSphereIntersection(center, radius, this);
 
-    // Continued in applyObjectToBoundingBox...
+    // Continued in applyObjectToSphere...
 }
 
 bool
-OutputIlluminationAssigner::applyObjectToBoundingBox(VertexAabbTreeNode &vertexAabbTreeNode,
-    const cgmath::BoundingBox3f &boundingBox)
+OutputIlluminationAssigner::applyObjectToSphere(VertexPointTreeNode &vertexPointTreeNode,
+    const cgmath::Vector3f &, float radius, float)
 {
-    mesh::VertexPtr vertexPtr = vertexAabbTreeNode.vertexPtr();
-    float sphereRadius = boundingBox.sizeX()*0.5;
-
-    if ((boundingBox.center() - vertexPtr->position()).length() <= sphereRadius) {
-        if (sphereRadius > vertexPtr->getFloat(mRadiusAttributeKey)) {
-            vertexPtr->setFloat(mRadiusAttributeKey, sphereRadius);
-        }
+    // The point tree only reports vertices inside the sphere.
+    mesh::VertexPtr vertexPtr = vertexPointTreeNode.vertexPtr();
+    if (radius > vertexPtr->getFloat(mRadiusAttributeKey)) {
+        vertexPtr->setFloat(mRadiusAttributeKey, radius);
     }
 
     // Keep testing all other vertices.
@@ -301,12 +297,9 @@ OutputIlluminationAssigner::getFilteredIndirectIllumination(const cgmath::Vector
     mFilterTotalWeight = 0.0;
     mFilterTotalIllumination = cgmath::Vector3f(0.0, 0.0, 0.0);
 
-    cgmath::BoundingBox3f boundingBox(position - cgmath::Vector3f::UNIT*radius,
-        position + cgmath::Vector3f::UNIT*radius);
+    mSamplePointTree.applyToSphereIntersection(position, radius, this);
 
-    mSampleAabbTree.applyToBoundingBoxIntersection(boundingBox, this);
-
-    // Continued in applyObjectToBoundingBox...
+    // Continued in applyObjectToSphere...
 
     if (mFilterTotalWeight == 0.0) {
         return cgmath::Vector3f(0.0, 0.0, 0.0);
@@ -316,14 +309,13 @@ OutputIlluminationAssigner::getFilteredIndirectIllumination(const cgmath::Vector
 }
 
 bool 
-OutputIlluminationAssigner::applyObjectToBoundingBox(Sample &sample,
-    const cgmath::BoundingBox3f &boundingBox)
+OutputIlluminationAssigner::applyObjectToSphere(Sample &sample,
+    const cgmath::Vector3f &, float radius, float distanceSquared)
 {
-    float sphereRadius = boundingBox.sizeX()*0.5;
-
-    float distance = (boundingBox.center() - sample.position()).length();
+    float distance = sqrtf(distanceSquared);
 
-    if (distance < sphereRadius) {
+    // Samples on the boundary of the sphere have no weight.
+    if (distance < radius) {
 
         float dot = mFilterNormal.dot(sample.normal());
         if (dot < 0.0) {
@@ -334,7 +326,7 @@ OutputIlluminationAssigner::applyObjectToBoundingBox(Sample &sample,
 
         static const float FILTER_RADIUS = 0.25;
 
-        weight *= gaussian(distance/sphereRadius/FILTER_RADIUS);
+        weight *= gaussian(distance/radius/FILTER_RADIUS);
 
         weight *= sample.faceArea();
         
@@ -9,8 +9,8 @@
 #include <mesh/Types.h>
 #include <mesh/AttributeKey.h>
 
-#include "VertexAabbTree.h"
-#include "SampleAabbTree.h"
+#include "VertexPointTree.h"
+#include "SamplePointTree.h"
 
 // OutputIlluminationAssigner
 //
@@ -18,8 +18,8 @@
 // based on the sampled illumination.
 
 class OutputIlluminationAssigner 
-    : public VertexAabbTree::BoundingBoxListener,
-        public SampleAabbTree::BoundingBoxListener
+    : public VertexPointTree::SphereListener,
+        public SamplePointTree::SphereListener
 {
 public:
     OutputIlluminationAssigner();
@@ -54,20 +54,20 @@ private:
 
     void addSamplesFromFace(mesh::FacePtr facePtr);
 
-    void initializeVertexAabbTree();
+    void initializeVertexPointTree();
 
     void applyRadiusToVerticesInSphere(const cgmath::Vector3f &center, float radius);
 
-    // For VertexAabbTree:
-    virtual bool applyObjectToBoundingBox(VertexAabbTreeNode &vertexAabbTreeNode,
-        const cgmath::BoundingBox3f &boundingBox);
+    // For VertexPointTree:
+    virtual bool applyObjectToSphere(VertexPointTreeNode &vertexPointTreeNode,
+        const cgmath::Vector3f &center, float radius, float distanceSquared);
 
     cgmath::Vector3f getFilteredIndirectIllumination(const cgmath::Vector3f &position,
         const cgmath::Vector3f &normal, float radius);
 
-    // For SampleAabbTree:
-    virtual bool applyObjectToBoundingBox(Sample &sample, 
-        const cgmath::BoundingBox3f &boundingBox);
+    // For SamplePointTree:
+    virtual bool applyObjectToSphere(Sample &sample, const cgmath::Vector3f &center,
+        float radius, float distanceSquared);
 
     float gaussian(float x);
 
@@ -87,10 +87,10 @@ private:
     typedef std::set<mesh::VertexPtr> VertexSet;
     VertexSet mVertexSet;
 
-    SampleAabbTree::ObjectVector mSampleAabbTreeObjectVector;
-    SampleAabbTree mSampleAabbTree;
+    SamplePointTree::ObjectVector mSamplePointTreeObjectVector;
+    SamplePointTree mSamplePointTree;
 
-    VertexAabbTree mVertexAabbTree;
+    VertexPointTree mVertexPointTree;
 
     cgmath::Vector3f mFilterNormal;
     float mFilterTotalWeight;
@@ -0,0 +1,176 @@
+// Copyright 2010 Drew Olbrich
+
+#include "PhotonMap.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <cgmath/Constants.h>
+
+const float PhotonMap::MINIMUM_NORMAL_DOT_PRODUCT = 0.5;
+const unsigned PhotonMap::MINIMUM_PHOTONS_PER_ESTIMATE = 8;
+
+// Filter that accepts only the photons deposited on surfaces
+// facing roughly the same direction as the query point.
+class PhotonNormalFilter : public cgmath::PointTree<PhotonMap::Photon>::NearestObjectFilter
+{
+public:
+    PhotonNormalFilter(const cgmath::Vector3f &normal) : mNormal(normal) {}
+
+    virtual bool acceptNearestObject(const PhotonMap::Photon &photon) const {
+        return photon.mNormal.dot(mNormal) > PhotonMap::MINIMUM_NORMAL_DOT_PRODUCT;
+    }
+
+private:
+    cgmath::Vector3f mNormal;
+};
+
+// Sphere listener that totals the area of the area samples
+// on surfaces facing roughly the same direction as the query point.
+class AreaSampleSphereListener
+    : public cgmath::PointTree<PhotonMap::AreaSample>::SphereListener
+{
+public:
+    AreaSampleSphereListener(const cgmath::Vector3f &normal)
+        : mNormal(normal), mTotalArea(0.0) {}
+
+    virtual bool applyObjectToSphere(PhotonMap::AreaSample &areaSample,
+        const cgmath::Vector3f &, float, float) {
+        if (areaSample.mNormal.dot(mNormal) > PhotonMap::MINIMUM_NORMAL_DOT_PRODUCT) {
+            mTotalArea += areaSample.mArea;
+        }
+        return false;
+    }
+
+    float totalArea() const { return mTotalArea; }
+
+private:
+    cgmath::Vector3f mNormal;
+    float mTotalArea;
+};
+
+PhotonMap::PhotonMap()
+    : mPhotonVector(),
+      mAreaSampleVector(),
+      mPhotonTree(),
+      mAreaSampleTree(),
+      mNearestObjectVector(),
+      mIsBalanced(true)
+{
+}
+
+PhotonMap::~PhotonMap()
+{
+}
+
+void
+PhotonMap::clear()
+{
+    PhotonVector().swap(mPhotonVector);
+    AreaSampleVector().swap(mAreaSampleVector);
+    mPhotonTree.clear();
+    mAreaSampleTree.clear();
+    mIsBalanced = true;
+}
+
+void
+PhotonMap::storePhoton(const cgmath::Vector3f &position, const cgmath::Vector3f &power,
+    const cgmath::Vector3f &normal)
+{
+    Photon photon;
+    photon.mPosition = position;
+    photon.mPower = power;
+    photon.mNormal = normal;
+
+    mPhotonVector.push_back(photon);
+
+    mIsBalanced = false;
+}
+
+void
+PhotonMap::storeAreaSample(const cgmath::Vector3f &position, const cgmath::Vector3f &normal,
+    float area)
+{
+    AreaSample areaSample;
+    areaSample.mPosition = position;
+    areaSample.mNormal = normal;
+    areaSample.mArea = area;
+
+    mAreaSampleVector.push_back(areaSample);
+
+    mIsBalanced = false;
+}
+
+void
+PhotonMap::balance()
+{
+    // The trees copy the photons and area samples,
+    // so the vectors are no longer needed.
+    mPhotonTree.initialize(mPhotonVector);
+    PhotonVector().swap(mPhotonVector);
+
+    mAreaSampleTree.initialize(mAreaSampleVector);
+    AreaSampleVector().swap(mAreaSampleVector);
+
+    mIsBalanced = true;
+}
+
+size_t
+PhotonMap::photonCount() const
+{
+    return mIsBalanced ? mPhotonTree.size() : mPhotonVector.size();
+}
+
+cgmath::Vector3f
+PhotonMap::estimateIrradiance(const cgmath::Vector3f &position,
+    const cgmath::Vector3f &normal, unsigned maximumPhotons,
+    float maximumDistance)
+{
+    assert(mIsBalanced);
+
+    PhotonNormalFilter photonNormalFilter(normal);
+    mPhotonTree.findNearestObjects(position, maximumPhotons, maximumDistance,
+        &mNearestObjectVector, &photonNormalFilter);
+
+    if (mNearestObjectVector.size() < MINIMUM_PHOTONS_PER_ESTIMATE) {
+        return cgmath::Vector3f::ZERO;
+    }
+
+    cgmath::Vector3f totalPower(0, 0, 0);
+    for (size_t index = 0; index < mNearestObjectVector.size(); ++index) {
+        totalPower += mNearestObjectVector[index].mObject->mPower;
+    }
+
+    // The nearest photons are sorted by distance. If they didn't fill
+    // the search radius, the density is measured over the entire search area.
+    // This is less biased at the edges of sparsely lit regions.
+    float radius = maximumDistance;
+    if (mNearestObjectVector.size() == maximumPhotons) {
+        radius = sqrtf(mNearestObjectVector.back().mDistanceSquared);
+    }
+
+    AreaSampleSphereListener areaSampleSphereListener(normal);
+    mAreaSampleTree.applyToSphereIntersection(position, radius, &areaSampleSphereListener);
+    float area = areaSampleSphereListener.totalArea();
+
+    // If the area samples are too sparse to measure the area,
+    // fall back on the area of a disk.
+    if (area == 0.0) {
+        area = cgmath::PI*radius*radius;
+    }
+
+    if (area == 0.0) {
+        return cgmath::Vector3f::ZERO;
+    }
+
+    return totalPower/area;
+}
+
+size_t
+PhotonMap::bytesUsed() const
+{
+    return mPhotonVector.capacity()*sizeof(Photon)
+        + mAreaSampleVector.capacity()*sizeof(AreaSample)
+        + mPhotonTree.bytesUsed()
+        + mAreaSampleTree.bytesUsed();
+}
@@ -0,0 +1,109 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__PHOTON_MAP__INCLUDED
+#define RFM_INDIRECT__PHOTON_MAP__INCLUDED
+
+#include <vector>
+
+#include <cgmath/Vector3f.h>
+#include <cgmath/PointTree.h>
+
+// PhotonMap
+//
+// Stores the photons deposited on the mesh by PhotonTracer, and estimates
+// the irradiance at arbitrary points from their density.
+//
+// Once all the photons have been stored, balance() arranges them into
+// a cgmath::PointTree.
+//
+// The density of the photons is measured against the area of the surfaces
+// that lie within the search radius, rather than against the area of a disk
+// of that radius. Around a vertex where a floor meets a wall, only part
+// of the disk lies on the floor, so dividing by the area of the whole disk
+// would underestimate the irradiance there. The area is measured with
+// a second point tree of area samples scattered over the surfaces of the mesh,
+// each of which stands for a small patch of surface.
+
+class PhotonMap
+{
+public:
+    PhotonMap();
+    ~PhotonMap();
+
+    struct Photon {
+        cgmath::Vector3f mPosition;
+        // Flux carried by the photon.
+        cgmath::Vector3f mPower;
+        // Geometric normal of the face the photon was deposited on.
+        cgmath::Vector3f mNormal;
+
+        // Required by the cgmath::PointTree template.
+        const cgmath::Vector3f &position() const { return mPosition; }
+    };
+
+    struct AreaSample {
+        cgmath::Vector3f mPosition;
+        cgmath::Vector3f mNormal;
+        // Area of the patch of surface represented by the sample.
+        float mArea;
+
+        // Required by the cgmath::PointTree template.
+        const cgmath::Vector3f &position() const { return mPosition; }
+    };
+
+    // Photons and area samples on surfaces whose normals are farther apart
+    // than this (as a dot product) from the normal at the query point
+    // belong to a different surface, such as the other side of a thin wall,
+    // or a wall that meets the floor at a corner, and are ignored.
+    static const float MINIMUM_NORMAL_DOT_PRODUCT;
+
+    // Estimates from fewer photons than this are mostly noise,
+    // and are treated as zero.
+    static const unsigned MINIMUM_PHOTONS_PER_ESTIMATE;
+
+    // Discard all photons and area samples.
+    void clear();
+
+    // Add a photon to the map. The map must then be balanced
+    // before it can be queried.
+    void storePhoton(const cgmath::Vector3f &position, const cgmath::Vector3f &power,
+        const cgmath::Vector3f &normal);
+
+    // Add an area sample to the map. The samples should cover all the surfaces
+    // that photons may be deposited on, with roughly even density.
+    void storeAreaSample(const cgmath::Vector3f &position, const cgmath::Vector3f &normal,
+        float area);
+
+    // Arrange the photons and area samples into point trees.
+    void balance();
+
+    // Number of photons stored in the map.
+    size_t photonCount() const;
+
+    // Estimate the irradiance at a point on a surface from the density of
+    // up to maximumPhotons of the photons closest to it, no farther than
+    // maximumDistance.
+    cgmath::Vector3f estimateIrradiance(const cgmath::Vector3f &position,
+        const cgmath::Vector3f &normal, unsigned maximumPhotons,
+        float maximumDistance);
+
+    // Number of bytes occupied by the photons and area samples.
+    size_t bytesUsed() const;
+
+private:
+    typedef std::vector<Photon> PhotonVector;
+    PhotonVector mPhotonVector;
+    typedef std::vector<AreaSample> AreaSampleVector;
+    AreaSampleVector mAreaSampleVector;
+
+    typedef cgmath::PointTree<Photon> PhotonTree;
+    PhotonTree mPhotonTree;
+    typedef cgmath::PointTree<AreaSample> AreaSampleTree;
+    AreaSampleTree mAreaSampleTree;
+
+    PhotonTree::NearestObjectVector mNearestObjectVector;
+
+    bool mIsBalanced;
+};
+
+#endif // RFM_INDIRECT__PHOTON_MAP__INCLUDED
@@ -0,0 +1,430 @@
+// Copyright 2010 Drew Olbrich
+
+#include "PhotonTracer.h"
+
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <cgmath/Vector2f.h>
+#include <cgmath/Constants.h>
+#include <cgmath/CircleOperations.h>
+#include <mesh/Mesh.h>
+#include <mesh/MeshOperations.h>
+#include <mesh/FaceOperations.h>
+#include <mesh/MaterialTable.h>
+#include <meshisect/FaceIntersector.h>
+
+#include "MeshShaderFaceListener.h"
+#include "PhotonMap.h"
+
+// Return the scalar power of a colored flux, used to weigh light sources
+// and surface reflectances against each other.
+static float
+GetScalarPower(const cgmath::Vector3f &power)
+{
+    return (power[0] + power[1] + power[2])/3.0;
+}
+
+// Create two unit vectors perpendicular to each other and to a unit normal.
+static void
+GetPerpendicularVectors(const cgmath::Vector3f &normal, cgmath::Vector3f *x,
+    cgmath::Vector3f *y)
+{
+    if (fabsf(normal[0]) > fabsf(normal[1]) && fabsf(normal[0]) > fabsf(normal[2])) {
+        *x = cgmath::Vector3f(0, 1, 0);
+    } else {
+        *x = cgmath::Vector3f(1, 0, 0);
+    }
+    *y = normal.cross(*x).normalized();
+    *x = y->cross(normal).normalized();
+}
+
+PhotonTracer::PhotonTracer()
+    : mMesh(NULL),
+      mFaceIntersector(NULL),
+      mMeshShaderFaceListener(NULL),
+      mAabbTreeStatistics(NULL),
+      mMaterialTable(NULL),
+      mDiffuseCoefficient(0.3),
+      mBounces(1),
+      mDistantAreaLightVector(),
+      mPhotonMap(NULL),
+      mMeshBoundingBox(),
+      mMeshBoundingBoxDiameter(0.0),
+      mEmitterVector(),
+      mStoredPhotonCount(0)
+{
+}
+
+PhotonTracer::~PhotonTracer()
+{
+}
+
+void
+PhotonTracer::setMesh(mesh::Mesh *mesh)
+{
+    mMesh = mesh;
+
+    mMeshBoundingBox = mesh::ComputeBoundingBox(*mMesh);
+    mMeshBoundingBoxDiameter = (mMeshBoundingBox.max() - mMeshBoundingBox.min()).length();
+}
+
+void
+PhotonTracer::setFaceIntersector(meshisect::FaceIntersector *faceIntersector,
+    MeshShaderFaceListener *meshShaderFaceListener)
+{
+    mFaceIntersector = faceIntersector;
+    mMeshShaderFaceListener = meshShaderFaceListener;
+}
+
+void
+PhotonTracer::setAabbTreeStatistics(cgmath::AabbTreeStatistics *aabbTreeStatistics)
+{
+    mAabbTreeStatistics = aabbTreeStatistics;
+}
+
+void
+PhotonTracer::setMaterialTable(const mesh::MaterialTable *materialTable)
+{
+    mMaterialTable = materialTable;
+}
+
+void
+PhotonTracer::setDiffuseCoefficient(float diffuseCoefficient)
+{
+    mDiffuseCoefficient = diffuseCoefficient;
+}
+
+float
+PhotonTracer::diffuseCoefficient() const
+{
+    return mDiffuseCoefficient;
+}
+
+void
+PhotonTracer::setBounces(unsigned bounces)
+{
+    mBounces = bounces;
+}
+
+unsigned
+PhotonTracer::bounces() const
+{
+    return mBounces;
+}
+
+void
+PhotonTracer::setDistantAreaLightVector(const DistantAreaLightVector &distantAreaLightVector)
+{
+    mDistantAreaLightVector = distantAreaLightVector;
+}
+
+void
+PhotonTracer::setPhotonMap(PhotonMap *photonMap)
+{
+    mPhotonMap = photonMap;
+}
+
+bool
+PhotonTracer::tracePhotons(unsigned photonCount)
+{
+    assert(mMesh != NULL);
+    assert(mFaceIntersector != NULL);
+    assert(mMeshShaderFaceListener != NULL);
+    assert(mMaterialTable != NULL);
+    assert(mPhotonMap != NULL);
+
+    mStoredPhotonCount = 0;
+
+    float totalPower = createEmitterVector();
+    if (totalPower == 0.0 || photonCount == 0) {
+        return false;
+    }
+
+    for (unsigned photon = 0; photon < photonCount; ++photon) {
+
+        const Emitter &emitter = chooseEmitter();
+
+        // Each emitter is chosen with a probability proportional to its power,
+        // so that all photons start out with roughly the same power.
+        float probability = GetScalarPower(emitter.mPower)/totalPower;
+        cgmath::Vector3f power = emitter.mPower/(probability*photonCount);
+
+        cgmath::Vector3f origin;
+        cgmath::Vector3f direction;
+        mesh::FacePtr facePtr;
+        emitPhoton(emitter, &origin, &direction, &facePtr);
+
+        tracePhoton(origin, direction, power, facePtr);
+    }
+
+    storeAreaSamples(mStoredPhotonCount*AREA_SAMPLES_PER_PHOTON);
+
+    return true;
+}
+
+unsigned
+PhotonTracer::storedPhotonCount() const
+{
+    return mStoredPhotonCount;
+}
+
+float
+PhotonTracer::createEmitterVector()
+{
+    mEmitterVector.clear();
+
+    float totalPower = 0.0;
+
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+        cgmath::Vector3f emission(mMaterialTable->getMaterialFromFace(facePtr).mEmission);
+        if (emission == cgmath::Vector3f::ZERO) {
+            continue;
+        }
+
+        Emitter emitter;
+        emitter.mFacePtr = facePtr;
+        emitter.mDistantAreaLight = NULL;
+        emitter.mPower = emission*mesh::GetFaceArea(facePtr);
+        totalPower += GetScalarPower(emitter.mPower);
+        emitter.mCumulativeProbability = totalPower;
+
+        mEmitterVector.push_back(emitter);
+    }
+
+    // Distant area lights emit photons from a disk that is large enough
+    // to cover the mesh, so their power is the irradiance they deliver
+    // to a perpendicular surface times the area of the disk.
+    float radius = mMeshBoundingBoxDiameter*0.5;
+    for (size_t index = 0; index < mDistantAreaLightVector.size(); ++index) {
+        light::DistantAreaLight &distantAreaLight = mDistantAreaLightVector[index];
+
+        // The polygon of the light source defines the directions
+        // that its photons are emitted in.
+        distantAreaLight.setSceneDiameter(mMeshBoundingBoxDiameter);
+        distantAreaLight.prepareForVertexCalculation();
+
+        Emitter emitter;
+        emitter.mFacePtr = mMesh->faceEnd();
+        emitter.mDistantAreaLight = &distantAreaLight;
+        emitter.mPower = distantAreaLight.intensity()*distantAreaLight.color()
+            *cgmath::PI*radius*radius;
+        totalPower += GetScalarPower(emitter.mPower);
+        emitter.mCumulativeProbability = totalPower;
+
+        mEmitterVector.push_back(emitter);
+    }
+
+    if (totalPower > 0.0) {
+        for (size_t index = 0; index < mEmitterVector.size(); ++index) {
+            mEmitterVector[index].mCumulativeProbability /= totalPower;
+        }
+    }
+
+    return totalPower;
+}
+
+const PhotonTracer::Emitter &
+PhotonTracer::chooseEmitter() const
+{
+    assert(!mEmitterVector.empty());
+
+    float random = drand48();
+    for (size_t index = 0; index < mEmitterVector.size(); ++index) {
+        if (random < mEmitterVector[index].mCumulativeProbability) {
+            return mEmitterVector[index];
+        }
+    }
+
+    // Guard against roundoff error in the cumulative probabilities.
+    return mEmitterVector.back();
+}
+
+void
+PhotonTracer::emitPhoton(const Emitter &emitter, cgmath::Vector3f *origin,
+    cgmath::Vector3f *direction, mesh::FacePtr *facePtr) const
+{
+    if (emitter.mDistantAreaLight == NULL) {
+
+        // Choose a random point on the emissive face, which is
+        // assumed to emit light only from its front side.
+        cgmath::Vector3f p0;
+        cgmath::Vector3f p1;
+        cgmath::Vector3f p2;
+        mesh::GetTriangularFaceVertexPositions(emitter.mFacePtr, &p0, &p1, &p2);
+
+        float u = drand48();
+        float v = drand48();
+        if (u + v > 1.0) {
+            u = 1.0 - u;
+            v = 1.0 - v;
+        }
+
+        *origin = p0 + (p1 - p0)*u + (p2 - p0)*v;
+        *direction = getRandomCosineWeightedDirection(
+            mesh::GetFaceGeometricNormal(emitter.mFacePtr));
+        *facePtr = emitter.mFacePtr;
+
+    } else {
+
+        // Choose a random point on a disk facing the light source,
+        // outside of the mesh bounding box.
+        const light::DistantAreaLight &distantAreaLight = *emitter.mDistantAreaLight;
+        cgmath::Vector3f towardLight = distantAreaLight.position().normalized();
+        cgmath::Vector3f x;
+        cgmath::Vector3f y;
+        GetPerpendicularVectors(towardLight, &x, &y);
+
+        cgmath::Vector2f pointOnCircle = cgmath::MapConcentricSquareToConcentricCircle(
+            cgmath::Vector2f(drand48(), drand48()));
+        float radius = mMeshBoundingBoxDiameter*0.5;
+
+        cgmath::Vector3f center = (mMeshBoundingBox.min() + mMeshBoundingBox.max())*0.5;
+
+        *origin = center + towardLight*mMeshBoundingBoxDiameter
+            + x*pointOnCircle[0]*radius + y*pointOnCircle[1]*radius;
+
+        // The photon travels away from a random point on the polygon
+        // of the light source, as seen from the origin. The polygon is made up
+        // of triangles of equal area that share its center.
+        int sides = distantAreaLight.sides();
+        int side = std::min(int(drand48()*sides), sides - 1);
+        cgmath::Vector3f p0 = distantAreaLight.getCenter(cgmath::Vector3f::ZERO);
+        cgmath::Vector3f p1 = distantAreaLight.calculateVertex(cgmath::Vector3f::ZERO, side);
+        cgmath::Vector3f p2 = distantAreaLight.calculateVertex(cgmath::Vector3f::ZERO,
+            (side + 1) % sides);
+
+        float u = drand48();
+        float v = drand48();
+        if (u + v > 1.0) {
+            u = 1.0 - u;
+            v = 1.0 - v;
+        }
+
+        *direction = -(p0 + (p1 - p0)*u + (p2 - p0)*v).normalized();
+        *facePtr = mMesh->faceEnd();
+    }
+}
+
+void
+PhotonTracer::tracePhoton(cgmath::Vector3f origin, cgmath::Vector3f direction,
+    cgmath::Vector3f power, mesh::FacePtr facePtr)
+{
+    // The segment must reach across the mesh from the distant light disk.
+    float length = mMeshBoundingBoxDiameter*2.0;
+
+    for (unsigned hit = 1; ; ++hit) {
+
+        mMeshShaderFaceListener->setFacePtrToIgnore(facePtr);
+
+        cgmath::Vector3f intersectionPoint;
+        if (!mFaceIntersector->intersectsRaySegment(origin, origin + direction*length,
+                &intersectionPoint, &facePtr, mAabbTreeStatistics)) {
+            // The photon left the scene.
+            return;
+        }
+
+        // Faces are two-sided, but they only hold one illumination value
+        // per vertex, so the photons that land on either side are stored
+        // with the geometric normal of the face.
+        cgmath::Vector3f normal = mesh::GetFaceGeometricNormal(facePtr);
+
+        // The first hit is direct illumination, which is already
+        // accounted for by the discontinuity mesh.
+        if (hit > 1) {
+            mPhotonMap->storePhoton(intersectionPoint, power, normal);
+            ++mStoredPhotonCount;
+        }
+
+        if (hit > mBounces) {
+            return;
+        }
+
+        cgmath::Vector3f diffuse(mMaterialTable->getMaterialFromFace(facePtr).mDiffuse);
+
+        if (hit > 1) {
+            // Russian roulette.
+            cgmath::Vector3f reflectance = mDiffuseCoefficient*diffuse;
+            float probability = std::min(1.0f, GetScalarPower(reflectance));
+            if (probability <= 0.0 || drand48() >= probability) {
+                return;
+            }
+            power *= reflectance/probability;
+        } else {
+            // The direct illumination stored in the mesh includes
+            // the diffuse color of the surface, but not the diffuse coefficient.
+            power *= diffuse;
+        }
+
+        // The photon is reflected off of whichever side it hit.
+        if (normal.dot(direction) > 0.0) {
+            normal = -normal;
+        }
+
+        origin = intersectionPoint;
+        direction = getRandomCosineWeightedDirection(normal);
+    }
+}
+
+void
+PhotonTracer::storeAreaSamples(unsigned areaSampleCount)
+{
+    float totalArea = 0.0;
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+        totalArea += mesh::GetFaceArea(facePtr);
+    }
+
+    if (totalArea == 0.0) {
+        return;
+    }
+
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+
+        // Every face gets at least one sample, and the samples of each face
+        // add up to exactly its area.
+        float area = mesh::GetFaceArea(facePtr);
+        unsigned sampleCount = std::max(1U, 
+            unsigned(area/totalArea*areaSampleCount + 0.5));
+
+        cgmath::Vector3f normal = mesh::GetFaceGeometricNormal(facePtr);
+
+        cgmath::Vector3f p0;
+        cgmath::Vector3f p1;
+        cgmath::Vector3f p2;
+        mesh::GetTriangularFaceVertexPositions(facePtr, &p0, &p1, &p2);
+
+        for (unsigned sample = 0; sample < sampleCount; ++sample) {
+            float u = drand48();
+            float v = drand48();
+            if (u + v > 1.0) {
+                u = 1.0 - u;
+                v = 1.0 - v;
+            }
+
+            mPhotonMap->storeAreaSample(p0 + (p1 - p0)*u + (p2 - p0)*v, normal,
+                area/sampleCount);
+        }
+    }
+}
+
+cgmath::Vector3f
+PhotonTracer::getRandomCosineWeightedDirection(const cgmath::Vector3f &normal) const
+{
+    cgmath::Vector3f x;
+    cgmath::Vector3f y;
+    GetPerpendicularVectors(normal, &x, &y);
+
+    cgmath::Vector2f pointOnCircle = cgmath::MapConcentricSquareToConcentricCircle(
+        cgmath::Vector2f(drand48(), drand48()));
+
+    float u = pointOnCircle[0];
+    float v = pointOnCircle[1];
+    float w = sqrtf(std::max(0.0f, 1.0f - u*u - v*v));
+
+    return x*u + y*v + normal*w;
+}
@@ -0,0 +1,153 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__PHOTON_TRACER__INCLUDED
+#define RFM_INDIRECT__PHOTON_TRACER__INCLUDED
+
+#include <vector>
+
+#include <cgmath/Vector3f.h>
+#include <cgmath/BoundingBox3f.h>
+#include <mesh/Types.h>
+#include <light/DistantAreaLight.h>
+
+namespace mesh {
+class Mesh;
+class MaterialTable;
+}
+
+namespace meshisect {
+class FaceIntersector;
+}
+
+namespace cgmath {
+class AabbTreeStatistics;
+}
+
+class MeshShaderFaceListener;
+class PhotonMap;
+
+// PhotonTracer
+//
+// Emits photons from the emissive faces of a mesh and from distant area lights,
+// traces their diffuse interreflections through the mesh, and deposits them
+// in a PhotonMap.
+//
+// The direct illumination is already encoded in the discontinuity mesh,
+// so photons are only stored once they have been reflected at least once.
+// To remain consistent with the gathering estimator in MeshShader,
+// which treats the direct illumination stored in the mesh as the illumination
+// leaving the surfaces it reaches, photons are attenuated at their first
+// reflection only by the diffuse color of the surface, which rfm_direct 
+// has already applied to the direct illumination. At each later reflection,
+// they survive by Russian roulette with a probability based on the diffuse
+// reflectance of the surface.
+//
+// Photons from distant area lights arrive from random points on the polygon
+// of the light source, so they spread out by its angular diameter
+// just as the direct illumination calculated by rfm_direct does.
+
+class PhotonTracer
+{
+public:
+    PhotonTracer();
+    ~PhotonTracer();
+
+    // The mesh to trace photons through.
+    void setMesh(mesh::Mesh *mesh);
+
+    // The face intersector, which must already be initialized with the mesh,
+    // and the listener it was configured with, which is used to prevent
+    // reflected photons from hitting the face they left.
+    void setFaceIntersector(meshisect::FaceIntersector *faceIntersector,
+        MeshShaderFaceListener *meshShaderFaceListener);
+
+    // Optional statistics object that the face intersector queries are added to.
+    void setAabbTreeStatistics(cgmath::AabbTreeStatistics *aabbTreeStatistics);
+
+    // Table of mesh materials, which define the emission and
+    // diffuse color of each face.
+    void setMaterialTable(const mesh::MaterialTable *materialTable);
+
+    // Diffuse coefficient, applied to the photon power on reflection.
+    void setDiffuseCoefficient(float diffuseCoefficient);
+    float diffuseCoefficient() const;
+
+    // The number of indirect illumination bounces to trace photons through.
+    void setBounces(unsigned bounces);
+    unsigned bounces() const;
+
+    // Distant area light sources, in addition to the emissive faces.
+    typedef std::vector<light::DistantAreaLight> DistantAreaLightVector;
+    void setDistantAreaLightVector(const DistantAreaLightVector &distantAreaLightVector);
+
+    // The photon map that photons are stored in.
+    void setPhotonMap(PhotonMap *photonMap);
+
+    // Emit the specified number of photons and store their hits in the photon map,
+    // along with the area samples that the photon map measures their density against.
+    // Returns false if the scene has no light sources.
+    bool tracePhotons(unsigned photonCount);
+
+    // Number of photons that were stored in the photon map by the last call
+    // to tracePhotons.
+    unsigned storedPhotonCount() const;
+
+private:
+    // The number of area samples scattered over the mesh per photon stored.
+    enum {
+        AREA_SAMPLES_PER_PHOTON = 1
+    };
+
+    // A source of photons, which is either an emissive face or a distant area light.
+    struct Emitter {
+        mesh::FacePtr mFacePtr;
+        const light::DistantAreaLight *mDistantAreaLight;
+        // Total flux emitted.
+        cgmath::Vector3f mPower;
+        // Cumulative probability used to select the emitter.
+        float mCumulativeProbability;
+    };
+    typedef std::vector<Emitter> EmitterVector;
+
+    // Create the vector of emitters. Returns the total luminous power emitted.
+    float createEmitterVector();
+
+    // Choose an emitter at random, in proportion to its power.
+    const Emitter &chooseEmitter() const;
+
+    // Choose the origin and initial direction of a photon.
+    void emitPhoton(const Emitter &emitter, cgmath::Vector3f *origin,
+        cgmath::Vector3f *direction, mesh::FacePtr *facePtr) const;
+
+    // Follow a photon until it leaves the scene or is absorbed.
+    void tracePhoton(cgmath::Vector3f origin, cgmath::Vector3f direction,
+        cgmath::Vector3f power, mesh::FacePtr facePtr);
+
+    // Scatter area samples over the faces of the mesh, with even density,
+    // and store them in the photon map.
+    void storeAreaSamples(unsigned areaSampleCount);
+
+    // Return a random direction in the hemisphere around a normal,
+    // with a cosine-weighted distribution.
+    cgmath::Vector3f getRandomCosineWeightedDirection(
+        const cgmath::Vector3f &normal) const;
+
+    mesh::Mesh *mMesh;
+    meshisect::FaceIntersector *mFaceIntersector;
+    MeshShaderFaceListener *mMeshShaderFaceListener;
+    cgmath::AabbTreeStatistics *mAabbTreeStatistics;
+    const mesh::MaterialTable *mMaterialTable;
+    float mDiffuseCoefficient;
+    unsigned mBounces;
+    DistantAreaLightVector mDistantAreaLightVector;
+    PhotonMap *mPhotonMap;
+
+    cgmath::BoundingBox3f mMeshBoundingBox;
+    float mMeshBoundingBoxDiameter;
+
+    EmitterVector mEmitterVector;
+
+    unsigned mStoredPhotonCount;
+};
+
+#endif // RFM_INDIRECT__PHOTON_TRACER__INCLUDED
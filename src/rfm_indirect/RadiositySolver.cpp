@@ -0,0 +1,706 @@
+// Copyright 2010 Drew Olbrich
+
+#include "RadiositySolver.h"
+
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <con/Streams.h>
+#include <cgmath/Constants.h>
+#include <cgmath/ColorOperations.h>
+#include <cgmath/Vector2f.h>
+#include <cgmath/CircleOperations.h>
+#include <mesh/Mesh.h>
+#include <mesh/MeshOperations.h>
+#include <mesh/FaceOperations.h>
+#include <mesh/MaterialTable.h>
+#include <meshisect/FaceIntersector.h>
+
+#include "MeshShaderFaceListener.h"
+
+// Clusters with a larger estimated form factor than this are always refined,
+// regardless of their brightness, because the approximation of their
+// orientation becomes too crude.
+static const float MAXIMUM_CLUSTER_FORM_FACTOR = 0.1;
+
+// Fraction of a visibility ray segment that is tested for occlusion.
+// The end of the segment is left out so the ray doesn't hit the face
+// it's aimed at.
+static const float VISIBILITY_SEGMENT_FRACTION = 0.999;
+
+// The number of rays fired from each face to estimate how much of the sky it sees.
+static const unsigned SKY_RAYS_PER_FACE = 64;
+
+// Limits on the scale factor applied to the links of a face so that their
+// form factors sum to the fraction of its hemisphere that doesn't see the sky.
+static const float MINIMUM_LINK_SCALE = 0.5;
+static const float MAXIMUM_LINK_SCALE = 2.0;
+
+// Create two unit vectors perpendicular to each other and to a unit normal.
+static void
+GetPerpendicularVectors(const cgmath::Vector3f &normal, cgmath::Vector3f *x,
+    cgmath::Vector3f *y)
+{
+    if (fabsf(normal[0]) > fabsf(normal[1]) && fabsf(normal[0]) > fabsf(normal[2])) {
+        *x = cgmath::Vector3f(0, 1, 0);
+    } else {
+        *x = cgmath::Vector3f(1, 0, 0);
+    }
+    *y = normal.cross(*x).normalized();
+    *x = y->cross(normal).normalized();
+}
+
+// Compares the centers of elements along one axis.
+class ElementCenterComparator
+{
+public:
+    explicit ElementCenterComparator(int axis) : mAxis(axis) {}
+    template <class ELEMENT>
+    bool operator()(const ELEMENT &lhs, const ELEMENT &rhs) const {
+        return lhs.mCenter[mAxis] < rhs.mCenter[mAxis];
+    }
+private:
+    int mAxis;
+};
+
+RadiositySolver::RadiositySolver()
+    : mMesh(NULL),
+      mFaceIntersector(NULL),
+      mMeshShaderFaceListener(NULL),
+      mAabbTreeStatistics(NULL),
+      mMaterialTable(NULL),
+      mDiffuseCoefficient(0.3),
+      mSkyColor(0, 0, 0),
+      mInputIlluminationAttributeKey(),
+      mSampledIlluminationAttributeKey(),
+      mRefinementEpsilon(0.0005),
+      mRaysPerLink(4),
+      mMaximumIterations(8),
+      mConvergenceTolerance(0.001),
+      mElementVector(),
+      mClusterVector(),
+      mLinkVector(),
+      mLinkOffsetVector(),
+      mLinkRayVector(),
+      mLinkRayOriginVector(),
+      mLinkRayEndpointVector(),
+      mLinkRayOccludedVector(),
+      mMeshBoundingBoxDiameter(0.0),
+      mIterationCount(0)
+{
+}
+
+RadiositySolver::~RadiositySolver()
+{
+}
+
+void
+RadiositySolver::setMesh(mesh::Mesh *mesh)
+{
+    mMesh = mesh;
+}
+
+void
+RadiositySolver::setFaceIntersector(meshisect::FaceIntersector *faceIntersector,
+    MeshShaderFaceListener *meshShaderFaceListener)
+{
+    mFaceIntersector = faceIntersector;
+    mMeshShaderFaceListener = meshShaderFaceListener;
+}
+
+void
+RadiositySolver::setAabbTreeStatistics(cgmath::AabbTreeStatistics *aabbTreeStatistics)
+{
+    mAabbTreeStatistics = aabbTreeStatistics;
+}
+
+void
+RadiositySolver::setMaterialTable(const mesh::MaterialTable *materialTable)
+{
+    mMaterialTable = materialTable;
+}
+
+void
+RadiositySolver::setDiffuseCoefficient(float diffuseCoefficient)
+{
+    mDiffuseCoefficient = diffuseCoefficient;
+}
+
+float
+RadiositySolver::diffuseCoefficient() const
+{
+    return mDiffuseCoefficient;
+}
+
+void
+RadiositySolver::setSkyColor(const cgmath::Vector3f &skyColor)
+{
+    mSkyColor = skyColor;
+}
+
+const cgmath::Vector3f &
+RadiositySolver::skyColor() const
+{
+    return mSkyColor;
+}
+
+void
+RadiositySolver::setInputIlluminationAttributeKey(const mesh::AttributeKey &attributeKey)
+{
+    mInputIlluminationAttributeKey = attributeKey;
+}
+
+void
+RadiositySolver::setSampledIlluminationAttributeKey(const mesh::AttributeKey &attributeKey)
+{
+    mSampledIlluminationAttributeKey = attributeKey;
+}
+
+void
+RadiositySolver::setRefinementEpsilon(float refinementEpsilon)
+{
+    mRefinementEpsilon = refinementEpsilon;
+}
+
+float
+RadiositySolver::refinementEpsilon() const
+{
+    return mRefinementEpsilon;
+}
+
+void
+RadiositySolver::setRaysPerLink(unsigned raysPerLink)
+{
+    mRaysPerLink = raysPerLink;
+}
+
+unsigned
+RadiositySolver::raysPerLink() const
+{
+    return mRaysPerLink;
+}
+
+void
+RadiositySolver::setMaximumIterations(unsigned maximumIterations)
+{
+    mMaximumIterations = maximumIterations;
+}
+
+unsigned
+RadiositySolver::maximumIterations() const
+{
+    return mMaximumIterations;
+}
+
+void
+RadiositySolver::setConvergenceTolerance(float convergenceTolerance)
+{
+    mConvergenceTolerance = convergenceTolerance;
+}
+
+float
+RadiositySolver::convergenceTolerance() const
+{
+    return mConvergenceTolerance;
+}
+
+void
+RadiositySolver::solve()
+{
+    assert(mMesh != NULL);
+    assert(mFaceIntersector != NULL);
+    assert(mMeshShaderFaceListener != NULL);
+    assert(mMaterialTable != NULL);
+    assert(mRaysPerLink > 0);
+
+    mClusterVector.clear();
+    mLinkVector.clear();
+    mLinkOffsetVector.clear();
+    mIterationCount = 0;
+
+    cgmath::BoundingBox3f meshBoundingBox = mesh::ComputeBoundingBox(*mMesh);
+    mMeshBoundingBoxDiameter = (meshBoundingBox.max() - meshBoundingBox.min()).length();
+
+    createElementVector();
+    if (mElementVector.empty()) {
+        return;
+    }
+
+    // A binary hierarchy over n elements has 2n - 1 clusters.
+    mClusterVector.reserve(2*mElementVector.size() - 1);
+    createCluster(0, mElementVector.size());
+
+    con::info << "Linking " << mElementVector.size() << " faces." << std::endl;
+
+    mLinkOffsetVector.reserve(mElementVector.size() + 1);
+    for (unsigned receiver = 0; receiver < mElementVector.size(); ++receiver) {
+        createElementLinks(receiver);
+    }
+    mLinkOffsetVector.push_back(mLinkVector.size());
+
+    con::info << "Created " << mLinkVector.size() << " links." << std::endl;
+
+    for (mIterationCount = 1; mIterationCount <= mMaximumIterations; ++mIterationCount) {
+
+        updateClusterFlux();
+
+        // Each element's new illumination is immediately visible to the
+        // elements that are linked to it later in the same sweep.
+        float maximumChange = 0.0;
+        for (unsigned receiver = 0; receiver < mElementVector.size(); ++receiver) {
+            Element &element = mElementVector[receiver];
+
+            cgmath::Vector3f illumination = (gatherElementIllumination(receiver)
+                + mSkyColor*element.mSkyFormFactor)*element.mReflectance;
+
+            for (int index = 0; index < 3; ++index) {
+                maximumChange = std::max(maximumChange,
+                    fabsf(illumination[index] - element.mIndirectIllumination[index]));
+            }
+
+            element.mIndirectIllumination = illumination;
+        }
+
+        con::info << "Iteration " << mIterationCount << ": maximum change "
+            << maximumChange << "." << std::endl;
+
+        if (maximumChange < mConvergenceTolerance) {
+            break;
+        }
+    }
+
+    mIterationCount = std::min(mIterationCount, mMaximumIterations);
+
+    storeSolution();
+
+    con::debug << "Radiosity solver size: " << bytesUsed() << " bytes." << std::endl;
+}
+
+size_t
+RadiositySolver::linkCount() const
+{
+    return mLinkVector.size();
+}
+
+unsigned
+RadiositySolver::iterationCount() const
+{
+    return mIterationCount;
+}
+
+size_t
+RadiositySolver::bytesUsed() const
+{
+    return mElementVector.capacity()*sizeof(Element)
+        + mClusterVector.capacity()*sizeof(Cluster)
+        + mLinkVector.capacity()*sizeof(Link)
+        + mLinkOffsetVector.capacity()*sizeof(unsigned);
+}
+
+void
+RadiositySolver::createElementVector()
+{
+    mElementVector.clear();
+    mElementVector.reserve(mMesh->faceCount());
+
+    for (mesh::FacePtr facePtr = mMesh->faceBegin();
+         facePtr != mMesh->faceEnd(); ++facePtr) {
+
+        Element element;
+        element.mFacePtr = facePtr;
+        mesh::GetTriangularFaceVertexPositions(facePtr,
+            &element.mP0, &element.mP1, &element.mP2);
+        element.mCenter = (element.mP0 + element.mP1 + element.mP2)/3.0;
+        element.mArea = mesh::GetFaceArea(facePtr);
+
+        // Degenerate faces neither receive nor contribute illumination.
+        if (element.mArea > 0.0) {
+            element.mNormal = mesh::GetFaceGeometricNormal(facePtr);
+        } else {
+            element.mArea = 0.0;
+            element.mNormal = cgmath::Vector3f(0, 0, 0);
+        }
+
+        element.mReflectance = cgmath::Vector3f(
+            mMaterialTable->getMaterialFromFace(facePtr).mDiffuse)*mDiffuseCoefficient;
+
+        element.mDirectIllumination = cgmath::Vector3f(0, 0, 0);
+        for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            element.mDirectIllumination += facePtr->getVertexVector3f(*iterator,
+                mInputIlluminationAttributeKey);
+        }
+        element.mDirectIllumination /= 3.0;
+
+        element.mIndirectIllumination = cgmath::Vector3f(0, 0, 0);
+        element.mSkyFormFactor = 0.0;
+
+        mElementVector.push_back(element);
+    }
+}
+
+unsigned
+RadiositySolver::createCluster(unsigned begin, unsigned end)
+{
+    assert(begin < end);
+
+    unsigned index = mClusterVector.size();
+    mClusterVector.push_back(Cluster());
+
+    // The children are created after their parent, so the root (index 0)
+    // is never a child, and zero means that a cluster has no children.
+    unsigned leftChild = 0;
+    unsigned rightChild = 0;
+    if (end - begin > 1) {
+        cgmath::BoundingBox3f centerBoundingBox;
+        centerBoundingBox.reset();
+        for (unsigned element = begin; element < end; ++element) {
+            centerBoundingBox.extendByVector3f(mElementVector[element].mCenter);
+        }
+
+        cgmath::Vector3f size = centerBoundingBox.size();
+        int axis = 0;
+        if (size[1] > size[axis]) {
+            axis = 1;
+        }
+        if (size[2] > size[axis]) {
+            axis = 2;
+        }
+
+        unsigned middle = begin + (end - begin)/2;
+        std::nth_element(mElementVector.begin() + begin, mElementVector.begin() + middle,
+            mElementVector.begin() + end, ElementCenterComparator(axis));
+
+        leftChild = createCluster(begin, middle);
+        rightChild = createCluster(middle, end);
+    }
+
+    Cluster &cluster = mClusterVector[index];
+    cluster.mBegin = begin;
+    cluster.mEnd = end;
+    cluster.mLeftChild = leftChild;
+    cluster.mRightChild = rightChild;
+
+    if (leftChild == 0) {
+        const Element &element = mElementVector[begin];
+        cluster.mBoundingBox.reset();
+        cluster.mBoundingBox.extendByVector3f(element.mP0);
+        cluster.mBoundingBox.extendByVector3f(element.mP1);
+        cluster.mBoundingBox.extendByVector3f(element.mP2);
+        cluster.mArea = element.mArea;
+        for (int axis = 0; axis < 3; ++axis) {
+            cluster.mProjectedArea[axis] = element.mArea*fabsf(element.mNormal[axis]);
+        }
+        cluster.mLuminance = cgmath::LinearColorToLuminance(element.mDirectIllumination);
+    } else {
+        const Cluster &left = mClusterVector[leftChild];
+        const Cluster &right = mClusterVector[rightChild];
+        cluster.mBoundingBox = left.mBoundingBox;
+        cluster.mBoundingBox.extendByBoundingBox3f(right.mBoundingBox);
+        cluster.mArea = left.mArea + right.mArea;
+        cluster.mProjectedArea = left.mProjectedArea + right.mProjectedArea;
+        cluster.mLuminance = 0.0;
+        if (cluster.mArea > 0.0) {
+            cluster.mLuminance = (left.mLuminance*left.mArea
+                + right.mLuminance*right.mArea)/cluster.mArea;
+        }
+    }
+
+    cluster.mCenter = cluster.mBoundingBox.center();
+    cluster.mRadius = cluster.mBoundingBox.size().length()*0.5;
+
+    return index;
+}
+
+void
+RadiositySolver::createElementLinks(unsigned receiver)
+{
+    mLinkOffsetVector.push_back(mLinkVector.size());
+
+    Element &element = mElementVector[receiver];
+    if (element.mArea == 0.0) {
+        return;
+    }
+
+    refineLink(receiver, 0);
+
+    element.mSkyFormFactor = getSkyFormFactor(element);
+
+    // The form factors of nearby faces are underestimated, so the links
+    // are scaled to cover the part of the hemisphere that doesn't see the sky.
+    float formFactor = 0.0;
+    for (unsigned index = mLinkOffsetVector.back(); index < mLinkVector.size(); ++index) {
+        formFactor += getLinkFormFactor(mLinkVector[index]);
+    }
+    if (formFactor > 0.0) {
+        float scale = std::min(std::max((1.0f - element.mSkyFormFactor)/formFactor,
+                MINIMUM_LINK_SCALE), MAXIMUM_LINK_SCALE);
+        for (unsigned index = mLinkOffsetVector.back(); index < mLinkVector.size(); ++index) {
+            mLinkVector[index].mWeight *= scale;
+        }
+    }
+}
+
+float
+RadiositySolver::getSkyFormFactor(const Element &element) const
+{
+    mMeshShaderFaceListener->setFacePtrToIgnore(element.mFacePtr);
+
+    cgmath::Vector3f x;
+    cgmath::Vector3f y;
+    GetPerpendicularVectors(element.mNormal, &x, &y);
+
+    meshisect::FaceIntersector::Vector3fVector originVector;
+    meshisect::FaceIntersector::Vector3fVector endpointVector;
+    originVector.reserve(SKY_RAYS_PER_FACE);
+    endpointVector.reserve(SKY_RAYS_PER_FACE);
+    for (unsigned ray = 0; ray < SKY_RAYS_PER_FACE; ++ray) {
+        cgmath::Vector2f pointOnCircle = cgmath::MapConcentricSquareToConcentricCircle(
+            cgmath::Vector2f(drand48(), drand48()));
+        float u = pointOnCircle[0];
+        float v = pointOnCircle[1];
+        float w = sqrtf(std::max(0.0f, 1.0f - u*u - v*v));
+        cgmath::Vector3f direction = x*u + y*v + element.mNormal*w;
+
+        cgmath::Vector3f origin = getRandomPointOnElement(element);
+        originVector.push_back(origin);
+        endpointVector.push_back(origin + direction*mMeshBoundingBoxDiameter);
+    }
+
+    std::vector<bool> occludedVector;
+    mFaceIntersector->occludesRaySegments(originVector, endpointVector, &occludedVector,
+        mAabbTreeStatistics);
+
+    unsigned missCount = std::count(occludedVector.begin(), occludedVector.end(), false);
+
+    return float(missCount)/SKY_RAYS_PER_FACE;
+}
+
+void
+RadiositySolver::refineLink(unsigned receiver, unsigned clusterIndex)
+{
+    const Element &element = mElementVector[receiver];
+    const Cluster &cluster = mClusterVector[clusterIndex];
+
+    if (cluster.mArea == 0.0) {
+        return;
+    }
+
+    if (cluster.mLeftChild == 0) {
+        if (cluster.mBegin != receiver) {
+            Link link;
+            if (createLink(receiver, clusterIndex, &link)) {
+                mLinkVector.push_back(link);
+            }
+        }
+        return;
+    }
+
+    // Skip clusters that lie entirely behind the receiver.
+    float maximumHeight = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        maximumHeight += element.mNormal[axis]*((element.mNormal[axis] > 0.0
+                ? cluster.mBoundingBox.maxAxis(axis) : cluster.mBoundingBox.minAxis(axis))
+            - element.mCenter[axis]);
+    }
+    if (maximumHeight <= 0.0) {
+        return;
+    }
+
+    // The cluster may only be linked as a whole if the receiver
+    // is well outside its bounding sphere.
+    float distance = (cluster.mCenter - element.mCenter).length() - cluster.mRadius;
+    if (distance > cluster.mRadius) {
+        float formFactorEstimate = cluster.mArea/(cgmath::PI*distance*distance);
+        if (formFactorEstimate < MAXIMUM_CLUSTER_FORM_FACTOR
+            && formFactorEstimate*cluster.mLuminance < mRefinementEpsilon) {
+            Link link;
+            if (createLink(receiver, clusterIndex, &link)) {
+                mLinkVector.push_back(link);
+            }
+            return;
+        }
+    }
+
+    refineLink(receiver, cluster.mLeftChild);
+    refineLink(receiver, cluster.mRightChild);
+}
+
+bool
+RadiositySolver::createLink(unsigned receiver, unsigned clusterIndex, Link *link)
+{
+    const Element &element = mElementVector[receiver];
+    const Cluster &cluster = mClusterVector[clusterIndex];
+    bool isElement = cluster.mLeftChild == 0;
+    unsigned elementCount = cluster.mEnd - cluster.mBegin;
+
+    // For element-to-element links, the source area is divided among the rays
+    // to keep the form factor bounded when the faces are close together.
+    float sourceArea = cluster.mArea/mRaysPerLink;
+
+    mMeshShaderFaceListener->setFacePtrToIgnore(element.mFacePtr);
+
+    // The rays are generated first and then tested together,
+    // so that rays toward the same source share an OccluderCache.
+    mLinkRayVector.clear();
+    mLinkRayOriginVector.clear();
+    mLinkRayEndpointVector.clear();
+    for (unsigned ray = 0; ray < mRaysPerLink; ++ray) {
+
+        unsigned sourceIndex = cluster.mBegin
+            + std::min(unsigned(drand48()*elementCount), elementCount - 1);
+        const Element &source = mElementVector[sourceIndex];
+
+        cgmath::Vector3f origin = getRandomPointOnElement(element);
+        cgmath::Vector3f vector = getRandomPointOnElement(source) - origin;
+
+        float distanceSquared = vector.lengthSquared();
+        if (distanceSquared == 0.0) {
+            continue;
+        }
+        cgmath::Vector3f direction = vector/sqrtf(distanceSquared);
+
+        float receiverCosine = element.mNormal.dot(direction);
+        if (receiverCosine <= 0.0) {
+            continue;
+        }
+
+        // Faces are lit from either side, as in MeshShader::getInputIllumination.
+        float sourceCosine = fabsf(source.mNormal.dot(direction));
+        if (isElement && sourceCosine == 0.0) {
+            continue;
+        }
+
+        LinkRay linkRay;
+        linkRay.mDirection = direction;
+        linkRay.mDistanceSquared = distanceSquared;
+        linkRay.mReceiverCosine = receiverCosine;
+        linkRay.mSourceCosine = sourceCosine;
+        mLinkRayVector.push_back(linkRay);
+        mLinkRayOriginVector.push_back(origin);
+        mLinkRayEndpointVector.push_back(origin + vector*VISIBILITY_SEGMENT_FRACTION);
+    }
+
+    meshisect::OccluderCache occluderCache;
+    mFaceIntersector->occludesRaySegments(mLinkRayOriginVector, mLinkRayEndpointVector,
+        &mLinkRayOccludedVector, mAabbTreeStatistics, &occluderCache);
+
+    cgmath::Vector3f weight(0, 0, 0);
+    for (size_t index = 0; index < mLinkRayVector.size(); ++index) {
+        if (mLinkRayOccludedVector[index]) {
+            continue;
+        }
+
+        const LinkRay &linkRay = mLinkRayVector[index];
+        const cgmath::Vector3f &direction = linkRay.mDirection;
+        float distanceSquared = linkRay.mDistanceSquared;
+        float receiverCosine = linkRay.mReceiverCosine;
+        float sourceCosine = linkRay.mSourceCosine;
+
+        if (isElement) {
+            float formFactor = sourceArea*receiverCosine*sourceCosine
+                /(cgmath::PI*distanceSquared + sourceArea);
+            weight += cgmath::Vector3f(formFactor, formFactor, formFactor);
+        } else {
+            float scale = receiverCosine/(cgmath::PI*distanceSquared*mRaysPerLink);
+            weight += cgmath::Vector3f(direction[0]*direction[0],
+                direction[1]*direction[1], direction[2]*direction[2])*scale;
+        }
+    }
+
+    if (weight == cgmath::Vector3f(0, 0, 0)) {
+        return false;
+    }
+
+    link->mCluster = clusterIndex;
+    link->mWeight = weight;
+
+    return true;
+}
+
+cgmath::Vector3f
+RadiositySolver::getRandomPointOnElement(const Element &element) const
+{
+    float r1 = sqrtf(drand48());
+    float r2 = drand48();
+
+    return element.mP0*(1.0 - r1) + element.mP1*(r1*(1.0 - r2)) + element.mP2*(r1*r2);
+}
+
+float
+RadiositySolver::getLinkFormFactor(const Link &link) const
+{
+    const Cluster &cluster = mClusterVector[link.mCluster];
+    if (cluster.mLeftChild == 0) {
+        return link.mWeight[0];
+    }
+
+    return link.mWeight.dot(cluster.mProjectedArea);
+}
+
+void
+RadiositySolver::updateClusterFlux()
+{
+    // Children always follow their parents in the cluster vector.
+    for (size_t index = mClusterVector.size(); index-- > 0; ) {
+        Cluster &cluster = mClusterVector[index];
+        if (cluster.mLeftChild == 0) {
+            const Element &element = mElementVector[cluster.mBegin];
+            cgmath::Vector3f illumination = element.mDirectIllumination
+                + element.mIndirectIllumination;
+            for (int axis = 0; axis < 3; ++axis) {
+                cluster.mFlux[axis] = illumination*cluster.mProjectedArea[axis];
+            }
+        } else {
+            const Cluster &left = mClusterVector[cluster.mLeftChild];
+            const Cluster &right = mClusterVector[cluster.mRightChild];
+            for (int axis = 0; axis < 3; ++axis) {
+                cluster.mFlux[axis] = left.mFlux[axis] + right.mFlux[axis];
+            }
+        }
+    }
+}
+
+cgmath::Vector3f
+RadiositySolver::gatherElementIllumination(unsigned receiver) const
+{
+    cgmath::Vector3f illumination(0, 0, 0);
+
+    for (unsigned index = mLinkOffsetVector[receiver];
+         index < mLinkOffsetVector[receiver + 1]; ++index) {
+        const Link &link = mLinkVector[index];
+        const Cluster &cluster = mClusterVector[link.mCluster];
+
+        if (cluster.mLeftChild == 0) {
+            const Element &source = mElementVector[cluster.mBegin];
+            illumination += (source.mDirectIllumination + source.mIndirectIllumination)
+                *link.mWeight[0];
+        } else {
+            illumination += cluster.mFlux[0]*link.mWeight[0]
+                + cluster.mFlux[1]*link.mWeight[1]
+                + cluster.mFlux[2]*link.mWeight[2];
+        }
+    }
+
+    return illumination;
+}
+
+void
+RadiositySolver::storeSolution()
+{
+    for (ElementVector::const_iterator iterator = mElementVector.begin();
+         iterator != mElementVector.end(); ++iterator) {
+        mesh::FacePtr facePtr = iterator->mFacePtr;
+
+        facePtr->setVector3f(mSampledIlluminationAttributeKey,
+            iterator->mIndirectIllumination);
+
+        for (mesh::AdjacentVertexIterator vertexIterator = facePtr->adjacentVertexBegin();
+             vertexIterator != facePtr->adjacentVertexEnd(); ++vertexIterator) {
+            facePtr->setVertexVector3f(*vertexIterator, mSampledIlluminationAttributeKey,
+                iterator->mIndirectIllumination);
+        }
+    }
+}
@@ -0,0 +1,251 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__RADIOSITY_SOLVER__INCLUDED
+#define RFM_INDIRECT__RADIOSITY_SOLVER__INCLUDED
+
+#include <vector>
+
+#include <cgmath/Vector3f.h>
+#include <cgmath/BoundingBox3f.h>
+#include <mesh/Types.h>
+#include <mesh/AttributeKey.h>
+
+namespace mesh {
+class Mesh;
+class MaterialTable;
+}
+
+namespace meshisect {
+class FaceIntersector;
+}
+
+namespace cgmath {
+class AabbTreeStatistics;
+}
+
+class MeshShaderFaceListener;
+
+// RadiositySolver
+//
+// Computes the indirect illumination of a mesh with hierarchical radiosity.
+//
+// The faces of the mesh are the receiving elements, and they are grouped
+// into a binary hierarchy of clusters that act as sources. Each face is linked
+// to the coarsest clusters whose estimated form factor, weighted by their
+// brightness, is below an error threshold, and to individual faces otherwise.
+// The visibility and form factor of each link are estimated once by firing
+// rays through the FaceIntersector, and the links are then reused
+// by every Gauss-Seidel sweep of the solution. The fraction of each face's
+// hemisphere that sees the sky is estimated separately, and the links
+// of the face are scaled so that their form factors account for the rest.
+//
+// Clusters are treated as unoriented collections of faces. Their flux
+// is approximated by the area of their faces projected onto the three
+// coordinate planes, which is accurate enough for the small form factors
+// that clusters are linked with.
+//
+// As in MeshShader, the direct illumination stored in the mesh is treated
+// as the illumination leaving the surfaces it reaches, and faces reflect
+// the illumination they receive on their front side only.
+
+class RadiositySolver
+{
+public:
+    RadiositySolver();
+    ~RadiositySolver();
+
+    // The mesh to solve. Its faces must be triangles.
+    void setMesh(mesh::Mesh *mesh);
+
+    // The face intersector, which must already be initialized with the mesh,
+    // and the listener it was configured with, which is used to prevent
+    // the visibility rays from hitting the face they leave.
+    void setFaceIntersector(meshisect::FaceIntersector *faceIntersector,
+        MeshShaderFaceListener *meshShaderFaceListener);
+
+    // Optional statistics object that the face intersector queries are added to.
+    void setAabbTreeStatistics(cgmath::AabbTreeStatistics *aabbTreeStatistics);
+
+    // Table of mesh materials, which define the diffuse color of each face.
+    void setMaterialTable(const mesh::MaterialTable *materialTable);
+
+    // Diffuse coefficient, applied to the indirect illumination.
+    void setDiffuseCoefficient(float diffuseCoefficient);
+    float diffuseCoefficient() const;
+
+    // The color of the sky, which illuminates the fraction of each face's
+    // hemisphere that isn't occluded by the mesh.
+    void setSkyColor(const cgmath::Vector3f &skyColor);
+    const cgmath::Vector3f &skyColor() const;
+
+    // Face vertex attribute holding the illumination leaving each face
+    // before any interreflection.
+    void setInputIlluminationAttributeKey(const mesh::AttributeKey &attributeKey);
+
+    // Face and face vertex attribute that the indirect illumination reflected
+    // by each face is written to.
+    void setSampledIlluminationAttributeKey(const mesh::AttributeKey &attributeKey);
+
+    // Links are refined until their form factor multiplied by the
+    // luminance of their source is less than this value.
+    void setRefinementEpsilon(float refinementEpsilon);
+    float refinementEpsilon() const;
+
+    // The number of rays fired to estimate the visibility of each link.
+    void setRaysPerLink(unsigned raysPerLink);
+    unsigned raysPerLink() const;
+
+    // The maximum number of Gauss-Seidel sweeps. Each sweep accounts
+    // for at least one more bounce of indirect illumination.
+    void setMaximumIterations(unsigned maximumIterations);
+    unsigned maximumIterations() const;
+
+    // The solution stops early when no face's reflected illumination changes
+    // by more than this amount in one sweep.
+    void setConvergenceTolerance(float convergenceTolerance);
+    float convergenceTolerance() const;
+
+    // Solve for the indirect illumination and store it in the sampled
+    // illumination attribute of each face and face vertex.
+    void solve();
+
+    // The number of links created by the last call to solve.
+    size_t linkCount() const;
+
+    // The number of sweeps performed by the last call to solve.
+    unsigned iterationCount() const;
+
+    // The number of bytes used by the hierarchy and the links.
+    size_t bytesUsed() const;
+
+private:
+    // A face of the mesh.
+    struct Element {
+        mesh::FacePtr mFacePtr;
+        cgmath::Vector3f mP0;
+        cgmath::Vector3f mP1;
+        cgmath::Vector3f mP2;
+        cgmath::Vector3f mCenter;
+        cgmath::Vector3f mNormal;
+        float mArea;
+        // Diffuse reflectance, including the diffuse coefficient.
+        cgmath::Vector3f mReflectance;
+        // Illumination leaving the face before interreflection.
+        cgmath::Vector3f mDirectIllumination;
+        // Illumination reflected by the face, which is being solved for.
+        cgmath::Vector3f mIndirectIllumination;
+        // Fraction of the face's hemisphere that sees the sky.
+        float mSkyFormFactor;
+    };
+    typedef std::vector<Element> ElementVector;
+
+    // A node in the hierarchy, covering a contiguous range of elements.
+    // A cluster with a single element stands for that element's face.
+    struct Cluster {
+        cgmath::BoundingBox3f mBoundingBox;
+        cgmath::Vector3f mCenter;
+        float mRadius;
+        unsigned mBegin;
+        unsigned mEnd;
+        unsigned mLeftChild;
+        unsigned mRightChild;
+        float mArea;
+        // Area of the faces projected onto the planes perpendicular
+        // to the X, Y, and Z axes.
+        cgmath::Vector3f mProjectedArea;
+        // Projected area multiplied by the illumination leaving the faces,
+        // for each of the three axes.
+        cgmath::Vector3f mFlux[3];
+        // Average luminance of the direct illumination leaving the faces.
+        float mLuminance;
+    };
+    typedef std::vector<Cluster> ClusterVector;
+
+    // Transfer of illumination from a cluster to a receiving element.
+    // For clusters with more than one element, mWeight scales the cluster's flux
+    // along each axis. For single elements, all three components
+    // hold the element-to-element form factor.
+    struct Link {
+        unsigned mCluster;
+        cgmath::Vector3f mWeight;
+    };
+    typedef std::vector<Link> LinkVector;
+
+    // A ray fired by createLink from the receiver toward a point on the source,
+    // which contributes to the link if it's not occluded.
+    struct LinkRay {
+        cgmath::Vector3f mDirection;
+        float mDistanceSquared;
+        float mReceiverCosine;
+        float mSourceCosine;
+    };
+    typedef std::vector<LinkRay> LinkRayVector;
+
+    // Create an element for every face of the mesh.
+    void createElementVector();
+
+    // Build the hierarchy of clusters over a range of elements,
+    // returning the index of the new cluster.
+    unsigned createCluster(unsigned begin, unsigned end);
+
+    // Create the links received by an element, refining them from the
+    // root of the hierarchy downward.
+    void createElementLinks(unsigned receiver);
+    void refineLink(unsigned receiver, unsigned cluster);
+
+    // Estimate the form factor of a link by firing rays between random points
+    // on the receiver and the source. Returns false if the source is invisible.
+    bool createLink(unsigned receiver, unsigned cluster, Link *link);
+
+    // Estimate the fraction of an element's hemisphere that sees the sky.
+    float getSkyFormFactor(const Element &element) const;
+
+    // Return a random point on an element.
+    cgmath::Vector3f getRandomPointOnElement(const Element &element) const;
+
+    // Return the form factor of a link, ignoring the illumination it carries.
+    float getLinkFormFactor(const Link &link) const;
+
+    // Accumulate the flux of the clusters from the current solution.
+    void updateClusterFlux();
+
+    // Return the illumination received by an element over its links.
+    cgmath::Vector3f gatherElementIllumination(unsigned receiver) const;
+
+    // Copy the solution into the mesh attributes.
+    void storeSolution();
+
+    mesh::Mesh *mMesh;
+    meshisect::FaceIntersector *mFaceIntersector;
+    MeshShaderFaceListener *mMeshShaderFaceListener;
+    cgmath::AabbTreeStatistics *mAabbTreeStatistics;
+    const mesh::MaterialTable *mMaterialTable;
+    float mDiffuseCoefficient;
+    cgmath::Vector3f mSkyColor;
+    mesh::AttributeKey mInputIlluminationAttributeKey;
+    mesh::AttributeKey mSampledIlluminationAttributeKey;
+    float mRefinementEpsilon;
+    unsigned mRaysPerLink;
+    unsigned mMaximumIterations;
+    float mConvergenceTolerance;
+
+    ElementVector mElementVector;
+    ClusterVector mClusterVector;
+
+    // The links received by element i are mLinkVector[mLinkOffsetVector[i]]
+    // through mLinkVector[mLinkOffsetVector[i + 1] - 1].
+    LinkVector mLinkVector;
+    std::vector<unsigned> mLinkOffsetVector;
+
+    // The rays fired by createLink, kept between calls to avoid reallocation.
+    LinkRayVector mLinkRayVector;
+    std::vector<cgmath::Vector3f> mLinkRayOriginVector;
+    std::vector<cgmath::Vector3f> mLinkRayEndpointVector;
+    std::vector<bool> mLinkRayOccludedVector;
+
+    float mMeshBoundingBoxDiameter;
+
+    unsigned mIterationCount;
+};
+
+#endif // RFM_INDIRECT__RADIOSITY_SOLVER__INCLUDED
@@ -62,9 +62,3 @@ Sample::faceArea() const
     return mFaceArea;
 }
 
-cgmath::BoundingBox3f
-Sample::boundingBox() const
-{
-    return cgmath::BoundingBox3f(mPosition, mPosition);
-}
-
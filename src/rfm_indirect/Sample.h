@@ -4,7 +4,6 @@
 #define RFM_INDIRECT__SAMPLE__INCLUDED
 
 #include <cgmath/Vector3f.h>
-#include <cgmath/BoundingBox3f.h>
 
 // Sample
 //
@@ -17,6 +16,7 @@ public:
     ~Sample();
 
     // The position of the sample.
+    // Required by the cgmath::PointTree template.
     void setPosition(const cgmath::Vector3f &position);
     const cgmath::Vector3f &position() const;
 
@@ -32,9 +32,6 @@ public:
     void setFaceArea(float faceArea);
     float faceArea() const;
 
-    // Required by the cgmath::AabbTree template.
-    cgmath::BoundingBox3f boundingBox() const;
-
 private:
     cgmath::Vector3f mPosition;
     cgmath::Vector3f mNormal;
@@ -0,0 +1,16 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__SAMPLE_POINT_TREE__INCLUDED
+#define RFM_INDIRECT__SAMPLE_POINT_TREE__INCLUDED
+
+#include <cgmath/PointTree.h>
+
+#include "Sample.h"
+
+// SamplePointTree
+//
+// Point tree of Sample objects.
+
+typedef cgmath::PointTree<Sample> SamplePointTree;
+
+#endif // RFM_INDIRECT__SAMPLE_POINT_TREE__INCLUDED
@@ -0,0 +1,16 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__VERTEX_POINT_TREE__INCLUDED
+#define RFM_INDIRECT__VERTEX_POINT_TREE__INCLUDED
+
+#include <cgmath/PointTree.h>
+
+#include "VertexPointTreeNode.h"
+
+// VertexPointTree
+//
+// Point tree of mesh vertices
+
+typedef cgmath::PointTree<VertexPointTreeNode> VertexPointTree;
+
+#endif // RFM_INDIRECT__VERTEX_POINT_TREE__INCLUDED
@@ -0,0 +1,33 @@
+// Copyright 2010 Drew Olbrich
+
+#include "VertexPointTreeNode.h"
+
+#include <mesh/Vertex.h>
+
+VertexPointTreeNode::VertexPointTreeNode()
+    : mVertexPtr()
+{
+}
+
+VertexPointTreeNode::~VertexPointTreeNode()
+{
+}
+
+void
+VertexPointTreeNode::setVertexPtr(mesh::VertexPtr vertexPtr)
+{
+    mVertexPtr = vertexPtr;
+}
+
+mesh::VertexPtr
+VertexPointTreeNode::vertexPtr() const
+{
+    return mVertexPtr;
+}
+
+const cgmath::Vector3f &
+VertexPointTreeNode::position() const
+{
+    return mVertexPtr->position();
+}
+
@@ -0,0 +1,30 @@
+// Copyright 2010 Drew Olbrich
+
+#ifndef RFM_INDIRECT__VERTEX_POINT_TREE_NODE__INCLUDED
+#define RFM_INDIRECT__VERTEX_POINT_TREE_NODE__INCLUDED
+
+#include <cgmath/Vector3f.h>
+#include <mesh/Types.h>
+
+// VertexPointTreeNode
+//
+// Point tree node for VertexPointTree.
+
+class VertexPointTreeNode
+{
+public:
+    VertexPointTreeNode();
+    ~VertexPointTreeNode();
+
+    // The vertex at the node in the point tree.
+    void setVertexPtr(mesh::VertexPtr vertexPtr);
+    mesh::VertexPtr vertexPtr() const;
+
+    // Required by the cgmath::PointTree template.
+    const cgmath::Vector3f &position() const;
+
+private:
+    mesh::VertexPtr mVertexPtr;
+};
+
+#endif // RFM_INDIRECT__VERTEX_POINT_TREE_NODE__INCLUDED
@@ -46,6 +46,10 @@ main(int argc, char **argv)
             meshLinter.setShouldMarkErrors(true);
         }
 
+        if (gOptions.specified("intersecting-faces")) {
+            meshLinter.setShouldTestIntersectingFaces(true);
+        }
+
         meshLinter.testMesh();
 
         if (gOptions.specified("output-file")) {
@@ -76,6 +80,7 @@ ParseCommandLineArguments(int argc, char **argv)
         ("output-file", opt::value<std::string>(), "Output file with marked errors")
         ("abs-tolerance", opt::value<float>(), "Absolute tolerance")
         ("rel-tolerance", opt::value<float>(), "Relative tolerance")
+        ("intersecting-faces", "Test for faces that intersect other faces")
         ;
 
     gOptions.parse(argc, argv);
@@ -3,11 +3,14 @@
 #include "MeshLinter.h"
 
 #include <iostream>
+#include <vector>
 
 #include <cgmath/Tolerance.h>
+#include <cgmath/ParallelAlgorithms.h>
 #include <mesh/FaceOperations.h>
 #include <mesh/IsConsistent.h>
 #include <mesh/MeshOperations.h>
+#include <meshisect/FaceIntersectorAabbTree.h>
 #include <meshprim/CylinderCreator.h>
 #include <cgmath/Matrix4fOperations.h>
 #include <cgmath/BoundingBox3f.h>
@@ -17,6 +20,7 @@ MeshLinter::MeshLinter()
       mAbsoluteTolerance(cgmath::TOLERANCE),
       mRelativeTolerance(cgmath::TOLERANCE),
       mShouldMarkErrors(false),
+      mShouldTestIntersectingFaces(false),
       mMarkedFaceVector()
 {
 }
@@ -73,6 +77,18 @@ MeshLinter::shouldMarkErrors() const
     return mShouldMarkErrors;
 }
 
+void
+MeshLinter::setShouldTestIntersectingFaces(bool shouldTestIntersectingFaces)
+{
+    mShouldTestIntersectingFaces = shouldTestIntersectingFaces;
+}
+
+bool
+MeshLinter::shouldTestIntersectingFaces() const
+{
+    return mShouldTestIntersectingFaces;
+}
+
 bool
 MeshLinter::testMesh()
 {
@@ -89,6 +105,11 @@ MeshLinter::testMesh()
         success = false;
     }
 
+    if (mShouldTestIntersectingFaces
+        && meshHasIntersectingFaces(*mMesh)) {
+        success = false;
+    }
+
     if (mShouldMarkErrors) {
         markErrors(mMesh);
     }
@@ -119,6 +140,100 @@ MeshLinter::meshHasDegenerateFaces(mesh::Mesh &mesh)
     return false;
 }
 
+bool
+MeshLinter::meshHasIntersectingFaces(mesh::Mesh &mesh)
+{
+    // Degenerate faces have already been reported, and their
+    // intersections with other faces aren't well defined.
+    meshisect::FaceIntersectorAabbTree::ObjectVector objectVector;
+    for (mesh::FacePtr facePtr = mesh.faceBegin(); facePtr != mesh.faceEnd(); ++facePtr) {
+        if (!mesh::FaceIsDegenerate(facePtr,
+                mesh::GetEpsilonFromFace(facePtr, mAbsoluteTolerance, mRelativeTolerance))) {
+            meshisect::FaceIntersectorAabbTreeNode faceIntersectorAabbTreeNode;
+            faceIntersectorAabbTreeNode.setFacePtr(facePtr);
+            objectVector.push_back(faceIntersectorAabbTreeNode);
+        }
+    }
+
+    meshisect::FaceIntersectorAabbTree faceIntersectorAabbTree;
+    faceIntersectorAabbTree.initialize(objectVector);
+
+    // Only faces whose bounding boxes overlap can intersect.
+    meshisect::FaceIntersectorAabbTree::ObjectIndexPairVector objectIndexPairVector;
+    faceIntersectorAabbTree.findSelfOverlappingPairs(0.0, cgmath::GetDefaultThreadCount(),
+        &objectIndexPairVector);
+
+    const meshisect::FaceIntersectorAabbTree::ObjectVector &treeObjectVector
+        = faceIntersectorAabbTree.objectVector();
+    size_t intersectingFacePairCount = 0;
+    std::vector<bool> faceIsIntersectingVector(mesh.faceIndexLimit(), false);
+    for (size_t index = 0; index < objectIndexPairVector.size(); ++index) {
+        mesh::FacePtr facePtr = treeObjectVector[objectIndexPairVector[index].first].facePtr();
+        mesh::FacePtr otherFacePtr
+            = treeObjectVector[objectIndexPairVector[index].second].facePtr();
+
+        // Faces that share a vertex touch there, which is not an error.
+        bool sharesVertex = false;
+        for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+             iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+            if (otherFacePtr->hasAdjacentVertex(*iterator)) {
+                sharesVertex = true;
+                break;
+            }
+        }
+        if (sharesVertex) {
+            continue;
+        }
+
+        if (faceEdgeIntersectsFace(facePtr, otherFacePtr)
+            || faceEdgeIntersectsFace(otherFacePtr, facePtr)) {
+            ++intersectingFacePairCount;
+            faceIsIntersectingVector[mesh.faceIndex(facePtr)] = true;
+            faceIsIntersectingVector[mesh.faceIndex(otherFacePtr)] = true;
+        }
+    }
+
+    if (intersectingFacePairCount > 0) {
+        std::cout << "Mesh has " << intersectingFacePairCount
+            << " pairs of intersecting faces." << std::endl;
+
+        // A face may intersect several others, but is only marked once.
+        // The faces are marked in the order of the mesh, so that
+        // the output is the same from one run to the next.
+        if (mShouldMarkErrors) {
+            for (mesh::FacePtr facePtr = mesh.faceBegin(); 
+                 facePtr != mesh.faceEnd(); ++facePtr) {
+                if (faceIsIntersectingVector[mesh.faceIndex(facePtr)]) {
+                    mMarkedFaceVector.push_back(facePtr);
+                }
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool
+MeshLinter::faceEdgeIntersectsFace(mesh::FacePtr facePtr, mesh::FacePtr otherFacePtr) const
+{
+    for (mesh::AdjacentVertexIterator iterator = facePtr->adjacentVertexBegin();
+         iterator != facePtr->adjacentVertexEnd(); ++iterator) {
+        mesh::AdjacentVertexIterator nextIterator = iterator;
+        ++nextIterator;
+        if (nextIterator == facePtr->adjacentVertexEnd()) {
+            nextIterator = facePtr->adjacentVertexBegin();
+        }
+
+        if (mesh::RaySegmentIntersectsFace(otherFacePtr, (*iterator)->position(),
+                (*nextIterator)->position())) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void
 MeshLinter::markErrors(mesh::Mesh *mesh)
 {
@@ -3,6 +3,8 @@
 #ifndef RFM_LINT__MESH_LINTER__INCLUDED
 #define RFM_LINT__MESH_LINTER__INCLUDED
 
+#include <vector>
+
 #include <mesh/Types.h>
 
 namespace mesh {
@@ -35,6 +37,11 @@ public:
     void setShouldMarkErrors(bool shouldMarkErrors);
     bool shouldMarkErrors() const;
 
+    // If true, the mesh is also tested for faces that intersect
+    // other faces. The test is not made by default.
+    void setShouldTestIntersectingFaces(bool shouldTestIntersectingFaces);
+    bool shouldTestIntersectingFaces() const;
+
     // Run the test. Returns true if there are no errors in the mesh.
     bool testMesh();
 
@@ -42,6 +49,13 @@ private:
     // Returns true if the mesh has one or more degenerate faces.
     bool meshHasDegenerateFaces(mesh::Mesh &mesh);
 
+    // Returns true if any two nonadjacent faces of the mesh intersect.
+    // Faces that only touch where they are coplanar aren't detected.
+    bool meshHasIntersectingFaces(mesh::Mesh &mesh);
+
+    // Returns true if an edge of the first face passes through the second face.
+    bool faceEdgeIntersectsFace(mesh::FacePtr facePtr, mesh::FacePtr otherFacePtr) const;
+
     // Mark errors in the mesh with additional geometry.
     void markErrors(mesh::Mesh *mesh);
 
@@ -49,6 +63,7 @@ private:
     float mAbsoluteTolerance;
     float mRelativeTolerance;
     bool mShouldMarkErrors;
+    bool mShouldTestIntersectingFaces;
 
     typedef std::vector<mesh::FacePtr> FaceVector;
     FaceVector mMarkedFaceVector;
@@ -25,6 +25,7 @@
 #include <mesh/AttributeKey.h>
 #include <mesh/AttributeKeyMap.h>
 #include <mesh/StandardAttributes.h>
+#include <mesh/MeshMemoryUsage.h>
 #include <meshrfm/ReadRfmFile.h>
 #include <meshrfm/RfmFileHeader.h>
 #include <cgmath/WriteMatrix.h>
@@ -40,6 +41,7 @@ static void ParseCommandLineArguments(int argc, char **argv);
 
 static void PrintByteOrder(const meshrfm::RfmFileHeader &header);
 static void PrintBoundingBox(const meshrfm::RfmFileHeader &header);
+static void PrintMemoryUsage();
 
 int
 main(int argc, char **argv)
@@ -85,6 +87,10 @@ main(int argc, char **argv)
             PrintByteOrder(header);
         }
 
+        if (gOptions.specified("memory")) {
+            PrintMemoryUsage();
+        }
+
     } catch (const std::exception &exception) {
         con::error << exception.what() << std::endl;
         exit(EXIT_FAILURE);
@@ -106,6 +112,7 @@ ParseCommandLineArguments(int argc, char **argv)
 
     gOptions.addOptions()
         ("file-version", "Print file version and byte order")
+        ("memory", "Read the entire file and print the memory the mesh occupies")
         ;
 
     gOptions.parse(argc, argv);
@@ -163,3 +170,21 @@ PrintBoundingBox(const meshrfm::RfmFileHeader &header)
     std::cout << std::setw(gTitleWidth) << "Bounding box: "
         << string << std::endl;
 }
+
+static void
+PrintMemoryUsage()
+{
+    con::info << "Reading entire file." << std::endl;
+
+    mesh::Mesh mesh;
+    meshrfm::ReadRfmFile(&mesh, gOptions.get("input-file").as<std::string>());
+
+    // The attribute names may be longer than the other titles,
+    // so the breakdown is printed as a list rather than aligned.
+    std::cout << "Memory usage:" << std::endl;
+    std::istringstream istr(mesh.memoryUsage().asString());
+    std::string line;
+    while (std::getline(istr, line)) {
+        std::cout << "    " << line << std::endl;
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright 2010 Drew Olbrich
+
+// Reorders the elements of a mesh for cache locality.
+
+#include <cstdlib>
+#include <iostream>
+
+#include <opt/ProgramOptionsParser.h>
+#include <con/Streams.h>
+#include <mesh/Mesh.h>
+#include <mesh/MeshOperations.h>
+#include <meshrfm/ReadRfmFile.h>
+#include <meshrfm/WriteRfmFile.h>
+
+static opt::ProgramOptionsParser gOptions;
+
+// Parse the command line arguments.
+static void ParseCommandLineArguments(int argc, char **argv);
+
+int
+main(int argc, char **argv)
+{
+    try {
+
+        ParseCommandLineArguments(argc, argv);
+
+        con::info << "Reading RFM file \"" << gOptions.get("input-file").as<std::string>()
+            << "\"." << std::endl;
+
+        mesh::Mesh mesh;
+        meshrfm::ReadRfmFile(&mesh, gOptions.get("input-file").as<std::string>());
+
+        con::info << "Sorting elements along a Morton curve." << std::endl;
+
+        mesh::SortElementsAlongMortonCurve(&mesh);
+
+        // The RFM file stores the elements in the order they're iterated
+        // over, and they're read back in the same order, so the new
+        // order is preserved.
+        con::info << "Writing RFM file \"" << gOptions.get("output-file").as<std::string>()
+            << "\"." << std::endl;
+
+        meshrfm::WriteRfmFile(mesh, gOptions.get("output-file").as<std::string>());
+
+        con::info << "Done." << std::endl;
+
+    } catch (const std::exception &exception) {
+        con::error << exception.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void
+ParseCommandLineArguments(int argc, char **argv)
+{
+    gOptions.setUsageSummary("input.rfm output.rfm [options]");
+    gOptions.setProgramPurpose("Reorders the vertices, edges, and faces of an RFM file "
+        "so that elements that are near each other in space are near each other "
+        "in the file and in memory.");
+
+    gOptions.addRequiredPositionalOptions()
+        ("input-file", "Input file")
+        ("output-file", "Output file")
+        ;
+
+    gOptions.parse(argc, argv);
+}
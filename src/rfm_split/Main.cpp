@@ -7,6 +7,7 @@
 
 #include <opt/ProgramOptionsParser.h>
 #include <con/Streams.h>
+#include <con/LogLevel.h>
 #include <mesh/Mesh.h>
 #include <meshsplit/Splitter.h>
 #include <meshrfm/ReadRfmFile.h>
@@ -43,6 +44,10 @@ main(int argc, char **argv)
             splitter.setRelativeTolerance(gOptions.get("rel-tolerance").as<float>());
         }
 
+        if (gOptions.specified("aabb-cache")) {
+            splitter.setAabbTreeFilename(gOptions.get("aabb-cache").as<std::string>());
+        }
+
         if (gOptions.specified("mark-intersections")) {
             splitter.setMarkIntersectionsWithCylinders(true);
         }
@@ -56,6 +61,11 @@ main(int argc, char **argv)
         // Split the intersecting faces.
         splitter.splitFaces();
 
+        if (con::LogLevelIsEnabled(con::LOG_LEVEL_DEBUG)) {
+            con::debug << "Mesh memory usage:\n" << mesh.memoryUsage().asString()
+                << std::endl;
+        }
+
         con::info << "Writing RFM file \"" << gOptions.get("output-file").as<std::string>()
             << "\"." << std::endl;
 
@@ -83,6 +93,9 @@ ParseCommandLineArguments(int argc, char **argv)
     gOptions.addOptions()
         ("abs-tolerance", opt::value<float>(), "Absolute tolerance")
         ("rel-tolerance", opt::value<float>(), "Relative tolerance")
+        ("aabb-cache", opt::value<std::string>(),
+            "File in which to save the AABB tree of faces, so that it's not rebuilt "
+            "when the same mesh is processed again")
         ;
 
     gOptions.addDebugOptions()